@@ -43,6 +43,7 @@ set(SOURCE_FILES
     version.sql
     size_utils.sql
     histogram.sql
+    approximate_agg.sql
     bgw_scheduler.sql
     metadata.sql
     views.sql
@@ -0,0 +1,112 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Microbenchmarks for the compression algorithms and the vectorized kernels.
+-- Requires a debug build, or a release build configured with
+-- -DCOMPRESSION_BENCHMARK=ON. The results are printed in CSV format:
+--
+--   psql -X -q -d <database> -f scripts/bench_compression.sql > bench.csv
+--
+-- Optional variables:
+--   rows        number of rows in the synthetic distributions (1000000)
+--   iterations  number of times each kernel is run (10)
+--   query       a query returning one column of real-world data to benchmark,
+--               e.g. -v query='select value from metrics order by time'
+--   algorithm   the compression algorithm for the query column (the default
+--               algorithm for its type)
+
+\set ON_ERROR_STOP 1
+
+\if :{?rows}
+\else
+\set rows 1000000
+\endif
+
+\if :{?iterations}
+\else
+\set iterations 10
+\endif
+
+CREATE EXTENSION IF NOT EXISTS timescaledb;
+
+\if :{?TSL_MODULE_PATHNAME}
+\else
+SELECT format('%L', '$libdir/timescaledb-tsl-' || extversion) AS "TSL_MODULE_PATHNAME"
+FROM pg_extension WHERE extname = 'timescaledb' \gset
+\endif
+
+CREATE OR REPLACE FUNCTION pg_temp.ts_bench_compression(anyarray, cstring, int4,
+    OUT kernel text, OUT rows int8, OUT uncompressed_bytes int8,
+    OUT compressed_bytes int8, OUT ns_per_row float8, OUT mb_per_sec float8)
+RETURNS SETOF record
+AS :TSL_MODULE_PATHNAME, 'ts_bench_compression' LANGUAGE C VOLATILE;
+
+SELECT setseed(0) \g /dev/null
+
+\pset format csv
+
+SELECT d.distribution, d.algorithm, b.*
+FROM (
+    SELECT 'int8 sequential', 'deltadelta', pg_temp.ts_bench_compression(
+        (SELECT array_agg(x::int8 ORDER BY x) FROM generate_series(1, :rows) x),
+        'deltadelta', :iterations)
+    UNION ALL
+    SELECT 'int8 random', 'deltadelta', pg_temp.ts_bench_compression(
+        (SELECT array_agg((random() * 1e9)::int8) FROM generate_series(1, :rows) x),
+        'deltadelta', :iterations)
+    UNION ALL
+    SELECT 'int4 low cardinality', 'deltadelta', pg_temp.ts_bench_compression(
+        (SELECT array_agg((random() * 10)::int4) FROM generate_series(1, :rows) x),
+        'deltadelta', :iterations)
+    UNION ALL
+    SELECT 'int4 low cardinality', 'bitpack', pg_temp.ts_bench_compression(
+        (SELECT array_agg((random() * 10)::int4) FROM generate_series(1, :rows) x),
+        'bitpack', :iterations)
+    UNION ALL
+    SELECT 'timestamptz 1s step', 'deltadelta', pg_temp.ts_bench_compression(
+        (SELECT array_agg('2025-01-01'::timestamptz + x * interval '1 second' ORDER BY x)
+            FROM generate_series(1, :rows) x),
+        'deltadelta', :iterations)
+    UNION ALL
+    SELECT 'float8 smooth', 'gorilla', pg_temp.ts_bench_compression(
+        (SELECT array_agg(round(sin(x / 1000.)::numeric, 2)::float8 ORDER BY x)
+            FROM generate_series(1, :rows) x),
+        'gorilla', :iterations)
+    UNION ALL
+    SELECT 'float8 random', 'gorilla', pg_temp.ts_bench_compression(
+        (SELECT array_agg(random()) FROM generate_series(1, :rows) x),
+        'gorilla', :iterations)
+    UNION ALL
+    SELECT 'float8 random 10% nulls', 'gorilla', pg_temp.ts_bench_compression(
+        (SELECT array_agg(CASE WHEN random() < 0.1 THEN NULL ELSE random() END)
+            FROM generate_series(1, :rows) x),
+        'gorilla', :iterations)
+    UNION ALL
+    SELECT 'float4 random', 'array', pg_temp.ts_bench_compression(
+        (SELECT array_agg(random()::float4) FROM generate_series(1, :rows) x),
+        'array', :iterations)
+    UNION ALL
+    SELECT 'text low cardinality', 'dictionary', pg_temp.ts_bench_compression(
+        (SELECT array_agg(format('device %s', (random() * 100)::int))
+            FROM generate_series(1, :rows) x),
+        'dictionary', :iterations)
+    UNION ALL
+    SELECT 'text high cardinality', 'array', pg_temp.ts_bench_compression(
+        (SELECT array_agg(md5(x::text)) FROM generate_series(1, :rows) x),
+        'array', :iterations)
+    UNION ALL
+    SELECT 'bool random', 'bool', pg_temp.ts_bench_compression(
+        (SELECT array_agg(random() < 0.5) FROM generate_series(1, :rows) x),
+        'bool', :iterations)
+) d(distribution, algorithm, result), LATERAL (SELECT (d.result).*) b;
+
+\if :{?query}
+\if :{?algorithm}
+\else
+\set algorithm default
+\endif
+SELECT 'query' AS distribution, :'algorithm' AS algorithm, b.*
+FROM pg_temp.ts_bench_compression((SELECT array_agg(v) FROM (:query) q(v)),
+    nullif(:'algorithm', 'default')::cstring, :iterations) b;
+\endif
@@ -0,0 +1,80 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.hll_sfunc(state INTERNAL, val ANYELEMENT)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_hll_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.hll_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_hll_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.hll_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'ts_hll_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.hll_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_hll_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.hll_finalfunc(state INTERNAL)
+RETURNS BIGINT
+AS '@MODULE_PATHNAME@', 'ts_hll_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_sfunc(state INTERNAL, val DOUBLE PRECISION, fraction DOUBLE PRECISION)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_finalfunc(state INTERNAL)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- The partial states of these aggregates are mergeable sketches, so they can be
+-- used with partial and parallel aggregation, and in continuous aggregates. Same
+-- as for histogram(), the serialized states must stay backwards compatible.
+
+-- Estimates the number of distinct not null values using a HyperLogLog sketch.
+CREATE OR REPLACE AGGREGATE @extschema@.approximate_count_distinct (ANYELEMENT) (
+    SFUNC = _timescaledb_functions.hll_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_functions.hll_combinefunc,
+    SERIALFUNC = _timescaledb_functions.hll_serializefunc,
+    DESERIALFUNC = _timescaledb_functions.hll_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_functions.hll_finalfunc
+);
+
+-- Estimates the value at the given fraction of the sorted not null values, with
+-- the relative error of at most 1%, using a DDSketch.
+CREATE OR REPLACE AGGREGATE @extschema@.approximate_percentile (DOUBLE PRECISION, DOUBLE PRECISION) (
+    SFUNC = _timescaledb_functions.ddsketch_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_functions.ddsketch_combinefunc,
+    SERIALFUNC = _timescaledb_functions.ddsketch_serializefunc,
+    DESERIALFUNC = _timescaledb_functions.ddsketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_functions.ddsketch_finalfunc
+);
@@ -18,6 +18,14 @@ CREATE OR REPLACE FUNCTION _timescaledb_functions.policy_reorder_check(config JS
 RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_reorder_check'
 LANGUAGE C;
 
+CREATE OR REPLACE PROCEDURE _timescaledb_functions.policy_precreate_chunks(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_precreate_chunks_proc'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.policy_precreate_chunks_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_precreate_chunks_check'
+LANGUAGE C;
+
 CREATE OR REPLACE PROCEDURE _timescaledb_functions.policy_recompression(job_id INTEGER, config JSONB)
 AS '@MODULE_PATHNAME@', 'ts_policy_recompression_proc'
 LANGUAGE C;
@@ -44,6 +44,16 @@ CREATE OR REPLACE FUNCTION _timescaledb_functions.compressed_data_has_nulls(_tim
     LANGUAGE C STRICT IMMUTABLE
     AS '@MODULE_PATHNAME@', 'ts_compressed_data_has_nulls';
 
+CREATE OR REPLACE FUNCTION _timescaledb_functions.bloom1_contains(bytea, anyelement)
+    RETURNS BOOL
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE
+    AS '@MODULE_PATHNAME@', 'ts_bloom1_contains';
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.bloom1_contains_any(bytea, anyarray)
+    RETURNS BOOL
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE
+    AS '@MODULE_PATHNAME@', 'ts_bloom1_contains_any';
+
 CREATE OR REPLACE FUNCTION _timescaledb_functions.dimension_info_in(cstring)
     RETURNS _timescaledb_internal.dimension_info
     LANGUAGE C STRICT IMMUTABLE
@@ -152,3 +152,18 @@ RETURNS TABLE (job_id INTEGER, schedule_interval INTERVAL, max_runtime INTERVAL,
 next_start TIMESTAMPTZ, check_config TEXT, fixed_schedule BOOL, initial_start TIMESTAMPTZ, timezone TEXT, application_name name)
 AS '@MODULE_PATHNAME@', 'ts_update_placeholder'
 LANGUAGE C VOLATILE;
+
+INSERT INTO _timescaledb_catalog.compression_algorithm( id, version, name, description) values
+( 7, 1, 'COMPRESSION_ALGORITHM_BITPACK', 'bitpack')
+;
+
+-- Bloom filter sparse index
+CREATE FUNCTION _timescaledb_functions.bloom1_contains(bytea, anyelement)
+    RETURNS BOOL
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE
+    AS '@MODULE_PATHNAME@', 'ts_update_placeholder';
+
+CREATE FUNCTION _timescaledb_functions.bloom1_contains_any(bytea, anyarray)
+    RETURNS BOOL
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE
+    AS '@MODULE_PATHNAME@', 'ts_update_placeholder';
@@ -310,3 +310,29 @@ RETURNS TABLE (job_id INTEGER, schedule_interval INTERVAL, max_runtime INTERVAL,
 next_start TIMESTAMPTZ, check_config TEXT, fixed_schedule BOOL, initial_start TIMESTAMPTZ, timezone TEXT)
 AS '@MODULE_PATHNAME@', 'ts_update_placeholder'
 LANGUAGE C VOLATILE;
+
+DELETE FROM _timescaledb_catalog.compression_algorithm WHERE id = 7 AND version = 1 AND name = 'COMPRESSION_ALGORITHM_BITPACK';
+
+DROP FUNCTION IF EXISTS _timescaledb_functions.bloom1_contains(bytea, anyelement);
+DROP FUNCTION IF EXISTS _timescaledb_functions.bloom1_contains_any(bytea, anyarray);
+
+-- Chunk pre-creation policy
+DELETE FROM _timescaledb_config.bgw_job WHERE proc_schema = '_timescaledb_functions' AND proc_name = 'policy_precreate_chunks';
+DROP FUNCTION IF EXISTS @extschema@.add_chunk_precreation_policy(REGCLASS, INTEGER, BOOL, INTERVAL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_chunk_precreation_policy(REGCLASS, BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_functions.policy_precreate_chunks(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_functions.policy_precreate_chunks_check(JSONB);
+
+-- Approximate aggregates
+DROP AGGREGATE IF EXISTS @extschema@.approximate_count_distinct(ANYELEMENT);
+DROP AGGREGATE IF EXISTS @extschema@.approximate_percentile(DOUBLE PRECISION, DOUBLE PRECISION);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_sfunc(INTERNAL, ANYELEMENT);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_combinefunc(INTERNAL, INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_serializefunc(INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_deserializefunc(BYTEA, INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_finalfunc(INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_sfunc(INTERNAL, DOUBLE PRECISION, DOUBLE PRECISION);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_combinefunc(INTERNAL, INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_serializefunc(INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_deserializefunc(BYTEA, INTERNAL);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_finalfunc(INTERNAL);
@@ -15,6 +15,7 @@
 #include <utils/lsyscache.h>
 #include <utils/syscache.h>
 
+#include "agg_bookend.h"
 #include "export.h"
 
 /* bookend aggregates first and last:
@@ -92,6 +93,20 @@ polydatum_serialize_type(StringInfo buf, Oid type_oid)
 	ReleaseSysCache(tup);
 }
 
+/* initializes the PolyDatumIOState used by polydatum_serialize for the given type */
+static void
+polydatum_init_send_state(PolyDatumIOState *state, const TypeInfoCache *type, MemoryContext mcxt)
+{
+	Oid func;
+	bool is_varlena;
+
+	state->type = *type;
+	Assert(OidIsValid(state->type.typoid));
+
+	getTypeBinaryOutputInfo(state->type.typoid, &func, &is_varlena);
+	fmgr_info_cxt(func, &state->proc, mcxt);
+}
+
 /* serializes the polydatum pd unto buf */
 static void
 polydatum_serialize(PolyDatum *pd, StringInfo buf, PolyDatumIOState *state, FunctionCallInfo fcinfo)
@@ -508,20 +523,12 @@ ts_bookend_serializefunc(PG_FUNCTION_ARGS)
 			MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(InternalCmpAggStoreIOState));
 		my_extra = (InternalCmpAggStoreIOState *) fcinfo->flinfo->fn_extra;
 
-		Oid func;
-		bool is_varlena;
-
-		my_extra->value.type = state->aggstate_type_cache.value_type_cache;
-		Assert(OidIsValid(my_extra->value.type.typoid));
-
-		getTypeBinaryOutputInfo(my_extra->value.type.typoid, &func, &is_varlena);
-		fmgr_info_cxt(func, &my_extra->value.proc, fcinfo->flinfo->fn_mcxt);
-
-		my_extra->cmp.type = state->aggstate_type_cache.cmp_type_cache;
-		Assert(OidIsValid(my_extra->cmp.type.typoid));
-
-		getTypeBinaryOutputInfo(my_extra->cmp.type.typoid, &func, &is_varlena);
-		fmgr_info_cxt(func, &my_extra->cmp.proc, fcinfo->flinfo->fn_mcxt);
+		polydatum_init_send_state(&my_extra->value,
+								  &state->aggstate_type_cache.value_type_cache,
+								  fcinfo->flinfo->fn_mcxt);
+		polydatum_init_send_state(&my_extra->cmp,
+								  &state->aggstate_type_cache.cmp_type_cache,
+								  fcinfo->flinfo->fn_mcxt);
 	}
 	pq_begintypsend(&buf);
 	polydatum_serialize(&state->value, &buf, &my_extra->value, fcinfo);
@@ -529,6 +536,36 @@ ts_bookend_serializefunc(PG_FUNCTION_ARGS)
 	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
+/*
+ * Serialize the partial state of first()/last() given by its value and
+ * comparison element, in the same format as ts_bookend_serializefunc. This is
+ * used by the vectorized implementation of these aggregates, which keeps its
+ * own state instead of InternalCmpAggStore.
+ */
+TSDLLEXPORT bytea *
+ts_bookend_serialize_values(Oid value_type, Datum value, bool value_isnull, Oid cmp_type,
+							Datum cmp, bool cmp_isnull)
+{
+	StringInfoData buf;
+	PolyDatumIOState value_io = { 0 };
+	PolyDatumIOState cmp_io = { 0 };
+	TypeInfoCache value_type_cache = { .typoid = value_type };
+	TypeInfoCache cmp_type_cache = { .typoid = cmp_type };
+	PolyDatum value_pd = { .is_null = value_isnull, .datum = value };
+	PolyDatum cmp_pd = { .is_null = cmp_isnull, .datum = cmp };
+
+	get_typlenbyval(value_type, &value_type_cache.typlen, &value_type_cache.typbyval);
+	get_typlenbyval(cmp_type, &cmp_type_cache.typlen, &cmp_type_cache.typbyval);
+
+	polydatum_init_send_state(&value_io, &value_type_cache, CurrentMemoryContext);
+	polydatum_init_send_state(&cmp_io, &cmp_type_cache, CurrentMemoryContext);
+
+	pq_begintypsend(&buf);
+	polydatum_serialize(&value_pd, &buf, &value_io, NULL);
+	polydatum_serialize(&cmp_pd, &buf, &cmp_io, NULL);
+	return pq_endtypsend(&buf);
+}
+
 /* ts_bookend_deserializefunc(bytea, internal) => internal */
 Datum
 ts_bookend_deserializefunc(PG_FUNCTION_ARGS)
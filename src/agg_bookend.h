@@ -0,0 +1,14 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include "export.h"
+
+extern TSDLLEXPORT bytea *ts_bookend_serialize_values(Oid value_type, Datum value,
+													  bool value_isnull, Oid cmp_type, Datum cmp,
+													  bool cmp_isnull);
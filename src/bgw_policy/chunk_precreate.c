@@ -0,0 +1,150 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Creation of chunks ahead of the inserts.
+ *
+ * An insert that doesn't find a chunk for its point has to create one. This
+ * takes a self-conflicting lock on the hypertable, and the collisions with the
+ * existing chunks are resolved while holding it. So at every chunk boundary,
+ * all concurrent writers of the hypertable wait for one chunk creation.
+ *
+ * The chunk pre-creation policy creates the chunks of the time ranges ahead
+ * of the current time in the background, so that the inserts find an
+ * existing chunk when they reach the boundary. For the closed dimensions,
+ * and any additional open dimensions, the partitions of the chunks in the
+ * current time range are used, so only the partitions that receive data get
+ * new chunks.
+ */
+#include <postgres.h>
+
+#include "chunk.h"
+#include "chunk_constraint.h"
+#include "chunk_precreate.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "dimension_vector.h"
+#include "hypercube.h"
+#include "hypertable.h"
+
+/*
+ * Get a coordinate inside the slice.
+ */
+static int64
+slice_coordinate(const Dimension *dim, const DimensionSlice *slice)
+{
+	if (slice->fd.range_start != DIMENSION_SLICE_MINVALUE)
+		return slice->fd.range_start;
+
+	/* The first slice of a closed dimension starts at -inf, but the hash values are non-negative */
+	return IS_OPEN_DIMENSION(dim) ? slice->fd.range_end - 1 : 0;
+}
+
+/*
+ * Get the points of the partitions to create the chunks for.
+ *
+ * The coordinates of the other dimensions are taken from the chunks in the
+ * most recent time range that starts at or before 'now'. The coordinate of
+ * the time dimension is set by the caller.
+ */
+static List *
+get_partition_points(const Hypertable *ht, const Dimension *time_dim, int64 now)
+{
+	const Hyperspace *hs = ht->space;
+	const DimensionSlice *current = NULL;
+	List *chunk_ids = NIL;
+	List *points = NIL;
+	ListCell *lc;
+
+	if (hs->num_dimensions == 1)
+	{
+		Point *p = ts_point_create(1);
+
+		p->num_coords = 1;
+		return list_make1(p);
+	}
+
+	/* The slices are sorted by range start */
+	DimensionVec *slices = ts_dimension_slice_scan_by_dimension(time_dim->fd.id, 0);
+
+	for (int i = 0; i < slices->num_slices && slices->slices[i]->fd.range_start <= now; i++)
+		current = slices->slices[i];
+
+	if (current == NULL)
+		return NIL;
+
+	ts_chunk_constraint_scan_by_dimension_slice_to_list(current, &chunk_ids, CurrentMemoryContext);
+
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+		Point *p;
+
+		if (chunk == NULL)
+			continue;
+
+		p = ts_point_create(hs->num_dimensions);
+		p->num_coords = hs->num_dimensions;
+
+		for (int i = 0; i < hs->num_dimensions; i++)
+		{
+			const Dimension *dim = &hs->dimensions[i];
+			const DimensionSlice *slice =
+				ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+			if (slice != NULL)
+				p->coordinates[i] = slice_coordinate(dim, slice);
+		}
+
+		points = lappend(points, p);
+	}
+
+	return points;
+}
+
+/*
+ * Create the chunks of the time range that contains 'now' and of the next
+ * 'chunks_ahead' time ranges, in each partition that receives data. The chunks
+ * that exist already are skipped.
+ *
+ * Returns the number of chunks created.
+ */
+int
+ts_bgw_policy_precreate_chunks(const Hypertable *ht, int64 now, int chunks_ahead)
+{
+	const Dimension *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	int time_index = time_dim - ht->space->dimensions;
+	List *points = get_partition_points(ht, time_dim, now);
+	int64 value = now;
+	int created = 0;
+
+	for (int i = 0; i <= chunks_ahead; i++)
+	{
+		DimensionSlice *slice = ts_dimension_calculate_default_slice(time_dim, value);
+		ListCell *lc;
+
+		foreach (lc, points)
+		{
+			Point *p = lfirst(lc);
+			bool found = true;
+
+			p->coordinates[time_index] = slice_coordinate(time_dim, slice);
+
+			if (ts_hypertable_find_chunk_for_point(ht, p) == NULL)
+				ts_hypertable_create_chunk_for_point(ht, p, &found);
+
+			if (!found)
+				created++;
+		}
+
+		if (slice->fd.range_end == DIMENSION_SLICE_MAXVALUE)
+			break;
+
+		value = slice->fd.range_end;
+	}
+
+	return created;
+}
@@ -0,0 +1,14 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include "export.h"
+#include "hypertable.h"
+
+extern TSDLLEXPORT int ts_bgw_policy_precreate_chunks(const Hypertable *ht, int64 now,
+													  int chunks_ahead);
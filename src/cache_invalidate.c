@@ -5,6 +5,7 @@
  */
 #include <postgres.h>
 #include <access/xact.h>
+#include <access/xlog.h>
 #include <catalog/namespace.h>
 #include <miscadmin.h>
 #include <nodes/nodes.h>
@@ -21,6 +22,8 @@
 #include "bgw/scheduler.h"
 #include "cache_invalidate.h"
 #include "cross_module_fn.h"
+#include "dimension_slice_index.h"
+#include "shared_chunk_cache.h"
 
 /*
  * Notes on the way cache invalidation works.
@@ -57,17 +60,21 @@ static inline void
 cache_invalidate_relcache_all(void)
 {
 	ts_hypertable_cache_invalidate_callback();
+	ts_dimension_slice_index_invalidate();
 	ts_bgw_job_cache_invalidate_callback();
 }
 
 static Oid hypertable_proxy_table_oid = InvalidOid;
 static Oid bgw_proxy_table_oid = InvalidOid;
+static Oid dimension_slice_table_oid = InvalidOid;
 
 void
-ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid)
+ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid,
+									 Oid dimension_slice_oid)
 {
 	hypertable_proxy_table_oid = hypertable_proxy_oid;
 	bgw_proxy_table_oid = bgw_proxy_oid;
+	dimension_slice_table_oid = dimension_slice_oid;
 }
 
 /*
@@ -84,21 +91,44 @@ cache_invalidate_relcache_callback(Datum arg, Oid relid)
 	if (!OidIsValid(relid))
 	{
 		cache_invalidate_relcache_all();
+
+		/*
+		 * On a standby, the invalidation of all relations might replace the
+		 * hypertable cache invalidation, see below.
+		 */
+		if (RecoveryInProgress())
+			ts_shared_chunk_cache_invalidate();
 	}
 	else if (ts_extension_is_proxy_table_relid(relid))
 	{
 		ts_extension_invalidate();
 		cache_invalidate_relcache_all();
-		ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid);
+		ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid, InvalidOid);
+		ts_shared_chunk_cache_invalidate();
 	}
 	else if (relid == hypertable_proxy_table_oid)
 	{
 		ts_hypertable_cache_invalidate_callback();
+		ts_dimension_slice_index_invalidate();
+
+		/*
+		 * The chunk metadata changes are replayed on a standby without running
+		 * the transaction callbacks that invalidate the shared chunk cache, so
+		 * we have to rely on the hypertable cache invalidation that is sent
+		 * for these changes.
+		 */
+		if (RecoveryInProgress())
+			ts_shared_chunk_cache_invalidate();
 	}
 	else if (relid == bgw_proxy_table_oid)
 	{
 		ts_bgw_job_cache_invalidate_callback();
 	}
+	else if (relid == dimension_slice_table_oid)
+	{
+		/* New slices were inserted, see ts_catalog_invalidate_cache() */
+		ts_dimension_slice_index_slices_added();
+	}
 }
 
 TS_FUNCTION_INFO_V1(ts_timescaledb_invalidate_cache);
@@ -135,6 +165,24 @@ cache_invalidate_xact_end(XactEvent event, void *arg)
 			 * backends cannot have the invalid state.
 			 */
 			cache_invalidate_relcache_all();
+			ts_shared_chunk_cache_xact_end(false);
+			break;
+		case XACT_EVENT_COMMIT:
+
+			/*
+			 * The shared chunk cache is invalidated after the changes to the
+			 * chunk metadata become visible to other backends.
+			 */
+			ts_shared_chunk_cache_xact_end(true);
+			break;
+		case XACT_EVENT_PREPARE:
+
+			/*
+			 * The changes of a prepared transaction become visible only at
+			 * COMMIT PREPARED, which invalidates the shared chunk cache
+			 * itself.
+			 */
+			ts_shared_chunk_cache_xact_prepare();
 			break;
 		default:
 			break;
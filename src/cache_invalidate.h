@@ -7,4 +7,5 @@
 
 #include <postgres.h>
 
-extern void ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid);
+extern void ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid,
+												 Oid dimension_slice_oid);
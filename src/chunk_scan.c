@@ -18,6 +18,7 @@
 #include "hypercube.h"
 #include "hypertable.h"
 #include "scan_iterator.h"
+#include "shared_chunk_cache.h"
 #include "utils.h"
 
 /*
@@ -49,6 +50,12 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 	Assert(OidIsValid(hs->main_table_relid));
 	MemoryContext orig_mcxt = MemoryContextSwitchTo(work_mcxt);
 
+	/*
+	 * The generation of the shared chunk cache has to be read before we scan
+	 * the metadata, see shared_chunk_cache.c.
+	 */
+	const uint64 cache_generation = ts_shared_chunk_cache_get_generation();
+
 	/*
 	 * For each matching chunk, fill in the metadata from the "chunk" table.
 	 * Make sure to filter out "dropped" chunks.
@@ -160,13 +167,23 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 
 	/*
 	 * Build hypercubes for the chunks by finding and combining the dimension
-	 * slices that match the chunk constraints.
+	 * slices that match the chunk constraints. The hypercubes that other
+	 * backends have already built are taken from the shared cache.
 	 */
+	const int num_cached = ts_shared_chunk_cache_lookup(cache_generation,
+														locked_chunks,
+														locked_chunk_count,
+														orig_mcxt);
 	ScanIterator slice_iterator = ts_dimension_slice_scan_iterator_create(NULL, orig_mcxt);
 	for (int chunk_index = 0; chunk_index < locked_chunk_count; chunk_index++)
 	{
 		Chunk *chunk = locked_chunks[chunk_index];
 		ChunkConstraints *constraints = chunk->constraints;
+
+		if (chunk->cube != NULL)
+		{
+			continue;
+		}
 		MemoryContextSwitchTo(orig_mcxt);
 		Hypercube *cube = ts_hypercube_alloc(constraints->num_dimension_constraints);
 		MemoryContextSwitchTo(work_mcxt);
@@ -214,6 +231,11 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 	}
 	ts_scan_iterator_close(&slice_iterator);
 
+	if (num_cached < locked_chunk_count)
+	{
+		ts_shared_chunk_cache_add(cache_generation, locked_chunks, locked_chunk_count);
+	}
+
 	Assert(CurrentMemoryContext == work_mcxt);
 	MemoryContextSwitchTo(orig_mcxt);
 	MemoryContextDelete(work_mcxt);
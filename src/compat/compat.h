@@ -511,6 +511,8 @@ RestrictSearchPath(void)
 
 /* This macro was renamed in PG17, see 414f6c0fb79a */
 #define WAIT_EVENT_MESSAGE_QUEUE_INTERNAL WAIT_EVENT_MQ_INTERNAL
+#define WAIT_EVENT_MESSAGE_QUEUE_RECEIVE WAIT_EVENT_MQ_RECEIVE
+#define WAIT_EVENT_MESSAGE_QUEUE_SEND WAIT_EVENT_MQ_SEND
 
 /* 'flush' argument was added in 173b56f1ef59 */
 #define LogLogicalMessageCompat(prefix, message, size, transactional, flush)                       \
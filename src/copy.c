@@ -18,6 +18,11 @@
  * insert our chunk dispatching. So, most of this code is a straight-up
  * copy of the regular PostgreSQL source code for the COPY command
  * (command/copy.c and command/copyfrom.c), albeit with minor modifications.
+ *
+ * The rows are routed and inserted in the backend that executes the COPY,
+ * because PostgreSQL does not allow parallel workers to insert tuples or to
+ * create chunks. With timescaledb.copy_parallel_workers, the conversion of
+ * the input values is done by parallel workers, see copy_parallel.c.
  */
 
 #include <postgres.h>
@@ -58,9 +63,12 @@
 
 #include "compat/compat.h"
 #include "copy.h"
+#include "copy_parallel.h"
 #include "cross_module_fn.h"
 #include "dimension.h"
+#include "guc.h"
 #include "hypertable.h"
+#include "indexing.h"
 #include "nodes/chunk_dispatch/chunk_dispatch.h"
 #include "nodes/chunk_dispatch/chunk_insert_state.h"
 #include "subspace_store.h"
@@ -77,13 +85,11 @@
 #define MAX_BUFFERED_TUPLES 1000
 
 /*
- * Flush buffers if there are >= this many bytes, as counted by the input
- * size, of tuples stored.
+ * Trim the list of buffers back down to at least this number after flushing.
+ * More buffers are kept if timescaledb.copy_buffer_memory allows it, see
+ * TSCopyMultiInsertInfoInit().
  */
-#define MAX_BUFFERED_BYTES 65535
-
-/* Trim the list of buffers back down to this number after flushing */
-#define MAX_PARTITION_BUFFERS 32
+#define MIN_PARTITION_BUFFERS 32
 
 /* Stores multi-insert data related to a single relation in CopyFrom. */
 typedef struct TSCopyMultiInsertBuffer
@@ -98,6 +104,12 @@ typedef struct TSCopyMultiInsertBuffer
 	Point *point;								/* The point in space of this buffer */
 	BulkInsertState bistate;					/* BulkInsertState for this buffer */
 	int nused;									/* number of 'slots' containing tuples */
+	int64 nbytes;								/* size of the tuples in 'slots' */
+	int32 chunk_id;								/* The chunk of this buffer */
+	bool compress;								/* compress into the compressed chunk */
+	uint64 period_tuples;						/* tuples stored in the current period */
+	double arrival_rate; /* share of the tuples routed to the chunk, see
+						  * TSCopyMultiInsertInfoUpdateArrivalRates() */
 	uint64 linenos[MAX_BUFFERED_TUPLES];		/* Line # of tuple in copy
 												 * stream */
 } TSCopyMultiInsertBuffer;
@@ -119,14 +131,34 @@ typedef struct TSCopyMultiInsertInfo
 	HTAB *multiInsertBuffers; /* Maps the chunk ids to the buffers (chunkid ->
 								 TSCopyMultiInsertBuffer) */
 	int bufferedTuples;		  /* number of tuples buffered over all buffers */
-	int bufferedBytes;		  /* number of bytes from all buffered tuples */
+	int64 bufferedBytes;	  /* number of bytes from all buffered tuples */
+	int64 memoryLimit;		  /* flush the buffers when they exceed this many bytes */
+	int maxBuffers;			  /* number of buffers to keep after flushing */
+	uint64 routedTuples;	  /* number of tuples stored in the buffers so far */
+	uint64 periodStart;		  /* routedTuples at the start of the current period */
+	CopyBufferStats stats;	  /* counters of this COPY */
 	CopyChunkState *ccstate;  /* Copy chunk state for this TSCopyMultiInsertInfo */
 	EState *estate;			  /* Executor state used for COPY */
 	CommandId mycid;		  /* Command Id used for COPY */
 	int ti_options;			  /* table insert options */
 	Hypertable *ht;			  /* The hypertable for the inserts */
+	bool compress_direct;	  /* Compress the rows of compressed chunks directly */
 } TSCopyMultiInsertInfo;
 
+/* Counters of all COPY commands of the backend */
+static CopyBufferStats buffer_stats = { 0 };
+
+CopyBufferStats
+ts_copy_get_buffer_stats(bool reset)
+{
+	CopyBufferStats result = buffer_stats;
+
+	if (reset)
+		memset(&buffer_stats, 0, sizeof(buffer_stats));
+
+	return result;
+}
+
 /*
  * The entry of the multiInsertBuffers HTAB.
  */
@@ -170,6 +202,7 @@ copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, Co
 	ccstate->scandesc = scandesc;
 	ccstate->next_copy_from = from_func;
 	ccstate->where_clause = NULL;
+	ccstate->parallel = NULL;
 
 	return ccstate;
 }
@@ -179,7 +212,7 @@ copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, Co
  * ResultRelInfo.
  */
 static TSCopyMultiInsertBuffer *
-TSCopyMultiInsertBufferInit(ChunkInsertState *cis, Point *point)
+TSCopyMultiInsertBufferInit(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cis, Point *point)
 {
 	TSCopyMultiInsertBuffer *buffer;
 
@@ -187,6 +220,23 @@ TSCopyMultiInsertBufferInit(ChunkInsertState *cis, Point *point)
 	memset((void *) buffer->slots, 0, sizeof(TupleTableSlot *) * MAX_BUFFERED_TUPLES);
 	buffer->bistate = GetBulkInsertState();
 	buffer->nused = 0;
+	buffer->nbytes = 0;
+	buffer->chunk_id = cis->chunk_id;
+	buffer->period_tuples = 0;
+	buffer->arrival_rate = 0;
+
+	/*
+	 * The rows for a compressed chunk can be compressed into new batches
+	 * directly, instead of being inserted into the uncompressed chunk and
+	 * recompressed later. This is not possible if the rows have to be checked
+	 * against the unique constraints, which requires decompressing the
+	 * conflicting batches, or passed to the AFTER ROW triggers of the chunk.
+	 */
+	buffer->compress =
+		miinfo->compress_direct && cis->chunk_compressed && !cis->use_tam &&
+		!(cis->result_relation_info->ri_TrigDesc &&
+		  cis->result_relation_info->ri_TrigDesc->trig_insert_after_row) &&
+		!ts_indexing_relation_has_primary_or_unique_index(cis->rel);
 
 	buffer->point = palloc(POINT_SIZE(point->num_coords));
 	memcpy(buffer->point, point, POINT_SIZE(point->num_coords));
@@ -226,9 +276,17 @@ TSCopyMultiInsertInfoGetOrSetupBuffer(TSCopyMultiInsertInfo *miinfo, ChunkInsert
 	/* No insert buffer for this chunk exists, create a new one */
 	if (!found)
 	{
-		entry->buffer = TSCopyMultiInsertBufferInit(cis, point);
+		entry->buffer = TSCopyMultiInsertBufferInit(miinfo, cis, point);
 	}
 
+	/*
+	 * The chunk insert state might have been closed and reopened since the
+	 * buffer was set up, so tell it again that the rows don't go to the
+	 * uncompressed chunk and the chunk doesn't become partial.
+	 */
+	if (entry->buffer->compress)
+		cis->compress_direct = true;
+
 	return entry->buffer;
 }
 
@@ -263,19 +321,47 @@ TSCopyMultiInsertInfoInit(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 	miinfo->mycid = mycid;
 	miinfo->ti_options = ti_options;
 	miinfo->ht = ht;
+	miinfo->memoryLimit = (int64) ts_guc_copy_buffer_memory * 1024L;
+	miinfo->routedTuples = 0;
+	miinfo->periodStart = 0;
+	memset(&miinfo->stats, 0, sizeof(miinfo->stats));
+
+	/*
+	 * Each buffer has a fixed size for the slot and line number arrays. Keep
+	 * as many buffers as fit into a quarter of the memory limit, so that the
+	 * tuples of hundreds of active chunks can be buffered with a large enough
+	 * limit.
+	 */
+	miinfo->maxBuffers =
+		Max(MIN_PARTITION_BUFFERS,
+			(int) (miinfo->memoryLimit / (4 * (int64) sizeof(TSCopyMultiInsertBuffer))));
+
+	/*
+	 * Whether the rows for compressed chunks can be compressed directly is
+	 * decided per chunk when its buffer is set up, see
+	 * TSCopyMultiInsertBufferInit().
+	 */
+	miinfo->compress_direct = ts_guc_enable_direct_compress_copy &&
+							  ts_cm_functions->compress_batches_for_insert != NULL &&
+							  !(rri->ri_TrigDesc && rri->ri_TrigDesc->trig_insert_after_row);
 }
 
 /*
- * Returns true if the buffers are full.
+ * Returns true if the buffers use up the memory limit.
  */
 static inline bool
 TSCopyMultiInsertInfoIsFull(TSCopyMultiInsertInfo *miinfo)
 {
-	if (miinfo->bufferedTuples >= MAX_BUFFERED_TUPLES ||
-		miinfo->bufferedBytes >= MAX_BUFFERED_BYTES)
-		return true;
+	return miinfo->bufferedBytes >= miinfo->memoryLimit;
+}
 
-	return false;
+/*
+ * Returns true if the buffer has no free slots left.
+ */
+static inline bool
+TSCopyMultiInsertBufferIsFull(TSCopyMultiInsertBuffer *buffer)
+{
+	return buffer->nused >= MAX_BUFFERED_TUPLES;
 }
 
 /*
@@ -290,12 +376,22 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 	Assert(miinfo != NULL);
 	Assert(buffer != NULL);
 
+	/* Don't reopen the chunk if there is nothing to write */
+	if (buffer->nused == 0)
+		return buffer->chunk_id;
+
 	EState *estate = miinfo->estate;
 	CommandId mycid = miinfo->mycid;
 	int ti_options = miinfo->ti_options;
 	int nused = buffer->nused;
 	TupleTableSlot **slots = buffer->slots;
 
+	miinfo->stats.flushes++;
+	miinfo->stats.tuples_flushed += nused;
+	miinfo->bufferedTuples -= nused;
+	miinfo->bufferedBytes -= buffer->nbytes;
+	buffer->nbytes = 0;
+
 	/*
 	 * table_multi_insert and reinitialization of the chunk insert state may
 	 * leak memory, so switch to short-lived memory context before calling it.
@@ -337,13 +433,30 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 		cstate->line_buf_valid = false;
 	}
 
-	table_multi_insert(resultRelInfo->ri_RelationDesc,
-					   slots,
-					   nused,
-					   mycid,
-					   ti_options,
-					   buffer->bistate);
-	MemoryContextSwitchTo(oldcontext);
+	if (buffer->compress)
+	{
+		/*
+		 * The rows are not in the uncompressed chunk, so there are no index
+		 * entries to insert, and there are no AFTER ROW triggers.
+		 */
+		cis->compress_direct = true;
+		ts_cm_functions->compress_batches_for_insert(cis, slots, nused);
+		MemoryContextSwitchTo(oldcontext);
+
+		for (i = 0; i < nused; i++)
+			ExecClearTuple(slots[i]);
+		nused = 0;
+	}
+	else
+	{
+		table_multi_insert(resultRelInfo->ri_RelationDesc,
+						   slots,
+						   nused,
+						   mycid,
+						   ti_options,
+						   buffer->bistate);
+		MemoryContextSwitchTo(oldcontext);
+	}
 
 	for (i = 0; i < nused; i++)
 	{
@@ -437,88 +550,168 @@ TSCopyMultiInsertBufferCleanup(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertB
 	pfree(buffer);
 }
 
-/* list_sort comparator to sort TSCopyMultiInsertBuffer by usage */
+/* list_sort comparator to sort TSCopyMultiInsertBuffer by size, largest first */
 static int
-TSCmpBuffersByUsage(const ListCell *a, const ListCell *b)
+TSCmpBuffersBySize(const ListCell *a, const ListCell *b)
 {
-	int b1 = ((const TSCopyMultiInsertBuffer *) lfirst(a))->nused;
-	int b2 = ((const TSCopyMultiInsertBuffer *) lfirst(b))->nused;
+	int64 b1 = ((const TSCopyMultiInsertBuffer *) lfirst(a))->nbytes;
+	int64 b2 = ((const TSCopyMultiInsertBuffer *) lfirst(b))->nbytes;
 
 	Assert(b1 >= 0);
 	Assert(b2 >= 0);
 
 	if (b1 > b2)
-	{
-		return 1;
-	}
+		return -1;
 
 	if (b1 == b2)
-	{
 		return 0;
-	}
+
+	return 1;
+}
+
+/*
+ * list_sort comparator to sort TSCopyMultiInsertBuffer for flushing some of
+ * them. The buffers that are compressed directly go last, because their rows
+ * end up in compressed batches of the same size, which should be close to the
+ * target batch size of 1000 rows. The other buffers go by size, largest first.
+ */
+static int
+TSCmpBuffersForFlush(const ListCell *a, const ListCell *b)
+{
+	bool c1 = ((const TSCopyMultiInsertBuffer *) lfirst(a))->compress;
+	bool c2 = ((const TSCopyMultiInsertBuffer *) lfirst(b))->compress;
+
+	if (c1 != c2)
+		return c1 ? 1 : -1;
+
+	return TSCmpBuffersBySize(a, b);
+}
+
+/* list_sort comparator to sort TSCopyMultiInsertBuffer by arrival rate */
+static int
+TSCmpBuffersByArrivalRate(const ListCell *a, const ListCell *b)
+{
+	double r1 = ((const TSCopyMultiInsertBuffer *) lfirst(a))->arrival_rate;
+	double r2 = ((const TSCopyMultiInsertBuffer *) lfirst(b))->arrival_rate;
+
+	if (r1 > r2)
+		return 1;
+
+	if (r1 == r2)
+		return 0;
 
 	return -1;
 }
 
 /*
- * Flush all buffers by writing the tuples to the chunks. In addition, trim down the
- * amount of multi-insert buffers to MAX_PARTITION_BUFFERS by deleting the least used
- * buffers (the buffers that store least tuples).
+ * Update the arrival rates of the buffers at the end of a period between two
+ * flushes.
+ *
+ * The arrival rate of a buffer is the share of the tuples routed to its chunk,
+ * averaged over the periods with exponentially decreasing weights. Unlike the
+ * number of buffered tuples, which is zero for all buffers right after a
+ * flush, it tells the chunks that keep receiving tuples apart from the ones
+ * that were only used for a while, e.g., because the input moved on to the
+ * next time range.
+ */
+static void
+TSCopyMultiInsertInfoUpdateArrivalRates(TSCopyMultiInsertInfo *miinfo, List *buffer_list)
+{
+	uint64 period_tuples = miinfo->routedTuples - miinfo->periodStart;
+	ListCell *lc;
+
+	if (period_tuples == 0)
+		return;
+
+	foreach (lc, buffer_list)
+	{
+		TSCopyMultiInsertBuffer *buffer = (TSCopyMultiInsertBuffer *) lfirst(lc);
+		double period_rate = (double) buffer->period_tuples / period_tuples;
+
+		buffer->arrival_rate = (buffer->arrival_rate + period_rate) / 2;
+		buffer->period_tuples = 0;
+	}
+
+	miinfo->periodStart = miinfo->routedTuples;
+}
+
+/*
+ * Flush the buffers by writing the tuples to the chunks. In addition, trim down
+ * the amount of multi-insert buffers to maxBuffers by deleting the buffers with
+ * the lowest arrival rate.
+ *
+ * If 'all' is false, only the largest buffers are flushed until at most half of
+ * the memory limit is used. The chunks that receive many tuples are then
+ * written in large batches, while the buffers of the other chunks keep
+ * collecting tuples instead of being flushed in small batches each time the
+ * limit is reached. The buffers that are compressed directly are flushed only
+ * if this is not enough, see TSCmpBuffersForFlush().
  */
 static inline void
-TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_cis)
+TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_cis, bool all)
 {
 	HASH_SEQ_STATUS status;
 	MultiInsertBufferEntry *entry;
-	int current_multi_insert_buffers;
 	int buffers_to_delete;
 	bool found;
-	int32 flushed_chunk_id;
 	List *buffer_list = NIL;
 	ListCell *lc;
 
-	current_multi_insert_buffers = hash_get_num_entries(miinfo->multiInsertBuffers);
-
-	/* Create a list of buffers that can be sorted by usage */
+	/* Create a list of buffers that can be sorted */
 	hash_seq_init(&status, miinfo->multiInsertBuffers);
 	for (entry = hash_seq_search(&status); entry != NULL; entry = hash_seq_search(&status))
 	{
 		buffer_list = lappend(buffer_list, entry->buffer);
 	}
 
-	buffers_to_delete = Max(current_multi_insert_buffers - MAX_PARTITION_BUFFERS, 0);
+	TSCopyMultiInsertInfoUpdateArrivalRates(miinfo, buffer_list);
 
-	/* Sorting is only needed if we want to remove the least used buffers */
-	if (buffers_to_delete > 0)
-		list_sort(buffer_list, TSCmpBuffersByUsage);
+	if (!all)
+		list_sort(buffer_list, TSCmpBuffersForFlush);
 
-	/* Flush buffers and delete them if needed */
 	foreach (lc, buffer_list)
 	{
 		TSCopyMultiInsertBuffer *buffer = (TSCopyMultiInsertBuffer *) lfirst(lc);
-		flushed_chunk_id = TSCopyMultiInsertBufferFlush(miinfo, buffer);
 
-		if (buffers_to_delete > 0)
+		if (!all && miinfo->bufferedBytes <= miinfo->memoryLimit / 2)
+			break;
+
+		TSCopyMultiInsertBufferFlush(miinfo, buffer);
+	}
+
+	buffers_to_delete = list_length(buffer_list) - miinfo->maxBuffers;
+
+	if (buffers_to_delete > 0)
+	{
+		list_sort(buffer_list, TSCmpBuffersByArrivalRate);
+
+		foreach (lc, buffer_list)
 		{
+			TSCopyMultiInsertBuffer *buffer = (TSCopyMultiInsertBuffer *) lfirst(lc);
+			int32 chunk_id = buffer->chunk_id;
+
+			if (buffers_to_delete == 0)
+				break;
+
 			/*
 			 * Reduce active multi-insert buffers. However, the current used buffer
 			 * should not be deleted because it might reused for the next insert.
 			 */
-			if (cur_cis == NULL || flushed_chunk_id != cur_cis->chunk_id)
-			{
-				TSCopyMultiInsertBufferCleanup(miinfo, buffer);
-				hash_search(miinfo->multiInsertBuffers, &flushed_chunk_id, HASH_REMOVE, &found);
-				Assert(found);
-				buffers_to_delete--;
-			}
+			if (cur_cis != NULL && chunk_id == cur_cis->chunk_id)
+				continue;
+
+			TSCopyMultiInsertBufferFlush(miinfo, buffer);
+			TSCopyMultiInsertBufferCleanup(miinfo, buffer);
+			hash_search(miinfo->multiInsertBuffers, &chunk_id, HASH_REMOVE, &found);
+			Assert(found);
+			miinfo->stats.evictions++;
+			buffers_to_delete--;
 		}
 	}
 
 	list_free(buffer_list);
 
-	/* All buffers have been flushed */
-	miinfo->bufferedTuples = 0;
-	miinfo->bufferedBytes = 0;
+	Assert(!all || (miinfo->bufferedTuples == 0 && miinfo->bufferedBytes == 0));
 }
 
 /*
@@ -529,8 +722,6 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 static inline void
 TSCopyMultiInsertInfoFlushAndCleanup(TSCopyMultiInsertInfo *miinfo)
 {
-	TSCopyMultiInsertInfoFlush(miinfo, NULL);
-
 	HASH_SEQ_STATUS status;
 	MultiInsertBufferEntry *entry;
 
@@ -539,10 +730,24 @@ TSCopyMultiInsertInfoFlushAndCleanup(TSCopyMultiInsertInfo *miinfo)
 	for (entry = hash_seq_search(&status); entry != NULL; entry = hash_seq_search(&status))
 	{
 		TSCopyMultiInsertBuffer *buffer = entry->buffer;
+		TSCopyMultiInsertBufferFlush(miinfo, buffer);
 		TSCopyMultiInsertBufferCleanup(miinfo, buffer);
 	}
 
 	hash_destroy(miinfo->multiInsertBuffers);
+
+	ereport(DEBUG2,
+			(errmsg("flushed " INT64_FORMAT " batches of %.1f tuples on average, "
+					"evicted " INT64_FORMAT " buffers",
+					miinfo->stats.flushes,
+					miinfo->stats.flushes > 0 ?
+						(double) miinfo->stats.tuples_flushed / miinfo->stats.flushes :
+						0.0,
+					miinfo->stats.evictions)));
+
+	buffer_stats.flushes += miinfo->stats.flushes;
+	buffer_stats.tuples_flushed += miinfo->stats.tuples_flushed;
+	buffer_stats.evictions += miinfo->stats.evictions;
 }
 
 /*
@@ -596,20 +801,29 @@ TSCopyMultiInsertInfoStore(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 
 	/* Record this slot as being used */
 	buffer->nused++;
+	buffer->period_tuples++;
 
 	/* Update how many tuples are stored and their size */
 	miinfo->bufferedTuples++;
+	miinfo->routedTuples++;
 
 	/*
 	 * Note: There is no reliable way to determine the in-memory size of a virtual
-	 * tuple. So, we perform flushing in PG < 14 only based on the number of buffered
-	 * tuples and not based on the size.
+	 * tuple. So, the size is estimated by the length of the input line. When
+	 * migrating data, there is no input line, and we use the size of the
+	 * materialized heap tuple, or the size of the values for other slot types.
 	 */
+	int tuplen;
+
 	if (cstate != NULL)
-	{
-		int tuplen = cstate->line_buf.len;
-		miinfo->bufferedBytes += tuplen;
-	}
+		tuplen = cstate->line_buf.len;
+	else if (TTS_IS_HEAPTUPLE(slot) || TTS_IS_BUFFERTUPLE(slot))
+		tuplen = ((HeapTupleTableSlot *) slot)->tuple->t_len;
+	else
+		tuplen = slot->tts_tupleDescriptor->natts * sizeof(Datum);
+
+	buffer->nbytes += tuplen;
+	miinfo->bufferedBytes += tuplen;
 }
 
 static void
@@ -951,7 +1165,7 @@ copyfrom(CopyChunkState *ccstate, ParseState *pstate, Hypertable *ht, MemoryCont
 			 * batching, so rows are visible to triggers etc.
 			 */
 			if (insertMethod == CIM_MULTI_CONDITIONAL)
-				TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis);
+				TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis, true);
 
 			currentTupleInsertMethod = CIM_SINGLE;
 		}
@@ -1087,17 +1301,23 @@ copyfrom(CopyChunkState *ccstate, ParseState *pstate, Hypertable *ht, MemoryCont
 										   ccstate->cstate);
 
 				/*
-				 * If enough inserts have queued up, then flush all
-				 * buffers out to their tables.
+				 * Write out the buffer of the chunk as soon as it has a full
+				 * batch. If enough inserts have queued up over all buffers,
+				 * flush the largest buffers out to their tables.
 				 */
-				if (TSCopyMultiInsertInfoIsFull(&multiInsertInfo))
+				if (TSCopyMultiInsertBufferIsFull(buffer))
+				{
+					TSCopyMultiInsertBufferFlush(&multiInsertInfo, buffer);
+				}
+				else if (TSCopyMultiInsertInfoIsFull(&multiInsertInfo))
 				{
 					ereport(DEBUG2,
-							(errmsg("flush called with %d bytes and %d buffered tuples",
+							(errmsg("flush called with " INT64_FORMAT
+									" bytes and %d buffered tuples",
 									multiInsertInfo.bufferedBytes,
 									multiInsertInfo.bufferedTuples)));
 
-					TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis);
+					TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis, false);
 				}
 			}
 
@@ -1368,9 +1588,18 @@ timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *proces
 
 	ccstate = copy_chunk_state_create(ht, rel, next_copy_from, cstate, NULL);
 	ccstate->where_clause = where_clause;
+
+	if (ts_copy_parallel_possible(stmt, rel, attnums))
+	{
+		ccstate->parallel = ts_copy_parallel_begin(cstate, rel, attnums);
+		ccstate->next_copy_from = ts_copy_parallel_next;
+	}
+
 	copycontext = cstate->copycontext;
 	*processed = copyfrom(ccstate, pstate, ht, copycontext, CopyFromErrorCallback, cstate);
 
+	if (ccstate->parallel != NULL)
+		ts_copy_parallel_end(ccstate->parallel);
 	copy_chunk_state_destroy(ccstate);
 	EndCopyFrom(cstate);
 	free_parsestate(pstate);
@@ -13,8 +13,11 @@
 #include <nodes/parsenodes.h>
 #include <storage/lockdefs.h>
 
+#include "export.h"
+
 typedef struct ChunkDispatch ChunkDispatch;
 typedef struct CopyChunkState CopyChunkState;
+typedef struct CopyParallelState CopyParallelState;
 typedef struct Hypertable Hypertable;
 
 typedef bool (*CopyFromFunc)(CopyChunkState *ccstate, ExprContext *econtext, Datum *values,
@@ -29,8 +32,17 @@ typedef struct CopyChunkState
 	CopyFromState cstate;
 	TableScanDesc scandesc;
 	Node *where_clause;
+	CopyParallelState *parallel; /* the parallel COPY, if used */
 } CopyChunkState;
 
+typedef struct CopyBufferStats
+{
+	int64 flushes;		  /* batches written to the chunks */
+	int64 tuples_flushed; /* tuples in these batches */
+	int64 evictions;	  /* buffers freed before the end of the COPY */
+} CopyBufferStats;
+
 extern void timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *processed,
 							   Hypertable *ht);
 extern void timescaledb_move_from_table_to_chunks(Hypertable *ht, LOCKMODE lockmode);
+extern TSDLLEXPORT CopyBufferStats ts_copy_get_buffer_stats(bool reset);
@@ -0,0 +1,741 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Parallel conversion of the COPY input.
+ *
+ * PostgreSQL does not allow the parallel workers to insert tuples or to write
+ * the catalog, which is needed to create chunks. So the COPY into a hypertable
+ * still routes and inserts the rows in the backend that executes it, but the
+ * conversion of the input values by the type input functions, which is a
+ * large part of the work, is done by the parallel workers.
+ *
+ * The leader reads the input and splits it into lines and fields. It sends
+ * the fields to the workers in batches, round-robin, and the workers send the
+ * converted rows back. The leader receives the rows of the batches in the
+ * order it sent them, so the rows are inserted in the input order and the
+ * triggers and constraints see them as in the serial COPY.
+ *
+ * The leader can't modify anything while the workers are running, so the
+ * input is converted in segments. The converted rows of a segment are kept in
+ * a tuplestore, and the leader inserts them after the workers of the segment
+ * have finished.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/parallel.h>
+#include <access/xact.h>
+#include <catalog/pg_proc.h>
+#include <commands/copyfrom_internal.h>
+#include <commands/defrem.h>
+#include <executor/executor.h>
+#include <executor/tuptable.h>
+#include <lib/stringinfo.h>
+#include <mb/pg_wchar.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <storage/latch.h>
+#include <storage/proc.h>
+#include <storage/shm_mq.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/tuplestore.h>
+
+#include "copy_parallel.h"
+
+#include "compat/compat.h"
+#include "config.h"
+#include "extension_constants.h"
+#include "guc.h"
+
+#define PARALLEL_KEY_COPY_SHARED UINT64CONST(0xC0B9000000000001)
+#define PARALLEL_KEY_COPY_QUEUES UINT64CONST(0xC0B9000000000002)
+
+/*
+ * The size of the queues for sending the input fields to a worker and the
+ * converted rows back to the leader.
+ */
+#define PARALLEL_COPY_QUEUE_SIZE (64 * 1024)
+
+/* The limits of a batch of input lines sent to a worker. */
+#define PARALLEL_COPY_BATCH_ROWS 1000
+#define PARALLEL_COPY_BATCH_SIZE (32 * 1024)
+
+/* Longer values are cut in the error context, like in the PostgreSQL COPY. */
+#define MAX_COPY_DATA_DISPLAY 100
+
+typedef struct CopyParallelShared
+{
+	Oid relid;
+	/* The number of the planned workers, for finding the queues. */
+	int nworkers;
+	int nfields;
+	AttrNumber attnums[FLEXIBLE_ARRAY_MEMBER];
+} CopyParallelShared;
+
+struct CopyParallelState
+{
+	CopyFromState cstate;
+	Relation rel;
+	List *attnums;
+	int nworkers;
+	MemoryContext mcxt;
+
+	/* No workers were available, so the rest of the input is copied serially. */
+	bool serial;
+	bool input_done;
+
+	/*
+	 * The line number of the last line read. The line number of the copy state
+	 * is set to the current row instead, for the error context.
+	 */
+	uint64 read_lineno;
+
+	/* The converted rows of the current segment, and the line of the next one. */
+	Tuplestorestate *rows;
+	TupleTableSlot *slot;
+	uint64 next_lineno;
+
+	/* The batch of input lines being sent to a worker. */
+	StringInfoData batch;
+	int batch_rows;
+};
+
+/*
+ * Converts the input fields to the values of a row, in a worker.
+ */
+typedef struct CopyConverter
+{
+	Relation rel;
+	int nfields;
+	AttrNumber *attnums;
+	FmgrInfo *in_functions;
+	Oid *typioparams;
+
+	/* The field being converted, for the error context. */
+	uint64 lineno;
+	int field;
+	const char *value;
+} CopyConverter;
+
+static Size
+copy_parallel_shared_size(int nfields)
+{
+	return add_size(offsetof(CopyParallelShared, attnums),
+					mul_size(sizeof(AttrNumber), nfields));
+}
+
+/*
+ * The input queue of worker i is at position i, and its output queue at
+ * position nworkers + i.
+ */
+static shm_mq *
+copy_parallel_queue_get(char *queue_space, int nworkers, int worker, bool output)
+{
+	const int position = output ? nworkers + worker : worker;
+	return (shm_mq *) (queue_space + position * PARALLEL_COPY_QUEUE_SIZE);
+}
+
+bool
+ts_copy_parallel_possible(const CopyStmt *stmt, Relation rel, List *attnums)
+{
+	ListCell *lc;
+
+	if (ts_guc_copy_parallel_workers <= 0 || IsInParallelMode())
+		return false;
+
+	foreach (lc, stmt->options)
+	{
+		DefElem *defel = lfirst_node(DefElem, lc);
+
+		/* The leader can only split the text and CSV formats into fields. */
+		if (strcmp(defel->defname, "format") == 0 && strcmp(defGetString(defel), "binary") == 0)
+			return false;
+
+		/* These options change the conversion of the fields. */
+		if (strcmp(defel->defname, "force_not_null") == 0 ||
+			strcmp(defel->defname, "force_null") == 0 || strcmp(defel->defname, "default") == 0 ||
+			strcmp(defel->defname, "on_error") == 0)
+			return false;
+	}
+
+	/* The input functions run in the workers. */
+	foreach (lc, attnums)
+	{
+		Form_pg_attribute attr =
+			TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(lfirst_int(lc)));
+		Oid in_func_oid;
+		Oid typioparam;
+
+		getTypeInputInfo(attr->atttypid, &in_func_oid, &typioparam);
+		if (func_parallel(in_func_oid) != PROPARALLEL_SAFE)
+			return false;
+	}
+
+	return true;
+}
+
+CopyParallelState *
+ts_copy_parallel_begin(CopyFromState cstate, Relation rel, List *attnums)
+{
+	CopyParallelState *cps = palloc0(sizeof(CopyParallelState));
+	MemoryContext oldcontext;
+
+	cps->cstate = cstate;
+	cps->rel = rel;
+	cps->attnums = attnums;
+	cps->nworkers = ts_guc_copy_parallel_workers;
+	cps->mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "COPY parallel", ALLOCSET_DEFAULT_SIZES);
+
+	oldcontext = MemoryContextSwitchTo(cps->mcxt);
+	cps->rows = tuplestore_begin_heap(false, false, maintenance_work_mem);
+	cps->slot = MakeSingleTupleTableSlot(RelationGetDescr(rel), &TTSOpsMinimalTuple);
+	initStringInfo(&cps->batch);
+	MemoryContextSwitchTo(oldcontext);
+
+	elog(DEBUG1,
+		 "using %d parallel workers to convert the COPY input for \"%s\"",
+		 cps->nworkers,
+		 RelationGetRelationName(rel));
+
+	return cps;
+}
+
+void
+ts_copy_parallel_end(CopyParallelState *cps)
+{
+	ExecDropSingleTupleTableSlot(cps->slot);
+	tuplestore_end(cps->rows);
+	MemoryContextDelete(cps->mcxt);
+}
+
+/*
+ * Read the next batch of input lines and split them into fields. The checks
+ * of the number of fields are the same as in NextCopyFrom(). Returns the
+ * number of lines read.
+ */
+static int
+copy_parallel_read_batch(CopyParallelState *cps)
+{
+	CopyFromState cstate = cps->cstate;
+	const int nfields = list_length(cps->attnums);
+	uint64 first_lineno = 0;
+
+	resetStringInfo(&cps->batch);
+	appendBinaryStringInfo(&cps->batch, (char *) &first_lineno, sizeof(first_lineno));
+	cps->batch_rows = 0;
+
+	cstate->cur_lineno = cps->read_lineno;
+
+	while (cps->batch_rows < PARALLEL_COPY_BATCH_ROWS &&
+		   cps->batch.len < PARALLEL_COPY_BATCH_SIZE)
+	{
+		char **fields;
+		int fldct;
+
+		if (!NextCopyFromRawFields(cstate, &fields, &fldct))
+		{
+			cps->input_done = true;
+			break;
+		}
+
+		if (cps->batch_rows == 0)
+		{
+			first_lineno = cstate->cur_lineno;
+			memcpy(cps->batch.data, &first_lineno, sizeof(first_lineno));
+		}
+
+		if (nfields > 0 && fldct > nfields)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("extra data after last expected column")));
+
+		if (fldct < nfields)
+		{
+			Form_pg_attribute attr =
+				TupleDescAttr(RelationGetDescr(cps->rel),
+							  AttrNumberGetAttrOffset(list_nth_int(cps->attnums, fldct)));
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("missing data for column \"%s\"", NameStr(attr->attname))));
+		}
+
+		for (int i = 0; i < nfields; i++)
+		{
+			/* The length includes the terminating zero, so the worker can use the string. */
+			int32 len = fields[i] == NULL ? -1 : strlen(fields[i]) + 1;
+
+			appendBinaryStringInfo(&cps->batch, (char *) &len, sizeof(len));
+			if (len > 0)
+				appendBinaryStringInfo(&cps->batch, fields[i], len);
+		}
+
+		cps->batch_rows++;
+	}
+
+	cps->read_lineno = cstate->cur_lineno;
+
+	return cps->batch_rows;
+}
+
+/*
+ * Check the workers for errors when a queue is detached unexpectedly. This
+ * rethrows the error of the worker, if there is one.
+ */
+static void
+copy_parallel_worker_lost(ParallelContext *pcxt)
+{
+	WaitForParallelWorkersToFinish(pcxt);
+	ereport(ERROR,
+			(errcode(ERRCODE_INTERNAL_ERROR),
+			 errmsg("lost connection to the parallel worker converting the COPY input")));
+}
+
+/*
+ * Convert the next segment of the input using the parallel workers, and
+ * store the converted rows in the tuplestore.
+ */
+static void
+copy_parallel_convert_segment(CopyParallelState *cps)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(cps->mcxt);
+	const int nfields = list_length(cps->attnums);
+	const Size segment_size = (Size) maintenance_work_mem * 1024L;
+	ParallelContext *pcxt;
+	CopyParallelShared *shared;
+	char *queue_space;
+	shm_mq_handle **input_queues;
+	shm_mq_handle **output_queues;
+	List *batch_rows = NIL;
+	int batches_sent = 0;
+	int batches_received = 0;
+	int rows_left = 0;
+	Size segment_bytes = 0;
+	bool segment_done = false;
+	bool pending = false;
+	int nworkers;
+
+	EnterParallelMode();
+
+	pcxt = CreateParallelContext(EXTENSION_VERSIONED_SO,
+								 "ts_copy_parallel_worker_main",
+								 cps->nworkers);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, copy_parallel_shared_size(nfields));
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(PARALLEL_COPY_QUEUE_SIZE, mul_size(2, cps->nworkers)));
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = shm_toc_allocate(pcxt->toc, copy_parallel_shared_size(nfields));
+	shared->relid = RelationGetRelid(cps->rel);
+	shared->nworkers = cps->nworkers;
+	shared->nfields = nfields;
+	for (int i = 0; i < nfields; i++)
+		shared->attnums[i] = list_nth_int(cps->attnums, i);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COPY_SHARED, shared);
+
+	queue_space =
+		shm_toc_allocate(pcxt->toc, mul_size(PARALLEL_COPY_QUEUE_SIZE, mul_size(2, cps->nworkers)));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COPY_QUEUES, queue_space);
+
+	input_queues = palloc(sizeof(shm_mq_handle *) * cps->nworkers);
+	output_queues = palloc(sizeof(shm_mq_handle *) * cps->nworkers);
+	for (int i = 0; i < cps->nworkers; i++)
+	{
+		shm_mq *mq = shm_mq_create(copy_parallel_queue_get(queue_space, cps->nworkers, i, false),
+								   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		input_queues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+
+		mq = shm_mq_create(copy_parallel_queue_get(queue_space, cps->nworkers, i, true),
+						   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_receiver(mq, MyProc);
+		output_queues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+
+	LaunchParallelWorkers(pcxt);
+	nworkers = pcxt->nworkers_launched;
+
+	if (nworkers == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+
+		elog(DEBUG1,
+			 "no parallel workers available, converting the rest of the COPY input for \"%s\" "
+			 "serially",
+			 RelationGetRelationName(cps->rel));
+
+		cps->serial = true;
+		cps->cstate->cur_lineno = cps->read_lineno;
+		MemoryContextSwitchTo(oldcontext);
+		return;
+	}
+
+	/* Detect the workers that failed to start. */
+	for (int i = 0; i < nworkers; i++)
+	{
+		shm_mq_set_handle(input_queues[i], pcxt->worker[i].bgwhandle);
+		shm_mq_set_handle(output_queues[i], pcxt->worker[i].bgwhandle);
+	}
+
+	cps->next_lineno = 0;
+
+	for (;;)
+	{
+		bool progress = false;
+
+		if (!pending && !segment_done)
+		{
+			if (copy_parallel_read_batch(cps) > 0)
+			{
+				if (cps->next_lineno == 0)
+					memcpy(&cps->next_lineno, cps->batch.data, sizeof(cps->next_lineno));
+
+				segment_bytes += cps->batch.len;
+				pending = true;
+			}
+
+			segment_done = cps->input_done || segment_bytes >= segment_size;
+		}
+
+		/*
+		 * Don't wait for the workers to read their queues, because they might be
+		 * waiting for us to read the converted rows.
+		 */
+		if (pending)
+		{
+			shm_mq_result result = shm_mq_send(input_queues[batches_sent % nworkers],
+											   cps->batch.len,
+											   cps->batch.data,
+											   /* nowait = */ true,
+											   /* force_flush = */ true);
+			if (result == SHM_MQ_DETACHED)
+				copy_parallel_worker_lost(pcxt);
+
+			if (result == SHM_MQ_SUCCESS)
+			{
+				batch_rows = lappend_int(batch_rows, cps->batch_rows);
+				batches_sent++;
+				pending = false;
+				progress = true;
+			}
+		}
+
+		/* Receive the rows of the batches in the order they were sent. */
+		while (batches_received < batches_sent)
+		{
+			Size nbytes;
+			void *data;
+			shm_mq_result result = shm_mq_receive(output_queues[batches_received % nworkers],
+												  &nbytes,
+												  &data,
+												  /* nowait = */ true);
+			if (result == SHM_MQ_WOULD_BLOCK)
+				break;
+
+			if (result == SHM_MQ_DETACHED)
+				copy_parallel_worker_lost(pcxt);
+
+			if (rows_left == 0)
+				rows_left = list_nth_int(batch_rows, batches_received);
+
+			ExecStoreMinimalTuple((MinimalTuple) data, cps->slot, /* shouldFree = */ false);
+			tuplestore_puttupleslot(cps->rows, cps->slot);
+
+			if (--rows_left == 0)
+				batches_received++;
+
+			progress = true;
+		}
+
+		if (segment_done && !pending && batches_received == batches_sent)
+			break;
+
+		if (!progress)
+		{
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 0,
+							 WAIT_EVENT_MESSAGE_QUEUE_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+
+		/* This also rethrows the errors from the workers. */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/* The workers finish when their input queue is detached. */
+	for (int i = 0; i < nworkers; i++)
+		shm_mq_detach(input_queues[i]);
+
+	WaitForParallelWorkersToFinish(pcxt);
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	list_free(batch_rows);
+	pfree(input_queues);
+	pfree(output_queues);
+	ExecClearTuple(cps->slot);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Compute the defaults for the columns that are not in the input, like
+ * NextCopyFrom() does.
+ */
+static void
+copy_parallel_eval_defaults(CopyFromState cstate, ExprContext *econtext, Datum *values,
+							bool *nulls)
+{
+	for (int i = 0; i < cstate->num_defaults; i++)
+	{
+		const int attoff = cstate->defmap[i];
+#if PG16_LT
+		ExprState *defexpr = cstate->defexprs[i];
+#else
+		ExprState *defexpr = cstate->defexprs[attoff];
+#endif
+
+		values[attoff] = ExecEvalExpr(defexpr, econtext, &nulls[attoff]);
+	}
+}
+
+/*
+ * Get the next row of the COPY input. This is the CopyFromFunc of the
+ * parallel COPY.
+ */
+bool
+ts_copy_parallel_next(CopyChunkState *ccstate, ExprContext *econtext, Datum *values, bool *nulls)
+{
+	CopyParallelState *cps = ccstate->parallel;
+	CopyFromState cstate = cps->cstate;
+
+	for (;;)
+	{
+		if (cps->serial)
+			return NextCopyFrom(cstate, econtext, values, nulls);
+
+		if (tuplestore_gettupleslot(cps->rows, true, true, cps->slot))
+		{
+			const int natts = RelationGetDescr(cps->rel)->natts;
+
+			slot_getallattrs(cps->slot);
+			memcpy(values, cps->slot->tts_values, sizeof(Datum) * natts);
+			memcpy(nulls, cps->slot->tts_isnull, sizeof(bool) * natts);
+
+			/*
+			 * The line buffer holds a later line, so the error context only shows
+			 * the line number of the row.
+			 */
+			cstate->cur_lineno = cps->next_lineno++;
+			cstate->line_buf_valid = false;
+			cstate->cur_attname = NULL;
+			cstate->cur_attval = NULL;
+
+			copy_parallel_eval_defaults(cstate, econtext, values, nulls);
+			return true;
+		}
+
+		if (cps->input_done)
+			return false;
+
+		tuplestore_clear(cps->rows);
+		copy_parallel_convert_segment(cps);
+	}
+}
+
+static void
+copy_converter_init(CopyConverter *conv, Relation rel, int nfields, AttrNumber *attnums)
+{
+	conv->rel = rel;
+	conv->nfields = nfields;
+	conv->attnums = attnums;
+	conv->in_functions = palloc(sizeof(FmgrInfo) * nfields);
+	conv->typioparams = palloc(sizeof(Oid) * nfields);
+	conv->lineno = 0;
+	conv->field = -1;
+	conv->value = NULL;
+
+	for (int i = 0; i < nfields; i++)
+	{
+		Form_pg_attribute attr =
+			TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attnums[i]));
+		Oid in_func_oid;
+
+		getTypeInputInfo(attr->atttypid, &in_func_oid, &conv->typioparams[i]);
+		fmgr_info(in_func_oid, &conv->in_functions[i]);
+	}
+}
+
+/*
+ * Convert the fields of the next row of a batch. Returns the position of the
+ * row after it.
+ */
+static char *
+copy_converter_convert_row(CopyConverter *conv, char *pos, Datum *values, bool *nulls)
+{
+	TupleDesc tupdesc = RelationGetDescr(conv->rel);
+
+	memset(values, 0, sizeof(Datum) * tupdesc->natts);
+	memset(nulls, true, sizeof(bool) * tupdesc->natts);
+
+	for (int i = 0; i < conv->nfields; i++)
+	{
+		const int attoff = AttrNumberGetAttrOffset(conv->attnums[i]);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attoff);
+		char *string = NULL;
+		int32 len;
+
+		memcpy(&len, pos, sizeof(len));
+		pos += sizeof(len);
+		if (len >= 0)
+		{
+			string = pos;
+			pos += len;
+			nulls[attoff] = false;
+		}
+
+		conv->field = i;
+		conv->value = string;
+		values[attoff] = InputFunctionCall(&conv->in_functions[i],
+										   string,
+										   conv->typioparams[i],
+										   attr->atttypmod);
+	}
+
+	conv->field = -1;
+	conv->value = NULL;
+
+	return pos;
+}
+
+static void
+copy_converter_error_callback(void *arg)
+{
+	CopyConverter *conv = (CopyConverter *) arg;
+	const char *relname = RelationGetRelationName(conv->rel);
+
+	if (conv->field < 0)
+	{
+		errcontext("COPY %s, line " UINT64_FORMAT, relname, conv->lineno);
+		return;
+	}
+
+	Form_pg_attribute attr =
+		TupleDescAttr(RelationGetDescr(conv->rel),
+					  AttrNumberGetAttrOffset(conv->attnums[conv->field]));
+
+	if (conv->value == NULL)
+	{
+		errcontext("COPY %s, line " UINT64_FORMAT ", column %s: null input",
+				   relname,
+				   conv->lineno,
+				   NameStr(attr->attname));
+		return;
+	}
+
+	const int len = strlen(conv->value);
+	char *value = (char *) conv->value;
+	if (len > MAX_COPY_DATA_DISPLAY)
+	{
+		const int cliplen = pg_mbcliplen(conv->value, len, MAX_COPY_DATA_DISPLAY);
+		value = psprintf("%.*s...", cliplen, conv->value);
+	}
+
+	errcontext("COPY %s, line " UINT64_FORMAT ", column %s: \"%s\"",
+			   relname,
+			   conv->lineno,
+			   NameStr(attr->attname),
+			   value);
+}
+
+void
+ts_copy_parallel_worker_main(dsm_segment *seg, shm_toc *toc)
+{
+	CopyParallelShared *shared = shm_toc_lookup(toc, PARALLEL_KEY_COPY_SHARED, false);
+	char *queue_space = shm_toc_lookup(toc, PARALLEL_KEY_COPY_QUEUES, false);
+	shm_mq *input =
+		copy_parallel_queue_get(queue_space, shared->nworkers, ParallelWorkerNumber, false);
+	shm_mq *output =
+		copy_parallel_queue_get(queue_space, shared->nworkers, ParallelWorkerNumber, true);
+	shm_mq_handle *input_queue;
+	shm_mq_handle *output_queue;
+	MemoryContext rowcontext;
+	CopyConverter conv;
+	ErrorContextCallback errcallback;
+	Relation rel;
+	TupleDesc tupdesc;
+	Datum *values;
+	bool *nulls;
+
+	shm_mq_set_receiver(input, MyProc);
+	input_queue = shm_mq_attach(input, seg, NULL);
+	shm_mq_set_sender(output, MyProc);
+	output_queue = shm_mq_attach(output, seg, NULL);
+
+	/* The leader holds a stronger lock, it doesn't conflict in the lock group. */
+	rel = table_open(shared->relid, AccessShareLock);
+	tupdesc = RelationGetDescr(rel);
+	copy_converter_init(&conv, rel, shared->nfields, shared->attnums);
+
+	values = palloc(sizeof(Datum) * tupdesc->natts);
+	nulls = palloc(sizeof(bool) * tupdesc->natts);
+	rowcontext = AllocSetContextCreate(CurrentMemoryContext, "COPY row", ALLOCSET_DEFAULT_SIZES);
+
+	errcallback.callback = copy_converter_error_callback;
+	errcallback.arg = &conv;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	for (;;)
+	{
+		Size nbytes;
+		void *data;
+		char *pos;
+		char *end;
+
+		/* The leader detaches when there are no more batches. */
+		if (shm_mq_receive(input_queue, &nbytes, &data, /* nowait = */ false) != SHM_MQ_SUCCESS)
+			break;
+
+		memcpy(&conv.lineno, data, sizeof(conv.lineno));
+		pos = (char *) data + sizeof(conv.lineno);
+		end = (char *) data + nbytes;
+
+		while (pos < end)
+		{
+			MemoryContext oldcontext = MemoryContextSwitchTo(rowcontext);
+			MinimalTuple tuple;
+
+			pos = copy_converter_convert_row(&conv, pos, values, nulls);
+			tuple = heap_form_minimal_tuple(tupdesc, values, nulls);
+
+			/* The leader waits for the last row of the batch, so we flush it. */
+			if (shm_mq_send(output_queue,
+							tuple->t_len,
+							tuple,
+							/* nowait = */ false,
+							/* force_flush = */ pos >= end) != SHM_MQ_SUCCESS)
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("could not send the converted row to the parallel leader")));
+
+			MemoryContextSwitchTo(oldcontext);
+			MemoryContextReset(rowcontext);
+			conv.lineno++;
+		}
+	}
+
+	error_context_stack = errcallback.previous;
+
+	table_close(rel, AccessShareLock);
+	shm_mq_detach(output_queue);
+	shm_mq_detach(input_queue);
+}
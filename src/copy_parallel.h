@@ -0,0 +1,24 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <commands/copy.h>
+#include <nodes/parsenodes.h>
+#include <storage/dsm.h>
+#include <storage/shm_toc.h>
+#include <utils/rel.h>
+
+#include "copy.h"
+
+extern bool ts_copy_parallel_possible(const CopyStmt *stmt, Relation rel, List *attnums);
+extern CopyParallelState *ts_copy_parallel_begin(CopyFromState cstate, Relation rel,
+												 List *attnums);
+extern bool ts_copy_parallel_next(CopyChunkState *ccstate, ExprContext *econtext, Datum *values,
+								  bool *nulls);
+extern void ts_copy_parallel_end(CopyParallelState *cps);
+
+extern PGDLLEXPORT void ts_copy_parallel_worker_main(dsm_segment *seg, shm_toc *toc);
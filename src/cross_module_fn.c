@@ -35,6 +35,10 @@ CROSSMODULE_WRAPPER(policy_reorder_add);
 CROSSMODULE_WRAPPER(policy_reorder_proc);
 CROSSMODULE_WRAPPER(policy_reorder_check);
 CROSSMODULE_WRAPPER(policy_reorder_remove);
+CROSSMODULE_WRAPPER(policy_precreate_chunks_add);
+CROSSMODULE_WRAPPER(policy_precreate_chunks_proc);
+CROSSMODULE_WRAPPER(policy_precreate_chunks_check);
+CROSSMODULE_WRAPPER(policy_precreate_chunks_remove);
 CROSSMODULE_WRAPPER(policy_retention_add);
 CROSSMODULE_WRAPPER(policy_retention_proc);
 CROSSMODULE_WRAPPER(policy_retention_check);
@@ -69,6 +73,8 @@ CROSSMODULE_WRAPPER(compressed_data_in);
 CROSSMODULE_WRAPPER(compressed_data_out);
 CROSSMODULE_WRAPPER(compressed_data_info);
 CROSSMODULE_WRAPPER(compressed_data_has_nulls);
+CROSSMODULE_WRAPPER(bloom1_contains);
+CROSSMODULE_WRAPPER(bloom1_contains_any);
 CROSSMODULE_WRAPPER(deltadelta_compressor_append);
 CROSSMODULE_WRAPPER(deltadelta_compressor_finish);
 CROSSMODULE_WRAPPER(gorilla_compressor_append);
@@ -361,6 +367,10 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.policy_reorder_proc = error_no_default_fn_pg_community,
 	.policy_reorder_check = error_no_default_fn_pg_community,
 	.policy_reorder_remove = error_no_default_fn_pg_community,
+	.policy_precreate_chunks_add = error_no_default_fn_pg_community,
+	.policy_precreate_chunks_proc = error_no_default_fn_pg_community,
+	.policy_precreate_chunks_check = error_no_default_fn_pg_community,
+	.policy_precreate_chunks_remove = error_no_default_fn_pg_community,
 	.policy_retention_add = error_no_default_fn_pg_community,
 	.policy_retention_proc = error_no_default_fn_pg_community,
 	.policy_retention_check = error_no_default_fn_pg_community,
@@ -403,6 +413,8 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	/* compression */
 	.compressed_data_send = error_no_default_fn_pg_community,
 	.compressed_data_recv = error_no_default_fn_pg_community,
+	.bloom1_contains = error_no_default_fn_pg_community,
+	.bloom1_contains_any = error_no_default_fn_pg_community,
 	.compressed_data_in = process_compressed_data_in,
 	.compressed_data_out = process_compressed_data_out,
 	.process_compress_table = process_compress_table_default,
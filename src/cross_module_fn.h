@@ -50,6 +50,10 @@ typedef struct CrossModuleFunctions
 	PGFunction policy_reorder_proc;
 	PGFunction policy_reorder_check;
 	PGFunction policy_reorder_remove;
+	PGFunction policy_precreate_chunks_add;
+	PGFunction policy_precreate_chunks_proc;
+	PGFunction policy_precreate_chunks_check;
+	PGFunction policy_precreate_chunks_remove;
 	PGFunction policy_retention_add;
 	PGFunction policy_retention_proc;
 	PGFunction policy_retention_check;
@@ -123,6 +127,8 @@ typedef struct CrossModuleFunctions
 	PGFunction compressed_data_out;
 	PGFunction compressed_data_info;
 	PGFunction compressed_data_has_nulls;
+	PGFunction bloom1_contains;
+	PGFunction bloom1_contains_any;
 	bool (*process_compress_table)(Hypertable *ht, WithClauseResult *with_clause_options);
 	void (*process_altertable_cmd)(Hypertable *ht, const AlterTableCmd *cmd);
 	void (*process_rename_cmd)(Oid relid, Cache *hcache, const RenameStmt *stmt);
@@ -130,6 +136,8 @@ typedef struct CrossModuleFunctions
 	PGFunction compress_chunk;
 	PGFunction decompress_chunk;
 	void (*decompress_batches_for_insert)(const ChunkInsertState *state, TupleTableSlot *slot);
+	void (*compress_batches_for_insert)(const ChunkInsertState *state, TupleTableSlot **slots,
+										int nslots);
 	bool (*decompress_target_segments)(ModifyHypertableState *ht_state);
 	int (*hypercore_decompress_update_segment)(Relation relation, const ItemPointer ctid,
 											   TupleTableSlot *slot, Snapshot snapshot,
@@ -0,0 +1,427 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <libpq/pqformat.h>
+#include <math.h>
+
+#include "ddsketch.h"
+#include "export.h"
+
+/* aggregate approximate_percentile:
+ *	 approximate_percentile(value, fraction) returns the estimated value at the
+ *	 given fraction of the sorted not null values
+ *
+ * Usage:
+ *	 SELECT device_id, approximate_percentile(temperature, 0.99) FROM table GROUP BY device_id;
+ *
+ * Description:
+ * Unlike percentile_disc(), this aggregate doesn't sort the input, but counts
+ * the values in a DDSketch, which can be merged. So it supports partial and
+ * parallel aggregation, and can be used in continuous aggregates. The result
+ * is within 1% of the exact percentile_disc() result. The fraction is stored
+ * in the sketch, and must be the same for all rows.
+ */
+
+TS_FUNCTION_INFO_V1(ts_ddsketch_sfunc);
+TS_FUNCTION_INFO_V1(ts_ddsketch_combinefunc);
+TS_FUNCTION_INFO_V1(ts_ddsketch_serializefunc);
+TS_FUNCTION_INFO_V1(ts_ddsketch_deserializefunc);
+TS_FUNCTION_INFO_V1(ts_ddsketch_finalfunc);
+
+/*
+ * Version of the serialized state, so that we can change the state and still
+ * accept the states materialized in continuous aggregates.
+ */
+#define DDSKETCH_SERIALIZATION_VERSION 1
+
+#define DDSKETCH_INITIAL_BINS 32
+
+#define DDSKETCH_GAMMA                                                                             \
+	((1.0 + TS_DDSKETCH_RELATIVE_ACCURACY) / (1.0 - TS_DDSKETCH_RELATIVE_ACCURACY))
+
+TSDLLEXPORT void
+ts_ddsketch_init(DDSketch *sketch, double fraction)
+{
+	memset(sketch, 0, sizeof(*sketch));
+	sketch->fraction = fraction;
+}
+
+static void
+ddsketch_check_fraction(double fraction)
+{
+	/* Written this way to also reject NaN. */
+	if (!(fraction >= 0 && fraction <= 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1", fraction)));
+}
+
+/*
+ * Change the range of the bins to [lo, hi], which must include the current
+ * highest bin. If the range is too wide, the lowest bins are collapsed into
+ * the lowest remaining one.
+ */
+static void
+ddsketch_store_extend(DDSketchStore *store, int32 lo, int32 hi)
+{
+	if ((int64) hi - lo + 1 > TS_DDSKETCH_MAX_BINS)
+		lo = hi - TS_DDSKETCH_MAX_BINS + 1;
+
+	const int32 nbins = hi - lo + 1;
+	if (nbins > store->capacity)
+	{
+		const int32 capacity = Min(Max(nbins, store->capacity * 2), TS_DDSKETCH_MAX_BINS);
+		store->bins = repalloc(store->bins, sizeof(*store->bins) * capacity);
+		store->capacity = capacity;
+	}
+
+	const int32 old_lo = store->offset;
+	const int32 old_hi = store->offset + store->nbins - 1;
+	Assert(old_hi <= hi);
+
+	int64 collapsed = 0;
+	for (int32 index = old_lo; index <= old_hi && index < lo; index++)
+		collapsed += store->bins[index - old_lo];
+
+	const int32 start = Max(lo, old_lo);
+	if (start <= old_hi)
+	{
+		memmove(&store->bins[start - lo],
+				&store->bins[start - old_lo],
+				sizeof(*store->bins) * (old_hi - start + 1));
+		memset(store->bins, 0, sizeof(*store->bins) * (start - lo));
+		memset(&store->bins[old_hi - lo + 1], 0, sizeof(*store->bins) * (hi - old_hi));
+	}
+	else
+	{
+		memset(store->bins, 0, sizeof(*store->bins) * nbins);
+	}
+
+	store->bins[0] += collapsed;
+	store->offset = lo;
+	store->nbins = nbins;
+}
+
+static void
+ddsketch_store_add(DDSketchStore *store, int32 index, int64 count)
+{
+	if (store->nbins == 0)
+	{
+		if (store->capacity == 0)
+		{
+			store->bins = palloc(sizeof(*store->bins) * DDSKETCH_INITIAL_BINS);
+			store->capacity = DDSKETCH_INITIAL_BINS;
+		}
+		store->offset = index;
+		store->nbins = 1;
+		store->bins[0] = count;
+		return;
+	}
+
+	const int32 hi = store->offset + store->nbins - 1;
+	if (index < store->offset || index > hi)
+		ddsketch_store_extend(store, Min(index, store->offset), Max(index, hi));
+
+	/* The index might be below the collapsed bins. */
+	index = Max(index, store->offset);
+	store->bins[index - store->offset] += count;
+}
+
+/*
+ * Add a value to the sketch. The bins are allocated in the current memory
+ * context, which must be the same for all calls.
+ */
+TSDLLEXPORT void
+ts_ddsketch_add(DDSketch *sketch, double value)
+{
+	static double log_gamma = 0;
+	if (log_gamma == 0)
+		log_gamma = log(DDSKETCH_GAMMA);
+
+	if (isnan(value) || isinf(value))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("approximate_percentile does not support NaN or infinite values")));
+
+	sketch->count++;
+
+	if (value == 0)
+	{
+		sketch->zero_count++;
+		return;
+	}
+
+	const int32 index = (int32) ceil(log(fabs(value)) / log_gamma);
+	ddsketch_store_add(value > 0 ? &sketch->positive : &sketch->negative, index, 1);
+}
+
+static void
+ddsketch_merge(DDSketch *sketch, const DDSketch *other)
+{
+	if (sketch->fraction != other->fraction)
+		elog(ERROR, "percentile value must not change between calls");
+
+	sketch->count += other->count;
+	sketch->zero_count += other->zero_count;
+
+	for (int32 i = 0; i < other->positive.nbins; i++)
+	{
+		if (other->positive.bins[i] != 0)
+			ddsketch_store_add(&sketch->positive,
+							   other->positive.offset + i,
+							   other->positive.bins[i]);
+	}
+
+	for (int32 i = 0; i < other->negative.nbins; i++)
+	{
+		if (other->negative.bins[i] != 0)
+			ddsketch_store_add(&sketch->negative,
+							   other->negative.offset + i,
+							   other->negative.bins[i]);
+	}
+}
+
+/* The representative value of a bin, which has the same relative error to both bin bounds. */
+static double
+ddsketch_bin_value(int32 index)
+{
+	return 2.0 * pow(DDSKETCH_GAMMA, index) / (DDSKETCH_GAMMA + 1.0);
+}
+
+static double
+ddsketch_quantile(const DDSketch *sketch)
+{
+	Assert(sketch->count > 0);
+	const double rank = sketch->fraction * (sketch->count - 1);
+	int64 seen = 0;
+
+	/* The negative values in the order of decreasing absolute value. */
+	for (int32 i = sketch->negative.nbins - 1; i >= 0; i--)
+	{
+		seen += sketch->negative.bins[i];
+		if (seen > rank)
+			return -ddsketch_bin_value(sketch->negative.offset + i);
+	}
+
+	seen += sketch->zero_count;
+	if (seen > rank)
+		return 0;
+
+	for (int32 i = 0; i < sketch->positive.nbins; i++)
+	{
+		seen += sketch->positive.bins[i];
+		if (seen > rank)
+			return ddsketch_bin_value(sketch->positive.offset + i);
+	}
+
+	/* Can't get here unless the counts are inconsistent. */
+	elog(ERROR, "invalid approximate_percentile state");
+	pg_unreachable();
+}
+
+static void
+ddsketch_store_serialize(StringInfo buf, const DDSketchStore *store)
+{
+	pq_sendint32(buf, store->offset);
+	pq_sendint32(buf, store->nbins);
+	for (int32 i = 0; i < store->nbins; i++)
+		pq_sendint64(buf, store->bins[i]);
+}
+
+/*
+ * Serialize the sketch. This is also used by the vectorized implementation of
+ * the aggregate, which keeps its own state.
+ */
+TSDLLEXPORT bytea *
+ts_ddsketch_serialize(const DDSketch *sketch)
+{
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, DDSKETCH_SERIALIZATION_VERSION);
+	pq_sendfloat8(&buf, sketch->fraction);
+	pq_sendint64(&buf, sketch->count);
+	pq_sendint64(&buf, sketch->zero_count);
+	ddsketch_store_serialize(&buf, &sketch->positive);
+	ddsketch_store_serialize(&buf, &sketch->negative);
+
+	return pq_endtypsend(&buf);
+}
+
+static void
+ddsketch_store_deserialize(StringInfo buf, DDSketchStore *store)
+{
+	const int32 offset = pq_getmsgint(buf, 4);
+	const int32 nbins = pq_getmsgint(buf, 4);
+
+	if (nbins < 0 || nbins > TS_DDSKETCH_MAX_BINS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid number of bins %d in approximate_percentile state", nbins)));
+
+	if (nbins == 0)
+		return;
+
+	store->offset = offset;
+	store->nbins = nbins;
+	store->capacity = Max(nbins, DDSKETCH_INITIAL_BINS);
+	store->bins = palloc(sizeof(*store->bins) * store->capacity);
+	for (int32 i = 0; i < nbins; i++)
+		store->bins[i] = pq_getmsgint64(buf);
+}
+
+/* approximate_percentile(state, value, fraction) */
+Datum
+ts_ddsketch_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_ddsketch_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(2))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("percentile value must not be null")));
+
+	const double fraction = PG_GETARG_FLOAT8(2);
+
+	if (PG_ARGISNULL(1))
+	{
+		/* Null values are not counted. */
+		if (state == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state);
+	}
+
+	MemoryContext old = MemoryContextSwitchTo(aggcontext);
+
+	if (state == NULL)
+	{
+		ddsketch_check_fraction(fraction);
+		state = palloc(sizeof(DDSketch));
+		ts_ddsketch_init(state, fraction);
+	}
+	else if (state->fraction != fraction)
+		elog(ERROR, "percentile value must not change between calls");
+
+	ts_ddsketch_add(state, PG_GETARG_FLOAT8(1));
+
+	MemoryContextSwitchTo(old);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ts_ddsketch_combinefunc(internal, internal) => internal */
+Datum
+ts_ddsketch_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state1 = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	DDSketch *state2 = (DDSketch *) (PG_ARGISNULL(1) ? NULL : PG_GETARG_POINTER(1));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_ddsketch_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state1);
+	}
+
+	MemoryContext old = MemoryContextSwitchTo(aggcontext);
+
+	if (state1 == NULL)
+	{
+		state1 = palloc(sizeof(DDSketch));
+		ts_ddsketch_init(state1, state2->fraction);
+	}
+
+	ddsketch_merge(state1, state2);
+
+	MemoryContextSwitchTo(old);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* ts_ddsketch_serializefunc(internal) => bytea */
+Datum
+ts_ddsketch_serializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+	DDSketch *state = (DDSketch *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(ts_ddsketch_serialize(state));
+}
+
+/* ts_ddsketch_deserializefunc(bytea *, internal) => internal */
+Datum
+ts_ddsketch_deserializefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	StringInfoData buf;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "ts_ddsketch_deserializefunc called in non-aggregate context");
+
+	Assert(!PG_ARGISNULL(0));
+	bytea *serialized = PG_GETARG_BYTEA_P(0);
+
+	buf.data = VARDATA(serialized);
+	buf.len = VARSIZE(serialized) - VARHDRSZ;
+	buf.maxlen = VARSIZE(serialized) - VARHDRSZ;
+	buf.cursor = 0;
+
+	const int version = pq_getmsgbyte(&buf);
+	if (version != DDSKETCH_SERIALIZATION_VERSION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("unsupported approximate_percentile state version %d", version)));
+
+	MemoryContext old = MemoryContextSwitchTo(aggcontext);
+
+	DDSketch *state = palloc(sizeof(DDSketch));
+	ts_ddsketch_init(state, pq_getmsgfloat8(&buf));
+	state->count = pq_getmsgint64(&buf);
+	state->zero_count = pq_getmsgint64(&buf);
+	ddsketch_store_deserialize(&buf, &state->positive);
+	ddsketch_store_deserialize(&buf, &state->negative);
+	pq_getmsgend(&buf);
+
+	MemoryContextSwitchTo(old);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ts_ddsketch_finalfunc(internal) => double precision */
+Datum
+ts_ddsketch_finalfunc(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_ddsketch_finalfunc called in non-aggregate context");
+	}
+
+	DDSketch *state = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	/* Same as percentile_disc(), the result is null when there are no values. */
+	if (state == NULL || state->count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(ddsketch_quantile(state));
+}
@@ -0,0 +1,47 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include "export.h"
+
+/*
+ * DDSketch quantile sketch used by approximate_percentile(). The values are
+ * counted in logarithmic bins, so that any quantile is estimated with the
+ * relative error of at most TS_DDSKETCH_RELATIVE_ACCURACY, as long as the
+ * number of bins doesn't exceed TS_DDSKETCH_MAX_BINS. After that, the bins
+ * closest to zero are collapsed together.
+ */
+#define TS_DDSKETCH_RELATIVE_ACCURACY 0.01
+#define TS_DDSKETCH_MAX_BINS 2048
+
+/*
+ * Dense range of bins for either positive or negative values. The bin with
+ * index k counts the values with absolute value in (gamma^(k-1), gamma^k].
+ */
+typedef struct DDSketchStore
+{
+	int32 offset; /* Index of the first bin. */
+	int32 nbins;
+	int32 capacity;
+	int64 *bins;
+} DDSketchStore;
+
+typedef struct DDSketch
+{
+	/* The quantile we compute, given as the constant argument of the aggregate. */
+	double fraction;
+
+	int64 count;
+	int64 zero_count;
+	DDSketchStore positive;
+	DDSketchStore negative;
+} DDSketch;
+
+extern TSDLLEXPORT void ts_ddsketch_init(DDSketch *sketch, double fraction);
+extern TSDLLEXPORT void ts_ddsketch_add(DDSketch *sketch, double value);
+extern TSDLLEXPORT bytea *ts_ddsketch_serialize(const DDSketch *sketch);
@@ -0,0 +1,524 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/xlog.h>
+#include <storage/lmgr.h>
+#include <utils/fmgroids.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+
+#include "dimension_slice.h"
+#include "dimension_slice_index.h"
+#include "dimension_vector.h"
+#include "scan_iterator.h"
+#include "ts_catalog/catalog.h"
+
+/*
+ * In-memory index of the dimension slices of a dimension.
+ *
+ * Chunk exclusion has to find the slices that overlap the restricted range of
+ * each dimension. The btree index on (dimension_id, range_start, range_end)
+ * can only use one of the range bounds, so e.g. a restriction on the recent
+ * time range has to scan the slices of all older chunks as well. With tens of
+ * thousands of chunks this dominates the planning time.
+ *
+ * Instead, we keep the slices of a dimension in an array sorted by the range
+ * start, augmented with the running maximum of the range end. The slices that
+ * start before the upper bound of the restriction form a prefix of the array,
+ * and the slices that might end after its lower bound form a suffix, because
+ * the running maximum is monotonic. Both are found by binary search, so a
+ * lookup is O(log n + k), where k is the number of matching slices plus the
+ * number of overlapping slices that have to be skipped, which is small because
+ * the slices of a dimension rarely overlap. This is the flattened form of an
+ * augmented interval tree.
+ *
+ * The indexes are built on first use and discarded together with the
+ * hypertable cache, which is invalidated by the updates and deletes of the
+ * dimension slices. The inserts for new chunks only send a relcache
+ * invalidation of the dimension_slice table, and the new slices are added to
+ * the loaded indexes in place, so that creating a chunk doesn't make every
+ * backend rescan all slices of the dimension. We process the pending
+ * invalidations before each lookup, so that the slices committed by the
+ * concurrent transactions are seen the same way as with the catalog scan.
+ *
+ * To find the new slices, we remember the slice id up to which all slices are
+ * in the indexes, and scan the slices with the larger ids. The ids are
+ * allocated before the inserts commit, so a slice with a smaller id might
+ * still be in flight. We advance the remembered id only when no transaction
+ * holds a lock that allows inserting into dimension_slice, and otherwise scan
+ * from the old one again at the next insert. The slices that are found more
+ * than once are skipped. On a standby we can't take that lock, so there the
+ * indexes are rebuilt after every insert like the other caches.
+ */
+
+typedef struct SliceIndexEntry
+{
+	int64 range_start;
+	int64 range_end;
+	int64 max_range_end; /* maximum range_end of this and preceding entries */
+	int32 slice_id;
+} SliceIndexEntry;
+
+typedef struct DimensionSliceIndex
+{
+	int32 dimension_id; /* hash key */
+	int num_entries;
+	int max_entries;
+	SliceIndexEntry *entries;
+} DimensionSliceIndex;
+
+static MemoryContext slice_index_mcxt = NULL;
+static HTAB *slice_indexes = NULL;
+
+/*
+ * The generation is incremented on invalidation, and the indexes are discarded
+ * when it differs from the generation they were built at. We don't reset the
+ * memory in the invalidation callback itself, because it might be called while
+ * an index is in use.
+ */
+static uint64 invalidation_generation = 0;
+static uint64 slice_indexes_generation = 0;
+
+/*
+ * The same for the inserts of the dimension slices, which only require adding
+ * the new slices to the indexes.
+ */
+static uint64 slices_added_generation = 0;
+static uint64 slice_indexes_synced_generation = 0;
+
+/*
+ * All slices with the ids up to this one are in the loaded indexes, or will be
+ * when they are built. Invalid when we couldn't determine it, in which case
+ * the indexes are discarded on the next insert.
+ */
+#define INVALID_SLICE_ID (-1)
+static int32 synced_slice_id = INVALID_SLICE_ID;
+
+static DimensionSliceIndexStats stats = { 0 };
+
+void
+ts_dimension_slice_index_invalidate(void)
+{
+	invalidation_generation++;
+}
+
+void
+ts_dimension_slice_index_slices_added(void)
+{
+	slices_added_generation++;
+}
+
+DimensionSliceIndexStats
+ts_dimension_slice_index_get_stats(bool reset)
+{
+	DimensionSliceIndexStats result = stats;
+
+	if (reset)
+		memset(&stats, 0, sizeof(stats));
+
+	return result;
+}
+
+/*
+ * Check that no other transaction is inserting dimension slices, by taking a
+ * lock that conflicts with the one that the inserts hold until commit. Our own
+ * inserts don't conflict, but their slices are visible to us anyway.
+ */
+static bool
+slice_indexes_lock_inserts(void)
+{
+	if (RecoveryInProgress())
+		return false;
+
+	return ConditionalLockRelationOid(catalog_get_table_id(ts_catalog_get(), DIMENSION_SLICE),
+									  ShareLock);
+}
+
+static void
+slice_indexes_unlock_inserts(void)
+{
+	UnlockRelationOid(catalog_get_table_id(ts_catalog_get(), DIMENSION_SLICE), ShareLock);
+}
+
+static int32
+slice_max_id(void)
+{
+	ScanIterator it =
+		ts_scan_iterator_create(DIMENSION_SLICE, AccessShareLock, CurrentMemoryContext);
+	int32 max_slice_id = 0;
+
+	it.ctx.index = catalog_get_index(ts_catalog_get(), DIMENSION_SLICE, DIMENSION_SLICE_ID_IDX);
+	it.ctx.scandirection = BackwardScanDirection;
+	it.ctx.limit = 1;
+
+	ts_scanner_foreach(&it)
+	{
+		bool isnull;
+		Datum id = slot_getattr(ts_scan_iterator_slot(&it), Anum_dimension_slice_id, &isnull);
+
+		Assert(!isnull);
+		max_slice_id = DatumGetInt32(id);
+	}
+	ts_scan_iterator_close(&it);
+
+	return max_slice_id;
+}
+
+static void
+slice_indexes_reset(void)
+{
+	HASHCTL ctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(DimensionSliceIndex),
+	};
+
+	if (slice_index_mcxt == NULL)
+		slice_index_mcxt =
+			AllocSetContextCreate(CacheMemoryContext, "Slice index", ALLOCSET_DEFAULT_SIZES);
+	else
+		MemoryContextReset(slice_index_mcxt);
+
+	ctl.hcxt = slice_index_mcxt;
+	slice_indexes =
+		hash_create("Slice index hash", 32, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	slice_indexes_generation = invalidation_generation;
+	slice_indexes_synced_generation = slices_added_generation;
+	synced_slice_id = INVALID_SLICE_ID;
+
+	/*
+	 * The indexes are empty, so the slices that are committed now will be in
+	 * them when they are built.
+	 */
+	if (slice_indexes_lock_inserts())
+	{
+		synced_slice_id = slice_max_id();
+		slice_indexes_unlock_inserts();
+	}
+}
+
+/*
+ * Add a slice to the index, keeping the entries sorted by range start, then
+ * range end. The new slices are usually the last ones, so this is cheap.
+ */
+static void
+slice_index_add(DimensionSliceIndex *index, const DimensionSlice *slice)
+{
+	int low = 0;
+	int high = index->num_entries;
+	int64 max_range_end;
+
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+		const SliceIndexEntry *entry = &index->entries[mid];
+
+		if (entry->range_start < slice->fd.range_start ||
+			(entry->range_start == slice->fd.range_start &&
+			 entry->range_end < slice->fd.range_end))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	/* The slice was already seen by the build or a previous scan. */
+	if (low < index->num_entries && index->entries[low].range_start == slice->fd.range_start &&
+		index->entries[low].range_end == slice->fd.range_end)
+		return;
+
+	if (index->num_entries == index->max_entries)
+	{
+		index->max_entries = Max(index->max_entries * 2, 16);
+
+		if (index->entries == NULL)
+			index->entries =
+				MemoryContextAlloc(slice_index_mcxt, sizeof(SliceIndexEntry) * index->max_entries);
+		else
+			index->entries =
+				repalloc(index->entries, sizeof(SliceIndexEntry) * index->max_entries);
+	}
+
+	memmove(&index->entries[low + 1],
+			&index->entries[low],
+			sizeof(SliceIndexEntry) * (index->num_entries - low));
+	index->entries[low] = (SliceIndexEntry){
+		.range_start = slice->fd.range_start,
+		.range_end = slice->fd.range_end,
+		.slice_id = slice->fd.id,
+	};
+	index->num_entries++;
+
+	/* Recompute the running maximum of the range end from the new entry. */
+	max_range_end = low > 0 ? index->entries[low - 1].max_range_end : PG_INT64_MIN;
+
+	for (int i = low; i < index->num_entries; i++)
+	{
+		max_range_end = Max(max_range_end, index->entries[i].range_end);
+		index->entries[i].max_range_end = max_range_end;
+	}
+
+	stats.slices_added++;
+}
+
+/*
+ * Add the slices inserted since the last synchronization to the loaded
+ * indexes.
+ */
+static void
+slice_indexes_sync(void)
+{
+	ScanIterator it;
+	int32 max_slice_id;
+	bool locked;
+
+	if (synced_slice_id == INVALID_SLICE_ID)
+	{
+		/* We don't know which slices the indexes have, so start over. */
+		slice_indexes_reset();
+		return;
+	}
+
+	slice_indexes_synced_generation = slices_added_generation;
+
+	/*
+	 * Without concurrent inserts, all slices with the ids below the largest one
+	 * that we see are committed.
+	 */
+	locked = slice_indexes_lock_inserts();
+	max_slice_id = synced_slice_id;
+
+	it = ts_scan_iterator_create(DIMENSION_SLICE, AccessShareLock, CurrentMemoryContext);
+	it.ctx.index = catalog_get_index(ts_catalog_get(), DIMENSION_SLICE, DIMENSION_SLICE_ID_IDX);
+	ts_scan_iterator_scan_key_init(&it,
+								   Anum_dimension_slice_id_idx_id,
+								   BTGreaterStrategyNumber,
+								   F_INT4GT,
+								   Int32GetDatum(synced_slice_id));
+
+	ts_scanner_foreach(&it)
+	{
+		DimensionSlice *slice = ts_dimension_slice_from_tuple(ts_scan_iterator_tuple_info(&it));
+		DimensionSliceIndex *index =
+			hash_search(slice_indexes, &slice->fd.dimension_id, HASH_FIND, NULL);
+
+		max_slice_id = Max(max_slice_id, slice->fd.id);
+
+		/* The other indexes will see the slice when they are built. */
+		if (index != NULL)
+			slice_index_add(index, slice);
+	}
+	ts_scan_iterator_close(&it);
+
+	if (locked)
+	{
+		synced_slice_id = max_slice_id;
+		slice_indexes_unlock_inserts();
+	}
+}
+
+static SliceIndexEntry *
+slice_index_build(int32 dimension_id, int *num_entries)
+{
+	/* The slices are sorted by range start, then range end. */
+	DimensionVec *slices = ts_dimension_slice_scan_by_dimension(dimension_id, 0);
+	SliceIndexEntry *entries = NULL;
+	int64 max_range_end = PG_INT64_MIN;
+
+	if (slices->num_slices > 0)
+		entries =
+			MemoryContextAlloc(slice_index_mcxt, sizeof(SliceIndexEntry) * slices->num_slices);
+
+	for (int i = 0; i < slices->num_slices; i++)
+	{
+		const DimensionSlice *slice = slices->slices[i];
+
+		max_range_end = Max(max_range_end, slice->fd.range_end);
+		entries[i] = (SliceIndexEntry){
+			.range_start = slice->fd.range_start,
+			.range_end = slice->fd.range_end,
+			.max_range_end = max_range_end,
+			.slice_id = slice->fd.id,
+		};
+	}
+
+	*num_entries = slices->num_slices;
+	ts_dimension_vec_free(slices);
+	stats.builds++;
+
+	return entries;
+}
+
+/*
+ * Get the slice index of the dimension, building it if necessary.
+ */
+DimensionSliceIndex *
+ts_dimension_slice_index_get(int32 dimension_id)
+{
+	DimensionSliceIndex *index;
+	SliceIndexEntry *entries;
+	int num_entries;
+	bool found;
+
+	/* Pick up the slices committed by the concurrent transactions. */
+	AcceptInvalidationMessages();
+
+	if (slice_indexes == NULL || slice_indexes_generation != invalidation_generation)
+		slice_indexes_reset();
+	else if (slice_indexes_synced_generation != slices_added_generation)
+		slice_indexes_sync();
+
+	index = hash_search(slice_indexes, &dimension_id, HASH_FIND, NULL);
+
+	if (index != NULL)
+		return index;
+
+	/*
+	 * Build the entries before adding the hash entry, so that we don't leave a
+	 * half-initialized index behind on error.
+	 */
+	entries = slice_index_build(dimension_id, &num_entries);
+	index = hash_search(slice_indexes, &dimension_id, HASH_ENTER, &found);
+	Assert(!found);
+	index->num_entries = num_entries;
+	index->max_entries = num_entries;
+	index->entries = entries;
+
+	return index;
+}
+
+static inline bool
+value_matches(int64 value, StrategyNumber strategy, int64 bound)
+{
+	switch (strategy)
+	{
+		case InvalidStrategy:
+			return true;
+		case BTLessStrategyNumber:
+			return value < bound;
+		case BTLessEqualStrategyNumber:
+			return value <= bound;
+		case BTEqualStrategyNumber:
+			return value == bound;
+		case BTGreaterEqualStrategyNumber:
+			return value >= bound;
+		case BTGreaterStrategyNumber:
+			return value > bound;
+		default:
+			elog(ERROR, "unexpected strategy number %d", strategy);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Find the first entry for which the start condition doesn't match. The
+ * upper-bound strategies match a prefix of the entries sorted by range_start.
+ */
+static int
+find_start_limit(const DimensionSliceIndex *index, StrategyNumber strategy, int64 value)
+{
+	int low = 0;
+	int high = index->num_entries;
+
+	Assert(strategy == InvalidStrategy || strategy == BTLessStrategyNumber ||
+		   strategy == BTLessEqualStrategyNumber);
+
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (value_matches(index->entries[mid].range_start, strategy, value))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Find the first entry for which the end condition can match. The lower-bound
+ * strategies match a suffix of the entries by the running maximum of
+ * range_end.
+ */
+static int
+find_end_limit(const DimensionSliceIndex *index, StrategyNumber strategy, int64 value)
+{
+	int low = 0;
+	int high = index->num_entries;
+
+	Assert(strategy == InvalidStrategy || strategy == BTGreaterStrategyNumber ||
+		   strategy == BTGreaterEqualStrategyNumber);
+
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (value_matches(index->entries[mid].max_range_end, strategy, value))
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return low;
+}
+
+/*
+ * Find the slices for which "range_start <start_strategy> start_value" and
+ * "range_end <end_strategy> end_value" hold, and append them to the dimension
+ * vector.
+ *
+ * The arguments have the same meaning as for
+ * ts_dimension_slice_scan_iterator_set_range(), including the adjustment of
+ * end_value for the exclusive range_end, so the result is the same as the one
+ * of the catalog scan.
+ */
+DimensionVec *
+ts_dimension_slice_index_find_range(const DimensionSliceIndex *index,
+									StrategyNumber start_strategy, int64 start_value,
+									StrategyNumber end_strategy, int64 end_value,
+									DimensionVec **dv, bool unique)
+{
+	int first;
+	int last;
+
+	if (end_strategy != InvalidStrategy)
+	{
+		/* See ts_dimension_slice_scan_iterator_set_range() */
+		if (end_value != PG_INT64_MAX)
+			end_value = REMAP_LAST_COORDINATE(end_value + 1);
+		else
+			end_value = PG_INT64_MAX;
+	}
+
+	first = find_end_limit(index, end_strategy, end_value);
+	last = find_start_limit(index, start_strategy, start_value);
+
+	stats.lookups++;
+
+	for (int i = first; i < last; i++)
+	{
+		const SliceIndexEntry *entry = &index->entries[i];
+		DimensionSlice *slice;
+
+		stats.slices_examined++;
+
+		if (!value_matches(entry->range_end, end_strategy, end_value))
+			continue;
+
+		slice = ts_dimension_slice_create(index->dimension_id,
+										  entry->range_start,
+										  entry->range_end);
+		slice->fd.id = entry->slice_id;
+		stats.slices_matched++;
+
+		if (unique)
+			*dv = ts_dimension_vec_add_unique_slice(dv, slice);
+		else
+			*dv = ts_dimension_vec_add_slice(dv, slice);
+	}
+
+	return *dv;
+}
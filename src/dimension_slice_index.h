@@ -0,0 +1,34 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <access/stratnum.h>
+
+#include "dimension_vector.h"
+#include "export.h"
+
+typedef struct DimensionSliceIndex DimensionSliceIndex;
+
+typedef struct DimensionSliceIndexStats
+{
+	int64 lookups;		   /* range lookups answered from the index */
+	int64 builds;		   /* indexes built from the catalog */
+	int64 slices_examined; /* slices compared with the restriction */
+	int64 slices_matched;  /* slices returned by the lookups */
+	int64 slices_added;	   /* new slices added to the built indexes */
+} DimensionSliceIndexStats;
+
+extern DimensionSliceIndex *ts_dimension_slice_index_get(int32 dimension_id);
+extern DimensionVec *ts_dimension_slice_index_find_range(const DimensionSliceIndex *index,
+														 StrategyNumber start_strategy,
+														 int64 start_value,
+														 StrategyNumber end_strategy,
+														 int64 end_value, DimensionVec **dv,
+														 bool unique);
+extern void ts_dimension_slice_index_invalidate(void);
+extern void ts_dimension_slice_index_slices_added(void);
+extern TSDLLEXPORT DimensionSliceIndexStats ts_dimension_slice_index_get_stats(bool reset);
@@ -14,6 +14,7 @@
 #define TSL_LIBRARY_NAME "timescaledb-tsl"
 #define TS_LIBDIR "$libdir/"
 #define EXTENSION_SO TS_LIBDIR "" EXTENSION_NAME
+#define EXTENSION_VERSIONED_SO TS_LIBDIR EXTENSION_NAME "-" TIMESCALEDB_VERSION_MOD
 #define EXTENSION_TSL_SO TS_LIBDIR TSL_LIBRARY_NAME "-" TIMESCALEDB_VERSION_MOD
 #define TS_HYPERCORE_TAM_NAME "hypercore"
 
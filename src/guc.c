@@ -6,6 +6,7 @@
 #include <postgres.h>
 #include <miscadmin.h>
 #include <parser/parse_func.h>
+#include <postmaster/bgworker.h>
 #include <utils/guc.h>
 #include <utils/regproc.h>
 #include <utils/varlena.h>
@@ -153,16 +154,25 @@ TSDLLEXPORT bool ts_guc_enable_compression_wal_markers = false;
 TSDLLEXPORT bool ts_guc_enable_decompression_sorted_merge = true;
 bool ts_guc_enable_chunkwise_aggregation = true;
 bool ts_guc_enable_vectorized_aggregation = true;
+TSDLLEXPORT bool ts_guc_enable_vectorized_aggregation_spill = true;
 bool ts_guc_enable_custom_hashagg = false;
+bool ts_guc_enable_vectorized_sort = false;
 TSDLLEXPORT bool ts_guc_enable_compression_indexscan = false;
 TSDLLEXPORT bool ts_guc_enable_bulk_decompression = true;
 TSDLLEXPORT bool ts_guc_auto_sparse_indexes = true;
+TSDLLEXPORT bool ts_guc_enable_sparse_index_bloom = true;
 TSDLLEXPORT bool ts_guc_default_hypercore_use_access_method = false;
 bool ts_guc_enable_chunk_skipping = false;
+bool ts_guc_enable_shared_chunk_cache = true;
+bool ts_guc_enable_dimension_slice_index = true;
+bool ts_guc_enable_buffered_insert = true;
+bool ts_guc_enable_direct_compress_copy = false;
 TSDLLEXPORT bool ts_guc_enable_segmentwise_recompression = true;
 TSDLLEXPORT bool ts_guc_enable_exclusive_locking_recompression = false;
 TSDLLEXPORT bool ts_guc_enable_bool_compression = true;
+TSDLLEXPORT bool ts_guc_enable_bitpack_compression = false;
 TSDLLEXPORT int ts_guc_compression_batch_size_limit = 1000;
+TSDLLEXPORT int ts_guc_compress_parallel_workers = 0;
 TSDLLEXPORT CompressTruncateBehaviour ts_guc_compress_truncate_behaviour = COMPRESS_TRUNCATE_ONLY;
 bool ts_guc_enable_event_triggers = false;
 
@@ -197,6 +207,8 @@ TSDLLEXPORT int ts_guc_hypercore_arrow_cache_max_entries;
  * GUC mechanism starts up */
 int ts_guc_max_open_chunks_per_insert;
 int ts_guc_max_cached_chunks_per_hypertable;
+int ts_guc_copy_buffer_memory = 16384;
+int ts_guc_copy_parallel_workers = 0;
 #ifdef USE_TELEMETRY
 TelemetryLevel ts_guc_telemetry_level = TELEMETRY_DEFAULT;
 char *ts_telemetry_cloud = NULL;
@@ -811,6 +823,54 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_shared_chunk_cache"),
+							 "Enable the shared chunk cache",
+							 "Use the chunk hypercubes cached in shared memory by other backends "
+							 "instead of scanning the dimension slices",
+							 &ts_guc_enable_shared_chunk_cache,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_dimension_slice_index"),
+							 "Enable the in-memory dimension slice index",
+							 "Use an in-memory index of the dimension slices to find the chunks "
+							 "matching the query restrictions during planning",
+							 &ts_guc_enable_dimension_slice_index,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_buffered_insert"),
+							 "Enable buffering of inserted tuples",
+							 "Collect the tuples of INSERT statements per chunk and write them "
+							 "with multi-inserts like COPY does",
+							 &ts_guc_enable_buffered_insert,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_direct_compress_copy"),
+							 "Enable COPY directly into compressed chunks",
+							 "Compress the rows that COPY writes into compressed chunks into new "
+							 "batches instead of inserting them into the uncompressed chunk",
+							 &ts_guc_enable_direct_compress_copy,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_segmentwise_recompression"),
 							 "Enable segmentwise recompression functionality",
 							 "Enable segmentwise recompression",
@@ -844,6 +904,18 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_bitpack_compression"),
+							 "Enable bitpack compression functionality",
+							 "Use frame-of-reference bit packing for integer columns when it is "
+							 "smaller than delta-delta encoding",
+							 &ts_guc_enable_bitpack_compression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomIntVariable(MAKE_EXTOPTION("compression_batch_size_limit"),
 							"The max number of tuples that can be batched together during "
 							"compression",
@@ -861,6 +933,25 @@ _guc_init(void)
 							NULL,
 							NULL,
 							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("compress_parallel_workers"),
+							"Number of parallel workers used to compress a chunk",
+							"The workers read the chunk with a parallel scan and partition the "
+							"rows between themselves by the hash of the segmentby values, and "
+							"each worker sorts and compresses its partition. Each worker can use "
+							"up to maintenance_work_mem for sorting. Only the chunks larger than "
+							"min_parallel_table_scan_size are compressed in parallel. Setting "
+							"this to 0 disables the parallel compression.",
+							&ts_guc_compress_parallel_workers,
+							0,
+							0,
+							/* The workers exchange rows through nworkers^2 queues. */
+							32,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_event_triggers"),
 							 "Enable event triggers for chunks creation",
 							 "Enable event triggers for chunks creation",
@@ -961,6 +1052,32 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_vectorized_aggregation_spill"),
+							 "Enable spilling for vectorized hash aggregation",
+							 "Save the input of vectorized hash aggregation that does not fit into "
+							 "work_mem, and aggregate it in several passes by partitions of the "
+							 "grouping keys, instead of emitting partial aggregation results",
+							 &ts_guc_enable_vectorized_aggregation_spill,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_vectorized_sort"),
+							 "Enable vectorized sort",
+							 "Enable the sorting of compressed data that reads the decompressed "
+							 "batches directly, instead of going through the tuple-by-tuple "
+							 "output of decompression",
+							 &ts_guc_enable_vectorized_sort,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_compression_indexscan"),
 							 "Enable compression to take indexscan path",
 							 "Enable indexscan during compression, if matching index is found",
@@ -997,6 +1114,19 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_sparse_index_bloom"),
+							 "Enable creation of the bloom1 sparse index on compressed chunks",
+							 "The hypertable columns that have hash indexes will have the bloom "
+							 "filter sparse index when compressed. Requires the "
+							 "`auto_sparse_indexes` to be enabled.",
+							 &ts_guc_enable_sparse_index_bloom,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_columnarscan"),
 							 "Enable columnar-optimized scans for supported access methods",
 							 "A columnar scan replaces sequence scans for columnar-oriented "
@@ -1025,6 +1155,38 @@ _guc_init(void)
 							assign_max_open_chunks_per_insert_hook,
 							NULL);
 
+	DefineCustomIntVariable(MAKE_EXTOPTION("copy_buffer_memory"),
+							"Memory used for buffering COPY into hypertables",
+							"The maximum amount of memory used for buffering the tuples of all "
+							"chunks during a COPY into a hypertable. The buffers of the chunks "
+							"that receive most tuples are flushed first when the limit is reached.",
+							&ts_guc_copy_buffer_memory,
+							16384,
+							64,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("copy_parallel_workers"),
+							"Number of parallel workers used to convert the COPY input",
+							"The parallel workers convert the values of the text and CSV input "
+							"of a COPY into a hypertable, and the rows are inserted by the "
+							"backend running the COPY. The input is converted in segments of "
+							"maintenance_work_mem. Setting this to 0 disables the parallel "
+							"conversion.",
+							&ts_guc_copy_parallel_workers,
+							0,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable(MAKE_EXTOPTION("max_cached_chunks_per_hypertable"),
 							"Maximum cached chunks",
 							"Maximum number of chunks stored in the cache",
@@ -0,0 +1,236 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <libpq/pqformat.h>
+#include <math.h>
+#include <utils/builtins.h>
+#include <utils/typcache.h>
+
+#include "export.h"
+#include "hyperloglog.h"
+
+/* aggregate approximate_count_distinct:
+ *	 approximate_count_distinct(value) returns the estimated number of distinct
+ *	 not null values
+ *
+ * Usage:
+ *	 SELECT device_id, approximate_count_distinct(user_id) FROM table GROUP BY device_id;
+ *
+ * Description:
+ * The estimate is computed with a HyperLogLog sketch of the 64-bit extended
+ * hashes of the values, so the aggregate supports every type that has an
+ * extended hash function. The sketch is small and can be merged, so the
+ * aggregate supports partial and parallel aggregation, and can be used in
+ * continuous aggregates. The vectorized aggregation in TSL computes the same
+ * hashes, so the partial states are interchangeable.
+ */
+
+TS_FUNCTION_INFO_V1(ts_hll_sfunc);
+TS_FUNCTION_INFO_V1(ts_hll_combinefunc);
+TS_FUNCTION_INFO_V1(ts_hll_serializefunc);
+TS_FUNCTION_INFO_V1(ts_hll_deserializefunc);
+TS_FUNCTION_INFO_V1(ts_hll_finalfunc);
+
+/*
+ * Version of the serialized state, so that we can change the state and still
+ * accept the states materialized in continuous aggregates.
+ */
+#define HLL_SERIALIZATION_VERSION 1
+
+typedef struct HllState
+{
+	uint8 registers[TS_HLL_NUM_REGISTERS];
+} HllState;
+
+/* approximate_count_distinct(state, value) */
+Datum
+ts_hll_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HllState *state = (HllState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_hll_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		/* Null values are not counted. */
+		if (state == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state);
+	}
+
+	/* Cache the type information for the extended hash function of the argument type. */
+	TypeCacheEntry *typcache = (TypeCacheEntry *) fcinfo->flinfo->fn_extra;
+	if (typcache == NULL)
+	{
+		Oid argtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+		typcache = lookup_type_cache(argtype, TYPECACHE_HASH_EXTENDED_PROC_FINFO);
+		if (!OidIsValid(typcache->hash_extended_proc))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify an extended hash function for type %s",
+							format_type_be(argtype))));
+		fcinfo->flinfo->fn_extra = typcache;
+	}
+
+	if (state == NULL)
+		state = MemoryContextAllocZero(aggcontext, sizeof(HllState));
+
+	uint64 hash = DatumGetUInt64(FunctionCall2Coll(&typcache->hash_extended_proc_finfo,
+												   PG_GET_COLLATION(),
+												   PG_GETARG_DATUM(1),
+												   UInt64GetDatum(0)));
+	ts_hll_add_hash(state->registers, hash);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ts_hll_combinefunc(internal, internal) => internal */
+Datum
+ts_hll_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HllState *state1 = (HllState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	HllState *state2 = (HllState *) (PG_ARGISNULL(1) ? NULL : PG_GETARG_POINTER(1));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_hll_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state1);
+	}
+
+	if (state1 == NULL)
+	{
+		state1 = MemoryContextAlloc(aggcontext, sizeof(HllState));
+		memcpy(state1, state2, sizeof(HllState));
+		PG_RETURN_POINTER(state1);
+	}
+
+	for (int i = 0; i < TS_HLL_NUM_REGISTERS; i++)
+		state1->registers[i] = Max(state1->registers[i], state2->registers[i]);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * Serialize the registers of a HyperLogLog sketch. This is also used by the
+ * vectorized implementation of the aggregate, which keeps its own state.
+ */
+TSDLLEXPORT bytea *
+ts_hll_serialize(const uint8 *registers)
+{
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, HLL_SERIALIZATION_VERSION);
+	pq_sendbyte(&buf, TS_HLL_PRECISION);
+	pq_sendbytes(&buf, (const void *) registers, TS_HLL_NUM_REGISTERS);
+
+	return pq_endtypsend(&buf);
+}
+
+/* ts_hll_serializefunc(internal) => bytea */
+Datum
+ts_hll_serializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+	HllState *state = (HllState *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(ts_hll_serialize(state->registers));
+}
+
+/* ts_hll_deserializefunc(bytea *, internal) => internal */
+Datum
+ts_hll_deserializefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	StringInfoData buf;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "ts_hll_deserializefunc called in non-aggregate context");
+
+	Assert(!PG_ARGISNULL(0));
+	bytea *serialized = PG_GETARG_BYTEA_P(0);
+
+	buf.data = VARDATA(serialized);
+	buf.len = VARSIZE(serialized) - VARHDRSZ;
+	buf.maxlen = VARSIZE(serialized) - VARHDRSZ;
+	buf.cursor = 0;
+
+	const int version = pq_getmsgbyte(&buf);
+	const int precision = pq_getmsgbyte(&buf);
+	if (version != HLL_SERIALIZATION_VERSION || precision != TS_HLL_PRECISION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("unsupported approximate_count_distinct state version %d precision %d",
+						version,
+						precision)));
+
+	HllState *state = MemoryContextAlloc(aggcontext, sizeof(HllState));
+	pq_copymsgbytes(&buf, (char *) state->registers, TS_HLL_NUM_REGISTERS);
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * The HyperLogLog estimate with the linear counting correction for small
+ * cardinalities. We use 64-bit hashes, so the correction for large
+ * cardinalities is not needed.
+ */
+static int64
+hll_estimate(const uint8 *registers)
+{
+	const double m = TS_HLL_NUM_REGISTERS;
+	const double alpha = 0.7213 / (1.0 + 1.079 / m);
+	double sum = 0;
+	int zero_registers = 0;
+
+	for (int i = 0; i < TS_HLL_NUM_REGISTERS; i++)
+	{
+		sum += ldexp(1.0, -registers[i]);
+		zero_registers += registers[i] == 0;
+	}
+
+	double estimate = alpha * m * m / sum;
+	if (estimate <= 2.5 * m && zero_registers > 0)
+		estimate = m * log(m / zero_registers);
+
+	return (int64) rint(estimate);
+}
+
+/* ts_hll_finalfunc(internal) => bigint */
+Datum
+ts_hll_finalfunc(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_hll_finalfunc called in non-aggregate context");
+	}
+
+	HllState *state = (HllState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	/* Same as count(DISTINCT), there are no distinct values when there are no rows. */
+	if (state == NULL)
+		PG_RETURN_INT64(0);
+
+	PG_RETURN_INT64(hll_estimate(state->registers));
+}
@@ -0,0 +1,39 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <port/pg_bitutils.h>
+
+#include "export.h"
+
+/*
+ * HyperLogLog sketch used by approximate_count_distinct(). We use 2^12 one-byte
+ * registers, which gives the standard error of about 1.6%.
+ */
+#define TS_HLL_PRECISION 12
+#define TS_HLL_NUM_REGISTERS (1 << TS_HLL_PRECISION)
+
+/*
+ * Add a 64-bit hash of a value to the registers. The upper bits of the hash
+ * select the register, and the register stores the maximum position of the
+ * leftmost one bit in the remaining bits.
+ */
+static inline void
+ts_hll_add_hash(uint8 *registers, uint64 hash)
+{
+	const uint32 index = (uint32) (hash >> (64 - TS_HLL_PRECISION));
+	const uint64 remainder = hash << TS_HLL_PRECISION;
+	const uint8 rank =
+		remainder == 0 ? (64 - TS_HLL_PRECISION + 1) : (64 - pg_leftmost_one_pos64(remainder));
+
+	if (rank > registers[index])
+	{
+		registers[index] = rank;
+	}
+}
+
+extern TSDLLEXPORT bytea *ts_hll_serialize(const uint8 *registers);
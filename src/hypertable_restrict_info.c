@@ -20,6 +20,7 @@
 #include "chunk_scan.h"
 #include "dimension.h"
 #include "dimension_slice.h"
+#include "dimension_slice_index.h"
 #include "dimension_vector.h"
 #include "expression_utils.h"
 #include "guc.h"
@@ -547,6 +548,21 @@ gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
 			{
 				const DimensionRestrictInfoOpen *open = (const DimensionRestrictInfoOpen *) dri;
 
+				if (ts_guc_enable_dimension_slice_index)
+				{
+					DimensionSliceIndex *index =
+						ts_dimension_slice_index_get(open->base.dimension->fd.id);
+
+					dv = ts_dimension_slice_index_find_range(index,
+															 open->upper_strategy,
+															 open->upper_bound,
+															 open->lower_strategy,
+															 open->lower_bound,
+															 &dv,
+															 false);
+					break;
+				}
+
 				ts_dimension_slice_scan_iterator_set_range(&it,
 														   open->base.dimension->fd.id,
 														   open->upper_strategy,
@@ -584,11 +600,27 @@ gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
 				/* Shouldn't have trivial restriction infos here. */
 				Assert(closed->strategy == BTEqualStrategyNumber);
 
+				DimensionSliceIndex *index = NULL;
+				if (ts_guc_enable_dimension_slice_index)
+					index = ts_dimension_slice_index_get(dri->dimension->fd.id);
+
 				ListCell *cell;
 				foreach (cell, closed->partitions)
 				{
 					int32 partition = lfirst_int(cell);
 
+					if (index != NULL)
+					{
+						dv = ts_dimension_slice_index_find_range(index,
+																 BTLessEqualStrategyNumber,
+																 partition,
+																 BTGreaterEqualStrategyNumber,
+																 partition,
+																 &dv,
+																 true);
+						continue;
+					}
+
 					/*
 					 * slice_end >= value && slice_start <= value.
 					 * See the comment about scan direction above.
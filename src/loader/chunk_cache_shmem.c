@@ -0,0 +1,110 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "extension_constants.h"
+#include "loader/chunk_cache_shmem.h"
+
+#define SHARED_CHUNK_CACHE_STATE_NAME "ts_shared_chunk_cache_state"
+
+/*
+ * The default is enough for the hypercubes of 10000 chunks, which takes about
+ * 1.5 MB of shared memory. The cache should fit all the chunks that are
+ * regularly used by the queries in all databases. When it is too small, it
+ * still works, but has to evict some entries for each batch of new ones, so
+ * the chunks are cached only for a part of the time.
+ */
+int ts_guc_shared_chunk_cache_size = 10000;
+
+typedef struct SharedChunkCacheState
+{
+	LWLock *lock;
+	pg_atomic_uint64 generation;
+} SharedChunkCacheState;
+
+static SharedChunkCacheRendezvous rendezvous;
+
+void
+ts_shared_chunk_cache_setup_gucs(void)
+{
+	DefineCustomIntVariable(MAKE_EXTOPTION("shared_chunk_cache_size"),
+							"Maximum number of chunks in the shared chunk cache",
+							"The hypercubes of this many chunks are cached in shared memory "
+							"for use by all backends. Set it to at least the number of "
+							"chunks regularly used by queries in all databases, each chunk "
+							"takes about 150 bytes. Set to 0 to disable the cache.",
+							&ts_guc_shared_chunk_cache_size,
+							ts_guc_shared_chunk_cache_size,
+							0,
+							10000000,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+}
+
+void
+ts_shared_chunk_cache_shmem_startup(void)
+{
+	SharedChunkCacheRendezvous **rendezvous_ptr;
+	SharedChunkCacheState *state;
+	HASHCTL hash_info;
+	HTAB *entries;
+	bool found;
+
+	if (ts_guc_shared_chunk_cache_size == 0)
+		return;
+
+	hash_info.keysize = sizeof(SharedChunkCacheKey);
+	hash_info.entrysize = sizeof(SharedChunkCacheEntry);
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	/*
+	 * The shmem_startup_hook is run on every backend on Windows, so we only
+	 * initialize the state when it is created. See function_telemetry.c for
+	 * the details.
+	 */
+	state = ShmemInitStruct(SHARED_CHUNK_CACHE_STATE_NAME, sizeof(SharedChunkCacheState), &found);
+	if (!found)
+	{
+		state->lock = &(GetNamedLWLockTranche(SHARED_CHUNK_CACHE_LWLOCK_TRANCHE_NAME))->lock;
+		pg_atomic_init_u64(&state->generation, 1);
+	}
+
+	entries = ShmemInitHash("timescaledb shared chunk cache",
+							ts_guc_shared_chunk_cache_size,
+							ts_guc_shared_chunk_cache_size,
+							&hash_info,
+							HASH_ELEM | HASH_BLOBS);
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.lock = state->lock;
+	rendezvous.entries = entries;
+	rendezvous.generation = &state->generation;
+	rendezvous.max_entries = ts_guc_shared_chunk_cache_size;
+
+	rendezvous_ptr =
+		(SharedChunkCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_SHARED_CHUNK_CACHE);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_shared_chunk_cache_shmem_alloc(void)
+{
+	if (ts_guc_shared_chunk_cache_size == 0)
+		return;
+
+	Size size = hash_estimate_size(ts_guc_shared_chunk_cache_size, sizeof(SharedChunkCacheEntry));
+	RequestAddinShmemSpace(add_size(size, sizeof(SharedChunkCacheState)));
+	RequestNamedLWLockTranche(SHARED_CHUNK_CACHE_LWLOCK_TRANCHE_NAME, 1);
+}
@@ -0,0 +1,65 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <port/atomics.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+/*
+ * The shared chunk cache is allocated by the loader and used by the versioned
+ * extension library, which can come from a different release. The rendezvous
+ * name includes the version of the layout of the structs below, so it has to
+ * be changed when they are.
+ */
+#define RENDEZVOUS_SHARED_CHUNK_CACHE "ts_shared_chunk_cache_v1"
+#define SHARED_CHUNK_CACHE_LWLOCK_TRANCHE_NAME "ts_shared_chunk_cache_lwlock_tranche"
+
+/* Chunks with more dimensions than this are not cached. */
+#define SHARED_CHUNK_CACHE_MAX_SLICES 4
+
+typedef struct SharedChunkCacheKey
+{
+	Oid database_id;
+	Oid chunk_catalog_id;
+	int32 chunk_id;
+} SharedChunkCacheKey;
+
+typedef struct SharedChunkCacheSlice
+{
+	int32 id;
+	int32 dimension_id;
+	int64 range_start;
+	int64 range_end;
+} SharedChunkCacheSlice;
+
+/*
+ * The hypercube of a chunk. The entry is valid only if its generation matches
+ * the current generation of the cache.
+ */
+typedef struct SharedChunkCacheEntry
+{
+	SharedChunkCacheKey key;
+	uint64 generation;
+	int32 num_slices;
+	SharedChunkCacheSlice slices[SHARED_CHUNK_CACHE_MAX_SLICES];
+} SharedChunkCacheEntry;
+
+typedef struct SharedChunkCacheRendezvous
+{
+	/* Protects the hash table. The generation is read without the lock. */
+	LWLock *lock;
+	HTAB *entries;
+	pg_atomic_uint64 *generation;
+	int max_entries;
+} SharedChunkCacheRendezvous;
+
+extern int ts_guc_shared_chunk_cache_size;
+
+extern void ts_shared_chunk_cache_setup_gucs(void);
+extern void ts_shared_chunk_cache_shmem_alloc(void);
+extern void ts_shared_chunk_cache_shmem_startup(void);
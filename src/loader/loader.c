@@ -38,6 +38,7 @@
 #include "loader/bgw_interface.h"
 #include "loader/bgw_launcher.h"
 #include "loader/bgw_message_queue.h"
+#include "loader/chunk_cache_shmem.h"
 #include "loader/function_telemetry.h"
 #include "loader/loader.h"
 #include "loader/lwlocks.h"
@@ -579,6 +580,7 @@ timescaledb_shmem_startup_hook(void)
 	ts_bgw_message_queue_shmem_startup();
 	ts_lwlocks_shmem_startup();
 	ts_function_telemetry_shmem_startup();
+	ts_shared_chunk_cache_shmem_startup();
 }
 
 /*
@@ -596,6 +598,7 @@ timescaledb_shmem_request_hook(void)
 	ts_bgw_message_queue_alloc();
 	ts_lwlocks_shmem_alloc();
 	ts_function_telemetry_shmem_alloc();
+	ts_shared_chunk_cache_shmem_alloc();
 }
 
 static void
@@ -619,6 +622,7 @@ _PG_init(void)
 
 	ts_bgw_cluster_launcher_init();
 	ts_bgw_counter_setup_gucs();
+	ts_shared_chunk_cache_setup_gucs();
 	ts_bgw_interface_register_api_version();
 
 	/* This is a safety-valve variable to prevent loading the full extension */
@@ -31,6 +31,7 @@
 #include "planner/planner.h"
 #include "transform.h"
 #include "ts_catalog/chunk_column_stats.h"
+#include "utils.h"
 
 #define INVALID_SUBPLAN_INDEX (-1)
 #define NO_MATCHING_SUBPLANS (-2)
@@ -60,6 +61,18 @@ typedef struct ParallelChunkAppendState
 	uint32 subplan_state[FLEXIBLE_ARRAY_MEMBER]; /* See SubplanState */
 } ParallelChunkAppendState;
 
+/*
+ * Range of the primary time dimension of a chunk subplan, see
+ * build_chunk_ranges() in planner.c.
+ */
+typedef struct ChunkRange
+{
+	int64 range_start;
+	int64 range_end;
+	int64 max_range_end; /* maximum range_end of this and preceding ranges */
+	int subplan;		 /* index in initial_subplans */
+} ChunkRange;
+
 typedef struct ChunkAppendState
 {
 	CustomScanState csstate;
@@ -101,6 +114,16 @@ typedef struct ChunkAppendState
 	/* included subplans by startup exclusion */
 	Bitmapset *included_subplans_by_se;
 
+	/* indexes in initial_subplans of the filtered subplans, NIL if unfiltered */
+	List *filtered_indexes;
+
+	/* chunk ranges sorted by range_start for the range-based exclusion */
+	int num_chunk_ranges;
+	ChunkRange *chunk_ranges;
+	Bitmapset *ranged_subplans;
+	List *range_strategies;
+	List *range_values;
+
 	/* valid subplans for runtime exclusion */
 	Bitmapset *valid_subplans;
 	Bitmapset *params;
@@ -149,10 +172,14 @@ static void choose_next_subplan_non_parallel(ChunkAppendState *state);
 static void choose_next_subplan_for_worker(ChunkAppendState *state);
 
 static bool can_exclude_chunk(List *constraints, List *baserestrictinfo);
-static void do_startup_exclusion(ChunkAppendState *state);
+static void do_startup_exclusion(ChunkAppendState *state, Bitmapset *excluded_by_range);
 static Node *constify_param_mutator(Node *node, void *context);
 
-static void initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes);
+static void initialize_chunk_ranges(ChunkAppendState *state, List *chunk_ranges);
+static bool chunk_ranges_find_candidates(ChunkAppendState *state, PlannerInfo *root,
+										 bool runtime, Bitmapset **candidates);
+static void initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes,
+								   Bitmapset *excluded_by_range);
 static LWLock *chunk_append_get_lock_pointer(void);
 
 static void show_sort_group_keys(ChunkAppendState *planstate, List *ancestors, ExplainState *es);
@@ -182,6 +209,8 @@ ts_chunk_append_state_create(CustomScan *cscan)
 	state->limit = lfourth_int(settings);
 	state->first_partial_plan = lfirst_int(list_nth_cell(settings, 4));
 
+	initialize_chunk_ranges(state, lfirst(list_nth_cell(cscan->custom_private, 5)));
+
 	state->filtered_subplans = state->initial_subplans;
 	state->filtered_ri_clauses = state->initial_ri_clauses;
 	state->filtered_first_partial_plan = state->first_partial_plan;
@@ -197,11 +226,12 @@ ts_chunk_append_state_create(CustomScan *cscan)
 }
 
 static void
-do_startup_exclusion(ChunkAppendState *state)
+do_startup_exclusion(ChunkAppendState *state, Bitmapset *excluded_by_range)
 {
 	List *filtered_children = NIL;
 	List *filtered_ri_clauses = NIL;
 	List *filtered_constraints = NIL;
+	List *filtered_indexes = NIL;
 	ListCell *lc_plan;
 	ListCell *lc_clauses;
 	ListCell *lc_constraints;
@@ -247,6 +277,14 @@ do_startup_exclusion(ChunkAppendState *state)
 		 */
 		if (scan != NULL && scan->scanrelid)
 		{
+			if (bms_is_member(i, excluded_by_range))
+			{
+				if (i < state->first_partial_plan)
+					filtered_first_partial_plan--;
+
+				continue;
+			}
+
 			foreach (lc, ri_clauses)
 			{
 				RestrictInfo *ri = makeNode(RestrictInfo);
@@ -283,11 +321,13 @@ do_startup_exclusion(ChunkAppendState *state)
 		filtered_children = lappend(filtered_children, lfirst(lc_plan));
 		filtered_ri_clauses = lappend(filtered_ri_clauses, ri_clauses);
 		filtered_constraints = lappend(filtered_constraints, lfirst(lc_constraints));
+		filtered_indexes = lappend_int(filtered_indexes, i);
 	}
 
 	state->filtered_subplans = filtered_children;
 	state->filtered_ri_clauses = filtered_ri_clauses;
 	state->filtered_constraints = filtered_constraints;
+	state->filtered_indexes = filtered_indexes;
 	state->filtered_first_partial_plan = filtered_first_partial_plan;
 
 	Assert(list_length(state->filtered_subplans) ==
@@ -326,7 +366,27 @@ chunk_append_begin(CustomScanState *node, EState *estate, int eflags)
 	node->ss.ps.resultopsfixed = false;
 	ExecAssignScanProjectionInfoWithVarno(&node->ss, INDEX_VAR);
 
-	initialize_constraints(state, lthird(cscan->custom_private));
+	/*
+	 * Find the chunks that are excluded by their time range first, so that we
+	 * don't have to load their constraints. The parallel workers use the
+	 * startup exclusion result of the leader, see below.
+	 */
+	Bitmapset *excluded_by_range = NULL;
+	if (state->startup_exclusion && !(IsParallelWorker() && node->ss.ps.plan->parallel_aware))
+	{
+		PlannerGlobal glob = {
+			.boundParams = estate->es_param_list_info,
+		};
+		PlannerInfo root = {
+			.glob = &glob,
+		};
+		Bitmapset *candidates;
+
+		if (chunk_ranges_find_candidates(state, &root, false, &candidates))
+			excluded_by_range = bms_difference(state->ranged_subplans, candidates);
+	}
+
+	initialize_constraints(state, lthird(cscan->custom_private), excluded_by_range);
 
 	/* In parallel mode with a parallel_aware plan, the parallel leader performs the startup
 	 * exclusion and stores the result in shared memory (the flag SUBPLAN_STATE_INCLUDED of
@@ -362,7 +422,7 @@ chunk_append_begin(CustomScanState *node, EState *estate, int eflags)
 	}
 
 	if (state->startup_exclusion)
-		do_startup_exclusion(state);
+		do_startup_exclusion(state, excluded_by_range);
 
 	perform_plan_init(state, estate, eflags);
 }
@@ -498,6 +558,9 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 
 	Assert(state->num_subplans == list_length(state->filtered_ri_clauses));
 
+	Bitmapset *candidates = NULL;
+	bool use_ranges = chunk_ranges_find_candidates(state, &root, true, &candidates);
+
 	lc_clauses = list_head(state->filtered_ri_clauses);
 	lc_constraints = list_head(state->filtered_constraints);
 
@@ -515,11 +578,19 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 		}
 		else
 		{
-			bool can_exclude = can_exclude_constraints_using_clauses(state,
-																	 lfirst(lc_constraints),
-																	 lfirst(lc_clauses),
-																	 &root,
-																	 ps);
+			int initial_index =
+				state->filtered_indexes != NIL ? list_nth_int(state->filtered_indexes, i) : i;
+			bool can_exclude;
+
+			if (use_ranges && bms_is_member(initial_index, state->ranged_subplans) &&
+				!bms_is_member(initial_index, candidates))
+				can_exclude = true;
+			else
+				can_exclude = can_exclude_constraints_using_clauses(state,
+																	lfirst(lc_constraints),
+																	lfirst(lc_clauses),
+																	&root,
+																	ps);
 
 			if (!can_exclude)
 				state->valid_subplans = bms_add_member(state->valid_subplans, i);
@@ -867,11 +938,13 @@ chunk_append_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordi
 	List *filtered_subplans = NIL;
 	List *filtered_ri_clauses = NIL;
 	List *filtered_constraints = NIL;
+	List *filtered_indexes = NIL;
 
 	for (int plan = 0; plan < list_length(state->initial_subplans); plan++)
 	{
 		if (ts_flags_are_set_32(pstate->subplan_state[plan], SUBPLAN_STATE_INCLUDED))
 		{
+			filtered_indexes = lappend_int(filtered_indexes, plan);
 			filtered_subplans =
 				lappend(filtered_subplans, list_nth(state->filtered_subplans, plan));
 			filtered_ri_clauses =
@@ -884,6 +957,7 @@ chunk_append_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordi
 	state->filtered_subplans = filtered_subplans;
 	state->filtered_ri_clauses = filtered_ri_clauses;
 	state->filtered_constraints = filtered_constraints;
+	state->filtered_indexes = filtered_indexes;
 
 	Assert(list_length(state->filtered_subplans) == list_length(state->filtered_ri_clauses));
 	Assert(list_length(state->filtered_ri_clauses) == list_length(state->filtered_constraints));
@@ -1182,16 +1256,171 @@ can_exclude_chunk(List *constraints, List *baserestrictinfo)
 	return false;
 }
 
+/*
+ * Read the chunk ranges prepared by the planner, see build_chunk_ranges() in
+ * planner.c, and compute the running maximum of the range end, so that we can
+ * find the first range that might end after a given point by binary search.
+ */
+static void
+initialize_chunk_ranges(ChunkAppendState *state, List *chunk_ranges)
+{
+	ListCell *lc_subplan, *lc_start, *lc_end;
+	int64 max_range_end = PG_INT64_MIN;
+	int i = 0;
+
+	if (chunk_ranges == NIL)
+		return;
+
+	List *subplans = lthird(chunk_ranges);
+
+	state->range_strategies = linitial(chunk_ranges);
+	state->range_values = lsecond(chunk_ranges);
+	state->num_chunk_ranges = list_length(subplans);
+	state->chunk_ranges = palloc(sizeof(ChunkRange) * state->num_chunk_ranges);
+
+	forthree (lc_subplan,
+			  subplans,
+			  lc_start,
+			  lfourth(chunk_ranges),
+			  lc_end,
+			  lfirst(list_nth_cell(chunk_ranges, 4)))
+	{
+		ChunkRange *range = &state->chunk_ranges[i++];
+
+		range->subplan = lfirst_int(lc_subplan);
+		range->range_start = DatumGetInt64(castNode(Const, lfirst(lc_start))->constvalue);
+		range->range_end = DatumGetInt64(castNode(Const, lfirst(lc_end))->constvalue);
+		max_range_end = Max(max_range_end, range->range_end);
+		range->max_range_end = max_range_end;
+
+		state->ranged_subplans = bms_add_member(state->ranged_subplans, range->subplan);
+	}
+}
+
+/*
+ * Find the chunk subplans with a time range that overlaps the restrictions on
+ * the time dimension.
+ *
+ * Returns false if none of the restrictions evaluates to a constant, in which
+ * case the chunks have to be checked individually. The subplans that are not
+ * in ranged_subplans are never excluded by this check.
+ */
+static bool
+chunk_ranges_find_candidates(ChunkAppendState *state, PlannerInfo *root, bool runtime,
+							 Bitmapset **candidates)
+{
+	ListCell *lc_strategy, *lc_value;
+	int64 lower = PG_INT64_MIN;
+	int64 upper = PG_INT64_MAX;
+	bool restricted = false;
+	int first;
+	int last;
+
+	*candidates = NULL;
+
+	if (state->num_chunk_ranges == 0)
+		return false;
+
+	forboth (lc_strategy, state->range_strategies, lc_value, state->range_values)
+	{
+		Node *value = lfirst(lc_value);
+		Const *c;
+		int64 internal;
+
+		if (runtime)
+			value = constify_param_mutator(value, state->csstate.ss.ps.state);
+		value = estimate_expression_value(root, value);
+
+		if (!IsA(value, Const))
+			continue;
+
+		/* The comparison operators are strict, so nothing matches a null. */
+		c = castNode(Const, value);
+		if (c->constisnull)
+			return true;
+
+		internal = ts_time_value_to_internal_or_infinite(c->constvalue, c->consttype);
+		restricted = true;
+
+		switch (lfirst_int(lc_strategy))
+		{
+			case BTLessStrategyNumber:
+				upper = Min(upper, internal == PG_INT64_MIN ? internal : internal - 1);
+				break;
+			case BTLessEqualStrategyNumber:
+				upper = Min(upper, internal);
+				break;
+			case BTEqualStrategyNumber:
+				lower = Max(lower, internal);
+				upper = Min(upper, internal);
+				break;
+			case BTGreaterEqualStrategyNumber:
+				lower = Max(lower, internal);
+				break;
+			case BTGreaterStrategyNumber:
+				lower = Max(lower, internal == PG_INT64_MAX ? internal : internal + 1);
+				break;
+			default:
+				Assert(false);
+				break;
+		}
+	}
+
+	if (!restricted)
+		return false;
+
+	/*
+	 * The chunk range [range_start, range_end) overlaps [lower, upper] if
+	 * range_start <= upper and range_end > lower. The ranges with
+	 * range_start <= upper form a prefix of the array, and the ones that
+	 * might have range_end > lower form a suffix.
+	 */
+	int low = 0;
+	int high = state->num_chunk_ranges;
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (state->chunk_ranges[mid].max_range_end > lower)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	first = low;
+
+	high = state->num_chunk_ranges;
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (state->chunk_ranges[mid].range_start <= upper)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	last = low;
+
+	for (int i = first; i < last; i++)
+	{
+		if (state->chunk_ranges[i].range_end > lower)
+			*candidates = bms_add_member(*candidates, state->chunk_ranges[i].subplan);
+	}
+
+	return true;
+}
+
 /*
  * Fetch the constraints for a relation and adjust range table indexes
  * if necessary.
  */
 static void
-initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes)
+initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes,
+					   Bitmapset *excluded_by_range)
 {
 	ListCell *lc_clauses, *lc_plan, *lc_relid;
 	List *constraints = NIL;
 	EState *estate = state->csstate.ss.ps.state;
+	int i = -1;
 
 	if (initial_rt_indexes == NIL)
 		return;
@@ -1210,6 +1439,15 @@ initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes)
 		Index initial_index = lfirst_oid(lc_relid);
 		List *relation_constraints = NIL;
 
+		i++;
+
+		/* The chunks excluded by their time range are not used any further. */
+		if (bms_is_member(i, excluded_by_range))
+		{
+			constraints = lappend(constraints, NIL);
+			continue;
+		}
+
 		if (scan != NULL && scan->scanrelid > 0)
 		{
 			Index rt_index = scan->scanrelid;
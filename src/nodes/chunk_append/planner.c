@@ -19,13 +19,19 @@
 #include <optimizer/subselect.h>
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
 
+#include "dimension.h"
 #include "guc.h"
+#include "hypercube.h"
 #include "import/planner.h"
 #include "nodes/chunk_append/chunk_append.h"
 #include "nodes/chunk_append/transform.h"
 #include "nodes/modify_hypertable.h"
 #include "nodes/vector_agg.h"
+#include "planner/planner.h"
+#include "time_utils.h"
 
 static Sort *make_sort(Plan *lefttree, int numCols, AttrNumber *sortColIdx, Oid *sortOperators,
 					   Oid *collations, bool *nullsFirst);
@@ -93,6 +99,177 @@ adjust_childscan(PlannerInfo *root, Plan *plan, Path *path, List *pathkeys, List
 	return plan;
 }
 
+typedef struct ChunkRangeSort
+{
+	int subplan;
+	int64 range_start;
+	int64 range_end;
+} ChunkRangeSort;
+
+static int
+chunk_range_sort_cmp(const void *left, const void *right)
+{
+	const ChunkRangeSort *l = left;
+	const ChunkRangeSort *r = right;
+
+	if (l->range_start != r->range_start)
+		return l->range_start < r->range_start ? -1 : 1;
+	if (l->range_end != r->range_end)
+		return l->range_end < r->range_end ? -1 : 1;
+	return l->subplan - r->subplan;
+}
+
+/*
+ * Collect the information for the range-based chunk exclusion in the executor.
+ *
+ * Checking every chunk with predicate_refuted_by() during startup and runtime
+ * exclusion is expensive with many chunks, and has to be repeated for every
+ * execution of a generic plan. Most of the time the chunks are excluded based
+ * on the restrictions on the primary time dimension though, so we remember
+ * these restrictions in the form "time_column op expression", and the range of
+ * this dimension for every chunk subplan, sorted by the range start. The
+ * executor evaluates the expressions once and finds the matching chunks by
+ * binary search, see chunk_ranges_find_candidates().
+ *
+ * Returns NIL if there are no usable restrictions. Otherwise a list of the
+ * strategy numbers, the expressions, the subplan indexes sorted by the range
+ * start, and the range starts and ends as int8 constants.
+ */
+static List *
+build_chunk_ranges(PlannerInfo *root, RelOptInfo *rel, CustomPath *path, List *clauses)
+{
+	Hypertable *ht;
+	const Dimension *dim;
+	TypeCacheEntry *tce;
+	ListCell *lc;
+	List *strategies = NIL;
+	List *values = NIL;
+	List *subplans = NIL;
+	List *starts = NIL;
+	List *ends = NIL;
+	ChunkRangeSort *ranges;
+	int num_ranges = 0;
+	int i;
+
+	if (ts_classify_relation(root, rel, &ht) != TS_REL_HYPERTABLE || ht == NULL)
+		return NIL;
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	if (dim == NULL || dim->partitioning != NULL || !IS_VALID_TIME_TYPE(dim->fd.column_type))
+		return NIL;
+
+	tce = lookup_type_cache(dim->fd.column_type, TYPECACHE_BTREE_OPFAMILY);
+
+	foreach (lc, clauses)
+	{
+		Expr *clause = castNode(RestrictInfo, lfirst(lc))->clause;
+		OpExpr *op;
+		Oid opno;
+		Node *value;
+		Var *var;
+		int strategy;
+
+		if (!IsA(clause, OpExpr) || list_length(castNode(OpExpr, clause)->args) != 2)
+			continue;
+
+		op = castNode(OpExpr, clause);
+		opno = op->opno;
+
+		if (IsA(linitial(op->args), Var))
+		{
+			var = linitial(op->args);
+			value = lsecond(op->args);
+		}
+		else if (IsA(lsecond(op->args), Var))
+		{
+			var = lsecond(op->args);
+			value = linitial(op->args);
+			opno = get_commutator(opno);
+		}
+		else
+			continue;
+
+		if (var->varno != (int) rel->relid || var->varattno != dim->column_attno ||
+			var->varlevelsup != 0 || !OidIsValid(opno))
+			continue;
+
+		if (exprType(value) != dim->fd.column_type || contain_var_clause(value) ||
+			contain_volatile_functions(value) || contain_subplans(value))
+			continue;
+
+		strategy = get_op_opfamily_strategy(opno, tce->btree_opf);
+		if (strategy == InvalidStrategy)
+			continue;
+
+		strategies = lappend_int(strategies, strategy);
+		values = lappend(values, value);
+	}
+
+	if (strategies == NIL)
+		return NIL;
+
+	ranges = palloc(sizeof(ChunkRangeSort) * list_length(path->custom_paths));
+	i = 0;
+	foreach (lc, path->custom_paths)
+	{
+		Path *child_path = lfirst(lc);
+		Hypertable *chunk_ht;
+		const Chunk *chunk;
+		const DimensionSlice *slice;
+
+		i++;
+
+		if (ts_classify_relation(root, child_path->parent, &chunk_ht) != TS_REL_CHUNK_CHILD ||
+			chunk_ht->fd.id != ht->fd.id)
+			continue;
+
+		/* The dimension slice of an OSM chunk doesn't reflect the data range. */
+		chunk = ts_planner_chunk_fetch(root, child_path->parent);
+		if (chunk == NULL || chunk->fd.osm_chunk)
+			continue;
+
+		slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+		if (slice == NULL)
+			continue;
+
+		ranges[num_ranges++] = (ChunkRangeSort){
+			.subplan = i - 1,
+			.range_start = slice->fd.range_start,
+			.range_end = slice->fd.range_end,
+		};
+	}
+
+	if (num_ranges == 0)
+		return NIL;
+
+	qsort(ranges, num_ranges, sizeof(ChunkRangeSort), chunk_range_sort_cmp);
+
+	for (i = 0; i < num_ranges; i++)
+	{
+		subplans = lappend_int(subplans, ranges[i].subplan);
+		starts = lappend(starts,
+						 makeConst(INT8OID,
+								   -1,
+								   InvalidOid,
+								   sizeof(int64),
+								   Int64GetDatum(ranges[i].range_start),
+								   false,
+								   FLOAT8PASSBYVAL));
+		ends = lappend(ends,
+					   makeConst(INT8OID,
+								 -1,
+								 InvalidOid,
+								 sizeof(int64),
+								 Int64GetDatum(ranges[i].range_end),
+								 false,
+								 FLOAT8PASSBYVAL));
+	}
+
+	pfree(ranges);
+
+	return list_make5(strategies, values, subplans, starts, ends);
+}
+
 Plan *
 ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path, List *tlist,
 							List *clauses, List *custom_plans)
@@ -103,6 +280,7 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 	List *chunk_rt_indexes = NIL;
 	List *sort_options = NIL;
 	List *custom_private = NIL;
+	List *chunk_ranges = NIL;
 	uint32 limit = 0;
 	List *orig_tlist = NIL;
 
@@ -274,6 +452,9 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 		Assert(list_length(chunk_ri_clauses) == list_length(chunk_rt_indexes));
 	}
 
+	if (capath->startup_exclusion || capath->runtime_exclusion_children)
+		chunk_ranges = build_chunk_ranges(root, rel, path, clauses);
+
 	/* pass down the parent clauses if doing parent exclusion */
 	if (capath->runtime_exclusion_parent)
 	{
@@ -296,6 +477,7 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 	custom_private = lappend(custom_private, chunk_rt_indexes);
 	custom_private = lappend(custom_private, sort_options);
 	custom_private = lappend(custom_private, parent_clauses);
+	custom_private = lappend(custom_private, chunk_ranges);
 
 	cscan->custom_private = custom_private;
 
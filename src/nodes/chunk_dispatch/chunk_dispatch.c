@@ -419,6 +419,7 @@ chunk_dispatch_exec(CustomScanState *node)
 	}
 	/* Calculate the tuple's point in the N-dimensional hyperspace */
 	point = ts_hyperspace_calculate_point(ht->space, (newslot ? newslot : slot));
+	state->point = point;
 
 	/* Save the main table's (hypertable's) ResultRelInfo */
 	if (!dispatch->hypertable_result_rel_info)
@@ -477,6 +478,7 @@ chunk_dispatch_end(CustomScanState *node)
 	PlanState *substate = linitial(node->custom_ps);
 
 	ExecEndNode(substate);
+	ts_chunk_dispatch_buffers_free(state);
 	ts_chunk_dispatch_destroy(state->dispatch);
 	ts_cache_release(&state->hypertable_cache);
 }
@@ -547,4 +549,6 @@ ts_chunk_dispatch_state_set_parent(ChunkDispatchState *state, ModifyTableState *
 	/* Inserts on hypertables should always have one subplan */
 	state->mtstate = mtstate;
 	state->arbiter_indexes = mt_plan->arbiterIndexes;
+
+	ts_chunk_dispatch_buffers_init(state, mtstate);
 }
@@ -89,6 +89,12 @@ typedef struct ChunkDispatchState
 
 	/* Should this INSERT be skipped due to ON CONFLICT DO NOTHING */
 	bool skip_current_tuple;
+
+	/* Point of the current tuple in the hyperspace */
+	struct Point *point;
+
+	/* Buffers for the multi-inserts into the chunks, NULL if not used */
+	struct ChunkInsertBuffers *buffers;
 } ChunkDispatchState;
 
 extern TSDLLEXPORT bool ts_is_chunk_dispatch_state(PlanState *state);
@@ -109,5 +115,11 @@ extern void ts_chunk_dispatch_decompress_batches_for_insert(ChunkDispatch *dispa
 extern TupleTableSlot *ts_chunk_dispatch_prepare_tuple_routing(ChunkDispatchState *state,
 															   TupleTableSlot *slot);
 
+extern void ts_chunk_dispatch_buffers_init(ChunkDispatchState *state, ModifyTableState *mtstate);
+extern bool ts_chunk_dispatch_buffers_add(ChunkDispatchState *state, ResultRelInfo *rri,
+										  TupleTableSlot *slot);
+extern void ts_chunk_dispatch_buffers_flush(ChunkDispatchState *state);
+extern void ts_chunk_dispatch_buffers_free(ChunkDispatchState *state);
+
 extern TSDLLEXPORT Path *ts_chunk_dispatch_path_create(PlannerInfo *root, ModifyTablePath *mtpath,
 													   Index hypertable_rti, int subpath_index);
@@ -0,0 +1,423 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/tableam.h>
+#include <commands/trigger.h>
+#include <executor/executor.h>
+#include <executor/tuptable.h>
+#include <nodes/execnodes.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/optimizer.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+
+#include "compat/compat.h"
+#include "chunk_dispatch.h"
+#include "chunk_insert_state.h"
+#include "dimension.h"
+#include "guc.h"
+
+/*
+ * Buffering of the tuples of an INSERT into a hypertable.
+ *
+ * ModifyTable inserts the tuples one at a time with table_tuple_insert(),
+ * which for heap means taking the buffer lock and writing a WAL record for
+ * every tuple. This makes INSERT ... SELECT backfills several times slower
+ * than COPY, which collects the tuples per chunk and writes them with
+ * table_multi_insert(), see copy.c.
+ *
+ * Here, we do the same for the INSERTs. The tuples go through the BEFORE ROW
+ * triggers and the constraint checks in ExecInsert() as usual, and are then
+ * appended to the buffer of their chunk in arrival order, so the rows of a
+ * batch are partitioned by chunk without sorting. The buffers are written out
+ * when they are full and at the end of the statement, and the index entries
+ * and the AFTER ROW triggers are processed at that point.
+ *
+ * Deferring the inserts is only possible when nothing can observe the tuples
+ * before the end of the statement, so this is used only for the plain
+ * INSERTs, without ON CONFLICT, RETURNING, WITH CHECK OPTION, transition
+ * tables or row triggers on the hypertable that have to see the preceding
+ * rows. The same goes for the volatile functions in the source query, like
+ * with COPY, see CIM_SINGLE in PostgreSQL copyfrom.c.
+ *
+ * Setting up the buffers costs more than it saves for the INSERTs of a few
+ * rows, so they are used only when the planner expects more rows than that.
+ */
+
+/* The same limits as for COPY, see copy.c */
+#define MAX_BUFFERED_TUPLES 1000
+#define MAX_BUFFERED_BYTES 65535
+#define MAX_CHUNK_BUFFERS 32
+
+/* The least number of rows the planner has to expect for buffering */
+#define MIN_BUFFERED_INSERT_ROWS 10
+
+typedef struct ChunkInsertBuffer
+{
+	/*
+	 * Point in the chunk to look up its insert state again when flushing,
+	 * because the insert state might be closed in the meantime due to
+	 * timescaledb.max_open_chunks_per_insert.
+	 */
+	Point *point;
+	/* Non-refcounted copy of the chunk tuple descriptor for the slots */
+	TupleDesc tupdesc;
+	BulkInsertState bistate;
+	int nused;
+	TupleTableSlot *slots[MAX_BUFFERED_TUPLES];
+} ChunkInsertBuffer;
+
+typedef struct ChunkInsertBufferEntry
+{
+	int32 chunk_id;
+	ChunkInsertBuffer *buffer;
+} ChunkInsertBufferEntry;
+
+typedef struct ChunkInsertBuffers
+{
+	MemoryContext mcxt;
+	HTAB *buffers; /* chunk_id -> ChunkInsertBuffer */
+	int buffered_tuples;
+	int buffered_bytes;
+} ChunkInsertBuffers;
+
+static HTAB *
+chunk_insert_buffers_create_hash(MemoryContext mcxt)
+{
+	HASHCTL hctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkInsertBufferEntry),
+		.hcxt = mcxt,
+	};
+
+	return hash_create("INSERT chunk buffers", 16, &hctl, HASH_ELEM | HASH_CONTEXT | HASH_BLOBS);
+}
+
+/*
+ * Check whether the plan that produces the tuples to insert calls volatile
+ * functions, which might look at the rows inserted before. The default
+ * expressions of the columns missing from the INSERT are in the target list as
+ * well.
+ */
+static bool
+plan_contains_volatile_functions(PlanState *planstate, void *context)
+{
+	Plan *plan = planstate->plan;
+
+	if (contain_volatile_functions((Node *) plan->targetlist) ||
+		contain_volatile_functions((Node *) plan->qual))
+		return true;
+
+	switch (nodeTag(plan))
+	{
+		case T_Result:
+			if (contain_volatile_functions(castNode(Result, plan)->resconstantqual))
+				return true;
+			break;
+		case T_ValuesScan:
+			if (contain_volatile_functions((Node *) castNode(ValuesScan, plan)->values_lists))
+				return true;
+			break;
+		case T_FunctionScan:
+			if (contain_volatile_functions((Node *) castNode(FunctionScan, plan)->functions))
+				return true;
+			break;
+		default:
+			break;
+	}
+
+	return planstate_tree_walker(planstate, plan_contains_volatile_functions, context);
+}
+
+/*
+ * Check the subplans of the statement for volatile functions. These are the
+ * CTEs and the initplans, which are not part of the source plan tree, e.g. a
+ * CTE is only referenced by its CteScan node.
+ */
+static bool
+subplans_contain_volatile_functions(EState *estate)
+{
+	ListCell *lc;
+
+	foreach (lc, estate->es_subplanstates)
+	{
+		PlanState *subplanstate = lfirst(lc);
+
+		/* The subplans that are not needed are not initialized. */
+		if (subplanstate != NULL && plan_contains_volatile_functions(subplanstate, NULL))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Set up the insert buffers if the INSERT statement allows them.
+ */
+void
+ts_chunk_dispatch_buffers_init(ChunkDispatchState *state, ModifyTableState *mtstate)
+{
+	ModifyTable *mt = castNode(ModifyTable, mtstate->ps.plan);
+	TriggerDesc *trigdesc = mtstate->resultRelInfo->ri_TrigDesc;
+	PlanState *subplanstate = linitial(state->cscan_state.custom_ps);
+	ChunkInsertBuffers *buffers;
+
+	if (!ts_guc_enable_buffered_insert)
+		return;
+
+	if (subplanstate->plan->plan_rows < MIN_BUFFERED_INSERT_ROWS)
+		return;
+
+	if (mtstate->operation != CMD_INSERT || mt->onConflictAction != ONCONFLICT_NONE ||
+		mt->returningLists != NIL || mt->withCheckOptionLists != NIL ||
+		mtstate->mt_transition_capture != NULL)
+		return;
+
+	/* The row triggers might look at the rows inserted before. */
+	if (trigdesc != NULL && (trigdesc->trig_insert_before_row || trigdesc->trig_insert_instead_row))
+		return;
+
+	/* The volatile functions might do the same. */
+	if (plan_contains_volatile_functions(subplanstate, NULL) ||
+		subplans_contain_volatile_functions(mtstate->ps.state))
+		return;
+
+	buffers = palloc0(sizeof(ChunkInsertBuffers));
+	buffers->mcxt = AllocSetContextCreate(mtstate->ps.state->es_query_cxt,
+										  "INSERT chunk buffers",
+										  ALLOCSET_DEFAULT_SIZES);
+	buffers->buffers = chunk_insert_buffers_create_hash(buffers->mcxt);
+	state->buffers = buffers;
+}
+
+static ChunkInsertBuffer *
+chunk_insert_buffer_create(ChunkInsertBuffers *buffers, ChunkInsertState *cis, Point *point)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(buffers->mcxt);
+	ChunkInsertBuffer *buffer = palloc0(sizeof(ChunkInsertBuffer));
+
+	buffer->point = palloc(POINT_SIZE(point->num_coords));
+	memcpy(buffer->point, point, POINT_SIZE(point->num_coords));
+	buffer->bistate = GetBulkInsertState();
+
+	/*
+	 * Avoid the ResourceOwner overhead of pinning the tuple descriptor for
+	 * every slot, see TSCopyMultiInsertBufferInit().
+	 */
+	buffer->tupdesc = CreateTupleDescCopyConstr(RelationGetDescr(cis->rel));
+	Assert(buffer->tupdesc->tdrefcount == -1);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return buffer;
+}
+
+static void
+chunk_insert_buffer_free(ChunkInsertBuffer *buffer)
+{
+	Assert(buffer->nused == 0);
+
+	FreeBulkInsertState(buffer->bistate);
+
+	/* The slots are created on demand, so only a prefix of them exists. */
+	for (int i = 0; i < MAX_BUFFERED_TUPLES && buffer->slots[i] != NULL; i++)
+		ExecDropSingleTupleTableSlot(buffer->slots[i]);
+
+	FreeTupleDesc(buffer->tupdesc);
+	pfree(buffer->point);
+	pfree(buffer);
+}
+
+/*
+ * Write the buffered tuples to the chunk, insert their index entries and
+ * queue the AFTER ROW triggers.
+ */
+static void
+chunk_insert_buffer_flush(ChunkDispatchState *state, ChunkInsertBuffer *buffer)
+{
+	ChunkDispatch *dispatch = state->dispatch;
+	EState *estate = dispatch->estate;
+	ChunkInsertState *cis;
+	ResultRelInfo *rri;
+	MemoryContext oldcontext;
+
+	cis = ts_chunk_dispatch_get_chunk_insert_state(dispatch, buffer->point, NULL, NULL);
+	rri = cis->result_relation_info;
+
+	/* The insert state might be new, see ExecInsert() */
+	if (rri->ri_RelationDesc->rd_rel->relhasindex && rri->ri_IndexRelationDescs == NULL)
+		ExecOpenIndices(rri, false);
+
+	/* table_multi_insert() might leak memory */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	table_multi_insert(rri->ri_RelationDesc,
+					   buffer->slots,
+					   buffer->nused,
+					   estate->es_output_cid,
+					   0,
+					   buffer->bistate);
+	MemoryContextSwitchTo(oldcontext);
+
+	for (int i = 0; i < buffer->nused; i++)
+	{
+		List *recheck_indexes = NIL;
+
+		if (rri->ri_NumIndices > 0)
+			recheck_indexes = ExecInsertIndexTuplesCompat(rri,
+														  buffer->slots[i],
+														  estate,
+														  false,
+														  false,
+														  NULL,
+														  NIL,
+														  false);
+
+		ExecARInsertTriggers(estate, rri, buffer->slots[i], recheck_indexes, NULL);
+		list_free(recheck_indexes);
+		ExecClearTuple(buffer->slots[i]);
+	}
+
+	buffer->nused = 0;
+	table_finish_bulk_insert(rri->ri_RelationDesc, 0);
+}
+
+/*
+ * Flush all the buffers.
+ *
+ * The flush looks up the insert states of the buffered chunks, which can
+ * close the insert state of the current tuple, so this must only be called
+ * when the current tuple is done.
+ */
+void
+ts_chunk_dispatch_buffers_flush(ChunkDispatchState *state)
+{
+	ChunkInsertBuffers *buffers = state->buffers;
+	HASH_SEQ_STATUS status;
+	ChunkInsertBufferEntry *entry;
+	bool free_buffers;
+
+	if (buffers == NULL || buffers->buffered_tuples == 0)
+		return;
+
+	/*
+	 * Don't keep the buffers of too many chunks around, they take a lot of
+	 * memory. The inserts usually go to a few recent chunks, so it is enough
+	 * to start over when there are too many.
+	 */
+	free_buffers = hash_get_num_entries(buffers->buffers) > MAX_CHUNK_BUFFERS;
+
+	hash_seq_init(&status, buffers->buffers);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->buffer->nused > 0)
+			chunk_insert_buffer_flush(state, entry->buffer);
+
+		if (free_buffers)
+			chunk_insert_buffer_free(entry->buffer);
+	}
+
+	if (free_buffers)
+	{
+		hash_destroy(buffers->buffers);
+		buffers->buffers = chunk_insert_buffers_create_hash(buffers->mcxt);
+	}
+
+	buffers->buffered_tuples = 0;
+	buffers->buffered_bytes = 0;
+
+	/*
+	 * Make the next tuple update the result relation in the on-chunk-changed
+	 * callback, since the lookups above changed the previous insert state
+	 * without it.
+	 */
+	state->dispatch->prev_cis = NULL;
+}
+
+/*
+ * Add the tuple to the buffer of its chunk instead of inserting it.
+ *
+ * Returns false if the tuple has to be inserted directly, because the chunk
+ * needs special handling for inserts.
+ */
+bool
+ts_chunk_dispatch_buffers_add(ChunkDispatchState *state, ResultRelInfo *rri,
+							  TupleTableSlot *slot)
+{
+	ChunkInsertBuffers *buffers = state->buffers;
+	ChunkInsertState *cis = state->cis;
+	ChunkInsertBufferEntry *entry;
+	ChunkInsertBuffer *buffer;
+	TupleTableSlot *batchslot;
+	bool found;
+
+	if (buffers == NULL)
+		return false;
+
+	/*
+	 * The inserts into compressed chunks must check the unique constraints
+	 * against the decompressed batches, and the chunks using our table access
+	 * method handle the inserts themselves.
+	 */
+	if (cis->chunk_compressed || cis->use_tam || rri->ri_FdwRoutine != NULL)
+		return false;
+
+	entry = hash_search(buffers->buffers, &cis->chunk_id, HASH_ENTER, &found);
+	if (!found)
+		entry->buffer = chunk_insert_buffer_create(buffers, cis, state->point);
+
+	buffer = entry->buffer;
+	Assert(buffer->nused < MAX_BUFFERED_TUPLES);
+
+	if (buffer->slots[buffer->nused] == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(buffers->mcxt);
+
+		buffer->slots[buffer->nused] =
+			MakeSingleTupleTableSlot(buffer->tupdesc, table_slot_callbacks(rri->ri_RelationDesc));
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	batchslot = buffer->slots[buffer->nused++];
+	ExecCopySlot(batchslot, slot);
+	buffers->buffered_tuples++;
+
+	/* There is no generic way to get the size of a tuple. */
+	if (TTS_IS_HEAPTUPLE(batchslot) || TTS_IS_BUFFERTUPLE(batchslot))
+		buffers->buffered_bytes += ((HeapTupleTableSlot *) batchslot)->tuple->t_len;
+
+	if (buffers->buffered_tuples >= MAX_BUFFERED_TUPLES ||
+		buffers->buffered_bytes >= MAX_BUFFERED_BYTES)
+		ts_chunk_dispatch_buffers_flush(state);
+
+	return true;
+}
+
+/*
+ * Release the buffers at the end of the statement. All the tuples must have
+ * been flushed.
+ */
+void
+ts_chunk_dispatch_buffers_free(ChunkDispatchState *state)
+{
+	ChunkInsertBuffers *buffers = state->buffers;
+	HASH_SEQ_STATUS status;
+	ChunkInsertBufferEntry *entry;
+
+	if (buffers == NULL)
+		return;
+
+	Assert(buffers->buffered_tuples == 0);
+
+	hash_seq_init(&status, buffers->buffers);
+	while ((entry = hash_seq_search(&status)) != NULL)
+		chunk_insert_buffer_free(entry->buffer);
+
+	MemoryContextDelete(buffers->mcxt);
+	pfree(buffers);
+	state->buffers = NULL;
+}
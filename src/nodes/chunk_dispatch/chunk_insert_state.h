@@ -55,6 +55,9 @@ typedef struct ChunkInsertState
 	bool chunk_compressed;
 	bool chunk_partial;
 
+	/* Rows go directly to the compressed chunk, see copy.c */
+	bool compress_direct;
+
 	/* Chunk uses our own table access method */
 	bool use_tam;
 } ChunkInsertState;
@@ -941,6 +941,18 @@ ExecInsert(ModifyTableContext *context,
 
 			/* Since there was no insertion conflict, we're done */
 		}
+		else if (ts_chunk_dispatch_buffers_add(cds, resultRelInfo, slot))
+		{
+			/*
+			 * The tuple is inserted together with the other tuples of the
+			 * chunk, which also takes care of the index entries and the
+			 * AFTER ROW triggers.
+			 */
+			if (canSetTag)
+				(estate->es_processed)++;
+
+			return NULL;
+		}
 		else
 		{
 			/* insert the tuple normally */
@@ -2760,6 +2772,10 @@ ExecModifyTable(CustomScanState *cs_node, PlanState *pstate)
 							node->canSetTag);
 	}
 
+	/* Insert the tuples buffered for the chunks */
+	if (cds != NULL)
+		ts_chunk_dispatch_buffers_flush(cds);
+
 	/*
 	 * We're done, but fire AFTER STATEMENT triggers before exiting.
 	 */
@@ -74,6 +74,7 @@
 #include "partitioning.h"
 #include "process_utility.h"
 #include "scan_iterator.h"
+#include "shared_chunk_cache.h"
 #include "time_utils.h"
 #include "trigger.h"
 #include "ts_catalog/array_utils.h"
@@ -5093,6 +5094,26 @@ process_create_stmt(ProcessUtilityArgs *args)
 	return DDL_CONTINUE;
 }
 
+/*
+ * The changes of a prepared transaction become visible at COMMIT PREPARED,
+ * which doesn't run the transaction callbacks of the prepared transaction. We
+ * don't know whether it modified the chunk metadata, so always invalidate the
+ * shared chunk cache after it commits. This is rare enough to not matter.
+ */
+static DDLResult
+process_transaction(ProcessUtilityArgs *args)
+{
+	TransactionStmt *stmt = castNode(TransactionStmt, args->parsetree);
+
+	if (stmt->kind != TRANS_STMT_COMMIT_PREPARED)
+		return DDL_CONTINUE;
+
+	prev_ProcessUtility(args);
+	ts_shared_chunk_cache_invalidate();
+
+	return DDL_DONE;
+}
+
 static DDLResult
 process_refresh_mat_view_start(ProcessUtilityArgs *args)
 {
@@ -5225,6 +5246,10 @@ process_ddl_command_start(ProcessUtilityArgs *args)
 			check_read_only = false;
 			handler = process_explain_start;
 			break;
+		case T_TransactionStmt:
+			check_read_only = false;
+			handler = process_transaction;
+			break;
 
 		default:
 			handler = NULL;
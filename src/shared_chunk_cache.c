@@ -0,0 +1,349 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+#include "chunk.h"
+#include "dimension_slice.h"
+#include "guc.h"
+#include "hypercube.h"
+#include "loader/chunk_cache_shmem.h"
+#include "shared_chunk_cache.h"
+#include "ts_catalog/catalog.h"
+
+/*
+ * Shared cache of chunk hypercubes.
+ *
+ * Building the hypercube of a chunk requires scanning the dimension slices
+ * referenced by its constraints. The backends cache the hypertables, but not
+ * the hypercubes of all chunks, so every new backend has to scan the slices
+ * of all chunks it touches. With many chunks and short-lived connections this
+ * becomes a noticeable part of the planning time, so we keep the hypercubes in
+ * a hash table in shared memory. The memory is allocated by the loader, see
+ * loader/chunk_cache_shmem.c, and the cache is not available if the loader is
+ * not preloaded or the cache is disabled there.
+ *
+ * The entries are invalidated by a single generation counter, and an entry is
+ * valid only if it was added at the current generation:
+ *
+ * 1. The transaction that modifies the chunk constraints or the dimension
+ *    slices increments the generation when it commits. At this point its
+ *    changes are already visible to the other backends, and it still holds its
+ *    locks. The changes of an aborted transaction were never visible, so the
+ *    cache stays valid then.
+ *    This transaction doesn't use the cache itself, because the metadata scans
+ *    see its own uncommitted changes. The changes of a prepared transaction
+ *    become visible at COMMIT PREPARED, which doesn't know whether the
+ *    transaction modified the metadata, so it always increments the
+ *    generation.
+ *
+ * 2. A backend reads the generation before scanning the metadata, and adds the
+ *    hypercubes it has built only if the generation is still the same, so the
+ *    hypercubes built from the metadata that changed concurrently are never
+ *    added.
+ *
+ * 3. On a standby, the metadata changes are replayed without running our
+ *    transaction callbacks, so we increment the generation when receiving the
+ *    hypertable cache invalidation that is sent on these changes. The same
+ *    happens when the extension is dropped or created, because the chunk ids
+ *    are reused then. The chunk catalog table is also a part of the key for
+ *    the latter reason.
+ *
+ * The generation is common for all databases, which is simpler and doesn't
+ * matter much because the metadata changes that require invalidation are
+ * infrequent.
+ */
+
+/*
+ * When the cache is full, we remove this fraction of its entries at once, see
+ * shared_chunk_cache_evict().
+ */
+#define SHARED_CHUNK_CACHE_EVICT_FRACTION 16
+
+static SharedChunkCacheRendezvous *shared_cache = NULL;
+static bool shared_cache_attached = false;
+
+/*
+ * Whether the current transaction has modified the chunk constraints or the
+ * dimension slices.
+ */
+static bool metadata_modified = false;
+
+/* The counters of this backend, for testing */
+static SharedChunkCacheStats stats = { 0 };
+
+static SharedChunkCacheRendezvous *
+shared_chunk_cache_attach(void)
+{
+	if (!shared_cache_attached)
+	{
+		SharedChunkCacheRendezvous **rendezvous =
+			(SharedChunkCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_SHARED_CHUNK_CACHE);
+		shared_cache = *rendezvous;
+		shared_cache_attached = true;
+	}
+
+	return shared_cache;
+}
+
+/*
+ * Get the current generation of the cache, to be used for the lookups and
+ * additions. Must be called before scanning the chunk metadata. Returns 0 if
+ * the cache cannot be used.
+ */
+uint64
+ts_shared_chunk_cache_get_generation(void)
+{
+	if (!ts_guc_enable_shared_chunk_cache || metadata_modified)
+		return 0;
+
+	SharedChunkCacheRendezvous *cache = shared_chunk_cache_attach();
+	if (cache == NULL)
+		return 0;
+
+	return pg_atomic_read_u64(cache->generation);
+}
+
+static void
+shared_chunk_cache_init_key(SharedChunkCacheKey *key)
+{
+	memset(key, 0, sizeof(*key));
+	key->database_id = MyDatabaseId;
+	key->chunk_catalog_id = catalog_get_table_id(ts_catalog_get(), CHUNK);
+}
+
+/*
+ * Fill in the hypercubes of the given chunks that are found in the cache. The
+ * chunk constraints must be already filled in, and the hypercubes are
+ * allocated on the given memory context. Returns the number of chunks found.
+ */
+int
+ts_shared_chunk_cache_lookup(uint64 generation, Chunk **chunks, int num_chunks,
+							 MemoryContext mctx)
+{
+	SharedChunkCacheRendezvous *cache = shared_chunk_cache_attach();
+	int num_found = 0;
+
+	SharedChunkCacheKey key;
+
+	if (generation == 0 || cache == NULL)
+		return 0;
+
+	shared_chunk_cache_init_key(&key);
+
+	MemoryContext old = MemoryContextSwitchTo(mctx);
+	LWLockAcquire(cache->lock, LW_SHARED);
+
+	for (int i = 0; i < num_chunks; i++)
+	{
+		Chunk *chunk = chunks[i];
+
+		Assert(chunk->cube == NULL);
+		key.chunk_id = chunk->fd.id;
+
+		const SharedChunkCacheEntry *entry = hash_search(cache->entries, &key, HASH_FIND, NULL);
+		if (entry == NULL || entry->generation != generation ||
+			entry->num_slices != chunk->constraints->num_dimension_constraints)
+		{
+			continue;
+		}
+
+		Hypercube *cube = ts_hypercube_alloc(entry->num_slices);
+		for (int j = 0; j < entry->num_slices; j++)
+		{
+			const SharedChunkCacheSlice *cached = &entry->slices[j];
+			DimensionSlice *slice = ts_dimension_slice_create(cached->dimension_id,
+															  cached->range_start,
+															  cached->range_end);
+			slice->fd.id = cached->id;
+			cube->slices[cube->num_slices++] = slice;
+		}
+
+		chunk->cube = cube;
+		num_found++;
+	}
+
+	LWLockRelease(cache->lock);
+	MemoryContextSwitchTo(old);
+
+	stats.hits += num_found;
+	stats.misses += num_chunks - num_found;
+
+	return num_found;
+}
+
+/*
+ * Make room in the cache. First we remove the stale entries. If there are
+ * not enough of them, the cache is too small for the chunks in use, and we
+ * remove some arbitrary valid entries as well. We remove a fraction of the
+ * cache at once, so that we don't have to scan the cache for every added
+ * entry, but keep the rest of the entries, so that the cache still works
+ * when the number of chunks in use exceeds its size.
+ */
+static void
+shared_chunk_cache_evict(SharedChunkCacheRendezvous *cache, uint64 generation)
+{
+	HASH_SEQ_STATUS status;
+	SharedChunkCacheEntry *entry;
+	const long min_removed = Max(1, cache->max_entries / SHARED_CHUNK_CACHE_EVICT_FRACTION);
+	long removed = 0;
+
+	hash_seq_init(&status, cache->entries);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->generation != generation)
+		{
+			hash_search(cache->entries, &entry->key, HASH_REMOVE, NULL);
+			removed++;
+		}
+	}
+
+	if (removed >= min_removed)
+		return;
+
+	hash_seq_init(&status, cache->entries);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		hash_search(cache->entries, &entry->key, HASH_REMOVE, NULL);
+		removed++;
+
+		if (removed >= min_removed)
+		{
+			hash_seq_term(&status);
+			break;
+		}
+	}
+}
+
+/*
+ * Add the hypercubes of the given chunks to the cache. The generation must be
+ * the one that was read before scanning the metadata of these chunks.
+ */
+void
+ts_shared_chunk_cache_add(uint64 generation, Chunk *const *chunks, int num_chunks)
+{
+	SharedChunkCacheRendezvous *cache = shared_chunk_cache_attach();
+	SharedChunkCacheKey key;
+
+	if (generation == 0 || cache == NULL)
+		return;
+
+	shared_chunk_cache_init_key(&key);
+
+	LWLockAcquire(cache->lock, LW_EXCLUSIVE);
+
+	/* The metadata might have changed while we were scanning it. */
+	if (pg_atomic_read_u64(cache->generation) != generation)
+	{
+		LWLockRelease(cache->lock);
+		return;
+	}
+
+	for (int i = 0; i < num_chunks; i++)
+	{
+		const Hypercube *cube = chunks[i]->cube;
+		bool found;
+
+		if (cube == NULL || cube->num_slices > SHARED_CHUNK_CACHE_MAX_SLICES)
+			continue;
+
+		if (hash_get_num_entries(cache->entries) >= cache->max_entries)
+			shared_chunk_cache_evict(cache, generation);
+
+		key.chunk_id = chunks[i]->fd.id;
+		SharedChunkCacheEntry *entry = hash_search(cache->entries, &key, HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+			break;
+
+		if (found && entry->generation == generation)
+			continue;
+
+		entry->generation = generation;
+		entry->num_slices = cube->num_slices;
+		for (int j = 0; j < cube->num_slices; j++)
+		{
+			const DimensionSlice *slice = cube->slices[j];
+			entry->slices[j] = (SharedChunkCacheSlice){
+				.id = slice->fd.id,
+				.dimension_id = slice->fd.dimension_id,
+				.range_start = slice->fd.range_start,
+				.range_end = slice->fd.range_end,
+			};
+		}
+
+		stats.added++;
+	}
+
+	LWLockRelease(cache->lock);
+}
+
+/*
+ * Called when the current transaction modifies the chunk constraints or the
+ * dimension slices.
+ */
+void
+ts_shared_chunk_cache_metadata_modified(void)
+{
+	metadata_modified = true;
+}
+
+/*
+ * Called at the end of the transaction. On commit, this happens after the
+ * changes are visible to the other backends.
+ */
+void
+ts_shared_chunk_cache_xact_end(bool commit)
+{
+	if (!metadata_modified)
+		return;
+
+	metadata_modified = false;
+
+	if (commit)
+		ts_shared_chunk_cache_invalidate();
+}
+
+/*
+ * Called when the current transaction is prepared. Its changes are not visible
+ * yet, and the cache is invalidated at COMMIT PREPARED instead, see
+ * process_utility.c. The backend is not in this transaction anymore, so it
+ * can use the cache again.
+ */
+void
+ts_shared_chunk_cache_xact_prepare(void)
+{
+	metadata_modified = false;
+}
+
+void
+ts_shared_chunk_cache_invalidate(void)
+{
+	SharedChunkCacheRendezvous *cache = shared_chunk_cache_attach();
+
+	if (cache != NULL)
+	{
+		pg_atomic_fetch_add_u64(cache->generation, 1);
+		stats.invalidations++;
+	}
+}
+
+SharedChunkCacheStats
+ts_shared_chunk_cache_get_stats(bool reset)
+{
+	SharedChunkCacheRendezvous *cache = shared_chunk_cache_attach();
+	SharedChunkCacheStats result = stats;
+
+	if (cache != NULL)
+		result.generation = pg_atomic_read_u64(cache->generation);
+
+	if (reset)
+		memset(&stats, 0, sizeof(stats));
+
+	return result;
+}
@@ -0,0 +1,31 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include "chunk.h"
+#include "export.h"
+
+typedef struct SharedChunkCacheStats
+{
+	int64 hits;			 /* chunks found in the cache */
+	int64 misses;		 /* chunks looked up but not found */
+	int64 added;		 /* chunks added to the cache */
+	int64 invalidations; /* generation increments by this backend */
+	uint64 generation;	 /* current generation, 0 if there is no cache */
+} SharedChunkCacheStats;
+
+extern uint64 ts_shared_chunk_cache_get_generation(void);
+extern int ts_shared_chunk_cache_lookup(uint64 generation, Chunk **chunks, int num_chunks,
+										MemoryContext mctx);
+extern void ts_shared_chunk_cache_add(uint64 generation, Chunk *const *chunks, int num_chunks);
+
+extern void ts_shared_chunk_cache_metadata_modified(void);
+extern void ts_shared_chunk_cache_xact_end(bool commit);
+extern void ts_shared_chunk_cache_xact_prepare(void);
+extern void ts_shared_chunk_cache_invalidate(void);
+extern TSDLLEXPORT SharedChunkCacheStats ts_shared_chunk_cache_get_stats(bool reset);
@@ -19,8 +19,10 @@
 #include <utils/syscache.h>
 
 #include "compat/compat.h"
+#include "annotations.h"
 #include "cache_invalidate.h"
 #include "extension.h"
+#include "shared_chunk_cache.h"
 #include "ts_catalog/catalog.h"
 #include "utils.h"
 
@@ -475,7 +477,8 @@ ts_catalog_get(void)
 							  s_catalog.extension_schema_id[TS_CACHE_SCHEMA]);
 
 	ts_cache_invalidate_set_proxy_tables(s_catalog.caches[CACHE_TYPE_HYPERTABLE].inval_proxy_id,
-										 s_catalog.caches[CACHE_TYPE_BGW_JOB].inval_proxy_id);
+										 s_catalog.caches[CACHE_TYPE_BGW_JOB].inval_proxy_id,
+										 catalog_get_table_id(&s_catalog, DIMENSION_SLICE));
 
 	for (i = 0; i < _MAX_INTERNAL_FUNCTIONS; i++)
 	{
@@ -509,7 +512,7 @@ ts_catalog_reset(void)
 	s_catalog.initialized = false;
 	database_info.database_id = InvalidOid;
 
-	ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid);
+	ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid, InvalidOid);
 }
 
 static CatalogTable
@@ -723,9 +726,27 @@ ts_catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 
 	switch (table)
 	{
-		case CHUNK:
-		case CHUNK_CONSTRAINT:
 		case DIMENSION_SLICE:
+			/* The chunk hypercubes in the shared cache might be affected. */
+			ts_shared_chunk_cache_metadata_modified();
+
+			/*
+			 * The new slices are added to the dimension slice indexes of all
+			 * backends in place, so the inserts only have to notify them
+			 * through the dimension_slice table itself. The other changes
+			 * invalidate the hypertable cache, which rebuilds the indexes.
+			 */
+			if (operation == CMD_INSERT)
+				relid = catalog_relid;
+			else
+				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
+			CacheInvalidateRelcacheByRelid(relid);
+			break;
+		case CHUNK_CONSTRAINT:
+			/* The chunk hypercubes in the shared cache might be affected. */
+			ts_shared_chunk_cache_metadata_modified();
+			TS_FALLTHROUGH;
+		case CHUNK:
 			if (operation == CMD_UPDATE || operation == CMD_DELETE)
 			{
 				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
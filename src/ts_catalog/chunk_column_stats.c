@@ -1257,6 +1257,17 @@ invalidate_range_tuple_found(TupleInfo *ti, void *data)
 	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
 	bool valid = false;
 
+	/*
+	 * Don't update the entries that are invalid already, every catalog update
+	 * invalidates the hypertable cache.
+	 */
+	if (!((Form_chunk_column_stats) GETSTRUCT(tuple))->valid)
+	{
+		if (should_free)
+			heap_freetuple(tuple);
+		return SCAN_CONTINUE;
+	}
+
 	Datum values[Natts_chunk_column_stats] = { 0 };
 	bool isnull[Natts_chunk_column_stats] = { 0 };
 	bool doReplace[Natts_chunk_column_stats] = { 0 };
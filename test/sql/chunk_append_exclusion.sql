@@ -0,0 +1,54 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test the exclusion of chunks by their time range in ChunkAppend with generic
+-- plans, where the restrictions are only known at execution time.
+CREATE TABLE ranged(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('ranged', 'time', chunk_time_interval => 10);
+INSERT INTO ranged SELECT t, t % 3, t FROM generate_series(0, 99) t;
+ANALYZE ranged;
+
+CREATE FUNCTION excluded_chunks(query text) RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off, summary off) ' || query
+    LOOP
+        IF line LIKE '%excluded%' THEN
+            RETURN NEXT trim(line);
+        END IF;
+    END LOOP;
+END;
+$$;
+
+SET plan_cache_mode TO force_generic_plan;
+
+PREPARE after(int) AS SELECT count(*) FROM ranged WHERE time > $1;
+EXECUTE after(75);
+SELECT excluded_chunks('EXECUTE after(75)');
+
+PREPARE between(int, int) AS SELECT count(*) FROM ranged WHERE time >= $1 AND time < $2;
+EXECUTE between(25, 45);
+SELECT excluded_chunks('EXECUTE between(25, 45)');
+-- The empty range doesn't match any chunk.
+EXECUTE between(45, 25);
+SELECT excluded_chunks('EXECUTE between(45, 25)');
+
+PREPARE exact(int) AS SELECT count(*) FROM ranged WHERE time = $1;
+EXECUTE exact(57);
+SELECT excluded_chunks('EXECUTE exact(57)');
+EXECUTE exact(NULL);
+SELECT excluded_chunks('EXECUTE exact(NULL)');
+
+-- The restrictions on the other columns don't prevent the exclusion by the
+-- time range.
+PREPARE mixed(int, int) AS SELECT count(*) FROM ranged WHERE time < $1 AND value > $2;
+EXECUTE mixed(50, 35);
+SELECT excluded_chunks('EXECUTE mixed(50, 35)');
+
+RESET plan_cache_mode;
+DEALLOCATE ALL;
+DROP TABLE ranged;
+DROP FUNCTION excluded_chunks(text);
@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION test.copy_buffer_stats(OUT flushes int8, OUT tuples_flushed int8,
+    OUT evictions int8)
+    AS :MODULE_PATHNAME, 'ts_test_copy_buffer_stats' LANGUAGE C VOLATILE;
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+
+CREATE TABLE copybuf(time int NOT NULL, device int NOT NULL);
+SELECT table_name FROM create_hypertable('copybuf', 'time', chunk_time_interval => 1000000);
+SELECT column_name FROM add_dimension('copybuf', 'device', number_partitions => 64);
+SELECT FROM test.copy_buffer_stats();
+
+-- The tuples are spread over 64 chunks. Each chunk is written in one batch
+-- at the end, instead of flushing all buffers every 1000 tuples.
+\copy copybuf from program 'bash -c "paste <(seq 0 19999) <(seq 0 19999)"'
+SELECT count(*) FROM show_chunks('copybuf');
+SELECT flushes, tuples_flushed / flushes AS avg_batch, evictions FROM test.copy_buffer_stats();
+
+-- With little memory the largest buffers are flushed when the limit is
+-- reached, and the buffers of the chunks with the fewest tuples are evicted.
+SET timescaledb.copy_buffer_memory TO '64kB';
+\copy copybuf from program 'bash -c "paste <(seq 1000000 1019999) <(seq 0 19999)"'
+SELECT count(*) FROM show_chunks('copybuf');
+SELECT flushes > 64 AS more_flushes, tuples_flushed, tuples_flushed / flushes > 15 AS large_batches,
+    evictions > 0 AS evicted
+FROM test.copy_buffer_stats();
+RESET timescaledb.copy_buffer_memory;
+
+SELECT count(*), count(DISTINCT device) FROM copybuf;
+
+DROP TABLE copybuf;
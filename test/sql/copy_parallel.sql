@@ -0,0 +1,90 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test the COPY with the input values converted by parallel workers. The rows
+-- are the same as with the serial COPY, and they are inserted in the input
+-- order.
+CREATE TABLE copypar(time int NOT NULL, device int, value float, note text DEFAULT 'none');
+SELECT table_name FROM create_hypertable('copypar', 'time', chunk_time_interval => 1000);
+
+SET timescaledb.copy_parallel_workers = 2;
+
+-- The columns that are not in the input get their defaults. NULLs, quoted
+-- newlines and the header of CSV work as usual.
+COPY copypar(time, device, value) FROM STDIN;
+1	1	1.5
+2	\N	2.5
+\.
+COPY copypar FROM STDIN WITH (FORMAT csv, HEADER);
+time,device,value,note
+3,3,3.5,"two
+lines"
+4,4,,"quoted, comma"
+\.
+COPY copypar FROM STDIN WHERE device > 5;
+5	5	5.5	skipped
+6	6	6.5	kept
+\.
+SELECT time, device, value, replace(note, E'\n', ' / ') AS note FROM copypar ORDER BY time;
+
+-- The errors of the input and of the constraints are reported as usual.
+\set ON_ERROR_STOP 0
+COPY copypar(time, device, value) FROM STDIN;
+7	7	7.5
+8	8
+\.
+COPY copypar(time, device, value) FROM STDIN;
+7	7	7.5
+8	8	8.5	extra
+\.
+COPY copypar(time, device, value) FROM STDIN;
+7	7	7.5
+\N	8	8.5
+\.
+\set ON_ERROR_STOP 1
+SELECT count(*) FROM copypar;
+
+-- Larger input is converted in several segments, and the rows are inserted
+-- in the input order, as the row trigger sees them.
+TRUNCATE copypar;
+CREATE TABLE copypar_log(seq serial, time int);
+CREATE FUNCTION copypar_log_row() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    INSERT INTO copypar_log(time) VALUES (NEW.time);
+    RETURN NEW;
+END
+$$;
+CREATE TRIGGER copypar_log BEFORE INSERT ON copypar
+    FOR EACH ROW EXECUTE FUNCTION copypar_log_row();
+
+SET maintenance_work_mem = '1MB';
+\copy copypar(time, device, value) from program 'bash -c "paste <(seq 1 50000) <(seq 1 50000) <(seq 1 50000)"'
+RESET maintenance_work_mem;
+
+SELECT count(*), min(time), max(time), count(*) FILTER (WHERE note = 'none') AS defaults
+FROM copypar;
+SELECT count(*) FROM (
+    SELECT time, device, value FROM copypar
+    EXCEPT SELECT g, g, g FROM generate_series(1, 50000) g) d;
+SELECT count(*) AS out_of_order FROM copypar_log WHERE time <> seq;
+
+DROP TRIGGER copypar_log ON copypar;
+
+-- Without any available workers, the rest of the input is copied serially.
+DELETE FROM copypar;
+SET max_parallel_workers = 0;
+SET client_min_messages TO DEBUG1;
+COPY copypar FROM STDIN;
+1	1	1.5	one
+2	2	2.5	two
+\.
+RESET client_min_messages;
+RESET max_parallel_workers;
+SELECT * FROM copypar ORDER BY time;
+
+RESET timescaledb.copy_parallel_workers;
+
+DROP TABLE copypar;
+DROP TABLE copypar_log;
+DROP FUNCTION copypar_log_row();
@@ -0,0 +1,73 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION test.dimension_slice_index_stats(OUT lookups int8, OUT builds int8,
+    OUT slices_examined int8, OUT slices_matched int8, OUT slices_added int8)
+    AS :MODULE_PATHNAME, 'ts_test_dimension_slice_index_stats' LANGUAGE C VOLATILE;
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+
+-- The planning might look up the slices more than once per query, so show
+-- the numbers of slices per lookup.
+CREATE VIEW slice_index_stats AS
+SELECT lookups > 0 AS used, builds,
+    coalesce(slices_examined / nullif(lookups, 0), 0) AS examined,
+    coalesce(slices_matched / nullif(lookups, 0), 0) AS matched,
+    slices_added AS added
+FROM test.dimension_slice_index_stats();
+
+CREATE TABLE sliced(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('sliced', 'time', chunk_time_interval => 10);
+INSERT INTO sliced SELECT t, t % 3, t FROM generate_series(0, 99) t;
+SELECT FROM test.dimension_slice_index_stats();
+
+-- The index is built on first use and only the matching slices are examined.
+SELECT count(*) FROM sliced WHERE time >= 25 AND time < 45;
+SELECT * FROM slice_index_stats;
+SELECT count(*) FROM sliced WHERE time < 15;
+SELECT * FROM slice_index_stats;
+SELECT count(*) FROM sliced WHERE time = 57;
+SELECT * FROM slice_index_stats;
+SELECT count(*) FROM sliced WHERE time > 1000;
+SELECT * FROM slice_index_stats;
+
+-- A new chunk is added to the index and seen by the next query.
+INSERT INTO sliced VALUES (150, 1, 1);
+SELECT count(*) FROM sliced WHERE time > 95;
+SELECT * FROM slice_index_stats;
+
+-- Dropped chunks are not.
+SELECT count(*) FROM drop_chunks('sliced', older_than => 50);
+SELECT FROM test.dimension_slice_index_stats();
+SELECT count(*) FROM sliced WHERE time < 55;
+SELECT * FROM slice_index_stats;
+
+-- The aborted changes are not visible after rollback.
+BEGIN;
+INSERT INTO sliced VALUES (-5, 1, 1);
+SELECT count(*) FROM sliced WHERE time < 55;
+SELECT * FROM slice_index_stats;
+ROLLBACK;
+SELECT count(*) FROM sliced WHERE time < 55;
+SELECT * FROM slice_index_stats;
+
+-- Closed dimensions use the index as well, and the results are the same as
+-- with the catalog scan.
+CREATE TABLE space(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('space', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO space SELECT t, t % 3, t FROM generate_series(0, 99) t;
+SELECT FROM test.dimension_slice_index_stats();
+SELECT count(*) FROM space WHERE device = 1 AND time < 30;
+SELECT count(*) FROM space WHERE device IN (1, 2) AND time >= 90;
+SELECT used, builds FROM slice_index_stats;
+
+SET timescaledb.enable_dimension_slice_index TO off;
+SELECT count(*) FROM space WHERE device = 1 AND time < 30;
+SELECT count(*) FROM space WHERE device IN (1, 2) AND time >= 90;
+SELECT * FROM slice_index_stats;
+RESET timescaledb.enable_dimension_slice_index;
+
+DROP TABLE sliced;
+DROP TABLE space;
+DROP VIEW slice_index_stats;
@@ -0,0 +1,71 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test the buffering of the tuples of INSERT statements.
+CREATE TABLE buffered(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('buffered', 'time', chunk_time_interval => 10);
+CREATE INDEX ON buffered(device, time);
+
+-- The AFTER ROW triggers are fired when the buffers are flushed.
+CREATE TABLE inserted(n int);
+INSERT INTO inserted VALUES (0);
+CREATE FUNCTION count_inserted() RETURNS trigger LANGUAGE plpgsql AS
+$$
+BEGIN
+    UPDATE inserted SET n = n + 1;
+    RETURN NULL;
+END;
+$$;
+CREATE TRIGGER count_inserted AFTER INSERT ON buffered
+    FOR EACH ROW EXECUTE FUNCTION count_inserted();
+
+-- The rows go to all the chunks in turn, and there are fewer open chunks than
+-- buffers, so the chunks are closed and reopened while they have buffered
+-- tuples.
+SET timescaledb.max_open_chunks_per_insert TO 2;
+INSERT INTO buffered SELECT t % 100, t % 7, t FROM generate_series(0, 2999) t;
+SELECT count(*), sum(value) FROM buffered;
+SELECT n FROM inserted;
+SELECT count(*) FROM show_chunks('buffered');
+
+-- The index entries are inserted as well.
+SET enable_seqscan TO off;
+SELECT count(*), sum(value) FROM buffered WHERE device = 3;
+RESET enable_seqscan;
+RESET timescaledb.max_open_chunks_per_insert;
+
+-- The inserts with RETURNING are not buffered.
+INSERT INTO buffered VALUES (5, 1, 1), (15, 1, 1), (105, 1, 1) RETURNING time;
+SELECT count(*) FROM buffered WHERE value = 1;
+
+SET timescaledb.enable_buffered_insert TO off;
+INSERT INTO buffered SELECT t % 100, t % 7, t FROM generate_series(0, 2999) t;
+RESET timescaledb.enable_buffered_insert;
+SELECT count(*), sum(value) FROM buffered;
+SELECT n FROM inserted;
+
+-- The volatile functions in the source query see the rows inserted by the
+-- statement before, so these inserts are not buffered, and neither are the
+-- ones with volatile column defaults.
+CREATE TABLE counted(time int NOT NULL, n bigint);
+SELECT table_name FROM create_hypertable('counted', 'time', chunk_time_interval => 10);
+CREATE FUNCTION count_counted() RETURNS bigint LANGUAGE sql VOLATILE AS
+$$ SELECT count(*) FROM counted $$;
+INSERT INTO counted SELECT t, count_counted() FROM generate_series(0, 29) t;
+SELECT min(n), max(n), count(DISTINCT n) FROM counted;
+ALTER TABLE counted ALTER COLUMN n SET DEFAULT count_counted();
+INSERT INTO counted(time) SELECT t FROM generate_series(30, 59) t;
+SELECT min(n), max(n), count(DISTINCT n) FROM counted WHERE time >= 30;
+
+-- The same goes for the volatile functions in the CTEs, which are not part of
+-- the source plan of the INSERT.
+WITH c AS MATERIALIZED (SELECT t, count_counted() AS n FROM generate_series(60, 89) t)
+INSERT INTO counted SELECT t, n FROM c;
+SELECT min(n), max(n), count(DISTINCT n) FROM counted WHERE time >= 60;
+
+DROP TABLE buffered;
+DROP TABLE inserted;
+DROP TABLE counted;
+DROP FUNCTION count_inserted();
+DROP FUNCTION count_counted();
@@ -0,0 +1,93 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION test.shared_chunk_cache_stats(OUT hits int8, OUT misses int8,
+    OUT added int8, OUT invalidations int8, OUT generation int8)
+    AS :MODULE_PATHNAME, 'ts_test_shared_chunk_cache_stats' LANGUAGE C VOLATILE;
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+
+-- The counters are per backend and reset on every call, but the generation is
+-- shared, so we remember the last one we have seen to check whether it has
+-- advanced. This test runs alone, so only this test advances it.
+CREATE TABLE last_generation(generation int8);
+INSERT INTO last_generation VALUES (0);
+CREATE FUNCTION cache_stats(OUT hit bool, OUT missed bool, OUT added bool,
+    OUT invalidated bool, OUT advanced bool) LANGUAGE plpgsql AS
+$$
+DECLARE
+    stats record;
+BEGIN
+    SELECT * INTO stats FROM test.shared_chunk_cache_stats();
+    SELECT stats.hits > 0, stats.misses > 0, stats.added > 0, stats.invalidations > 0,
+        stats.generation > l.generation
+    INTO hit, missed, added, invalidated, advanced
+    FROM last_generation l;
+    UPDATE last_generation SET generation = stats.generation;
+END;
+$$;
+
+-- Test that the chunk hypercubes in the shared chunk cache stay consistent
+-- with the chunk metadata when it is modified by other backends. Creating the
+-- chunks invalidates the cache.
+CREATE TABLE cached(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('cached', 'time', chunk_time_interval => 10);
+INSERT INTO cached SELECT t, t % 3, t FROM generate_series(0, 99) t;
+SELECT * FROM cache_stats();
+
+-- The first backend adds the hypercubes to the cache, and the next one uses
+-- them.
+SELECT count(*), min(time), max(time) FROM cached WHERE time >= 25;
+SELECT * FROM cache_stats();
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+SELECT count(*), min(time), max(time) FROM cached WHERE time >= 25;
+SELECT * FROM cache_stats();
+
+-- Only the chunks that are not there yet are added.
+SELECT count(*), min(time), max(time) FROM cached;
+SELECT * FROM cache_stats();
+
+-- Drop some chunks and check the results in a new backend. The cached
+-- hypercubes are not used after that.
+SELECT count(*) FROM drop_chunks('cached', older_than => 30);
+SELECT invalidated, advanced FROM cache_stats();
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+SELECT count(*), min(time), max(time) FROM cached;
+SELECT * FROM cache_stats();
+SELECT count(*), min(time), max(time) FROM cached WHERE time < 45;
+SELECT * FROM cache_stats();
+
+-- The transaction that creates new chunks doesn't use the cache, and the
+-- aborted changes are not visible after that. The abort doesn't invalidate the
+-- cache, because the changes were never visible to the other backends.
+BEGIN;
+INSERT INTO cached VALUES (105, 1, 1), (-5, 1, 1);
+SELECT count(*), min(time), max(time) FROM cached;
+ROLLBACK;
+SELECT * FROM cache_stats();
+SELECT count(*), min(time), max(time) FROM cached;
+SELECT * FROM cache_stats();
+
+-- The DDL that doesn't change the chunk constraints keeps the cache valid.
+CREATE INDEX ON cached(device);
+SELECT invalidated, advanced FROM cache_stats();
+SELECT count(*), min(time), max(time) FROM cached WHERE time < 45;
+SELECT * FROM cache_stats();
+
+-- The DDL that adds chunk constraints invalidates it.
+ALTER TABLE cached ADD CONSTRAINT cached_key UNIQUE (time, device);
+SELECT invalidated, advanced FROM cache_stats();
+SELECT count(*), min(time), max(time) FROM cached WHERE time < 45;
+SELECT * FROM cache_stats();
+
+SET timescaledb.enable_shared_chunk_cache TO off;
+SELECT count(*), min(time), max(time) FROM cached WHERE time < 45;
+SELECT * FROM cache_stats();
+RESET timescaledb.enable_shared_chunk_cache;
+
+DROP TABLE cached;
+SELECT invalidated, advanced FROM cache_stats();
+
+DROP FUNCTION cache_stats();
+DROP TABLE last_generation;
@@ -0,0 +1,40 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
+
+#include "copy.h"
+#include "export.h"
+
+TS_FUNCTION_INFO_V1(ts_test_copy_buffer_stats);
+
+/*
+ * Return the counters of the COPY multi-insert buffers since the previous
+ * call.
+ */
+Datum
+ts_test_copy_buffer_stats(PG_FUNCTION_ARGS)
+{
+	CopyBufferStats stats = ts_copy_get_buffer_stats(true);
+	TupleDesc tupdesc;
+	Datum values[3];
+	bool nulls[3] = { false };
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("function returning record called in context "
+						"that cannot accept type record")));
+
+	tupdesc = BlessTupleDesc(tupdesc);
+	values[0] = Int64GetDatum(stats.flushes);
+	values[1] = Int64GetDatum(stats.tuples_flushed);
+	values[2] = Int64GetDatum(stats.evictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -0,0 +1,41 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
+
+#include "dimension_slice_index.h"
+#include "export.h"
+
+TS_FUNCTION_INFO_V1(ts_test_dimension_slice_index_stats);
+
+/*
+ * Return the counters of the dimension slice index since the previous call.
+ */
+Datum
+ts_test_dimension_slice_index_stats(PG_FUNCTION_ARGS)
+{
+	DimensionSliceIndexStats stats = ts_dimension_slice_index_get_stats(true);
+	TupleDesc tupdesc;
+	Datum values[5];
+	bool nulls[5] = { false };
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("function returning record called in context "
+						"that cannot accept type record")));
+
+	tupdesc = BlessTupleDesc(tupdesc);
+	values[0] = Int64GetDatum(stats.lookups);
+	values[1] = Int64GetDatum(stats.builds);
+	values[2] = Int64GetDatum(stats.slices_examined);
+	values[3] = Int64GetDatum(stats.slices_matched);
+	values[4] = Int64GetDatum(stats.slices_added);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -0,0 +1,42 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
+
+#include "export.h"
+#include "shared_chunk_cache.h"
+
+TS_FUNCTION_INFO_V1(ts_test_shared_chunk_cache_stats);
+
+/*
+ * Return the counters of the shared chunk cache for this backend since the
+ * previous call, and the current generation of the cache.
+ */
+Datum
+ts_test_shared_chunk_cache_stats(PG_FUNCTION_ARGS)
+{
+	SharedChunkCacheStats stats = ts_shared_chunk_cache_get_stats(true);
+	TupleDesc tupdesc;
+	Datum values[5];
+	bool nulls[5] = { false };
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("function returning record called in context "
+						"that cannot accept type record")));
+
+	tupdesc = BlessTupleDesc(tupdesc);
+	values[0] = Int64GetDatum(stats.hits);
+	values[1] = Int64GetDatum(stats.misses);
+	values[2] = Int64GetDatum(stats.added);
+	values[3] = Int64GetDatum(stats.invalidations);
+	values[4] = Int64GetDatum((int64) stats.generation);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
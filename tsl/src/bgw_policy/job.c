@@ -32,8 +32,10 @@
 #include "bgw/timer.h"
 #include "bgw_policy/chunk_stats.h"
 #include "bgw_policy/compression_api.h"
+#include "bgw_policy/chunk_precreate.h"
 #include "bgw_policy/continuous_aggregate_api.h"
 #include "bgw_policy/policy_utils.h"
+#include "bgw_policy/precreate_api.h"
 #include "bgw_policy/reorder_api.h"
 #include "bgw_policy/retention_api.h"
 #include "compression/api.h"
@@ -285,6 +287,74 @@ policy_reorder_read_and_validate_config(Jsonb *config, PolicyReorderData *policy
 	}
 }
 
+/*
+ * Get the current time of the hypertable in the internal time format.
+ */
+static int64
+get_precreate_chunks_now(const Dimension *dim)
+{
+	Oid partitioning_type = ts_dimension_get_partition_type(dim);
+
+	if (IS_INTEGER_TYPE(partitioning_type))
+	{
+		Oid now_func = ts_get_integer_now_func(dim, true);
+
+		return ts_sub_integer_from_now(0, partitioning_type, now_func);
+	}
+	else
+	{
+		Interval zero = { 0 };
+		Datum now = subtract_interval_from_now(&zero, partitioning_type);
+
+		return ts_time_value_to_internal(now, partitioning_type);
+	}
+}
+
+bool
+policy_precreate_chunks_execute(int32 job_id, Jsonb *config)
+{
+	PolicyPrecreateChunksData policy;
+	const Dimension *dim;
+	int created;
+
+	policy_precreate_chunks_read_and_validate_config(config, &policy);
+
+	dim = hyperspace_get_open_dimension(policy.hypertable->space, 0);
+	created = ts_bgw_policy_precreate_chunks(policy.hypertable,
+											 get_precreate_chunks_now(dim),
+											 policy.chunks_ahead);
+
+	elog(DEBUG1,
+		 "created %d chunks ahead for hypertable %s.%s",
+		 created,
+		 NameStr(policy.hypertable->fd.schema_name),
+		 NameStr(policy.hypertable->fd.table_name));
+
+	return true;
+}
+
+void
+policy_precreate_chunks_read_and_validate_config(Jsonb *config, PolicyPrecreateChunksData *policy)
+{
+	int32 htid = policy_precreate_chunks_get_hypertable_id(config);
+	int32 chunks_ahead = policy_precreate_chunks_get_chunks_ahead(config);
+	Hypertable *ht = ts_hypertable_get_by_id(htid);
+
+	if (!ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("configuration hypertable id %d not found", htid)));
+
+	policy_precreate_chunks_check_chunks_ahead(chunks_ahead);
+	policy_precreate_chunks_check_time_dimension(ht, hyperspace_get_open_dimension(ht->space, 0));
+
+	if (policy)
+	{
+		policy->hypertable = ht;
+		policy->chunks_ahead = chunks_ahead;
+	}
+}
+
 bool
 policy_retention_execute(int32 job_id, Jsonb *config)
 {
@@ -24,6 +24,12 @@ typedef struct PolicyReorderData
 	Oid index_relid;
 } PolicyReorderData;
 
+typedef struct PolicyPrecreateChunksData
+{
+	Hypertable *hypertable;
+	int32 chunks_ahead;
+} PolicyPrecreateChunksData;
+
 typedef struct PolicyRetentionData
 {
 	Oid object_relid;
@@ -58,11 +64,14 @@ extern bool policy_reorder_execute(int32 job_id, Jsonb *config);
 extern bool policy_retention_execute(int32 job_id, Jsonb *config);
 extern bool policy_refresh_cagg_execute(int32 job_id, Jsonb *config);
 extern bool policy_recompression_execute(int32 job_id, Jsonb *config);
+extern bool policy_precreate_chunks_execute(int32 job_id, Jsonb *config);
 extern void policy_reorder_read_and_validate_config(Jsonb *config, PolicyReorderData *policy_data);
 extern void policy_retention_read_and_validate_config(Jsonb *config,
 													  PolicyRetentionData *policy_data);
 extern void policy_refresh_cagg_read_and_validate_config(Jsonb *config,
 														 PolicyContinuousAggData *policy_data);
+extern void policy_precreate_chunks_read_and_validate_config(Jsonb *config,
+															 PolicyPrecreateChunksData *policy);
 extern void policy_compression_read_and_validate_config(Jsonb *config,
 														PolicyCompressionData *policy_data);
 extern void policy_recompression_read_and_validate_config(Jsonb *config,
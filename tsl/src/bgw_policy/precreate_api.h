@@ -0,0 +1,24 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <utils/jsonb.h>
+
+#include "dimension.h"
+#include "hypertable.h"
+
+/* User-facing API functions */
+extern Datum policy_precreate_chunks_add(PG_FUNCTION_ARGS);
+extern Datum policy_precreate_chunks_remove(PG_FUNCTION_ARGS);
+extern Datum policy_precreate_chunks_proc(PG_FUNCTION_ARGS);
+extern Datum policy_precreate_chunks_check(PG_FUNCTION_ARGS);
+
+extern int32 policy_precreate_chunks_get_hypertable_id(const Jsonb *config);
+extern int32 policy_precreate_chunks_get_chunks_ahead(const Jsonb *config);
+extern void policy_precreate_chunks_check_chunks_ahead(int32 chunks_ahead);
+extern void policy_precreate_chunks_check_time_dimension(const Hypertable *ht,
+														 const Dimension *dim);
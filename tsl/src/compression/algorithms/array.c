@@ -470,21 +470,70 @@ tsl_array_decompression_iterator_from_datum_reverse(Datum compressed_array, Oid
 	return &iterator->base;
 }
 
-/* Pass through to the specialized functions below for BOOL and TEXT */
+/*
+ * Whether we can bulk decompress the arrays of the given element type. Bool
+ * uses the bit-packed Arrow layout, the other fixed-width types use the
+ * fixed-size primitive layout, and the varlena types use the Arrow binary
+ * layout, where the bodies are stored without the varlena headers.
+ */
+bool
+array_decompress_all_supported(Oid element_type)
+{
+	if (element_type == BOOLOID)
+	{
+		return true;
+	}
+
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+
+	if (typlen == -1)
+	{
+		return true;
+	}
+
+	if (typlen <= 0)
+	{
+		/* cstring. */
+		return false;
+	}
+
+	if (typbyval)
+	{
+		return true;
+	}
+
+	/*
+	 * The fixed-width by-reference values are referenced directly in the
+	 * decompressed buffer, so they must be properly aligned at every element.
+	 * The consumers of the bulk decompression results treat the types that
+	 * fit into a Datum as by-value, so we can't support the small by-reference
+	 * types like macaddr.
+	 */
+	return typlen > SIZEOF_DATUM && att_align_nominal(typlen, typalign) == typlen;
+}
+
 ArrowArray *
 tsl_array_decompress_all(Datum compressed_array, Oid element_type, MemoryContext dest_mctx)
 {
-	switch (element_type)
+	if (element_type == BOOLOID)
 	{
-		case BOOLOID:
-			return tsl_bool_array_decompress_all(compressed_array, element_type, dest_mctx);
-		case TEXTOID:
-			return tsl_text_array_decompress_all(compressed_array, element_type, dest_mctx);
-		default:
-			elog(ERROR, "unsupported array type %u", element_type);
-			break;
+		return tsl_bool_array_decompress_all(compressed_array, element_type, dest_mctx);
 	}
-	return NULL;
+
+	void *compressed_data = PG_DETOAST_DATUM(compressed_array);
+	StringInfoData si = { .data = compressed_data, .len = VARSIZE(compressed_data) };
+	ArrayCompressed *header = consumeCompressedData(&si, sizeof(ArrayCompressed));
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_ARRAY);
+	CheckCompressedData(header->element_type == element_type);
+
+	return array_decompress_all_serialized_no_header(&si,
+													 element_type,
+													 header->has_nulls,
+													 dest_mctx);
 }
 
 ArrowArray *
@@ -558,23 +607,9 @@ tsl_bool_array_decompress_all(Datum compressed_array, Oid element_type, MemoryCo
 #include "simple8b_rle_decompress_all.h"
 #undef ELEMENT_TYPE
 
-ArrowArray *
-tsl_text_array_decompress_all(Datum compressed_array, Oid element_type, MemoryContext dest_mctx)
-{
-	Assert(element_type == TEXTOID);
-	void *compressed_data = PG_DETOAST_DATUM(compressed_array);
-	StringInfoData si = { .data = compressed_data, .len = VARSIZE(compressed_data) };
-	ArrayCompressed *header = consumeCompressedData(&si, sizeof(ArrayCompressed));
-
-	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_ARRAY);
-	CheckCompressedData(header->element_type == TEXTOID);
-
-	return text_array_decompress_all_serialized_no_header(&si, header->has_nulls, dest_mctx);
-}
-
-ArrowArray *
-text_array_decompress_all_serialized_no_header(StringInfo si, bool has_nulls,
-											   MemoryContext dest_mctx)
+static ArrowArray *
+varlena_array_decompress_all_serialized_no_header(StringInfo si, char typalign, bool has_nulls,
+												  MemoryContext dest_mctx)
 {
 	Simple8bRleSerialized *nulls_serialized = NULL;
 	if (has_nulls)
@@ -609,7 +644,7 @@ text_array_decompress_all_serialized_no_header(StringInfo si, bool has_nulls,
 		 * See the corresponding row-by-row code in bytes_to_datum_and_advance().
 		 */
 		const void *vardata =
-			DatumGetPointer(att_align_pointer(unaligned, TYPALIGN_INT, -1, unaligned));
+			DatumGetPointer(att_align_pointer(unaligned, typalign, -1, unaligned));
 
 		/*
 		 * Check for potentially corrupt varlena headers since we're reading them
@@ -650,13 +685,13 @@ text_array_decompress_all_serialized_no_header(StringInfo si, bool has_nulls,
 		const Datum alignment_bytes = PointerGetDatum(vardata) - PointerGetDatum(unaligned);
 		CheckCompressedData(VARSIZE_ANY(vardata) + alignment_bytes == sizes[i]);
 
-		const uint32 textlen = VARSIZE_ANY_EXHDR(vardata);
-		memcpy(&arrow_bodies[offset], VARDATA_ANY(vardata), textlen);
+		const uint32 body_bytes = VARSIZE_ANY_EXHDR(vardata);
+		memcpy(&arrow_bodies[offset], VARDATA_ANY(vardata), body_bytes);
 
 		offsets[i] = offset;
 
-		CheckCompressedData(offset <= offset + textlen); /* Check for overflow. */
-		offset += textlen;
+		CheckCompressedData(offset <= offset + body_bytes); /* Check for overflow. */
+		offset += body_bytes;
 	}
 	offsets[n_notnull] = offset;
 
@@ -732,6 +767,138 @@ text_array_decompress_all_serialized_no_header(StringInfo si, bool has_nulls,
 	return result;
 }
 
+static ArrowArray *
+fixed_array_decompress_all_serialized_no_header(StringInfo si, int16 typlen, char typalign,
+												bool has_nulls, MemoryContext dest_mctx)
+{
+	Simple8bRleSerialized *nulls_serialized = NULL;
+	if (has_nulls)
+	{
+		nulls_serialized = bytes_deserialize_simple8b_and_advance(si);
+	}
+
+	Simple8bRleSerialized *sizes_serialized = bytes_deserialize_simple8b_and_advance(si);
+
+	uint32 n_notnull;
+	const uint32 *sizes = simple8brle_decompress_all_uint32(sizes_serialized, &n_notnull);
+	const uint32 n_total = has_nulls ? nulls_serialized->num_elements : n_notnull;
+	CheckCompressedData(n_total >= n_notnull);
+
+	/*
+	 * We need additional padding at the end of buffer, because the code that
+	 * converts the elements to postgres Datum always reads in 8 bytes.
+	 */
+	char *restrict values =
+		MemoryContextAlloc(dest_mctx, pad_to_multiple(64, typlen * n_total) + 8);
+
+	for (uint32 i = 0; i < n_notnull; i++)
+	{
+		/*
+		 * The elements are stored aligned as required by the type, and
+		 * sizes[i] includes the alignment padding in addition to the value
+		 * size. See the corresponding row-by-row code in
+		 * bytes_to_datum_and_advance().
+		 */
+		const char *unaligned = consumeCompressedData(si, sizes[i]);
+		const char *aligned =
+			DatumGetPointer(att_align_pointer(unaligned, typalign, typlen, unaligned));
+		CheckCompressedData(aligned + typlen == unaligned + sizes[i]);
+
+		memcpy(&values[typlen * i], aligned, typlen);
+	}
+
+	uint64 *restrict validity_bitmap = NULL;
+	if (has_nulls)
+	{
+		const int validity_bitmap_bytes = sizeof(uint64) * (pad_to_multiple(64, n_total) / 64);
+		validity_bitmap = MemoryContextAlloc(dest_mctx, validity_bitmap_bytes);
+
+		/*
+		 * First, mark all data as valid, we will fill the nulls later if needed.
+		 * Note that the validity bitmap size is a multiple of 64 bits. We have to
+		 * fill the tail bits with zeros, because the corresponding elements are not
+		 * valid.
+		 */
+		memset(validity_bitmap, 0xFF, validity_bitmap_bytes);
+		if (n_total % 64)
+		{
+			const uint64 tail_mask = ~0ULL >> (64 - n_total % 64);
+			validity_bitmap[n_total / 64] &= tail_mask;
+		}
+
+		/*
+		 * We have decompressed the data with nulls skipped, reshuffle it
+		 * according to the nulls bitmap.
+		 */
+		const Simple8bRleBitmap nulls = simple8brle_bitmap_decompress(nulls_serialized);
+		CheckCompressedData(n_notnull + simple8brle_bitmap_num_ones(&nulls) == n_total);
+
+		int current_notnull_element = n_notnull - 1;
+		for (int i = n_total - 1; i >= 0; i--)
+		{
+			Assert(i >= current_notnull_element);
+
+			if (simple8brle_bitmap_get_at(&nulls, i))
+			{
+				arrow_set_row_validity(validity_bitmap, i, false);
+			}
+			else
+			{
+				Assert(current_notnull_element >= 0);
+				memmove(&values[typlen * i], &values[typlen * current_notnull_element], typlen);
+				current_notnull_element--;
+			}
+		}
+
+		Assert(current_notnull_element == -1);
+	}
+
+	ArrowArray *result =
+		MemoryContextAllocZero(dest_mctx, sizeof(ArrowArray) + (sizeof(void *) * 2));
+	const void **buffers = (const void **) &result[1];
+	buffers[0] = validity_bitmap;
+	buffers[1] = values;
+	result->n_buffers = 2;
+	result->buffers = buffers;
+	result->length = n_total;
+	result->null_count = n_total - n_notnull;
+	return result;
+}
+
+/*
+ * Decompress the array data that follows the header, in the Arrow layout
+ * appropriate for the element type. This is also used to decompress the
+ * dictionary of the dictionary compression.
+ */
+ArrowArray *
+array_decompress_all_serialized_no_header(StringInfo si, Oid element_type, bool has_nulls,
+										  MemoryContext dest_mctx)
+{
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+
+	if (typlen == -1)
+	{
+		return varlena_array_decompress_all_serialized_no_header(si,
+																 typalign,
+																 has_nulls,
+																 dest_mctx);
+	}
+
+	if (element_type == BOOLOID || typlen <= 0)
+	{
+		elog(ERROR, "unsupported array type %u", element_type);
+	}
+
+	return fixed_array_decompress_all_serialized_no_header(si,
+														   typlen,
+														   typalign,
+														   has_nulls,
+														   dest_mctx);
+}
+
 DecompressResult
 array_decompression_iterator_try_next_reverse(DecompressionIterator *base_iter)
 {
@@ -65,16 +65,19 @@ extern void array_compressed_send(CompressedDataHeader *header, StringInfo buffe
 extern Datum tsl_array_compressor_append(PG_FUNCTION_ARGS);
 extern Datum tsl_array_compressor_finish(PG_FUNCTION_ARGS);
 
-/* Pass through to the specialized functions below for BOOL and TEXT */
+/*
+ * Bulk decompression produces the bit-packed layout for bool, the fixed-size
+ * layout for fixed-width types, and the Arrow binary layout (offsets and
+ * bodies without varlena headers) for varlena types.
+ */
+bool array_decompress_all_supported(Oid element_type);
 ArrowArray *tsl_array_decompress_all(Datum compressed_array, Oid element_type,
 									 MemoryContext dest_mctx);
 ArrowArray *tsl_bool_array_decompress_all(Datum compressed_array, Oid element_type,
 										  MemoryContext dest_mctx);
-ArrowArray *tsl_text_array_decompress_all(Datum compressed_array, Oid element_type,
-										  MemoryContext dest_mctx);
 
-ArrowArray *text_array_decompress_all_serialized_no_header(StringInfo si, bool has_nulls,
-														   MemoryContext dest_mctx);
+ArrowArray *array_decompress_all_serialized_no_header(StringInfo si, Oid element_type,
+													  bool has_nulls, MemoryContext dest_mctx);
 
 #define ARRAY_ALGORITHM_DEFINITION                                                                 \
 	{                                                                                              \
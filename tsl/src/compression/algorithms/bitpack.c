@@ -0,0 +1,923 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "bitpack.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+#include <port/pg_bitutils.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
+#include <utils/timestamp.h>
+
+#include "compression/arrow_c_data_interface.h"
+#include "compression/compression.h"
+#include "deltadelta.h"
+#include "simple8b_rle.h"
+#include "simple8b_rle_bitmap.h"
+
+/*
+ * The packed values are organized in blocks of this many values, so that a
+ * block of bit width b takes exactly b 64-bit words.
+ */
+#define BITPACK_BLOCK_SIZE 64
+
+/*
+ * The cost of one exception in bits, used to choose the bit width: 16-bit
+ * position and 64-bit high part of the value.
+ */
+#define BITPACK_EXCEPTION_BITS (16 + 64)
+
+typedef struct BitpackCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 has_nulls; /* 1 if this has a NULLs bitmap after the values, 0 otherwise */
+	uint8 bit_width;
+	uint8 padding[1];
+	uint32 num_values; /* number of not-null values */
+	uint32 num_exceptions;
+	uint64 reference;
+	/*
+	 * Followed by:
+	 * 1) the packed values, bit_width 64-bit words per block,
+	 * 2) the uint16 positions of exceptions, padded to a multiple of 4,
+	 * 3) the uint64 high bits of exceptions,
+	 * 4) the simple8b-encoded nulls bitmap, if has_nulls is set.
+	 */
+	char data[FLEXIBLE_ARRAY_MEMBER];
+} BitpackCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	BitpackCompressed test_val = { .vl_len_ = { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(BitpackCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.has_nulls) + sizeof(test_val.bit_width) +
+							 sizeof(test_val.padding) + sizeof(test_val.num_values) +
+							 sizeof(test_val.num_exceptions) + sizeof(test_val.reference),
+					 "BitpackCompressed wrong size");
+	StaticAssertStmt(sizeof(BitpackCompressed) == 24, "BitpackCompressed wrong size");
+	StaticAssertStmt(GLOBAL_MAX_ROWS_PER_COMPRESSION <= PG_UINT16_MAX,
+					 "bitpack uses uint16 exception positions");
+}
+
+/*
+ * Pointers to the parts of the compressed data.
+ */
+typedef struct BitpackLayout
+{
+	const BitpackCompressed *header;
+	const uint64 *packed;
+	const uint16 *exception_positions;
+	const uint64 *exception_values;
+	Simple8bRleSerialized *nulls;
+} BitpackLayout;
+
+typedef struct BitpackDecompressionIterator
+{
+	DecompressionIterator base;
+	uint64 *values;
+	int32 num_values;
+	int32 next_value;
+	Simple8bRleDecompressionIterator nulls;
+	bool has_nulls;
+} BitpackDecompressionIterator;
+
+typedef struct BitpackCompressor
+{
+	uint64 *values;
+	uint32 num_values;
+	uint32 num_allocated;
+	Simple8bRleCompressor nulls;
+	bool has_nulls;
+
+	/*
+	 * We also build the deltadelta representation of the same data, and use
+	 * it if it turns out to be smaller.
+	 */
+	DeltaDeltaCompressor *deltadelta;
+} BitpackCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	BitpackCompressor *internal;
+} ExtendedCompressor;
+
+static pg_attribute_always_inline uint32
+bitpack_num_blocks(uint32 num_values)
+{
+	return (num_values + BITPACK_BLOCK_SIZE - 1) / BITPACK_BLOCK_SIZE;
+}
+
+static pg_attribute_always_inline uint64
+bitpack_mask(int bit_width)
+{
+	return bit_width == 64 ? ~0ULL : (1ULL << bit_width) - 1;
+}
+
+static pg_attribute_always_inline uint32
+bitpack_positions_bytes(uint32 num_exceptions)
+{
+	/* Padded so that the following uint64 array is aligned. */
+	return pad_to_multiple(4, num_exceptions) * sizeof(uint16);
+}
+
+bool
+bitpack_compressed_has_nulls(const CompressedDataHeader *header)
+{
+	const BitpackCompressed *compressed = (const BitpackCompressed *) header;
+	return compressed->has_nulls;
+}
+
+static void
+bitpack_parse(void *compressed, BitpackLayout *layout)
+{
+	StringInfoData si = { .data = compressed, .len = VARSIZE(compressed) };
+	const BitpackCompressed *header = consumeCompressedData(&si, sizeof(BitpackCompressed));
+
+	CheckCompressedData(header->has_nulls == 0 || header->has_nulls == 1);
+	CheckCompressedData(header->bit_width <= 64);
+	CheckCompressedData(header->num_values > 0);
+	CheckCompressedData(header->num_values <= GLOBAL_MAX_ROWS_PER_COMPRESSION);
+	CheckCompressedData(header->num_exceptions <= header->num_values);
+	CheckCompressedData(header->bit_width < 64 || header->num_exceptions == 0);
+
+	layout->header = header;
+	layout->packed =
+		consumeCompressedData(&si,
+							  sizeof(uint64) * bitpack_num_blocks(header->num_values) *
+								  header->bit_width);
+	layout->exception_positions =
+		consumeCompressedData(&si, bitpack_positions_bytes(header->num_exceptions));
+	layout->exception_values =
+		consumeCompressedData(&si, sizeof(uint64) * header->num_exceptions);
+	layout->nulls = header->has_nulls ? bytes_deserialize_simple8b_and_advance(&si) : NULL;
+}
+
+/*
+ * Unpack one block of 64 values of the given bit width. When inlined with a
+ * constant bit width, the positions of all values are known at compile time,
+ * so the loop is fully unrolled into shifts and masks that the compiler can
+ * vectorize.
+ */
+static pg_attribute_always_inline void
+bitpack_unpack_width(const uint64 *restrict packed, uint32 num_blocks, const int bit_width,
+					 uint64 *restrict offsets)
+{
+	const uint64 mask = bitpack_mask(bit_width);
+	for (uint32 block = 0; block < num_blocks; block++)
+	{
+		const uint64 *restrict words = &packed[block * bit_width];
+		uint64 *restrict out = &offsets[block * BITPACK_BLOCK_SIZE];
+		for (int i = 0; i < BITPACK_BLOCK_SIZE; i++)
+		{
+			const int bit = i * bit_width;
+			const int word = bit / 64;
+			const int shift = bit % 64;
+			uint64 value = words[word] >> shift;
+			if (shift + bit_width > 64)
+				value |= words[word + 1] << (64 - shift);
+			out[i] = value & mask;
+		}
+	}
+}
+
+/*
+ * Unpack the offsets from the reference, including the exceptions. The output
+ * must have room for the number of values padded to the block size.
+ */
+static void
+bitpack_unpack(const BitpackLayout *layout, uint64 *restrict offsets)
+{
+	const BitpackCompressed *header = layout->header;
+	const uint32 num_blocks = bitpack_num_blocks(header->num_values);
+
+	switch (header->bit_width)
+	{
+		case 0:
+			memset(offsets, 0, sizeof(uint64) * num_blocks * BITPACK_BLOCK_SIZE);
+			break;
+#define UNPACK_CASE(W)                                                                             \
+	case W:                                                                                        \
+		bitpack_unpack_width(layout->packed, num_blocks, W, offsets);                              \
+		break;
+#define UNPACK_CASES_8(B)                                                                          \
+	UNPACK_CASE(B + 1)                                                                             \
+	UNPACK_CASE(B + 2)                                                                             \
+	UNPACK_CASE(B + 3)                                                                             \
+	UNPACK_CASE(B + 4)                                                                             \
+	UNPACK_CASE(B + 5)                                                                             \
+	UNPACK_CASE(B + 6)                                                                             \
+	UNPACK_CASE(B + 7)                                                                             \
+	UNPACK_CASE(B + 8)
+			UNPACK_CASES_8(0)
+			UNPACK_CASES_8(8)
+			UNPACK_CASES_8(16)
+			UNPACK_CASES_8(24)
+			UNPACK_CASES_8(32)
+			UNPACK_CASES_8(40)
+			UNPACK_CASES_8(48)
+			UNPACK_CASES_8(56)
+#undef UNPACK_CASES_8
+#undef UNPACK_CASE
+		default:
+			/* Checked when parsing. */
+			pg_unreachable();
+	}
+
+	for (uint32 i = 0; i < header->num_exceptions; i++)
+	{
+		const uint16 position = layout->exception_positions[i];
+		CheckCompressedData(position < header->num_values);
+		offsets[position] |= layout->exception_values[i] << header->bit_width;
+	}
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+static void
+bitpack_compressor_append_int16(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt16(val));
+}
+
+static void
+bitpack_compressor_append_int32(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt32(val));
+}
+
+static void
+bitpack_compressor_append_int64(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt64(val));
+}
+
+static void
+bitpack_compressor_append_date(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetDateADT(val));
+}
+
+static void
+bitpack_compressor_append_timestamp(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetTimestamp(val));
+}
+
+static void
+bitpack_compressor_append_timestamptz(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetTimestampTz(val));
+}
+
+static void
+bitpack_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_null(extended->internal);
+}
+
+static void *
+bitpack_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed = bitpack_compressor_finish(extended->internal);
+	pfree(extended->internal->values);
+	pfree(extended->internal->deltadelta);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor bitpack_uint16_compressor = {
+	.append_val = bitpack_compressor_append_int16,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+const Compressor bitpack_uint32_compressor = {
+	.append_val = bitpack_compressor_append_int32,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+const Compressor bitpack_uint64_compressor = {
+	.append_val = bitpack_compressor_append_int64,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+const Compressor bitpack_date_compressor = {
+	.append_val = bitpack_compressor_append_date,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+const Compressor bitpack_timestamp_compressor = {
+	.append_val = bitpack_compressor_append_timestamp,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+const Compressor bitpack_timestamptz_compressor = {
+	.append_val = bitpack_compressor_append_timestamptz,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+Compressor *
+bitpack_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor = palloc(sizeof(*compressor));
+	switch (element_type)
+	{
+		case INT2OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint16_compressor };
+			return &compressor->base;
+		case INT4OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint32_compressor };
+			return &compressor->base;
+		case INT8OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint64_compressor };
+			return &compressor->base;
+		case DATEOID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_date_compressor };
+			return &compressor->base;
+		case TIMESTAMPOID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_timestamp_compressor };
+			return &compressor->base;
+		case TIMESTAMPTZOID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_timestamptz_compressor };
+			return &compressor->base;
+		default:
+			elog(ERROR,
+				 "invalid type for bitpack compressor \"%s\"",
+				 format_type_be(element_type));
+	}
+
+	pg_unreachable();
+}
+
+BitpackCompressor *
+bitpack_compressor_alloc(void)
+{
+	BitpackCompressor *compressor = palloc0(sizeof(*compressor));
+	compressor->num_allocated = TARGET_COMPRESSED_BATCH_SIZE;
+	compressor->values = palloc(sizeof(uint64) * compressor->num_allocated);
+	simple8brle_compressor_init(&compressor->nulls);
+	compressor->deltadelta = delta_delta_compressor_alloc();
+	return compressor;
+}
+
+void
+bitpack_compressor_append_null(BitpackCompressor *compressor)
+{
+	compressor->has_nulls = true;
+	simple8brle_compressor_append(&compressor->nulls, 1);
+	delta_delta_compressor_append_null(compressor->deltadelta);
+}
+
+void
+bitpack_compressor_append_value(BitpackCompressor *compressor, int64 next_val)
+{
+	if (compressor->num_values >= compressor->num_allocated)
+	{
+		compressor->num_allocated *= 2;
+		compressor->values =
+			repalloc(compressor->values, sizeof(uint64) * compressor->num_allocated);
+	}
+
+	compressor->values[compressor->num_values++] = next_val;
+	simple8brle_compressor_append(&compressor->nulls, 0);
+	delta_delta_compressor_append_value(compressor->deltadelta, next_val);
+}
+
+static BitpackCompressed *
+bitpack_from_parts(uint8 bit_width, uint32 num_values, uint64 reference, const uint64 *packed,
+				   uint32 num_exceptions, const uint16 *exception_positions,
+				   const uint64 *exception_values, Simple8bRleSerialized *nulls)
+{
+	const Size packed_size = sizeof(uint64) * bitpack_num_blocks(num_values) * bit_width;
+	const Size positions_size = bitpack_positions_bytes(num_exceptions);
+	const Size exception_values_size = sizeof(uint64) * num_exceptions;
+	const Size nulls_size = nulls != NULL ? simple8brle_serialized_total_size(nulls) : 0;
+	const Size compressed_size = sizeof(BitpackCompressed) + packed_size + positions_size +
+								 exception_values_size + nulls_size;
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	/* Zero-initialize so that the padding of the positions is deterministic. */
+	char *compressed_data = palloc0(compressed_size);
+	BitpackCompressed *compressed = (BitpackCompressed *) compressed_data;
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_BITPACK;
+	compressed->has_nulls = nulls_size != 0 ? 1 : 0;
+	compressed->bit_width = bit_width;
+	compressed->num_values = num_values;
+	compressed->num_exceptions = num_exceptions;
+	compressed->reference = reference;
+
+	compressed_data += sizeof(*compressed);
+	memcpy(compressed_data, packed, packed_size);
+	compressed_data += packed_size;
+	memcpy(compressed_data, exception_positions, sizeof(uint16) * num_exceptions);
+	compressed_data += positions_size;
+	memcpy(compressed_data, exception_values, exception_values_size);
+	compressed_data += exception_values_size;
+
+	if (nulls != NULL)
+	{
+		CheckCompressedData(nulls->num_elements > num_values);
+		bytes_serialize_simple8b_and_advance(compressed_data, nulls_size, nulls);
+	}
+
+	return compressed;
+}
+
+/*
+ * Choose the reference and the bit width that give the smallest compressed
+ * size. The values with offsets wider than the bit width become exceptions.
+ */
+static void
+bitpack_choose_parameters(const uint64 *values, uint32 num_values, uint64 *reference,
+						  uint8 *bit_width, uint32 *num_exceptions)
+{
+	int64 min = PG_INT64_MAX;
+	for (uint32 i = 0; i < num_values; i++)
+		min = Min(min, (int64) values[i]);
+
+	uint32 width_counts[65] = { 0 };
+	for (uint32 i = 0; i < num_values; i++)
+	{
+		const uint64 offset = values[i] - (uint64) min;
+		width_counts[offset == 0 ? 0 : pg_leftmost_one_pos64(offset) + 1]++;
+	}
+
+	/*
+	 * Go from the widest to the narrowest bit width, counting the offsets that
+	 * don't fit.
+	 */
+	const uint64 num_blocks = bitpack_num_blocks(num_values);
+	uint64 best_cost = PG_UINT64_MAX;
+	uint32 exceptions = 0;
+	for (int width = 64; width >= 0; width--)
+	{
+		const uint64 cost = num_blocks * BITPACK_BLOCK_SIZE * width +
+							(uint64) exceptions * BITPACK_EXCEPTION_BITS;
+		if (cost <= best_cost)
+		{
+			best_cost = cost;
+			*bit_width = width;
+			*num_exceptions = exceptions;
+		}
+		exceptions += width_counts[width];
+	}
+
+	*reference = (uint64) min;
+}
+
+static void
+bitpack_pack(const uint64 *values, uint32 num_values, uint64 reference, uint8 bit_width,
+			 uint64 *restrict packed, uint16 *restrict exception_positions,
+			 uint64 *restrict exception_values)
+{
+	const uint64 mask = bitpack_mask(bit_width);
+	uint32 num_exceptions = 0;
+
+	memset(packed, 0, sizeof(uint64) * bitpack_num_blocks(num_values) * bit_width);
+
+	for (uint32 i = 0; i < num_values; i++)
+	{
+		const uint64 offset = values[i] - reference;
+		if (bit_width < 64 && (offset >> bit_width) != 0)
+		{
+			exception_positions[num_exceptions] = i;
+			exception_values[num_exceptions] = offset >> bit_width;
+			num_exceptions++;
+		}
+
+		if (bit_width == 0)
+			continue;
+
+		const uint64 low = offset & mask;
+		const uint64 bit = (uint64) i * bit_width;
+		const uint32 word = bit / 64;
+		const int shift = bit % 64;
+		packed[word] |= low << shift;
+		if (shift + bit_width > 64)
+			packed[word + 1] |= low >> (64 - shift);
+	}
+}
+
+void *
+bitpack_compressor_finish(BitpackCompressor *compressor)
+{
+	void *deltadelta = delta_delta_compressor_finish(compressor->deltadelta);
+
+	if (compressor->num_values == 0)
+	{
+		Assert(deltadelta == NULL);
+		return NULL;
+	}
+
+	if (compressor->num_values > GLOBAL_MAX_ROWS_PER_COMPRESSION)
+	{
+		/* The exception positions wouldn't fit. */
+		return deltadelta;
+	}
+
+	uint64 reference;
+	uint8 bit_width;
+	uint32 num_exceptions;
+	bitpack_choose_parameters(compressor->values,
+							  compressor->num_values,
+							  &reference,
+							  &bit_width,
+							  &num_exceptions);
+
+	Simple8bRleSerialized *nulls =
+		compressor->has_nulls ? simple8brle_compressor_finish(&compressor->nulls) : NULL;
+
+	const Size bitpack_size =
+		sizeof(BitpackCompressed) +
+		sizeof(uint64) * bitpack_num_blocks(compressor->num_values) * bit_width +
+		bitpack_positions_bytes(num_exceptions) + sizeof(uint64) * num_exceptions +
+		(nulls != NULL ? simple8brle_serialized_total_size(nulls) : 0);
+
+	if (VARSIZE(deltadelta) <= bitpack_size)
+		return deltadelta;
+
+	pfree(deltadelta);
+
+	uint64 *packed = palloc(sizeof(uint64) * bitpack_num_blocks(compressor->num_values) *
+							Max(bit_width, 1));
+	uint16 *exception_positions = palloc(sizeof(uint16) * Max(num_exceptions, 1));
+	uint64 *exception_values = palloc(sizeof(uint64) * Max(num_exceptions, 1));
+	bitpack_pack(compressor->values,
+				 compressor->num_values,
+				 reference,
+				 bit_width,
+				 packed,
+				 exception_positions,
+				 exception_values);
+
+	BitpackCompressed *compressed = bitpack_from_parts(bit_width,
+													   compressor->num_values,
+													   reference,
+													   packed,
+													   num_exceptions,
+													   exception_positions,
+													   exception_values,
+													   nulls);
+	Assert(VARSIZE(compressed) == bitpack_size);
+
+	pfree(packed);
+	pfree(exception_positions);
+	pfree(exception_values);
+
+	return compressed;
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+static void
+bitpack_decompression_iterator_init(BitpackDecompressionIterator *iter, void *compressed,
+									Oid element_type, bool forward)
+{
+	BitpackLayout layout;
+	bitpack_parse(compressed, &layout);
+
+	const uint32 num_values = layout.header->num_values;
+	uint64 *values =
+		palloc(sizeof(uint64) * bitpack_num_blocks(num_values) * BITPACK_BLOCK_SIZE);
+	bitpack_unpack(&layout, values);
+	for (uint32 i = 0; i < num_values; i++)
+		values[i] += layout.header->reference;
+
+	*iter = (BitpackDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_BITPACK,
+			.forward = forward,
+			.element_type = element_type,
+			.try_next = forward ? bitpack_decompression_iterator_try_next_forward :
+								  bitpack_decompression_iterator_try_next_reverse,
+		},
+		.values = values,
+		.num_values = num_values,
+		.next_value = forward ? 0 : num_values - 1,
+		.has_nulls = layout.nulls != NULL,
+	};
+
+	if (layout.nulls != NULL)
+	{
+		if (forward)
+			simple8brle_decompression_iterator_init_forward(&iter->nulls, layout.nulls);
+		else
+			simple8brle_decompression_iterator_init_reverse(&iter->nulls, layout.nulls);
+	}
+}
+
+static inline DecompressResult
+convert_from_internal(DecompressResultInternal res_internal, Oid element_type)
+{
+	if (res_internal.is_done || res_internal.is_null)
+	{
+		return (DecompressResult){
+			.is_done = res_internal.is_done,
+			.is_null = res_internal.is_null,
+		};
+	}
+
+	switch (element_type)
+	{
+		case INT8OID:
+			return (DecompressResult){
+				.val = Int64GetDatum(res_internal.val),
+			};
+		case INT4OID:
+			return (DecompressResult){
+				.val = Int32GetDatum(res_internal.val),
+			};
+		case INT2OID:
+			return (DecompressResult){
+				.val = Int16GetDatum(res_internal.val),
+			};
+		case DATEOID:
+			return (DecompressResult){
+				.val = DateADTGetDatum(res_internal.val),
+			};
+		case TIMESTAMPTZOID:
+			return (DecompressResult){
+				.val = TimestampTzGetDatum(res_internal.val),
+			};
+		case TIMESTAMPOID:
+			return (DecompressResult){
+				.val = TimestampGetDatum(res_internal.val),
+			};
+		default:
+			elog(ERROR,
+				 "invalid type requested from bitpack decompression \"%s\"",
+				 format_type_be(element_type));
+	}
+
+	pg_unreachable();
+}
+
+static DecompressResultInternal
+bitpack_decompression_iterator_try_next_forward_internal(BitpackDecompressionIterator *iter)
+{
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			simple8brle_decompression_iterator_try_next_forward(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResultInternal){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			CheckCompressedData(result.val == 1);
+			return (DecompressResultInternal){
+				.is_null = true,
+			};
+		}
+
+		CheckCompressedData(iter->next_value < iter->num_values);
+	}
+
+	if (iter->next_value >= iter->num_values)
+		return (DecompressResultInternal){
+			.is_done = true,
+		};
+
+	return (DecompressResultInternal){
+		.val = iter->values[iter->next_value++],
+	};
+}
+
+DecompressResult
+bitpack_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK && iter->forward);
+	return convert_from_internal(bitpack_decompression_iterator_try_next_forward_internal(
+									 (BitpackDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+static DecompressResultInternal
+bitpack_decompression_iterator_try_next_reverse_internal(BitpackDecompressionIterator *iter)
+{
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			simple8brle_decompression_iterator_try_next_reverse(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResultInternal){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			CheckCompressedData(result.val == 1);
+			return (DecompressResultInternal){
+				.is_null = true,
+			};
+		}
+
+		CheckCompressedData(iter->next_value >= 0);
+	}
+
+	if (iter->next_value < 0)
+		return (DecompressResultInternal){
+			.is_done = true,
+		};
+
+	return (DecompressResultInternal){
+		.val = iter->values[iter->next_value--],
+	};
+}
+
+DecompressResult
+bitpack_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK && !iter->forward);
+	return convert_from_internal(bitpack_decompression_iterator_try_next_reverse_internal(
+									 (BitpackDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+DecompressionIterator *
+bitpack_decompression_iterator_from_datum_forward(Datum compressed, Oid element_type)
+{
+	BitpackDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	bitpack_decompression_iterator_init(iterator,
+										(void *) PG_DETOAST_DATUM(compressed),
+										element_type,
+										/* forward = */ true);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+bitpack_decompression_iterator_from_datum_reverse(Datum compressed, Oid element_type)
+{
+	BitpackDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	bitpack_decompression_iterator_init(iterator,
+										(void *) PG_DETOAST_DATUM(compressed),
+										element_type,
+										/* forward = */ false);
+	return &iterator->base;
+}
+
+/* Functions for bulk decompression. */
+#define ELEMENT_TYPE uint16
+#include "bitpack_impl.c"
+#undef ELEMENT_TYPE
+
+#define ELEMENT_TYPE uint32
+#include "bitpack_impl.c"
+#undef ELEMENT_TYPE
+
+#define ELEMENT_TYPE uint64
+#include "bitpack_impl.c"
+#undef ELEMENT_TYPE
+
+ArrowArray *
+bitpack_decompress_all(Datum compressed_data, Oid element_type, MemoryContext dest_mctx)
+{
+	switch (element_type)
+	{
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return bitpack_decompress_all_uint64(compressed_data, dest_mctx);
+		case INT4OID:
+		case DATEOID:
+			return bitpack_decompress_all_uint32(compressed_data, dest_mctx);
+		case INT2OID:
+			return bitpack_decompress_all_uint16(compressed_data, dest_mctx);
+		default:
+			elog(ERROR,
+				 "type '%s' is not supported for bitpack decompression",
+				 format_type_be(element_type));
+			pg_unreachable();
+	}
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+void
+bitpack_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const BitpackCompressed *data = (BitpackCompressed *) header;
+	BitpackLayout layout;
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK);
+
+	bitpack_parse(header, &layout);
+
+	pq_sendbyte(buffer, data->has_nulls);
+	pq_sendbyte(buffer, data->bit_width);
+	pq_sendint32(buffer, data->num_values);
+	pq_sendint32(buffer, data->num_exceptions);
+	pq_sendint64(buffer, data->reference);
+
+	const uint32 num_words = bitpack_num_blocks(data->num_values) * data->bit_width;
+	for (uint32 i = 0; i < num_words; i++)
+		pq_sendint64(buffer, layout.packed[i]);
+
+	for (uint32 i = 0; i < data->num_exceptions; i++)
+		pq_sendint16(buffer, layout.exception_positions[i]);
+
+	for (uint32 i = 0; i < data->num_exceptions; i++)
+		pq_sendint64(buffer, layout.exception_values[i]);
+
+	if (data->has_nulls)
+		simple8brle_serialized_send(buffer, layout.nulls);
+}
+
+Datum
+bitpack_compressed_recv(StringInfo buffer)
+{
+	const uint8 has_nulls = pq_getmsgbyte(buffer);
+	CheckCompressedData(has_nulls == 0 || has_nulls == 1);
+
+	const uint8 bit_width = pq_getmsgbyte(buffer);
+	CheckCompressedData(bit_width <= 64);
+
+	const uint32 num_values = pq_getmsgint(buffer, 4);
+	CheckCompressedData(num_values > 0);
+	CheckCompressedData(num_values <= GLOBAL_MAX_ROWS_PER_COMPRESSION);
+
+	const uint32 num_exceptions = pq_getmsgint(buffer, 4);
+	CheckCompressedData(num_exceptions <= num_values);
+	CheckCompressedData(bit_width < 64 || num_exceptions == 0);
+
+	const uint64 reference = pq_getmsgint64(buffer);
+
+	const uint32 num_words = bitpack_num_blocks(num_values) * bit_width;
+	uint64 *packed = palloc(sizeof(uint64) * Max(num_words, 1));
+	for (uint32 i = 0; i < num_words; i++)
+		packed[i] = pq_getmsgint64(buffer);
+
+	uint16 *exception_positions = palloc(sizeof(uint16) * Max(num_exceptions, 1));
+	for (uint32 i = 0; i < num_exceptions; i++)
+		exception_positions[i] = pq_getmsgint(buffer, 2);
+
+	uint64 *exception_values = palloc(sizeof(uint64) * Max(num_exceptions, 1));
+	for (uint32 i = 0; i < num_exceptions; i++)
+		exception_values[i] = pq_getmsgint64(buffer);
+
+	Simple8bRleSerialized *nulls = has_nulls ? simple8brle_serialized_recv(buffer) : NULL;
+
+	BitpackCompressed *compressed = bitpack_from_parts(bit_width,
+													   num_values,
+													   reference,
+													   packed,
+													   num_exceptions,
+													   exception_positions,
+													   exception_values,
+													   nulls);
+
+	PG_RETURN_POINTER(compressed);
+}
@@ -0,0 +1,66 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+/*
+ * Bitpack is a frame-of-reference encoding for integers or integer-like
+ * objects, with patched exceptions in the spirit of PFOR. We subtract the
+ * minimum of the batch (the reference) from every value, and pack the
+ * resulting offsets with a fixed number of bits per value. The bit width is
+ * chosen to minimize the total size, so the few offsets that don't fit are
+ * stored separately as exceptions: their position and their high bits.
+ *
+ * The packed values are organized in blocks of 64, so that a block of bit
+ * width b takes exactly b 64-bit words. This allows the bulk decompression to
+ * use unrolled loops specialized for each bit width, that the compiler can
+ * vectorize.
+ *
+ * The bitpack compressor also builds the deltadelta representation of the
+ * same data, and returns whichever one is smaller. This means that a column
+ * that uses bitpack as the default algorithm can have a mix of bitpack and
+ * deltadelta batches.
+ */
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+
+#include "compression/compression.h"
+
+typedef struct BitpackCompressor BitpackCompressor;
+typedef struct BitpackCompressed BitpackCompressed;
+typedef struct BitpackDecompressionIterator BitpackDecompressionIterator;
+
+extern bool bitpack_compressed_has_nulls(const CompressedDataHeader *header);
+extern Compressor *bitpack_compressor_for_type(Oid element_type);
+extern BitpackCompressor *bitpack_compressor_alloc(void);
+extern void bitpack_compressor_append_null(BitpackCompressor *compressor);
+extern void bitpack_compressor_append_value(BitpackCompressor *compressor, int64 next_val);
+extern void *bitpack_compressor_finish(BitpackCompressor *compressor);
+
+extern DecompressionIterator *bitpack_decompression_iterator_from_datum_forward(Datum compressed,
+																				Oid element_type);
+extern DecompressionIterator *bitpack_decompression_iterator_from_datum_reverse(Datum compressed,
+																				Oid element_type);
+extern DecompressResult bitpack_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult bitpack_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern ArrowArray *bitpack_decompress_all(Datum compressed_data, Oid element_type,
+										  MemoryContext dest_mctx);
+
+extern void bitpack_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum bitpack_compressed_recv(StringInfo buf);
+
+#define BITPACK_ALGORITHM_DEFINITION                                                               \
+	{                                                                                              \
+		.iterator_init_forward = bitpack_decompression_iterator_from_datum_forward,                \
+		.iterator_init_reverse = bitpack_decompression_iterator_from_datum_reverse,                \
+		.decompress_all = bitpack_decompress_all,                                                  \
+		.compressed_data_send = bitpack_compressed_send,                                           \
+		.compressed_data_recv = bitpack_compressed_recv,                                           \
+		.compressor_for_type = bitpack_compressor_for_type,                                        \
+		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+	}
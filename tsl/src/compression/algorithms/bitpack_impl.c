@@ -0,0 +1,122 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Decompress the entire batch of bitpack-compressed rows into an Arrow array.
+ * Specialized for each supported data type.
+ */
+
+#define FUNCTION_NAME_HELPER(X, Y) X##_##Y
+#define FUNCTION_NAME(X, Y) FUNCTION_NAME_HELPER(X, Y)
+
+static ArrowArray *
+FUNCTION_NAME(bitpack_decompress_all, ELEMENT_TYPE)(Datum compressed, MemoryContext dest_mctx)
+{
+	BitpackLayout layout;
+	bitpack_parse(DatumGetPointer(compressed), &layout);
+
+	const bool has_nulls = layout.nulls != NULL;
+	Simple8bRleBitmap nulls = { 0 };
+	if (has_nulls)
+		nulls = simple8brle_bitmap_decompress(layout.nulls);
+
+	const uint32 n_notnull = layout.header->num_values;
+	const uint32 n_total = has_nulls ? nulls.num_elements : n_notnull;
+
+	/*
+	 * The number of not-null elements we have must be consistent with the
+	 * nulls bitmap.
+	 */
+	CheckCompressedData(!has_nulls || n_notnull + simple8brle_bitmap_num_ones(&nulls) == n_total);
+
+	/*
+	 * The unpacking works on whole blocks, so pad the number of elements to
+	 * the block size.
+	 */
+	const uint32 n_notnull_padded = bitpack_num_blocks(n_notnull) * BITPACK_BLOCK_SIZE;
+	const uint32 n_total_padded = pad_to_multiple(BITPACK_BLOCK_SIZE, n_total);
+	Assert(n_total_padded >= n_notnull_padded);
+	Assert(n_total <= GLOBAL_MAX_ROWS_PER_COMPRESSION);
+
+	/*
+	 * We need additional padding at the end of buffer, because the code that
+	 * converts the elements to postgres Datum always reads in 8 bytes.
+	 */
+	const int buffer_bytes = n_total_padded * sizeof(ELEMENT_TYPE) + 8;
+	ELEMENT_TYPE *decompressed_values = MemoryContextAlloc(dest_mctx, buffer_bytes);
+
+	/*
+	 * Unpack the offsets from the reference, and then add the reference in the
+	 * width of the element type. For 64-bit types we can do this in place.
+	 */
+	uint64 *offsets = sizeof(ELEMENT_TYPE) == sizeof(uint64) ?
+						  (uint64 *) decompressed_values :
+						  palloc(sizeof(uint64) * n_notnull_padded);
+	bitpack_unpack(&layout, offsets);
+
+	const ELEMENT_TYPE reference = layout.header->reference;
+	for (uint32 i = 0; i < n_notnull_padded; i++)
+	{
+		decompressed_values[i] = reference + (ELEMENT_TYPE) offsets[i];
+	}
+
+	if ((void *) offsets != (void *) decompressed_values)
+		pfree(offsets);
+
+	uint64 *restrict validity_bitmap = NULL;
+	if (has_nulls)
+	{
+		/* Now move the data to account for nulls, and fill the validity bitmap. */
+		const int validity_bitmap_bytes = sizeof(uint64) * ((n_total + 64 - 1) / 64);
+		validity_bitmap = MemoryContextAlloc(dest_mctx, validity_bitmap_bytes);
+
+		/*
+		 * First, mark all data as valid, we will fill the nulls later if needed.
+		 * Note that the validity bitmap size is a multiple of 64 bits. We have to
+		 * fill the tail bits with zeros, because the corresponding elements are not
+		 * valid.
+		 */
+		memset(validity_bitmap, 0xFF, validity_bitmap_bytes);
+		if (n_total % 64)
+		{
+			const uint64 tail_mask = ~0ULL >> (64 - n_total % 64);
+			validity_bitmap[n_total / 64] &= tail_mask;
+		}
+
+		int current_notnull_element = n_notnull - 1;
+		for (int i = n_total - 1; i >= 0; i--)
+		{
+			Assert(i >= current_notnull_element);
+
+			if (simple8brle_bitmap_get_at(&nulls, i))
+			{
+				arrow_set_row_validity(validity_bitmap, i, false);
+			}
+			else
+			{
+				Assert(current_notnull_element >= 0);
+				decompressed_values[i] = decompressed_values[current_notnull_element];
+				current_notnull_element--;
+			}
+		}
+
+		Assert(current_notnull_element == -1);
+	}
+
+	/* Return the result. */
+	ArrowArray *result = MemoryContextAllocZero(dest_mctx, sizeof(ArrowArray) + sizeof(void *) * 2);
+	const void **buffers = (const void **) &result[1];
+	buffers[0] = validity_bitmap;
+	buffers[1] = decompressed_values;
+	result->n_buffers = 2;
+	result->buffers = buffers;
+	result->length = n_total;
+	result->null_count = n_total - n_notnull;
+	return result;
+}
+
+#undef FUNCTION_NAME
+#undef FUNCTION_NAME_HELPER
@@ -407,21 +407,19 @@ dictionary_decompression_iterator_init(DictionaryDecompressionIterator *iter, co
 	Assert(array_decompression_iterator_try_next_forward(dictionary_iterator).is_done);
 }
 
-/* Pass through to the specialized functions below for BOOL and TEXT */
+static ArrowArray *dictionary_decompress_all(Datum compressed, Oid element_type,
+											 MemoryContext dest_mctx);
+
+/* Pass through to the specialized function for BOOL */
 ArrowArray *
 tsl_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryContext dest_mctx)
 {
-	switch (element_type)
+	if (element_type == BOOLOID)
 	{
-		case BOOLOID:
-			return tsl_bool_dictionary_decompress_all(compressed, element_type, dest_mctx);
-		case TEXTOID:
-			return tsl_text_dictionary_decompress_all(compressed, element_type, dest_mctx);
-		default:
-			elog(ERROR, "unsupported dictionary type %u", element_type);
-			break;
+		return tsl_bool_dictionary_decompress_all(compressed, element_type, dest_mctx);
 	}
-	return NULL;
+
+	return dictionary_decompress_all(compressed, element_type, dest_mctx);
 }
 
 ArrowArray *
@@ -496,11 +494,14 @@ tsl_bool_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryCon
 #include "simple8b_rle_decompress_all.h"
 #undef ELEMENT_TYPE
 
-ArrowArray *
-tsl_text_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryContext dest_mctx)
+/*
+ * For the varlena types, the result is an Arrow dictionary-encoded array with
+ * int16 indices. For the fixed-width types, we materialize the values, because
+ * the consumers expect the plain fixed-size layout for them.
+ */
+static ArrowArray *
+dictionary_decompress_all(Datum compressed, Oid element_type, MemoryContext dest_mctx)
 {
-	Assert(element_type == TEXTOID);
-
 	compressed = PointerGetDatum(PG_DETOAST_DATUM(compressed));
 
 	StringInfoData si = { .data = DatumGetPointer(compressed), .len = VARSIZE(compressed) };
@@ -508,7 +509,7 @@ tsl_text_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryCon
 	const DictionaryCompressed *header = consumeCompressedData(&si, sizeof(DictionaryCompressed));
 
 	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_DICTIONARY);
-	CheckCompressedData(header->element_type == TEXTOID);
+	CheckCompressedData(header->element_type == element_type);
 
 	Simple8bRleSerialized *indices_serialized = bytes_deserialize_simple8b_and_advance(&si);
 
@@ -536,13 +537,16 @@ tsl_text_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryCon
 	bool have_incorrect_index = false;
 	for (uint32 i = 0; i < n_notnull; i++)
 	{
-		have_incorrect_index = have_incorrect_index || indices[i] >= (int16) header->num_distinct;
+		have_incorrect_index =
+			have_incorrect_index || indices[i] < 0 || indices[i] >= (int16) header->num_distinct;
 	}
 	CheckCompressedData(!have_incorrect_index);
 
 	/* Decompress the actual values in the dictionary. */
-	ArrowArray *dict =
-		text_array_decompress_all_serialized_no_header(&si, /* has_nulls = */ false, dest_mctx);
+	ArrowArray *dict = array_decompress_all_serialized_no_header(&si,
+																 element_type,
+																 /* has_nulls = */ false,
+																 dest_mctx);
 	CheckCompressedData(header->num_distinct == dict->length);
 
 	uint64 *restrict validity_bitmap = NULL;
@@ -599,12 +603,61 @@ tsl_text_dictionary_decompress_all(Datum compressed, Oid element_type, MemoryCon
 		MemoryContextAllocZero(dest_mctx, sizeof(ArrowArray) + (sizeof(void *) * 2));
 	const void **buffers = (const void **) &result[1];
 	buffers[0] = validity_bitmap;
-	buffers[1] = indices;
 	result->n_buffers = 2;
 	result->buffers = buffers;
 	result->length = n_total;
 	result->null_count = n_total - n_notnull;
-	result->dictionary = dict;
+
+	const int16 typlen = get_typlen(element_type);
+	if (typlen == -1)
+	{
+		buffers[1] = indices;
+		result->dictionary = dict;
+		return result;
+	}
+
+	/*
+	 * Fixed-width type, look up the values by the indices. The null elements
+	 * have index 0, which is valid if we have any not-null elements, so we
+	 * don't need to check the validity.
+	 */
+	Assert(typlen > 0);
+	const char *restrict dict_values = dict->buffers[1];
+
+	/*
+	 * We need additional padding at the end of buffer, because the code that
+	 * converts the elements to postgres Datum always reads in 8 bytes.
+	 */
+	char *restrict values =
+		MemoryContextAlloc(dest_mctx, pad_to_multiple(64, typlen * n_total) + 8);
+
+#define GATHER_CASE(CTYPE)                                                                         \
+	case sizeof(CTYPE):                                                                            \
+		for (uint32 i = 0; i < n_total; i++)                                                       \
+		{                                                                                          \
+			((CTYPE *) values)[i] = ((const CTYPE *) dict_values)[indices[i]];                     \
+		}                                                                                          \
+		break
+
+	if (n_notnull > 0)
+	{
+		switch (typlen)
+		{
+			GATHER_CASE(uint8);
+			GATHER_CASE(uint16);
+			GATHER_CASE(uint32);
+			GATHER_CASE(uint64);
+			default:
+				for (uint32 i = 0; i < n_total; i++)
+				{
+					memcpy(&values[typlen * i], &dict_values[typlen * indices[i]], typlen);
+				}
+				break;
+		}
+	}
+#undef GATHER_CASE
+
+	buffers[1] = values;
 	return result;
 }
 
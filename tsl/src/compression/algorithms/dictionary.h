@@ -48,13 +48,11 @@ extern Datum dictionary_compressed_recv(StringInfo buf);
 extern Datum tsl_dictionary_compressor_append(PG_FUNCTION_ARGS);
 extern Datum tsl_dictionary_compressor_finish(PG_FUNCTION_ARGS);
 
-/* Pass through to the specialized functions below for BOOL and TEXT */
+/* Supports the same element types as the bulk decompression of arrays. */
 ArrowArray *tsl_dictionary_decompress_all(Datum compressed, Oid element_type,
 										  MemoryContext dest_mctx);
 ArrowArray *tsl_bool_dictionary_decompress_all(Datum compressed, Oid element_type,
 											   MemoryContext dest_mctx);
-ArrowArray *tsl_text_dictionary_decompress_all(Datum compressed, Oid element_type,
-											   MemoryContext dest_mctx);
 
 #define DICTIONARY_ALGORITHM_DEFINITION                                                            \
 	{                                                                                              \
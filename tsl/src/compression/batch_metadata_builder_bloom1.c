@@ -0,0 +1,408 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * The bloom filter sparse index for compressed batches. It allows us to skip
+ * the batches that can't contain the given value for the equality and
+ * "= ANY(array)" conditions. This is useful for the high-cardinality columns
+ * like various ids, for which the minmax sparse index doesn't help.
+ *
+ * The bloom filter is stored as a bytea bitmap with a power of two number of
+ * bits. For each value, we set BLOOM1_HASHES bits which are derived from the
+ * 64-bit extended hash of the value using double hashing. The size of the
+ * filter is chosen based on the number of distinct hashes in the batch. The
+ * "1" in the name is the version of this format.
+ */
+#include <postgres.h>
+
+#include <access/stratnum.h>
+#include <catalog/pg_collation.h>
+#include <catalog/pg_type.h>
+#include <port/pg_bitutils.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
+
+#include "batch_metadata_builder_bloom1.h"
+
+#include "compression.h"
+#include "extension_constants.h"
+#include "utils.h"
+
+#if PG16_GE
+#include <varatt.h>
+#endif
+
+/* The number of bits we set for each value. */
+#define BLOOM1_HASHES 4
+
+/*
+ * The number of bits in the filter per distinct value. With four hashes, this
+ * gives about 1% false positive rate, before rounding the filter size up to a
+ * power of two.
+ */
+#define BLOOM1_BITS_PER_VALUE 10
+
+#define BLOOM1_MIN_BITS 64
+
+#define BLOOM1_SEED 0
+
+typedef struct BatchMetadataBuilderBloom1
+{
+	BatchMetadataBuilder functions;
+
+	FmgrInfo *hash_function;
+	Oid hash_collation;
+
+	/* The hashes of the not-null values of the current batch. */
+	uint64 *hashes;
+	int num_hashes;
+	int num_allocated_hashes;
+
+	/* The bloom filter we have put into the compressed row, if any. */
+	bytea *bloom;
+
+	int16 bloom_attr_offset;
+} BatchMetadataBuilderBloom1;
+
+static void bloom1_update_val(void *builder_, Datum val);
+static void bloom1_update_null(void *builder_);
+static void bloom1_insert_to_compressed_row(void *builder_, RowCompressor *compressor);
+static void bloom1_reset(void *builder_, RowCompressor *compressor);
+
+/*
+ * We can build the bloom filter for the types that have the extended hash
+ * function, and only for the deterministic collations, because for them the
+ * equal values have the same bytes and therefore the same hash.
+ */
+bool
+bloom1_column_supported(Oid type_oid, Oid collation)
+{
+	TypeCacheEntry *type = lookup_type_cache(type_oid, TYPECACHE_HASH_EXTENDED_PROC);
+	if (!OidIsValid(type->hash_extended_proc))
+	{
+		return false;
+	}
+
+	return !OidIsValid(collation) || get_collation_isdeterministic(collation);
+}
+
+/*
+ * Check that the condition "column <op> value" with the given operator and
+ * collation can be checked with the bloom filter. The operator must be the
+ * hash equality for the column type, so that the equal values have the same
+ * hash.
+ */
+bool
+bloom1_operator_supported(Oid op_oid, Oid column_type, Oid collation)
+{
+	if (!OidIsValid(op_oid) || !op_strict(op_oid))
+	{
+		return false;
+	}
+
+	if (OidIsValid(collation) && !get_collation_isdeterministic(collation))
+	{
+		return false;
+	}
+
+	TypeCacheEntry *type = lookup_type_cache(column_type, TYPECACHE_HASH_OPFAMILY);
+	if (!OidIsValid(type->hash_opf))
+	{
+		return false;
+	}
+
+	return get_op_opfamily_strategy(op_oid, type->hash_opf) == HTEqualStrategyNumber;
+}
+
+/*
+ * The hashes of the values with deterministic collations don't depend on the
+ * particular collation, so we always use the "C" collation. This way, the
+ * bloom filter doesn't depend on the collation of the query.
+ */
+static Oid
+bloom1_hash_collation(Oid type_oid)
+{
+	return type_is_collatable(type_oid) ? C_COLLATION_OID : InvalidOid;
+}
+
+static FmgrInfo *
+bloom1_hash_function(Oid type_oid)
+{
+	TypeCacheEntry *type = lookup_type_cache(type_oid, TYPECACHE_HASH_EXTENDED_PROC_FINFO);
+	if (!OidIsValid(type->hash_extended_proc))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("could not identify an extended hash function for type %s",
+						format_type_be(type_oid))));
+	}
+
+	return &type->hash_extended_proc_finfo;
+}
+
+static inline uint64
+bloom1_hash(FmgrInfo *hash_function, Oid collation, Datum value)
+{
+	return DatumGetUInt64(
+		FunctionCall2Coll(hash_function, collation, value, Int64GetDatum(BLOOM1_SEED)));
+}
+
+/*
+ * Get the position of the i-th bit for the given hash. The number of bits is
+ * a power of two, and the second hash is odd, so all the positions are
+ * different.
+ */
+static inline uint32
+bloom1_bit_position(uint64 hash, int i, uint32 num_bits)
+{
+	const uint32 h1 = (uint32) hash;
+	const uint32 h2 = ((uint32) (hash >> 32)) | 1;
+	return (h1 + i * h2) & (num_bits - 1);
+}
+
+static bool
+bloom1_check_hash(const bytea *bloom, uint64 hash)
+{
+	const uint8 *bits = (const uint8 *) VARDATA_ANY(bloom);
+	const uint32 num_bytes = VARSIZE_ANY_EXHDR(bloom);
+	const uint32 num_bits = num_bytes * 8;
+
+	/* Can't really happen unless the data is corrupt. */
+	CheckCompressedData(num_bits >= BLOOM1_MIN_BITS && (num_bits & (num_bits - 1)) == 0);
+
+	for (int i = 0; i < BLOOM1_HASHES; i++)
+	{
+		const uint32 position = bloom1_bit_position(hash, i, num_bits);
+		if (!(bits[position / 8] & (1 << (position % 8))))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+BatchMetadataBuilder *
+batch_metadata_builder_bloom1_create(Oid type_oid, int bloom_attr_offset)
+{
+	BatchMetadataBuilderBloom1 *builder = palloc(sizeof(*builder));
+
+	*builder = (BatchMetadataBuilderBloom1){
+		.functions =
+			(BatchMetadataBuilder){
+				.update_val = bloom1_update_val,
+				.update_null = bloom1_update_null,
+				.insert_to_compressed_row = bloom1_insert_to_compressed_row,
+				.reset = bloom1_reset,
+			},
+		.hash_function = bloom1_hash_function(type_oid),
+		.hash_collation = bloom1_hash_collation(type_oid),
+		.num_allocated_hashes = TARGET_COMPRESSED_BATCH_SIZE,
+		.bloom_attr_offset = bloom_attr_offset,
+	};
+
+	builder->hashes = palloc(sizeof(*builder->hashes) * builder->num_allocated_hashes);
+
+	return &builder->functions;
+}
+
+static void
+bloom1_update_val(void *builder_, Datum val)
+{
+	BatchMetadataBuilderBloom1 *builder = (BatchMetadataBuilderBloom1 *) builder_;
+
+	if (builder->num_hashes >= builder->num_allocated_hashes)
+	{
+		builder->num_allocated_hashes *= 2;
+		builder->hashes = repalloc(builder->hashes,
+								   sizeof(*builder->hashes) * builder->num_allocated_hashes);
+	}
+
+	builder->hashes[builder->num_hashes++] =
+		bloom1_hash(builder->hash_function, builder->hash_collation, val);
+}
+
+static void
+bloom1_update_null(void *builder_)
+{
+	/* The nulls never match the equality conditions, so we don't store them. */
+}
+
+static int
+uint64_cmp(const void *a, const void *b)
+{
+	const uint64 x = *(const uint64 *) a;
+	const uint64 y = *(const uint64 *) b;
+	return (x > y) - (x < y);
+}
+
+static void
+bloom1_insert_to_compressed_row(void *builder_, RowCompressor *compressor)
+{
+	BatchMetadataBuilderBloom1 *builder = (BatchMetadataBuilderBloom1 *) builder_;
+	Assert(builder->bloom_attr_offset >= 0);
+
+	if (builder->num_hashes == 0)
+	{
+		/*
+		 * All values are null, so no value can match. The condition on the
+		 * null bloom filter is also null, so the batch is skipped.
+		 */
+		compressor->compressed_is_null[builder->bloom_attr_offset] = true;
+		return;
+	}
+
+	/*
+	 * Deduplicate the hashes to determine the size of the filter. The batches
+	 * of low-cardinality columns get small filters.
+	 */
+	qsort(builder->hashes, builder->num_hashes, sizeof(*builder->hashes), uint64_cmp);
+	int num_distinct = 1;
+	for (int i = 1; i < builder->num_hashes; i++)
+	{
+		if (builder->hashes[i] != builder->hashes[num_distinct - 1])
+		{
+			builder->hashes[num_distinct++] = builder->hashes[i];
+		}
+	}
+
+	const uint32 num_bits =
+		pg_nextpower2_32(Max(BLOOM1_MIN_BITS, num_distinct * BLOOM1_BITS_PER_VALUE));
+	const uint32 num_bytes = num_bits / 8;
+
+	if (builder->bloom != NULL)
+	{
+		pfree(builder->bloom);
+	}
+	builder->bloom = palloc0(VARHDRSZ + num_bytes);
+	SET_VARSIZE(builder->bloom, VARHDRSZ + num_bytes);
+
+	uint8 *bits = (uint8 *) VARDATA(builder->bloom);
+	for (int i = 0; i < num_distinct; i++)
+	{
+		for (int j = 0; j < BLOOM1_HASHES; j++)
+		{
+			const uint32 position = bloom1_bit_position(builder->hashes[i], j, num_bits);
+			bits[position / 8] |= 1 << (position % 8);
+		}
+	}
+
+	compressor->compressed_is_null[builder->bloom_attr_offset] = false;
+	compressor->compressed_values[builder->bloom_attr_offset] = PointerGetDatum(builder->bloom);
+}
+
+static void
+bloom1_reset(void *builder_, RowCompressor *compressor)
+{
+	BatchMetadataBuilderBloom1 *builder = (BatchMetadataBuilderBloom1 *) builder_;
+
+	builder->num_hashes = 0;
+	if (builder->bloom != NULL)
+	{
+		pfree(builder->bloom);
+		builder->bloom = NULL;
+	}
+
+	compressor->compressed_is_null[builder->bloom_attr_offset] = true;
+	compressor->compressed_values[builder->bloom_attr_offset] = 0;
+}
+
+/*
+ * Find the function that checks the bloom filter, for the equality or for the
+ * "= ANY(array)" condition.
+ */
+Oid
+bloom1_get_contains_function(bool is_array_op)
+{
+	Oid argtypes[] = { BYTEAOID, is_array_op ? ANYARRAYOID : ANYELEMENTOID };
+	return ts_get_function_oid(is_array_op ? "bloom1_contains_any" : "bloom1_contains",
+							   FUNCTIONS_SCHEMA_NAME,
+							   lengthof(argtypes),
+							   argtypes);
+}
+
+/*
+ * The hash function for the argument type is cached in fn_extra. Note that
+ * these functions can be called from the scan keys where we don't have the
+ * proper call expression, so the callers have to provide it with
+ * fmgr_info_set_expr().
+ */
+static FmgrInfo *
+bloom1_get_cached_hash_function(FunctionCallInfo fcinfo, bool is_array_op, Oid *type_oid)
+{
+	Oid argtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+	if (is_array_op)
+	{
+		argtype = get_element_type(argtype);
+	}
+
+	if (!OidIsValid(argtype))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("could not determine the type of the bloom filter argument")));
+	}
+
+	*type_oid = argtype;
+	if (fcinfo->flinfo->fn_extra == NULL)
+	{
+		fcinfo->flinfo->fn_extra = bloom1_hash_function(argtype);
+	}
+
+	return (FmgrInfo *) fcinfo->flinfo->fn_extra;
+}
+
+Datum
+tsl_bloom1_contains(PG_FUNCTION_ARGS)
+{
+	const bytea *bloom = PG_GETARG_BYTEA_PP(0);
+
+	Oid type_oid;
+	FmgrInfo *hash_function = bloom1_get_cached_hash_function(fcinfo, false, &type_oid);
+	const uint64 hash =
+		bloom1_hash(hash_function, bloom1_hash_collation(type_oid), PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(bloom1_check_hash(bloom, hash));
+}
+
+Datum
+tsl_bloom1_contains_any(PG_FUNCTION_ARGS)
+{
+	const bytea *bloom = PG_GETARG_BYTEA_PP(0);
+	ArrayType *array = PG_GETARG_ARRAYTYPE_P(1);
+
+	Oid type_oid;
+	FmgrInfo *hash_function = bloom1_get_cached_hash_function(fcinfo, true, &type_oid);
+	const Oid collation = bloom1_hash_collation(type_oid);
+
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	get_typlenbyvalalign(type_oid, &typlen, &typbyval, &typalign);
+
+	Datum *values;
+	bool *nulls;
+	int num_values;
+	deconstruct_array(array, type_oid, typlen, typbyval, typalign, &values, &nulls, &num_values);
+
+	for (int i = 0; i < num_values; i++)
+	{
+		/* The null elements can't match. */
+		if (nulls[i])
+		{
+			continue;
+		}
+
+		if (bloom1_check_hash(bloom, bloom1_hash(hash_function, collation, values[i])))
+		{
+			PG_RETURN_BOOL(true);
+		}
+	}
+
+	PG_RETURN_BOOL(false);
+}
@@ -0,0 +1,24 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+
+#include "batch_metadata_builder.h"
+
+/*
+ * The name of the sparse index type, used for the names of the metadata
+ * columns of compressed chunks.
+ */
+#define BLOOM1_SPARSE_INDEX_TYPE "bloom1"
+
+extern bool bloom1_column_supported(Oid type_oid, Oid collation);
+extern bool bloom1_operator_supported(Oid op_oid, Oid column_type, Oid collation);
+extern Oid bloom1_get_contains_function(bool is_array_op);
+
+extern Datum tsl_bloom1_contains(PG_FUNCTION_ARGS);
+extern Datum tsl_bloom1_contains_any(PG_FUNCTION_ARGS);
@@ -20,14 +20,17 @@
 #include "compat/compat.h"
 
 #include "algorithms/array.h"
+#include "algorithms/bitpack.h"
 #include "algorithms/bool_compress.h"
 #include "algorithms/deltadelta.h"
 #include "algorithms/dictionary.h"
 #include "algorithms/gorilla.h"
 #include "algorithms/null.h"
 #include "batch_metadata_builder.h"
+#include "batch_metadata_builder_bloom1.h"
 #include "chunk.h"
 #include "compression.h"
+#include "compression_parallel.h"
 #include "create.h"
 #include "custom_type_cache.h"
 #include "debug_assert.h"
@@ -61,6 +64,7 @@ static const CompressionAlgorithmDefinition definitions[_END_COMPRESSION_ALGORIT
 	[COMPRESSION_ALGORITHM_DELTADELTA] = DELTA_DELTA_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_BOOL] = BOOL_COMPRESS_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_NULL] = NULL_COMPRESS_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_BITPACK] = BITPACK_ALGORITHM_DEFINITION,
 };
 
 static NameData compression_algorithm_name[] = {
@@ -71,6 +75,7 @@ static NameData compression_algorithm_name[] = {
 	[COMPRESSION_ALGORITHM_DELTADELTA] = { "DELTADELTA" },
 	[COMPRESSION_ALGORITHM_BOOL] = { "BOOL" },
 	[COMPRESSION_ALGORITHM_NULL] = { "NULL" },
+	[COMPRESSION_ALGORITHM_BITPACK] = { "BITPACK" },
 };
 
 Name
@@ -107,17 +112,20 @@ tsl_get_decompress_all_function(CompressionAlgorithm algorithm, Oid type)
 	if (algorithm >= _END_COMPRESSION_ALGORITHMS)
 		elog(ERROR, "invalid compression algorithm %d", algorithm);
 
-	if (type != TEXTOID && type != BOOLOID &&
-		(algorithm == COMPRESSION_ALGORITHM_DICTIONARY || algorithm == COMPRESSION_ALGORITHM_ARRAY))
+	if ((algorithm == COMPRESSION_ALGORITHM_DICTIONARY ||
+		 algorithm == COMPRESSION_ALGORITHM_ARRAY) &&
+		!array_decompress_all_supported(type))
 	{
-		/* Bulk decompression of array and dictionary is only supported for text. */
+		/*
+		 * Bulk decompression of array and dictionary is supported for bool,
+		 * fixed-width and varlena types, but not e.g. for cstring.
+		 */
 		return NULL;
 	}
 
 	return definitions[algorithm].decompress_all;
 }
 
-static Tuplesortstate *compress_chunk_sort_relation(CompressionSettings *settings, Relation in_rel);
 static void row_compressor_process_ordered_slot(RowCompressor *row_compressor, TupleTableSlot *slot,
 												CommandId mycid);
 static void row_compressor_update_group(RowCompressor *row_compressor, TupleTableSlot *row);
@@ -503,7 +511,7 @@ compress_chunk(Oid in_table, Oid out_table, int insert_options)
 		index_endscan(index_scan);
 		index_close(matched_index_rel, AccessShareLock);
 	}
-	else
+	else if (!compress_chunk_parallel(settings, in_rel, &row_compressor))
 	{
 		elog(ts_guc_debug_compression_path_info ? INFO : DEBUG1,
 			 "using tuplesort to scan rows from \"%s\" for converting to columnstore",
@@ -641,7 +649,7 @@ compression_create_tuplesort_state(CompressionSettings *settings, Relation rel)
 								false /*=randomAccess*/);
 }
 
-static Tuplesortstate *
+Tuplesortstate *
 compress_chunk_sort_relation(CompressionSettings *settings, Relation in_rel)
 {
 	Tuplesortstate *tuplesortstate;
@@ -831,9 +839,28 @@ build_column_map(const CompressionSettings *settings, Relation uncompressed_tabl
 			Ensure(!is_orderby || batch_minmax_builder != NULL,
 				   "orderby columns must have minmax metadata");
 
+			BatchMetadataBuilder *batch_bloom1_builder = NULL;
+			if (batch_minmax_builder == NULL)
+			{
+				AttrNumber bloom1_attr_number =
+					compressed_column_metadata_attno(settings,
+													 uncompressed_table->rd_id,
+													 attr->attnum,
+													 compressed_table->rd_id,
+													 BLOOM1_SPARSE_INDEX_TYPE);
+				if (bloom1_attr_number != InvalidAttrNumber)
+				{
+					batch_bloom1_builder =
+						batch_metadata_builder_bloom1_create(attr->atttypid,
+															 AttrNumberGetAttrOffset(
+																 bloom1_attr_number));
+				}
+			}
+
 			*column = (PerColumn){
 				.compressor = compressor_for_type(attr->atttypid),
-				.metadata_builder = batch_minmax_builder,
+				.metadata_builder =
+					batch_minmax_builder != NULL ? batch_minmax_builder : batch_bloom1_builder,
 				.segmentby_column_index = -1,
 			};
 		}
@@ -904,7 +931,13 @@ void
 row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate *sorted_rel,
 								  TupleDesc sorted_desc, Relation in_rel)
 {
-	CommandId mycid = GetCurrentCommandId(true);
+	/*
+	 * The parallel compression workers don't insert the compressed tuples
+	 * themselves, and they are not allowed to use the command id for writing.
+	 */
+	CommandId mycid = row_compressor->insert_compressed_tuple != NULL ?
+						  InvalidCommandId :
+						  GetCurrentCommandId(true);
 	TupleTableSlot *slot = MakeTupleTableSlot(sorted_desc, &TTSOpsMinimalTuple);
 	bool got_tuple;
 	int64 nrows_processed = 0;
@@ -1121,15 +1154,13 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	compressed_tuple = heap_form_tuple(RelationGetDescr(row_compressor->compressed_table),
 									   row_compressor->compressed_values,
 									   row_compressor->compressed_is_null);
-	Assert(row_compressor->bistate != NULL);
-	heap_insert(row_compressor->compressed_table,
-				compressed_tuple,
-				mycid,
-				row_compressor->insert_options /*=options*/,
-				row_compressor->bistate);
-	if (row_compressor->resultRelInfo->ri_NumIndices > 0)
+	if (row_compressor->insert_compressed_tuple != NULL)
 	{
-		ts_catalog_index_insert(row_compressor->resultRelInfo, compressed_tuple);
+		row_compressor->insert_compressed_tuple(row_compressor, compressed_tuple);
+	}
+	else
+	{
+		row_compressor_insert_compressed_tuple(row_compressor, compressed_tuple, mycid);
 	}
 
 	heap_freetuple(compressed_tuple);
@@ -1175,6 +1206,26 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	MemoryContextReset(row_compressor->per_row_ctx);
 }
 
+/*
+ * Insert the compressed tuple into the compressed table and update its
+ * indexes.
+ */
+void
+row_compressor_insert_compressed_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple,
+									   CommandId mycid)
+{
+	Assert(row_compressor->bistate != NULL);
+	heap_insert(row_compressor->compressed_table,
+				compressed_tuple,
+				mycid,
+				row_compressor->insert_options /*=options*/,
+				row_compressor->bistate);
+	if (row_compressor->resultRelInfo->ri_NumIndices > 0)
+	{
+		ts_catalog_index_insert(row_compressor->resultRelInfo, compressed_tuple);
+	}
+}
+
 void
 row_compressor_reset(RowCompressor *row_compressor)
 {
@@ -2051,6 +2102,9 @@ tsl_compressed_data_info(PG_FUNCTION_ARGS)
 		case COMPRESSION_ALGORITHM_NULL:
 			has_nulls = true;
 			break;
+		case COMPRESSION_ALGORITHM_BITPACK:
+			has_nulls = bitpack_compressed_has_nulls(header);
+			break;
 		default:
 			elog(ERROR, "unknown compression algorithm %d", header->compression_algorithm);
 			break;
@@ -2095,6 +2149,9 @@ tsl_compressed_data_has_nulls(PG_FUNCTION_ARGS)
 		case COMPRESSION_ALGORITHM_NULL:
 			has_nulls = true;
 			break;
+		case COMPRESSION_ALGORITHM_BITPACK:
+			has_nulls = bitpack_compressed_has_nulls(header);
+			break;
 		default:
 			elog(ERROR, "unknown compression algorithm %d", header->compression_algorithm);
 			break;
@@ -2127,6 +2184,15 @@ compression_get_default_algorithm(Oid typeoid)
 		case INT4OID:
 		case INT2OID:
 		case INT8OID:
+			/*
+			 * The bitpack compressor falls back to deltadelta for the batches
+			 * where it is smaller.
+			 */
+			if (ts_guc_enable_bitpack_compression)
+				return COMPRESSION_ALGORITHM_BITPACK;
+			else
+				return COMPRESSION_ALGORITHM_DELTADELTA;
+
 		case DATEOID:
 		case TIMESTAMPOID:
 		case TIMESTAMPTZOID:
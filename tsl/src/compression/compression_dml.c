@@ -14,13 +14,17 @@
 #include <parser/parse_coerce.h>
 #include <parser/parse_relation.h>
 #include <parser/parsetree.h>
+#include <utils/inval.h>
 #include <utils/lsyscache.h>
+#include <utils/memutils.h>
 #include <utils/relcache.h>
 #include <utils/snapmgr.h>
+#include <utils/tuplesort.h>
 #include <utils/typcache.h>
 
 #include <compat/compat.h>
 #include <compression/arrow_c_data_interface.h>
+#include <compression/batch_metadata_builder_bloom1.h>
 #include <compression/compression.h>
 #include <compression/compression_dml.h>
 #include <compression/create.h>
@@ -30,9 +34,12 @@
 #include <nodes/chunk_dispatch/chunk_dispatch.h>
 #include <nodes/chunk_dispatch/chunk_insert_state.h>
 #include <nodes/decompress_chunk/vector_dict.h>
+#include <nodes/decompress_chunk/vector_expression.h>
 #include <nodes/decompress_chunk/vector_predicates.h>
+#include <nodes/decompress_chunk/vector_quals.h>
 #include <nodes/modify_hypertable.h>
 #include <ts_catalog/array_utils.h>
+#include <ts_catalog/chunk_column_stats.h>
 
 static struct decompress_batches_stats
 decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, Snapshot snapshot,
@@ -40,7 +47,8 @@ decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, S
 						ScanKeyData *heap_scankeys, int num_heap_scankeys,
 						ScanKeyData *mem_scankeys, int num_mem_scankeys,
 						tuple_filtering_constraints *constraints, bool *skip_current_tuple,
-						bool delete_only, Bitmapset *null_columns, List *is_nulls);
+						bool delete_only, Bitmapset *null_columns, List *is_nulls,
+						List *vectorized_quals);
 
 static bool batch_matches(RowDecompressor *decompressor, ScanKeyData *scankeys, int num_scankeys,
 						  tuple_filtering_constraints *constraints, bool *skip_current_tuple);
@@ -48,8 +56,15 @@ static bool batch_matches_vectorized(RowDecompressor *decompressor, ScanKeyData
 									 int num_scankeys, tuple_filtering_constraints *constraints,
 									 bool *skip_current_tuple);
 static void process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
-							   ScanKeyData **mem_scankeys, int *num_mem_scankeys,
-							   List **heap_filters, List **index_filters, List **is_null);
+							   List *vectorized_predicates, ScanKeyData **mem_scankeys,
+							   int *num_mem_scankeys, List **heap_filters, List **index_filters,
+							   List **is_null);
+static List *make_vectorized_predicates(Relation chunk_rel, CompressionSettings *settings,
+										Index scanrelid, List *predicates, EState *estate,
+										List **vectorized_predicates);
+static void add_bloom1_batchfilter(Chunk *ch, CompressionSettings *settings, Var *var, Oid opno,
+								   Oid collation, Const *arg_value, bool is_array_op,
+								   List **heap_filters);
 static Relation find_matching_index(Relation comp_chunk_rel, List **index_filters,
 									List **heap_filters);
 static tuple_filtering_constraints *
@@ -65,7 +80,7 @@ static bool key_column_is_null(tuple_filtering_constraints *constraints, Relatio
 							   Oid ht_relid, TupleTableSlot *slot);
 static bool can_delete_without_decompression(ModifyHypertableState *ht_state,
 											 CompressionSettings *settings, Chunk *chunk,
-											 List *predicates);
+											 List *predicates, List *vectorized_predicates);
 static bool can_vectorize_constraint_checks(tuple_filtering_constraints *constraints,
 											CompressionSettings *settings, Relation chunk_rel,
 											Oid ht_relid, TupleTableSlot *slot);
@@ -211,6 +226,7 @@ decompress_batches_for_insert(const ChunkInsertState *cis, TupleTableSlot *slot)
 									false,
 									null_columns, /* no null column check for non-segmentby
 											 columns */
+									NIL,
 									NIL);
 	if (index_rel)
 		index_close(index_rel, AccessShareLock);
@@ -230,11 +246,81 @@ decompress_batches_for_insert(const ChunkInsertState *cis, TupleTableSlot *slot)
 	table_close(in_rel, NoLock);
 }
 
+/*
+ * Compress the given rows of a compressed chunk and insert them as new
+ * batches of the compressed chunk, instead of inserting them into the
+ * uncompressed chunk and recompressing them later.
+ *
+ * The rows are sorted by the segmentby and orderby columns, but the new
+ * batches will usually overlap with the existing ones, so the chunk is marked
+ * as unordered. The caller must ensure that there are no unique constraints
+ * to check.
+ *
+ * The batches are at most as large as the given rows, which the caller
+ * collects up to the target batch size when it can. The rows are also split by
+ * the segmentby values, so the new batches can be smaller than usual. They are
+ * merged with the rest when the unordered chunk is recompressed.
+ */
+void
+compress_batches_for_insert(const ChunkInsertState *cis, TupleTableSlot **slots, int nslots)
+{
+	Relation in_rel = cis->rel;
+	CompressionSettings *settings = ts_compression_settings_get(RelationGetRelid(in_rel));
+	MemoryContext mcxt = AllocSetContextCreate(CurrentMemoryContext,
+											   "compress batches for insert",
+											   ALLOCSET_DEFAULT_SIZES);
+	MemoryContext oldcontext = MemoryContextSwitchTo(mcxt);
+	RowCompressor row_compressor;
+
+	Assert(!ts_indexing_relation_has_primary_or_unique_index(in_rel));
+	Ensure(settings != NULL && OidIsValid(settings->fd.compress_relid),
+		   "no compressed chunk for \"%s\"",
+		   RelationGetRelationName(in_rel));
+
+	Relation out_rel = table_open(settings->fd.compress_relid, RowExclusiveLock);
+	Tuplesortstate *sorted = compression_create_tuplesort_state(settings, in_rel);
+
+	for (int i = 0; i < nslots; i++)
+		tuplesort_puttupleslot(sorted, slots[i]);
+	tuplesort_performsort(sorted);
+
+	row_compressor_init(settings,
+						&row_compressor,
+						in_rel,
+						out_rel,
+						RelationGetDescr(out_rel)->natts,
+						false /*need_bistate*/,
+						0 /*insert options*/);
+	row_compressor_append_sorted_rows(&row_compressor, sorted, RelationGetDescr(in_rel), in_rel);
+	row_compressor_close(&row_compressor);
+	tuplesort_end(sorted);
+	table_close(out_rel, NoLock);
+
+	Chunk *chunk = ts_chunk_get_by_id(cis->chunk_id, true);
+	if (!ts_chunk_is_unordered(chunk))
+	{
+		ts_chunk_set_unordered(chunk);
+		/* changed chunk status, so invalidate any plans involving this chunk */
+		CacheInvalidateRelcacheByRelid(chunk->table_id);
+	}
+
+	/*
+	 * The new rows might be outside of the min/max ranges of the chunk column
+	 * stats, so the chunk must not be skipped based on them anymore, the same
+	 * as for the partial chunks, see ts_chunk_set_partial().
+	 */
+	ts_chunk_column_stats_set_invalid(chunk->fd.hypertable_id, chunk->fd.id);
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextDelete(mcxt);
+}
+
 /*
  * This method will:
  *  1. Evaluate WHERE clauses and check if SEGMENT BY columns
  *     are specified or not.
- *  2. Build scan keys for SEGMENT BY columns.
+ *  2. Build scan keys for SEGMENT BY columns and vectorized quals for
+ *     the compressed columns.
  *  3. Move scanned rows to staging area.
  *  4. Update catalog table to change status of moved chunk.
  *
@@ -242,7 +328,8 @@ decompress_batches_for_insert(const ChunkInsertState *cis, TupleTableSlot *slot)
  */
 static bool
 decompress_batches_for_update_delete(ModifyHypertableState *ht_state, Chunk *chunk,
-									 List *predicates, EState *estate, bool has_joins)
+									 Index scanrelid, List *predicates, EState *estate,
+									 bool has_joins)
 {
 	/* process each chunk with its corresponding predicates */
 
@@ -263,23 +350,38 @@ decompress_batches_for_update_delete(ModifyHypertableState *ht_state, Chunk *chu
 	struct decompress_batches_stats stats;
 	int num_mem_scankeys = 0;
 	ScanKeyData *mem_scankeys = NULL;
+	List *vectorized_predicates = NIL;
+	List *vectorized_quals = NIL;
 
 	CompressionSettings *settings = ts_compression_settings_get(chunk->table_id);
+
+	chunk_rel = table_open(chunk->table_id, RowExclusiveLock);
+	comp_chunk_rel = table_open(settings->fd.compress_relid, RowExclusiveLock);
+
+	vectorized_quals = make_vectorized_predicates(chunk_rel,
+												  settings,
+												  scanrelid,
+												  predicates,
+												  estate,
+												  &vectorized_predicates);
+
 	bool delete_only = ht_state->mt->operation == CMD_DELETE && !has_joins &&
-					   can_delete_without_decompression(ht_state, settings, chunk, predicates);
+					   can_delete_without_decompression(ht_state,
+														settings,
+														chunk,
+														predicates,
+														vectorized_predicates);
 
 	process_predicates(chunk,
 					   settings,
 					   predicates,
+					   vectorized_predicates,
 					   &mem_scankeys,
 					   &num_mem_scankeys,
 					   &heap_filters,
 					   &index_filters,
 					   &is_null);
 
-	chunk_rel = table_open(chunk->table_id, RowExclusiveLock);
-	comp_chunk_rel = table_open(settings->fd.compress_relid, RowExclusiveLock);
-
 	if (index_filters)
 	{
 		matching_index_rel = find_matching_index(comp_chunk_rel, &index_filters, &heap_filters);
@@ -314,7 +416,8 @@ decompress_batches_for_update_delete(ModifyHypertableState *ht_state, Chunk *chu
 									NULL,
 									delete_only,
 									null_columns,
-									is_null);
+									is_null,
+									vectorized_quals);
 
 	/* close the selected index */
 	if (matching_index_rel)
@@ -408,6 +511,61 @@ decompress_batch_endscan(DecompressBatchScanDesc scan)
 	pfree(scan);
 }
 
+/*
+ * State for computing the vectorized quals on the batches of the
+ * RowDecompressor. The columns are decompressed on demand and cached for the
+ * current batch, because several quals often reference the same column.
+ */
+typedef struct RowDecompressorVectorQualState
+{
+	VectorQualState vqstate;
+	RowDecompressor *decompressor;
+	/* Arrays indexed by uncompressed attribute offset */
+	const ArrowArray **arrow_arrays;
+	bool *default_values;
+} RowDecompressorVectorQualState;
+
+static const ArrowArray *
+row_decompressor_get_arrow_array(VectorQualState *vqstate, Expr *expr, bool *is_default_value)
+{
+	RowDecompressorVectorQualState *rdvqstate = (RowDecompressorVectorQualState *) vqstate;
+	const Var *var = castNode(Var, expr);
+	const int attoff = AttrNumberGetAttrOffset(var->varattno);
+
+	if (rdvqstate->arrow_arrays[attoff] == NULL)
+	{
+		rdvqstate->arrow_arrays[attoff] =
+			decompress_single_column(rdvqstate->decompressor,
+									 var->varattno,
+									 &rdvqstate->default_values[attoff]);
+	}
+
+	*is_default_value = rdvqstate->default_values[attoff];
+	return rdvqstate->arrow_arrays[attoff];
+}
+
+/*
+ * Compute the vectorized quals on the compressed tuple currently deformed
+ * into the decompressor.
+ */
+static VectorQualSummary
+row_decompressor_vector_qual_compute(RowDecompressorVectorQualState *rdvqstate)
+{
+	RowDecompressor *decompressor = rdvqstate->decompressor;
+	const int natts = decompressor->out_desc->natts;
+	MemoryContext oldcontext = MemoryContextSwitchTo(decompressor->per_compressed_row_ctx);
+	VectorQualSummary summary;
+
+	memset(rdvqstate->arrow_arrays, 0, sizeof(ArrowArray *) * natts);
+	rdvqstate->vqstate.num_results =
+		DatumGetInt32(decompressor->compressed_datums[decompressor->count_compressed_attindex]);
+	summary = vector_qual_compute(&rdvqstate->vqstate);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return summary;
+}
+
 /*
  * This method will:
  *  1.Scan the index created with SEGMENT BY columns or the entire compressed chunk
@@ -424,7 +582,8 @@ decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, S
 						ScanKeyData *heap_scankeys, int num_heap_scankeys,
 						ScanKeyData *mem_scankeys, int num_mem_scankeys,
 						tuple_filtering_constraints *constraints, bool *skip_current_tuple,
-						bool delete_only, Bitmapset *null_columns, List *is_nulls)
+						bool delete_only, Bitmapset *null_columns, List *is_nulls,
+						List *vectorized_quals)
 {
 	HeapTuple compressed_tuple;
 	RowDecompressor decompressor;
@@ -437,6 +596,7 @@ decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, S
 	BatchMatcher *batch_matcher =
 		constraints && constraints->vectorized_filtering ? batch_matches_vectorized : batch_matches;
 	AttrNumber meta_count_attno = InvalidAttrNumber;
+	RowDecompressorVectorQualState rdvqstate = { 0 };
 
 	struct decompress_batches_stats stats = { 0 };
 
@@ -527,6 +687,23 @@ decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, S
 			meta_count_attno = TupleDescGetAttrNumber(decompressor.in_desc,
 													  COMPRESSION_COLUMN_METADATA_COUNT_NAME);
 			Assert(meta_count_attno != InvalidAttrNumber);
+
+			if (vectorized_quals != NIL)
+			{
+				const int natts = decompressor.out_desc->natts;
+
+				rdvqstate = (RowDecompressorVectorQualState){
+					.vqstate = {
+						.vectorized_quals_constified = vectorized_quals,
+						.expression_states = vector_expression_init_states(vectorized_quals),
+						.per_vector_mcxt = decompressor.per_compressed_row_ctx,
+						.get_arrow_array = row_decompressor_get_arrow_array,
+					},
+					.decompressor = &decompressor,
+					.arrow_arrays = palloc0(sizeof(ArrowArray *) * natts),
+					.default_values = palloc0(sizeof(bool) * natts),
+				};
+			}
 		}
 
 		heap_deform_tuple(compressed_tuple,
@@ -534,6 +711,24 @@ decompress_batches_scan(Relation in_rel, Relation out_rel, Relation index_rel, S
 						  decompressor.compressed_datums,
 						  decompressor.compressed_is_nulls);
 
+		if (vectorized_quals != NIL)
+		{
+			VectorQualSummary summary = row_decompressor_vector_qual_compute(&rdvqstate);
+
+			if (summary == NoRowsPass)
+			{
+				row_decompressor_reset(&decompressor);
+				stats.batches_filtered++;
+				continue;
+			}
+
+			/*
+			 * A batch can be deleted without decompression only when all its
+			 * rows match, otherwise we have to keep the rest of them.
+			 */
+			decompressor.delete_only = delete_only && summary == AllRowsPass;
+		}
+
 		if (num_mem_scankeys && !batch_matcher(&decompressor,
 											   mem_scankeys,
 											   num_mem_scankeys,
@@ -906,6 +1101,7 @@ decompress_chunk_walker(PlanState *ps, struct decompress_chunk_context *ctx)
 
 				batches_decompressed = decompress_batches_for_update_delete(ctx->ht_state,
 																			current_chunk,
+																			scanrelid,
 																			predicates,
 																			ps->state,
 																			ctx->has_joins);
@@ -1051,8 +1247,8 @@ get_batch_keys_for_unique_constraints(const ChunkInsertState *cis, Relation rela
  */
 static void
 process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
-				   ScanKeyData **mem_scankeys, int *num_mem_scankeys, List **heap_filters,
-				   List **index_filters, List **is_null)
+				   List *vectorized_predicates, ScanKeyData **mem_scankeys, int *num_mem_scankeys,
+				   List **heap_filters, List **index_filters, List **is_null)
 {
 	ListCell *lc;
 	if (ts_guc_enable_dml_decompression_tuple_filtering)
@@ -1073,6 +1269,7 @@ process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
 	foreach (lc, predicates)
 	{
 		Node *node = copyObject(lfirst(lc));
+		bool is_vectorized = list_member_ptr(vectorized_predicates, lfirst(lc));
 		Var *var;
 		Expr *expr;
 		Oid collation, opno;
@@ -1146,8 +1343,9 @@ process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
 
 				/*
 				 * Segmentby columns are checked as part of batch scan so no need to redo the check.
+				 * The vectorized quals are computed on the whole batch instead.
 				 */
-				if (ts_guc_enable_dml_decompression_tuple_filtering)
+				if (ts_guc_enable_dml_decompression_tuple_filtering && !is_vectorized)
 				{
 					ScanKeyEntryInitialize(&(*mem_scankeys)[(*num_mem_scankeys)++],
 										   arg_value->constisnull ? SK_ISNULL : 0,
@@ -1248,6 +1446,17 @@ process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
 							break;
 					}
 				}
+				else
+				{
+					add_bloom1_batchfilter(ch,
+										   settings,
+										   var,
+										   opno,
+										   collation,
+										   arg_value,
+										   /* is_array_op = */ false,
+										   heap_filters);
+				}
 			}
 			break;
 			case T_ScalarArrayOpExpr:
@@ -1309,6 +1518,18 @@ process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
 					continue;
 				}
 
+				if (sa_expr->useOr)
+				{
+					add_bloom1_batchfilter(ch,
+										   settings,
+										   var,
+										   opno,
+										   collation,
+										   arg_value,
+										   /* is_array_op = */ true,
+										   heap_filters);
+				}
+
 				break;
 			}
 			case T_NullTest:
@@ -1353,6 +1574,68 @@ process_predicates(Chunk *ch, CompressionSettings *settings, List *predicates,
 	}
 }
 
+/*
+ * Find the predicates that can be computed on the compressed batches with the
+ * vectorized quals, the same way as in DecompressChunk. Returns the constified
+ * vectorized quals, and the original predicates they were made from in
+ * vectorized_predicates, so that we don't build the scan keys for checking
+ * them row by row.
+ */
+static List *
+make_vectorized_predicates(Relation chunk_rel, CompressionSettings *settings, Index scanrelid,
+						   List *predicates, EState *estate, List **vectorized_predicates)
+{
+	TupleDesc desc = RelationGetDescr(chunk_rel);
+	List *vectorized_quals = NIL;
+	ListCell *lc;
+
+	if (!ts_guc_enable_dml_decompression_tuple_filtering || !ts_guc_enable_bulk_decompression)
+		return NIL;
+
+	VectorQualInfo vqinfo = {
+		.rti = scanrelid,
+		.vector_attrs = palloc0(sizeof(bool) * (desc->natts + 1)),
+		.maxattno = desc->natts,
+	};
+
+	for (int i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(desc, i);
+
+		/* Segmentby columns are checked as part of batch scan */
+		if (attr->attisdropped ||
+			ts_array_is_member(settings->fd.segmentby, NameStr(attr->attname)))
+			continue;
+
+		vqinfo.vector_attrs[attr->attnum] =
+			tsl_get_decompress_all_function(compression_get_default_algorithm(attr->atttypid),
+											attr->atttypid) != NULL;
+	}
+
+	/*
+	 * The vectorized quals can only reference external parameters and not the
+	 * join parameters, so it is safe to constify them once here.
+	 */
+	PlannerGlobal glob = { .boundParams = estate->es_param_list_info };
+	PlannerInfo root = { .glob = &glob };
+
+	foreach (lc, predicates)
+	{
+		Node *vectorized_qual = vector_qual_make(lfirst(lc), &vqinfo);
+
+		if (vectorized_qual == NULL)
+			continue;
+
+		vectorized_quals =
+			lappend(vectorized_quals, estimate_expression_value(&root, vectorized_qual));
+		*vectorized_predicates = lappend(*vectorized_predicates, lfirst(lc));
+	}
+
+	pfree(vqinfo.vector_attrs);
+
+	return vectorized_quals;
+}
+
 static BatchFilter *
 make_batchfilter(char *column_name, StrategyNumber strategy, Oid collation, RegProcedure opcode,
 				 Const *value, bool is_null_check, bool is_null, bool is_array_op)
@@ -1373,6 +1656,46 @@ make_batchfilter(char *column_name, StrategyNumber strategy, Oid collation, RegP
 	return segment_filter;
 }
 
+/*
+ * Add the filter on the bloom filter sparse index for the equality or
+ * "= ANY(array)" condition on a non-segmentby column. The filter calls the
+ * function that checks the bloom filter, so it doesn't have a strategy.
+ */
+static void
+add_bloom1_batchfilter(Chunk *ch, CompressionSettings *settings, Var *var, Oid opno,
+					   Oid collation, Const *arg_value, bool is_array_op, List **heap_filters)
+{
+	if (arg_value->constisnull)
+		return;
+
+	Oid value_type = is_array_op ? get_element_type(arg_value->consttype) : arg_value->consttype;
+	if (value_type != var->vartype || var->varcollid != collation)
+		return;
+
+	int bloom1_attno = compressed_column_metadata_attno(settings,
+														ch->table_id,
+														var->varattno,
+														settings->fd.compress_relid,
+														BLOOM1_SPARSE_INDEX_TYPE);
+	if (bloom1_attno == InvalidAttrNumber)
+		return;
+
+	if (!bloom1_operator_supported(opno, var->vartype, collation))
+		return;
+
+	*heap_filters =
+		lappend(*heap_filters,
+				make_batchfilter(get_attname(settings->fd.compress_relid, bloom1_attno, false),
+								 InvalidStrategy,
+								 collation,
+								 bloom1_get_contains_function(is_array_op),
+								 arg_value,
+								 false, /* is_null_check */
+								 false, /* is_null */
+								 false	/* is_array_op */
+								 ));
+}
+
 /*
  * A compressed chunk can have multiple indexes. For a given list
  * of columns in index_filters, find the matching index which has
@@ -1587,13 +1910,20 @@ key_column_is_null(tuple_filtering_constraints *constraints, Relation chunk_rel,
 
 static bool
 can_delete_without_decompression(ModifyHypertableState *ht_state, CompressionSettings *settings,
-								 Chunk *chunk, List *predicates)
+								 Chunk *chunk, List *predicates, List *vectorized_predicates)
 {
 	ListCell *lc;
 
 	if (!ts_guc_enable_compressed_direct_batch_delete)
 		return false;
 
+	/*
+	 * Frozen chunks cannot be modified. Decompression reports the error when
+	 * it tries to change the chunk status, so don't bypass it.
+	 */
+	if (ts_chunk_is_frozen(chunk))
+		return false;
+
 	/*
 	 * If there is a RETURNING clause we skip the optimization to delete compressed batches directly
 	 */
@@ -1623,6 +1953,13 @@ can_delete_without_decompression(ModifyHypertableState *ht_state, CompressionSet
 		Expr *arg_value;
 		Oid opno;
 
+		/*
+		 * Vectorized predicates are computed for every batch, and only the
+		 * batches where all rows match are deleted directly.
+		 */
+		if (list_member_ptr(vectorized_predicates, node))
+			continue;
+
 		if (ts_extract_expr_args((Expr *) node, &var, &arg_value, &opno, NULL))
 		{
 			if (!IsA(arg_value, Const))
@@ -0,0 +1,772 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Parallel compression of a chunk.
+ *
+ * The rows of the uncompressed chunk are partitioned by the hash of their
+ * segmentby values, so that all rows of a segment belong to the same
+ * partition and the partitions can be compressed independently. There is one
+ * partition per parallel worker.
+ *
+ * The workers read the uncompressed chunk together with a single parallel
+ * scan, so every block is read only once. Each worker sorts the rows of its
+ * own partition, and sends the rows of the other partitions to their owners
+ * through a grid of shared memory queues, one per pair of workers. When the
+ * scan is done, every worker compresses its sorted partition.
+ *
+ * The parallel workers are not allowed to write to the tables, so they send
+ * the compressed tuples to the leader through the shared memory queues. The
+ * leader collects the compressed tuples while the workers are running, and
+ * inserts them into the compressed chunk after leaving the parallel mode,
+ * because some parts of the insertion, like the TOAST, are not allowed in the
+ * parallel mode.
+ */
+#include <postgres.h>
+#include <access/parallel.h>
+#include <access/tableam.h>
+#include <access/xact.h>
+#include <common/hashfn.h>
+#include <executor/tuptable.h>
+#include <miscadmin.h>
+#include <optimizer/paths.h>
+#include <pgstat.h>
+#include <storage/bufmgr.h>
+#include <storage/condition_variable.h>
+#include <storage/latch.h>
+#include <storage/proc.h>
+#include <storage/shm_mq.h>
+#include <storage/spin.h>
+#include <utils/lsyscache.h>
+#include <utils/snapmgr.h>
+#include <utils/tuplesort.h>
+#include <utils/tuplestore.h>
+#include <utils/typcache.h>
+
+#include "compression_parallel.h"
+
+#include "compat/compat.h"
+#include "config.h"
+#include "extension_constants.h"
+#include "guc.h"
+#include "hypercore/hypercore_handler.h"
+#include "ts_catalog/array_utils.h"
+
+#define PARALLEL_KEY_COMPRESS_SHARED UINT64CONST(0xC0DE000000000001)
+#define PARALLEL_KEY_COMPRESS_QUEUES UINT64CONST(0xC0DE000000000002)
+#define PARALLEL_KEY_COMPRESS_ROW_QUEUES UINT64CONST(0xC0DE000000000003)
+#define PARALLEL_KEY_COMPRESS_SCAN UINT64CONST(0xC0DE000000000004)
+
+/*
+ * The size of the queue for sending the compressed tuples from a worker to the
+ * leader. The larger tuples are sent in parts.
+ */
+#define PARALLEL_COMPRESS_QUEUE_SIZE (64 * 1024)
+
+/*
+ * The size of the queue for sending the uncompressed rows between a pair of
+ * workers. There are nworkers^2 of them, so they are smaller.
+ */
+#define PARALLEL_COMPRESS_ROW_QUEUE_SIZE (16 * 1024)
+
+/*
+ * How often a worker receives the rows sent by the other workers while it is
+ * scanning the chunk, in the number of scanned rows.
+ */
+#define PARALLEL_COMPRESS_RECEIVE_INTERVAL 256
+
+typedef struct ParallelCompressShared
+{
+	Oid in_relid;
+	Oid out_relid;
+
+	/* The number of the planned workers, for finding the row queues. */
+	int nworkers;
+
+	/*
+	 * Every launched worker owns one partition. The leader only knows how many
+	 * workers were launched after launching them, so the workers wait until it
+	 * sets this.
+	 */
+	uint32 num_partitions;
+	ConditionVariable partitions_set;
+
+	/* The statistics merged from all the workers. */
+	slock_t mutex;
+	int64 rowcnt_pre_compression;
+	int64 num_compressed_rows;
+} ParallelCompressShared;
+
+/*
+ * Computes the partition of the uncompressed row from its segmentby values.
+ */
+typedef struct SegmentbyHasher
+{
+	int num_columns;
+	AttrNumber *attnos;
+	FmgrInfo **hash_functions;
+	Oid *collations;
+} SegmentbyHasher;
+
+typedef struct ParallelCompressWorker
+{
+	/* Must be the first member, we get it in the row compressor callbacks. */
+	RowCompressor row_compressor;
+	shm_mq_handle *queue;
+} ParallelCompressWorker;
+
+/*
+ * The exchange of the uncompressed rows between the workers. The row queues
+ * are indexed by partition, and the entry for our own partition is NULL.
+ */
+typedef struct RowExchange
+{
+	uint32 num_partitions;
+	uint32 partition;
+	shm_mq_handle **outgoing;
+	/* The senders that have finished are also NULL. */
+	shm_mq_handle **incoming;
+	int num_incoming;
+	TupleTableSlot *received_slot;
+	Tuplesortstate *tuplesortstate;
+} RowExchange;
+
+/*
+ * We need a hash function for every segmentby column to partition the rows.
+ */
+static bool
+segmentby_columns_hashable(CompressionSettings *settings, Relation rel)
+{
+	const int num_segmentby = ts_array_length(settings->fd.segmentby);
+	for (int i = 1; i <= num_segmentby; i++)
+	{
+		const char *attname = ts_array_get_element_text(settings->fd.segmentby, i);
+		AttrNumber attno = get_attnum(RelationGetRelid(rel), attname);
+		Ensure(attno != InvalidAttrNumber, "segmentby column \"%s\" not found", attname);
+
+		Form_pg_attribute attr =
+			TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno));
+		TypeCacheEntry *type = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC);
+		if (!OidIsValid(type->hash_proc))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static SegmentbyHasher *
+segmentby_hasher_create(CompressionSettings *settings, Relation rel)
+{
+	SegmentbyHasher *hasher = palloc0(sizeof(*hasher));
+	hasher->num_columns = ts_array_length(settings->fd.segmentby);
+	hasher->attnos = palloc(sizeof(*hasher->attnos) * hasher->num_columns);
+	hasher->hash_functions = palloc(sizeof(*hasher->hash_functions) * hasher->num_columns);
+	hasher->collations = palloc(sizeof(*hasher->collations) * hasher->num_columns);
+
+	for (int i = 0; i < hasher->num_columns; i++)
+	{
+		const char *attname = ts_array_get_element_text(settings->fd.segmentby, i + 1);
+		AttrNumber attno = get_attnum(RelationGetRelid(rel), attname);
+		Ensure(attno != InvalidAttrNumber, "segmentby column \"%s\" not found", attname);
+
+		Form_pg_attribute attr =
+			TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno));
+		TypeCacheEntry *type = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC_FINFO);
+		Ensure(OidIsValid(type->hash_proc),
+			   "no hash function for segmentby column \"%s\"",
+			   attname);
+
+		hasher->attnos[i] = attno;
+		hasher->hash_functions[i] = &type->hash_proc_finfo;
+		hasher->collations[i] = attr->attcollation;
+	}
+
+	return hasher;
+}
+
+static uint32
+segmentby_hasher_get_partition(SegmentbyHasher *hasher, TupleTableSlot *slot,
+							   uint32 num_partitions)
+{
+	uint32 hash = 0;
+	for (int i = 0; i < hasher->num_columns; i++)
+	{
+		bool isnull;
+		Datum value = slot_getattr(slot, hasher->attnos[i], &isnull);
+		if (!isnull)
+		{
+			hash = hash_combine(hash,
+								DatumGetUInt32(FunctionCall1Coll(hasher->hash_functions[i],
+																 hasher->collations[i],
+																 value)));
+		}
+		else
+		{
+			hash = hash_combine(hash, 0);
+		}
+	}
+
+	return hash % num_partitions;
+}
+
+static shm_mq *
+row_queue_get(char *row_queue_space, int nworkers, int sender, int receiver)
+{
+	return (shm_mq *) (row_queue_space +
+					   (sender * nworkers + receiver) * PARALLEL_COMPRESS_ROW_QUEUE_SIZE);
+}
+
+static void
+row_exchange_init(RowExchange *exchange, dsm_segment *seg, char *row_queue_space, int nworkers,
+				  uint32 num_partitions, Tuplesortstate *tuplesortstate, TupleDesc tupdesc)
+{
+	*exchange = (RowExchange){
+		.num_partitions = num_partitions,
+		.partition = ParallelWorkerNumber,
+		.outgoing = palloc0(sizeof(shm_mq_handle *) * num_partitions),
+		.incoming = palloc0(sizeof(shm_mq_handle *) * num_partitions),
+		.num_incoming = num_partitions - 1,
+		.received_slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsMinimalTuple),
+		.tuplesortstate = tuplesortstate,
+	};
+
+	for (uint32 i = 0; i < num_partitions; i++)
+	{
+		if (i == exchange->partition)
+		{
+			continue;
+		}
+
+		shm_mq *outgoing = row_queue_get(row_queue_space, nworkers, exchange->partition, i);
+		shm_mq_set_sender(outgoing, MyProc);
+		exchange->outgoing[i] = shm_mq_attach(outgoing, seg, NULL);
+
+		shm_mq *incoming = row_queue_get(row_queue_space, nworkers, i, exchange->partition);
+		shm_mq_set_receiver(incoming, MyProc);
+		exchange->incoming[i] = shm_mq_attach(incoming, seg, NULL);
+	}
+}
+
+/*
+ * Put the rows that the other workers have sent us so far into our tuplesort.
+ * Returns true if we have received any rows.
+ */
+static bool
+row_exchange_receive(RowExchange *exchange)
+{
+	bool received = false;
+
+	for (uint32 i = 0; i < exchange->num_partitions; i++)
+	{
+		while (exchange->incoming[i] != NULL)
+		{
+			Size nbytes;
+			void *data;
+			shm_mq_result result =
+				shm_mq_receive(exchange->incoming[i], &nbytes, &data, /* nowait = */ true);
+			if (result == SHM_MQ_WOULD_BLOCK)
+			{
+				break;
+			}
+
+			if (result == SHM_MQ_DETACHED)
+			{
+				/* The sender has finished, and we have received all its rows. */
+				shm_mq_detach(exchange->incoming[i]);
+				exchange->incoming[i] = NULL;
+				exchange->num_incoming--;
+				break;
+			}
+
+			ExecStoreMinimalTuple((MinimalTuple) data,
+								  exchange->received_slot,
+								  /* shouldFree = */ false);
+			tuplesort_puttupleslot(exchange->tuplesortstate, exchange->received_slot);
+			received = true;
+		}
+	}
+
+	return received;
+}
+
+static void
+row_exchange_send(RowExchange *exchange, uint32 partition, MinimalTuple tuple)
+{
+	for (;;)
+	{
+		shm_mq_result result = shm_mq_send(exchange->outgoing[partition],
+										   tuple->t_len,
+										   tuple,
+										   /* nowait = */ true,
+										   /* force_flush = */ false);
+		if (result == SHM_MQ_SUCCESS)
+		{
+			return;
+		}
+
+		if (result == SHM_MQ_DETACHED)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("could not send the row to the parallel worker")));
+		}
+
+		/*
+		 * The queue is full. The receiver might be waiting for us to read our
+		 * own queues, so we do that before waiting. We have to retry the send
+		 * with the same arguments afterwards.
+		 */
+		if (!row_exchange_receive(exchange))
+		{
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 0,
+							 WAIT_EVENT_MESSAGE_QUEUE_SEND);
+			ResetLatch(MyLatch);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Tell the other workers that we have sent all the rows, and receive the rest
+ * of their rows.
+ */
+static void
+row_exchange_finish(RowExchange *exchange)
+{
+	for (uint32 i = 0; i < exchange->num_partitions; i++)
+	{
+		if (exchange->outgoing[i] != NULL)
+		{
+			/* This also flushes the rows that we haven't flushed yet. */
+			shm_mq_detach(exchange->outgoing[i]);
+			exchange->outgoing[i] = NULL;
+		}
+	}
+
+	while (exchange->num_incoming > 0)
+	{
+		if (!row_exchange_receive(exchange))
+		{
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 0,
+							 WAIT_EVENT_MESSAGE_QUEUE_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	ExecDropSingleTupleTableSlot(exchange->received_slot);
+}
+
+/*
+ * Scan our share of the uncompressed chunk, and sort the rows of our
+ * partition, in the order required for compression. The rows of the other
+ * partitions are sent to their workers, and we receive the rows of our
+ * partition from them.
+ */
+static Tuplesortstate *
+sort_partition(Relation in_rel, SegmentbyHasher *hasher, ParallelTableScanDesc pscan,
+			   RowExchange *exchange)
+{
+	TableScanDesc scan = table_beginscan_parallel(in_rel, pscan);
+	TupleTableSlot *slot = table_slot_create(in_rel, NULL);
+	uint64 nrows = 0;
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		uint32 partition = segmentby_hasher_get_partition(hasher, slot, exchange->num_partitions);
+		if (partition == exchange->partition)
+		{
+			tuplesort_puttupleslot(exchange->tuplesortstate, slot);
+		}
+		else
+		{
+			bool should_free;
+			MinimalTuple tuple = ExecFetchSlotMinimalTuple(slot, &should_free);
+			row_exchange_send(exchange, partition, tuple);
+			if (should_free)
+			{
+				pfree(tuple);
+			}
+		}
+
+		/* Don't let the other workers wait until our queues are full. */
+		if (++nrows % PARALLEL_COMPRESS_RECEIVE_INTERVAL == 0)
+		{
+			row_exchange_receive(exchange);
+			CHECK_FOR_INTERRUPTS();
+		}
+	}
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+
+	row_exchange_finish(exchange);
+
+	tuplesort_performsort(exchange->tuplesortstate);
+
+	return exchange->tuplesortstate;
+}
+
+static uint32
+wait_for_partitions(ParallelCompressShared *shared)
+{
+	uint32 num_partitions;
+
+	ConditionVariablePrepareToSleep(&shared->partitions_set);
+	for (;;)
+	{
+		SpinLockAcquire(&shared->mutex);
+		num_partitions = shared->num_partitions;
+		SpinLockRelease(&shared->mutex);
+
+		if (num_partitions > 0)
+		{
+			break;
+		}
+
+		ConditionVariableSleep(&shared->partitions_set, PG_WAIT_EXTENSION);
+	}
+	ConditionVariableCancelSleep();
+
+	return num_partitions;
+}
+
+static void
+parallel_compress_send_tuple(RowCompressor *row_compressor, HeapTuple tuple)
+{
+	ParallelCompressWorker *worker = (ParallelCompressWorker *) row_compressor;
+
+	shm_mq_result result = shm_mq_send(worker->queue,
+									   tuple->t_len,
+									   tuple->t_data,
+									   /* nowait = */ false,
+									   /* force_flush = */ false);
+	if (result != SHM_MQ_SUCCESS)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not send the compressed tuple to the parallel leader")));
+	}
+}
+
+void
+ts_compress_chunk_parallel_worker_main(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCompressShared *shared = shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_SHARED, false);
+	char *queue_space = shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_QUEUES, false);
+
+	shm_mq *mq = (shm_mq *) (queue_space + ParallelWorkerNumber * PARALLEL_COMPRESS_QUEUE_SIZE);
+	shm_mq_set_sender(mq, MyProc);
+
+	ParallelCompressWorker worker = { .queue = shm_mq_attach(mq, seg, NULL) };
+
+	/* The leader holds the stronger locks, these don't conflict in the lock group. */
+	Relation in_rel = table_open(shared->in_relid, AccessShareLock);
+	Relation out_rel = table_open(shared->out_relid, AccessShareLock);
+	CompressionSettings *settings =
+		ts_compression_settings_get_by_compress_relid(shared->out_relid);
+
+	row_compressor_init(settings,
+						&worker.row_compressor,
+						in_rel,
+						out_rel,
+						RelationGetDescr(out_rel)->natts,
+						/* need_bistate = */ false,
+						/* insert_options = */ 0);
+	worker.row_compressor.insert_compressed_tuple = parallel_compress_send_tuple;
+
+	SegmentbyHasher *hasher = segmentby_hasher_create(settings, in_rel);
+
+	RowExchange exchange;
+	row_exchange_init(&exchange,
+					  seg,
+					  shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_ROW_QUEUES, false),
+					  shared->nworkers,
+					  wait_for_partitions(shared),
+					  compression_create_tuplesort_state(settings, in_rel),
+					  RelationGetDescr(in_rel));
+
+	Tuplesortstate *sorted_rel =
+		sort_partition(in_rel,
+					   hasher,
+					   shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_SCAN, false),
+					   &exchange);
+	row_compressor_append_sorted_rows(&worker.row_compressor,
+									  sorted_rel,
+									  RelationGetDescr(in_rel),
+									  in_rel);
+	tuplesort_end(sorted_rel);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->rowcnt_pre_compression += worker.row_compressor.rowcnt_pre_compression;
+	shared->num_compressed_rows += worker.row_compressor.num_compressed_rows;
+	SpinLockRelease(&shared->mutex);
+
+	row_compressor_close(&worker.row_compressor);
+	table_close(out_rel, AccessShareLock);
+	table_close(in_rel, AccessShareLock);
+
+	shm_mq_detach(worker.queue);
+}
+
+static bool
+parallel_compression_possible(CompressionSettings *settings, Relation in_rel)
+{
+	if (ts_guc_compress_parallel_workers <= 0 || IsInParallelMode())
+	{
+		return false;
+	}
+
+	/* The scan in the workers doesn't know about the compressed part of Hypercore. */
+	if (REL_IS_HYPERCORE(in_rel))
+	{
+		return false;
+	}
+
+	/* We partition the rows by the segmentby values. */
+	if (ts_array_length(settings->fd.segmentby) == 0 ||
+		!segmentby_columns_hashable(settings, in_rel))
+	{
+		return false;
+	}
+
+	/* Not worth it for the small chunks. */
+	return RelationGetNumberOfBlocks(in_rel) >= (BlockNumber) min_parallel_table_scan_size;
+}
+
+/*
+ * Receive the compressed tuples from the workers until all of them have
+ * finished.
+ */
+static void
+receive_compressed_tuples(ParallelContext *pcxt, shm_mq_handle **queues,
+						  Tuplestorestate *compressed_tuples)
+{
+	const int num_queues = pcxt->nworkers_launched;
+	bool *finished = palloc0(sizeof(bool) * num_queues);
+	int num_active = num_queues;
+
+	while (num_active > 0)
+	{
+		bool received = false;
+		for (int i = 0; i < num_queues; i++)
+		{
+			if (finished[i])
+			{
+				continue;
+			}
+
+			Size nbytes;
+			void *data;
+			shm_mq_result result = shm_mq_receive(queues[i], &nbytes, &data, /* nowait = */ true);
+			if (result == SHM_MQ_WOULD_BLOCK)
+			{
+				continue;
+			}
+
+			if (result == SHM_MQ_DETACHED)
+			{
+				finished[i] = true;
+				num_active--;
+				continue;
+			}
+
+			HeapTupleData tuple = {
+				.t_len = nbytes,
+				.t_tableOid = InvalidOid,
+				.t_data = (HeapTupleHeader) data,
+			};
+			ItemPointerSetInvalid(&tuple.t_self);
+			tuplestore_puttuple(compressed_tuples, &tuple);
+			received = true;
+		}
+
+		if (!received && num_active > 0)
+		{
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 0,
+							 WAIT_EVENT_MESSAGE_QUEUE_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+
+		/* This also rethrows the errors from the workers. */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(finished);
+}
+
+/*
+ * Compress the chunk using the parallel workers, and insert the compressed
+ * tuples using the given row compressor. Returns false if the parallel
+ * compression is not possible, and the caller has to compress the chunk
+ * serially. If it is possible but no workers can be launched, the chunk is
+ * compressed serially here, so that the choice doesn't depend on the number of
+ * available workers.
+ */
+bool
+compress_chunk_parallel(CompressionSettings *settings, Relation in_rel,
+						RowCompressor *row_compressor)
+{
+	const int nworkers = ts_guc_compress_parallel_workers;
+
+	if (!parallel_compression_possible(settings, in_rel))
+	{
+		return false;
+	}
+
+	elog(ts_guc_debug_compression_path_info ? INFO : DEBUG1,
+		 "using %d parallel workers to convert rows to columnstore from \"%s\"",
+		 nworkers,
+		 RelationGetRelationName(in_rel));
+
+	/* We can't assign the transaction id in the parallel mode. */
+	(void) GetCurrentTransactionId();
+
+	EnterParallelMode();
+
+	/* The workers must see the same rows that the serial compression would. */
+	PushActiveSnapshot(GetLatestSnapshot());
+
+	ParallelContext *pcxt =
+		CreateParallelContext(EXTENSION_TSL_SO, "ts_compress_chunk_parallel_worker_main", nworkers);
+
+	const Size row_queues_size =
+		mul_size(PARALLEL_COMPRESS_ROW_QUEUE_SIZE, mul_size(nworkers, nworkers));
+	const Size pscan_size = table_parallelscan_estimate(in_rel, GetActiveSnapshot());
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCompressShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, mul_size(PARALLEL_COMPRESS_QUEUE_SIZE, nworkers));
+	shm_toc_estimate_chunk(&pcxt->estimator, row_queues_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, pscan_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 4);
+
+	InitializeParallelDSM(pcxt);
+
+	ParallelCompressShared *shared = shm_toc_allocate(pcxt->toc, sizeof(ParallelCompressShared));
+	*shared = (ParallelCompressShared){
+		.in_relid = RelationGetRelid(in_rel),
+		.out_relid = RelationGetRelid(row_compressor->compressed_table),
+		.nworkers = nworkers,
+		.num_partitions = 0,
+	};
+	ConditionVariableInit(&shared->partitions_set);
+	SpinLockInit(&shared->mutex);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_SHARED, shared);
+
+	char *queue_space =
+		shm_toc_allocate(pcxt->toc, mul_size(PARALLEL_COMPRESS_QUEUE_SIZE, nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_QUEUES, queue_space);
+
+	shm_mq_handle **queues = palloc(sizeof(shm_mq_handle *) * nworkers);
+	for (int i = 0; i < nworkers; i++)
+	{
+		shm_mq *mq = shm_mq_create(queue_space + i * PARALLEL_COMPRESS_QUEUE_SIZE,
+								   PARALLEL_COMPRESS_QUEUE_SIZE);
+		shm_mq_set_receiver(mq, MyProc);
+		queues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+
+	/* The workers attach to the row queues themselves. */
+	char *row_queue_space = shm_toc_allocate(pcxt->toc, row_queues_size);
+	for (int i = 0; i < nworkers * nworkers; i++)
+	{
+		(void) shm_mq_create(row_queue_space + i * PARALLEL_COMPRESS_ROW_QUEUE_SIZE,
+							 PARALLEL_COMPRESS_ROW_QUEUE_SIZE);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_ROW_QUEUES, row_queue_space);
+
+	ParallelTableScanDesc pscan = shm_toc_allocate(pcxt->toc, pscan_size);
+	table_parallelscan_initialize(in_rel, pscan, GetActiveSnapshot());
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_SCAN, pscan);
+
+	LaunchParallelWorkers(pcxt);
+
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		PopActiveSnapshot();
+		ExitParallelMode();
+
+		elog(DEBUG1,
+			 "no parallel workers available to convert rows to columnstore from \"%s\"",
+			 RelationGetRelationName(in_rel));
+
+		Tuplesortstate *sorted_rel = compress_chunk_sort_relation(settings, in_rel);
+		row_compressor_append_sorted_rows(row_compressor,
+										  sorted_rel,
+										  RelationGetDescr(in_rel),
+										  in_rel);
+		tuplesort_end(sorted_rel);
+		return true;
+	}
+
+	/*
+	 * The workers exchange the rows with each other, so all of them have to be
+	 * running before we let them start. This throws an error if some of them
+	 * failed to start.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->num_partitions = pcxt->nworkers_launched;
+	SpinLockRelease(&shared->mutex);
+	ConditionVariableBroadcast(&shared->partitions_set);
+
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+	{
+		shm_mq_set_handle(queues[i], pcxt->worker[i].bgwhandle);
+	}
+
+	Tuplestorestate *compressed_tuples = tuplestore_begin_heap(false, false, work_mem);
+	receive_compressed_tuples(pcxt, queues, compressed_tuples);
+
+	WaitForParallelWorkersToFinish(pcxt);
+
+	const int64 rowcnt_pre_compression = shared->rowcnt_pre_compression;
+	const int64 num_compressed_rows = shared->num_compressed_rows;
+
+	DestroyParallelContext(pcxt);
+	PopActiveSnapshot();
+	ExitParallelMode();
+
+	/* Now we can insert the compressed tuples. */
+	CommandId mycid = GetCurrentCommandId(true);
+	int64 num_inserted = 0;
+	TupleTableSlot *slot =
+		MakeSingleTupleTableSlot(RelationGetDescr(row_compressor->compressed_table),
+								 &TTSOpsMinimalTuple);
+	while (tuplestore_gettupleslot(compressed_tuples, true, false, slot))
+	{
+		bool should_free;
+		HeapTuple tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+		row_compressor_insert_compressed_tuple(row_compressor, tuple, mycid);
+		num_inserted++;
+		if (should_free)
+		{
+			heap_freetuple(tuple);
+		}
+	}
+	ExecDropSingleTupleTableSlot(slot);
+	tuplestore_end(compressed_tuples);
+
+	Ensure(num_inserted == num_compressed_rows,
+		   "unexpected number of compressed tuples received from the parallel workers");
+
+	row_compressor->rowcnt_pre_compression += rowcnt_pre_compression;
+	row_compressor->num_compressed_rows += num_compressed_rows;
+
+	return true;
+}
@@ -6,6 +6,7 @@
 
 #include <postgres.h>
 #include <catalog/pg_am.h>
+#include <nodes/makefuncs.h>
 #include <parser/parse_coerce.h>
 #include <parser/parse_relation.h>
 #include <utils/typcache.h>
@@ -471,6 +472,26 @@ build_update_delete_scankeys(Relation in_rel, List *heap_filters, int *num_scank
 												   filter->value ? filter->value->constvalue : 0,
 												   filter->is_null_check,
 												   filter->is_array_op);
+
+		/*
+		 * The filters without a strategy use the function directly, and it
+		 * might be polymorphic, like the one that checks the bloom filter
+		 * sparse index. Provide the call expression so that it can determine
+		 * the argument types.
+		 */
+		if (added && filter->strategy == InvalidStrategy && filter->value != NULL)
+		{
+			ScanKey key = &scankeys[key_index - 1];
+			FuncExpr *call = makeFuncExpr(filter->opcode,
+										  BOOLOID,
+										  list_make2(makeNullConst(typoid, -1, InvalidOid),
+													 copyObject(filter->value)),
+										  InvalidOid,
+										  filter->collation,
+										  COERCE_EXPLICIT_CALL);
+			fmgr_info_set_expr((Node *) call, &key->sk_func);
+		}
+
 		/*
 		 * When we plan to DELETE directly on compressed chunks we
 		 * need to ensure all query constraints could be applied
@@ -39,6 +39,7 @@
 #include "chunk.h"
 #include "chunk_index.h"
 #include "compression.h"
+#include "compression/batch_metadata_builder_bloom1.h"
 #include "compression/compression_storage.h"
 #include "create.h"
 #include "custom_type_cache.h"
@@ -52,7 +53,7 @@
 #include "utils.h"
 #include "with_clause/alter_table_with_clause.h"
 
-static const char *sparse_index_types[] = { "min", "max" };
+static const char *sparse_index_types[] = { "min", "max", BLOOM1_SPARSE_INDEX_TYPE };
 
 #ifdef USE_ASSERT_CHECKING
 static bool
@@ -182,11 +183,13 @@ build_columndefs(CompressionSettings *settings, Oid src_relid)
 	Relation rel = table_open(src_relid, AccessShareLock);
 
 	Bitmapset *btree_columns = NULL;
+	Bitmapset *hash_columns = NULL;
 	if (ts_guc_auto_sparse_indexes)
 	{
 		/*
 		 * Check which columns have btree indexes. We will create sparse minmax
-		 * indexes for them in compressed chunk.
+		 * indexes for them in compressed chunk. For the columns that have hash
+		 * indexes, we will create the bloom filter sparse indexes.
 		 */
 		ListCell *lc;
 		List *index_oids = RelationGetIndexList(rel);
@@ -206,8 +209,20 @@ build_columndefs(CompressionSettings *settings, Oid src_relid)
 			 * to 'BRIN' with range opclass, but not for bloom filter opclass. For GIN,
 			 * sparse minmax is useless because it doesn't help satisfy text search
 			 * queries, and so on. Currently we check only the simplest btree case.
+			 *
+			 * The hash index can satisfy only the equality tests, same as the
+			 * bloom filter sparse index.
 			 */
-			if (index_info->ii_Am != BTREE_AM_OID)
+			Bitmapset **columns = NULL;
+			if (index_info->ii_Am == BTREE_AM_OID)
+			{
+				columns = &btree_columns;
+			}
+			else if (index_info->ii_Am == HASH_AM_OID && ts_guc_enable_sparse_index_bloom)
+			{
+				columns = &hash_columns;
+			}
+			else
 			{
 				continue;
 			}
@@ -217,7 +232,7 @@ build_columndefs(CompressionSettings *settings, Oid src_relid)
 				AttrNumber attno = index_info->ii_IndexAttrNumbers[i];
 				if (attno != InvalidAttrNumber)
 				{
-					btree_columns = bms_add_member(btree_columns, attno);
+					*columns = bms_add_member(*columns, attno);
 				}
 			}
 		}
@@ -316,6 +331,24 @@ build_columndefs(CompressionSettings *settings, Oid src_relid)
 				compressed_column_defs = lappend(compressed_column_defs, def);
 			}
 		}
+		else if (bms_is_member(attr->attnum, hash_columns) &&
+				 bloom1_column_supported(attr->atttypid, attr->attcollation))
+		{
+			/*
+			 * The bloom filter sparse index for the columns that have hash
+			 * indexes. It is useful for the point lookups on high-cardinality
+			 * columns, for which the minmax sparse index doesn't help. We don't
+			 * need it if we already have the minmax sparse index.
+			 */
+			ColumnDef *def =
+				makeColumnDef(compressed_column_metadata_name_v2(BLOOM1_SPARSE_INDEX_TYPE,
+																 NameStr(attr->attname)),
+							  BYTEAOID,
+							  /* typmod = */ -1,
+							  /* collOid = */ InvalidOid);
+			def->storage = TYPSTORAGE_MAIN;
+			compressed_column_defs = lappend(compressed_column_defs, def);
+		}
 
 		compressed_column_defs = lappend(compressed_column_defs,
 										 makeColumnDef(NameStr(attr->attname),
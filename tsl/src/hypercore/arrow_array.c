@@ -21,15 +21,15 @@ typedef struct ArrowPrivate
 {
 	MemoryContext mcxt; /* The memory context on which the private data is allocated */
 	size_t value_capacity;
-	struct varlena *value; /* For text types, a reusable memory area to create
-							* the varlena version of the c-string */
+	struct varlena *value; /* For varlena types, a reusable memory area to
+							* create the varlena from the Arrow body */
 	bool typbyval;		   /* Cached typbyval for the type in the arrow array. This
 							* avoids having to do get_typbyval() syscache lookups on
 							* hot paths. */
 } ArrowPrivate;
 
 static Datum
-arrow_private_cstring_to_text_datum(ArrowPrivate *ap, const uint8 *data, size_t datalen)
+arrow_private_body_to_varlena_datum(ArrowPrivate *ap, const uint8 *data, size_t datalen)
 {
 	const size_t varlen = VARHDRSZ + datalen;
 
@@ -196,11 +196,11 @@ arrow_from_iterator_varlen(MemoryContext mcxt, DecompressionIterator *iterator,
 			++null_count;
 		else
 		{
-			/* We store all the varlen data here, including header, so we are
-			 * not strictly following the arrow format. */
-			const int varlen = VARSIZE_ANY(result.val);
+			/* We store the varlen data without the header, following the
+			 * Arrow binary layout, same as the bulk decompression. */
+			const int varlen = VARSIZE_ANY_EXHDR(result.val);
 			EXTEND_BUFFER_IF_NEEDED(data_buffer, endpos + varlen, data_capacity);
-			memcpy(&data_buffer[endpos], DatumGetPointer(result.val), varlen);
+			memcpy(&data_buffer[endpos], VARDATA_ANY(result.val), varlen);
 			endpos += varlen;
 		}
 
@@ -438,19 +438,12 @@ arrow_get_datum_varlen(const ArrowArray *array, Oid typid, uint16 index)
 
 	const int32 offset = offsets[index];
 
-	/* Need to handle text as a special case because the cstrings are stored
-	 * back-to-back without varlena header */
-	if (typid == TEXTOID)
-	{
-		ArrowPrivate *ap = arrow_private_get(array);
-		const int32 datalen = offsets[index + 1] - offset;
-		value = arrow_private_cstring_to_text_datum(ap, &data[offset], datalen);
-	}
-	else
-		value = PointerGetDatum(&data[offset]);
+	/* The values are stored back-to-back without varlena header, so we have
+	 * to add it. */
+	ArrowPrivate *ap = arrow_private_get(array);
+	const int32 datalen = offsets[index + 1] - offset;
+	value = arrow_private_body_to_varlena_datum(ap, &data[offset], datalen);
 
-	/* We have stored the bytes of the varlen value directly in the buffer, so
-	 * this should work as expected. */
 	TS_DEBUG_LOG("retrieved varlen value '%s' row %u"
 				 " from offset %d dictionary=%p in memory context %s",
 				 datum_as_string(typid, value, false),
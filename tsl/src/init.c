@@ -12,6 +12,7 @@
 #include "bgw_policy/job.h"
 #include "bgw_policy/job_api.h"
 #include "bgw_policy/policies_v2.h"
+#include "bgw_policy/precreate_api.h"
 #include "bgw_policy/reorder_api.h"
 #include "bgw_policy/retention_api.h"
 #include "chunk.h"
@@ -22,6 +23,7 @@
 #include "compression/algorithms/dictionary.h"
 #include "compression/algorithms/gorilla.h"
 #include "compression/api.h"
+#include "compression/batch_metadata_builder_bloom1.h"
 #include "compression/compression.h"
 #include "compression/create.h"
 #include "compression/recompress.h"
@@ -47,6 +49,7 @@
 #include "nodes/gapfill/gapfill_functions.h"
 #include "nodes/skip_scan/skip_scan.h"
 #include "nodes/vector_agg/plan.h"
+#include "nodes/vector_sort/vector_sort.h"
 #include "partialize_finalize.h"
 #include "planner.h"
 #include "process_utility.h"
@@ -100,6 +103,10 @@ CrossModuleFunctions tsl_cm_functions = {
 	.policy_reorder_proc = policy_reorder_proc,
 	.policy_reorder_check = policy_reorder_check,
 	.policy_reorder_remove = policy_reorder_remove,
+	.policy_precreate_chunks_add = policy_precreate_chunks_add,
+	.policy_precreate_chunks_proc = policy_precreate_chunks_proc,
+	.policy_precreate_chunks_check = policy_precreate_chunks_check,
+	.policy_precreate_chunks_remove = policy_precreate_chunks_remove,
 	.policy_retention_add = policy_retention_add,
 	.policy_retention_proc = policy_retention_proc,
 	.policy_retention_check = policy_retention_check,
@@ -160,6 +167,8 @@ CrossModuleFunctions tsl_cm_functions = {
 	.compressed_data_out = tsl_compressed_data_out,
 	.compressed_data_info = tsl_compressed_data_info,
 	.compressed_data_has_nulls = tsl_compressed_data_has_nulls,
+	.bloom1_contains = tsl_bloom1_contains,
+	.bloom1_contains_any = tsl_bloom1_contains_any,
 	.deltadelta_compressor_append = tsl_deltadelta_compressor_append,
 	.deltadelta_compressor_finish = tsl_deltadelta_compressor_finish,
 	.gorilla_compressor_append = tsl_gorilla_compressor_append,
@@ -176,6 +185,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	.compress_chunk = tsl_compress_chunk,
 	.decompress_chunk = tsl_decompress_chunk,
 	.decompress_batches_for_insert = decompress_batches_for_insert,
+	.compress_batches_for_insert = compress_batches_for_insert,
 	.decompress_target_segments = decompress_target_segments,
 	.hypercore_handler = hypercore_handler,
 	.hypercore_proxy_handler = hypercore_proxy_handler,
@@ -221,6 +231,7 @@ ts_module_init(PG_FUNCTION_ARGS)
 	_attr_capture_init();
 	_skip_scan_init();
 	_vector_agg_init();
+	_vector_sort_init();
 
 	/* Register a cleanup function to be called when the backend exits */
 	if (register_proc_exit)
@@ -37,6 +37,7 @@
 #include "hypercore/hypercore_handler.h"
 #include "hypercore/vector_quals.h"
 #include "import/ts_explain.h"
+#include "nodes/decompress_chunk/vector_expression.h"
 
 typedef struct SimpleProjInfo
 {
@@ -785,6 +786,7 @@ columnar_scan_begin(CustomScanState *state, EState *estate, int eflags)
 	vector_qual_state_init(&cstate->vqstate,
 						   vectorized_quals_constified,
 						   state->ss.ss_ScanTupleSlot);
+	cstate->vqstate.expression_states = vector_expression_init_states(vectorized_quals_constified);
 
 	/* If the node is supposed to project, then try to make it a simple
 	 * projection. If not possible, it will fall back to standard PostgreSQL
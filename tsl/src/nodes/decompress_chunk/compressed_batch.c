@@ -6,10 +6,13 @@
 
 #include <postgres.h>
 
+#include <access/tupmacs.h>
 #include <executor/tuptable.h>
 #include <nodes/bitmapset.h>
+#include <nodes/nodeFuncs.h>
 #include <utils/builtins.h>
 #include <utils/date.h>
+#include <utils/lsyscache.h>
 #include <utils/timestamp.h>
 
 #include "compression/arrow_c_data_interface.h"
@@ -18,12 +21,14 @@
 #include "guc.h"
 #include "nodes/decompress_chunk/compressed_batch.h"
 #include "nodes/decompress_chunk/vector_dict.h"
+#include "nodes/decompress_chunk/vector_expression.h"
 #include "nodes/decompress_chunk/vector_predicates.h"
 #include "nodes/decompress_chunk/vector_quals.h"
 
 /*
- * Create a single-value ArrowArray of an arithmetic type. This is a specialized
- * function because arithmetic types have a particular layout of ArrowArrays.
+ * Create a single-value ArrowArray of an arithmetic or another fixed-width
+ * type. This is a specialized function because these types have a particular
+ * layout of ArrowArrays.
  */
 static ArrowArray *
 make_single_value_arrow_arithmetic(Oid arithmetic_type, Datum datum, bool isnull)
@@ -73,17 +78,41 @@ make_single_value_arrow_arithmetic(Oid arithmetic_type, Datum datum, bool isnull
 		FOR_TYPE(TIMESTAMPTZOID, TimestampTz, DatumGetTimestampTz);
 		FOR_TYPE(TIMESTAMPOID, Timestamp, DatumGetTimestamp);
 		FOR_TYPE(DATEOID, DateADT, DatumGetDateADT);
+		case BOOLOID:
+			/* The bool columns have a dedicated storage format. */
+			arrow_set_row_validity((uint64 *) arrow->buffers[1], 0, DatumGetBool(datum));
+			break;
 		default:
-			elog(ERROR, "unexpected column type '%s'", format_type_be(arithmetic_type));
-			pg_unreachable();
+		{
+			/*
+			 * Other fixed-width types that are supported by the bulk
+			 * decompression of array and dictionary.
+			 */
+			int16 typlen;
+			bool typbyval;
+			get_typlenbyval(arithmetic_type, &typlen, &typbyval);
+			Ensure(typlen > 0, "unexpected column type '%s'", format_type_be(arithmetic_type));
+			if (typbyval)
+			{
+				store_att_byval(with_buffers->values_buffer, datum, typlen);
+			}
+			else
+			{
+				void *values = palloc0(pad_to_multiple(64, typlen));
+				memcpy(values, DatumGetPointer(datum), typlen);
+				arrow->buffers[1] = values;
+			}
+			break;
+		}
 	}
 
 	return arrow;
 }
 
 /*
- * Create a single-value ArrowArray of text. This is a specialized function
- * because the text ArrowArray has a specialized layout.
+ * Create a single-value ArrowArray of text or another varlena type. This is a
+ * specialized function because these ArrowArrays have the binary layout with
+ * offsets and bodies.
  */
 static ArrowArray *
 make_single_value_arrow_text(Datum datum, bool isnull)
@@ -133,7 +162,7 @@ make_single_value_arrow_text(Datum datum, bool isnull)
 ArrowArray *
 make_single_value_arrow(Oid pgtype, Datum datum, bool isnull)
 {
-	if (pgtype == TEXTOID)
+	if (get_typlen(pgtype) == -1)
 	{
 		return make_single_value_arrow_text(datum, isnull);
 	}
@@ -276,10 +305,10 @@ decompress_column(DecompressContext *dcontext, DecompressBatchState *batch_state
 	else
 	{
 		/*
-		 * Text column. Pre-allocate memory for its text Datum in the
-		 * decompressed scan slot. We can't put direct references to Arrow
+		 * Text or other varlena column. Pre-allocate memory for its Datum in
+		 * the decompressed scan slot. We can't put direct references to Arrow
 		 * memory there, because it doesn't have the varlena headers that
-		 * Postgres expects for text.
+		 * Postgres expects.
 		 */
 		const int maxbytes =
 			VARHDRSZ + (arrow->dictionary ? get_max_text_datum_size(arrow->dictionary) :
@@ -419,6 +448,71 @@ compressed_batch_get_arrow_array(VectorQualState *vqstate, Expr *expr, bool *is_
 	return vector;
 }
 
+/*
+ * AND the validity bitmap of the vector to the predicate result. Note that the
+ * vector here might have only one row, in contrast with the number of rows in
+ * the batch, if the column has a default value in this batch.
+ */
+static void
+and_validity_bitmap(const ArrowArray *vector, uint64 *restrict predicate_result)
+{
+	const size_t n_vector_result_words = (vector->length + 63) / 64;
+	const uint64 *validity = (const uint64 *) vector->buffers[0];
+	if (validity)
+	{
+		for (size_t i = 0; i < n_vector_result_words; i++)
+		{
+			predicate_result[i] &= validity[i];
+		}
+	}
+	else
+	{
+		Assert(vector->null_count == 0);
+	}
+}
+
+/*
+ * Expand a single-value ArrowArray of a fixed-width type, that we build for
+ * the default values, to the given number of rows. This is used when it is
+ * compared with another column that has the values for every row.
+ */
+static const ArrowArray *
+expand_single_value_arrow(VectorQualState *vqstate, const ArrowArray *single, int16 value_bytes,
+						  int64 nrows)
+{
+	Assert(single->length == 1);
+	Ensure(value_bytes > 0, "unexpected value size %d in vectorized comparison", value_bytes);
+
+	const size_t n_words = (nrows + 63) / 64;
+	struct ArrowWithBuffers
+	{
+		ArrowArray arrow;
+		const void *buffers[2];
+	};
+	struct ArrowWithBuffers *with_buffers =
+		MemoryContextAllocZero(vqstate->per_vector_mcxt, sizeof(struct ArrowWithBuffers));
+	uint64 *validity = MemoryContextAlloc(vqstate->per_vector_mcxt, sizeof(uint64) * n_words);
+	/* The value buffer has 64-byte padding as required by Arrow. */
+	char *values =
+		MemoryContextAlloc(vqstate->per_vector_mcxt, pad_to_multiple(64, value_bytes * nrows));
+
+	const bool isnull = single->buffers[0] != NULL && !arrow_row_is_valid(single->buffers[0], 0);
+	memset(validity, isnull ? 0 : 0xFF, sizeof(uint64) * n_words);
+	for (int64 row = 0; row < nrows; row++)
+	{
+		memcpy(&values[row * value_bytes], single->buffers[1], value_bytes);
+	}
+
+	ArrowArray *arrow = &with_buffers->arrow;
+	arrow->length = nrows;
+	arrow->null_count = isnull ? nrows : 0;
+	arrow->n_buffers = 2;
+	arrow->buffers = with_buffers->buffers;
+	arrow->buffers[0] = validity;
+	arrow->buffers[1] = values;
+	return arrow;
+}
+
 static void
 compute_plain_qual(VectorQualState *vqstate, TupleTableSlot *slot, Node *qual,
 				   uint64 *restrict result)
@@ -454,9 +548,10 @@ compute_plain_qual(VectorQualState *vqstate, TupleTableSlot *slot, Node *qual,
 	}
 
 	/*
-	 * For now, we support NullTest, "Var ? Const" predicates,
-	 * boolean Variables, the negation of boolean variables
-	 * and ScalarArrayOperations.
+	 * For now, we support NullTest, "Var ? Const" predicates, "Var ? Var"
+	 * predicates for arithmetic types, boolean Variables, the negation of
+	 * boolean variables and ScalarArrayOperations. Instead of Var, the predicates can also
+	 * use some simple expressions over it, see vector_expression.c.
 	 */
 	List *args = NULL;
 	RegProcedure vector_const_opcode = InvalidOid;
@@ -516,13 +611,43 @@ compute_plain_qual(VectorQualState *vqstate, TupleTableSlot *slot, Node *qual,
 	}
 
 	/*
-	 * Find the compressed column referred to by the Var.
+	 * Find the compressed column referred to by the Var, and compute the
+	 * expression over it if needed. The rows that didn't pass the preceding
+	 * quals are not used for the expression errors.
 	 */
 	Expr *expr = linitial(args);
 	uint64 default_value_predicate_result[1];
 	uint64 *predicate_result = result;
 	bool default_value = false;
-	const ArrowArray *vector = vqstate->get_arrow_array(vqstate, expr, &default_value);
+	const ArrowArray *vector = vector_expression_compute(vqstate, expr, result, &default_value);
+
+	/*
+	 * For the comparison of two columns, compute the right side as well. If
+	 * only one of them has a default value, expand it to the full batch, so
+	 * that the predicate is computed for every row.
+	 */
+	const ArrowArray *right_vector = NULL;
+	if (opexpr && !IsA(lsecond(args), Const))
+	{
+		Expr *right_expr = lsecond(args);
+		bool right_default_value = false;
+		right_vector = vector_expression_compute(vqstate, right_expr, result, &right_default_value);
+		if (default_value && !right_default_value)
+		{
+			vector = expand_single_value_arrow(vqstate,
+											   vector,
+											   get_typlen(exprType((Node *) expr)),
+											   right_vector->length);
+			default_value = false;
+		}
+		else if (!default_value && right_default_value)
+		{
+			right_vector = expand_single_value_arrow(vqstate,
+													 right_vector,
+													 get_typlen(exprType((Node *) right_expr)),
+													 vector->length);
+		}
+	}
 
 	if (default_value)
 	{
@@ -546,6 +671,23 @@ compute_plain_qual(VectorQualState *vqstate, TupleTableSlot *slot, Node *qual,
 	{
 		vector_booleantest(vector, booltest->booltesttype, predicate_result);
 	}
+	else if (right_vector)
+	{
+		VectorVectorPredicate *vector_vector_predicate =
+			get_vector_vector_predicate(vector_const_opcode);
+		Assert(vector_vector_predicate != NULL);
+
+		Ensure(vector->dictionary == NULL && right_vector->dictionary == NULL,
+			   "unexpected dictionary-encoded column in vectorized comparison");
+		Ensure(vector->length == right_vector->length,
+			   "mismatched lengths of columns in vectorized comparison");
+
+		vector_vector_predicate(vector, right_vector, predicate_result);
+
+		/* Account for nulls on both sides, which shouldn't pass the predicate. */
+		and_validity_bitmap(vector, predicate_result);
+		and_validity_bitmap(right_vector, predicate_result);
+	}
 	else
 	{
 		/*
@@ -611,25 +753,11 @@ compute_plain_qual(VectorQualState *vqstate, TupleTableSlot *slot, Node *qual,
 		}
 
 		/*
-		 * Account for nulls which shouldn't pass the predicate. Note that the
-		 * vector here might have only one row, in contrast with the number of
-		 * rows in the batch, if the column has a default value in this batch.
+		 * Account for nulls which shouldn't pass the predicate.
 		 */
-		const size_t n_vector_result_words = (vector->length + 63) / 64;
 		Assert((predicate_result != default_value_predicate_result) ||
-			   n_vector_result_words == 1); /* to placate Coverity. */
-		const uint64 *validity = (const uint64 *) vector->buffers[0];
-		if (validity)
-		{
-			for (size_t i = 0; i < n_vector_result_words; i++)
-			{
-				predicate_result[i] &= validity[i];
-			}
-		}
-		else
-		{
-			Assert(vector->null_count == 0);
-		}
+			   vector->length == 1); /* to placate Coverity. */
+		and_validity_bitmap(vector, predicate_result);
 	}
 
 	/* Translate the result if the column had a default value. */
@@ -1004,6 +1132,7 @@ compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
 	CompressedBatchVectorQualState cbvqstate = {
 		.vqstate = {
 			.vectorized_quals_constified = dcontext->vectorized_quals_constified,
+			.expression_states = dcontext->vector_expression_states,
 			.num_results = batch_state->total_batch_rows,
 			.per_vector_mcxt = batch_state->per_batch_context,
 			.slot = compressed_slot,
@@ -1036,6 +1165,16 @@ compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
 		InstrCountTuples2(dcontext->ps, 1);
 		InstrCountFiltered1(dcontext->ps, batch_state->total_batch_rows);
 	}
+	else if (vector_qual_summary == AllRowsPass && dcontext->skip_decompression_all_rows_pass)
+	{
+		/*
+		 * The caller is going to use only the batch metadata, so we don't have
+		 * to decompress anything else.
+		 */
+		Assert(!dcontext->batch_sorted_merge);
+		batch_state->vector_qual_result = NULL;
+		vqstate->vector_qual_result = NULL;
+	}
 	else
 	{
 		/*
@@ -1111,12 +1250,10 @@ make_next_tuple(DecompressBatchState *batch_state, uint16 arrow_row, int num_dat
 		else if (column_values->decompression_type > SIZEOF_DATUM)
 		{
 			/*
-			 * Fixed-width by-reference type that doesn't fit into a Datum.
-			 * For now this only happens for 8-byte types on 32-bit systems,
-			 * but eventually we could also use it for bigger by-value types
-			 * such as UUID.
+			 * Fixed-width by-reference type that doesn't fit into a Datum,
+			 * such as UUID, or the 8-byte types on 32-bit systems.
 			 */
-			const uint8 value_bytes = column_values->decompression_type;
+			const int value_bytes = column_values->decompression_type;
 			const char *src = column_values->buffers[1];
 			*column_values->output_value = PointerGetDatum(&src[value_bytes * arrow_row]);
 			*column_values->output_isnull =
@@ -36,8 +36,8 @@ typedef enum
 
 	/*
 	 * Any positive number is also valid for the decompression type. It means
-	 * arrow array of a fixed-size by-value type, with size in bytes given by
-	 * the number.
+	 * arrow array of a fixed-size type, with size in bytes given by the
+	 * number. The types larger than Datum are by-reference.
 	 */
 } DecompressionType;
 
@@ -57,6 +57,7 @@ typedef struct CompressedColumnValues
 	 * arrow fixed:     validity, value
 	 * arrow text:      validity, uint32* offsets, void* bodies
 	 * arrow dict text: validity, uint32* dict offsets, void* dict bodies, int16* indices
+	 * The "text" layouts are also used for the other varlena types.
 	 */
 	const void *restrict buffers[4];
 
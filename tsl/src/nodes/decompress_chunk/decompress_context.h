@@ -72,10 +72,19 @@ typedef struct DecompressContext
 	int num_data_columns;
 
 	List *vectorized_quals_constified;
+	List *vector_expression_states;
 	bool reverse;
 	bool batch_sorted_merge; /* Batch sorted merge optimization enabled. */
 	bool enable_bulk_decompression;
 
+	/*
+	 * Leave the remaining compressed columns undecompressed (DT_Invalid) when
+	 * all rows of the batch pass the vectorized quals. This is set by the
+	 * vectorized aggregation node when it can compute its result from the
+	 * batch metadata in this case.
+	 */
+	bool skip_decompression_all_rows_pass;
+
 	/*
 	 * Scratch space for bulk decompression which might need a lot of temporary
 	 * data.
@@ -31,6 +31,7 @@
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/exec.h"
 #include "nodes/decompress_chunk/planner.h"
+#include "nodes/decompress_chunk/vector_expression.h"
 
 static void decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags);
 static void decompress_chunk_end(CustomScanState *node);
@@ -82,6 +83,7 @@ decompress_chunk_state_create(CustomScan *cscan)
 	chunk_state->decompress_context.enable_bulk_decompression =
 		list_nth_int(settings, DCS_EnableBulkDecompression);
 	chunk_state->has_row_marks = list_nth_int(settings, DCS_HasRowMarks);
+	chunk_state->batch_sorted_merge_limit = list_nth_int(settings, DCS_BatchSortedMergeLimit);
 
 	Assert(IsA(cscan->custom_exprs, List));
 	Assert(list_length(cscan->custom_exprs) == 1);
@@ -226,6 +228,16 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 	 */
 	node->custom_ps = lappend(node->custom_ps, ExecInitNode(compressed_scan, estate, eflags));
 
+	/*
+	 * With a LIMIT, the batch sorted merge needs only a known number of the
+	 * first compressed batches, so we can use a bounded sort for them.
+	 */
+	if (chunk_state->batch_sorted_merge_limit > 0)
+	{
+		Assert(dcontext->batch_sorted_merge);
+		ExecSetTupleBound(chunk_state->batch_sorted_merge_limit, linitial(node->custom_ps));
+	}
+
 	/*
 	 * Count the actual data columns we have to decompress, skipping the
 	 * metadata columns. We only need the metadata columns when initializing the
@@ -401,6 +413,8 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 		dcontext->vectorized_quals_constified =
 			lappend(dcontext->vectorized_quals_constified, constified);
 	}
+	dcontext->vector_expression_states =
+		vector_expression_init_states(dcontext->vectorized_quals_constified);
 
 	detoaster_init(&dcontext->detoaster, CurrentMemoryContext);
 }
@@ -456,6 +470,76 @@ decompress_chunk_exec_impl(DecompressChunkState *chunk_state, const BatchQueueFu
 	return result_slot;
 }
 
+/*
+ * Batch-mode output of DecompressChunk.
+ *
+ * Some parent nodes, like VectorAgg, work on the entire decompressed batches
+ * in columnar format, so going through the tuple-by-tuple interface of this
+ * node would only add the per-tuple overhead of making the virtual tuples. Such
+ * nodes read the compressed tuples from our child node themselves, and call
+ * this function to decompress them. The resulting batch state has the arrow
+ * arrays of the decompressed columns in compressed_columns, and the bitmap of
+ * rows that pass the vectorized quals in vector_qual_result. The batches are
+ * not merged even if this node uses the batch sorted merge, and the Postgres
+ * quals and the projection of this node are not applied, so the parent node
+ * must not depend on them.
+ *
+ * The batch state is owned by this node and is valid until the next call.
+ * Returns NULL if the entire batch is filtered out by the vectorized quals.
+ */
+DecompressBatchState *
+decompress_chunk_load_batch(DecompressChunkState *chunk_state, TupleTableSlot *compressed_slot)
+{
+	DecompressContext *dcontext = &chunk_state->decompress_context;
+	BatchQueue *bq = chunk_state->batch_queue;
+	DecompressBatchState *batch_state = batch_array_get_at(&bq->batch_array, 0);
+
+	Assert(chunk_state->csstate.ss.ps.qual == NULL);
+
+	/*
+	 * We discard the previous batch here and not earlier, because the parent
+	 * node might still reference its memory, e.g. the grouping column values
+	 * of the VectorAgg batch grouping policy.
+	 */
+	compressed_batch_discard_tuples(batch_state);
+
+	compressed_batch_set_compressed_tuple(dcontext, batch_state, compressed_slot);
+
+	if (batch_state->next_batch_row >= batch_state->total_batch_rows)
+	{
+		return NULL;
+	}
+
+	return batch_state;
+}
+
+/*
+ * Count the rows of a batch returned in batch mode for EXPLAIN.
+ *
+ * Normally this is done in the tuple-by-tuple interface, so that we don't say
+ * we filtered out more rows than we returned (e.g. with LIMIT). In batch mode,
+ * we always return full batches. The batches that were fully filtered out, and
+ * their rows, were already counted in compressed_batch_set_compressed_tuple().
+ */
+void
+decompress_chunk_count_batch_rows(DecompressChunkState *chunk_state,
+								  const DecompressBatchState *batch_state)
+{
+	PlanState *ps = &chunk_state->csstate.ss.ps;
+	const int not_filtered_rows =
+		arrow_num_valid(batch_state->vector_qual_result, batch_state->total_batch_rows);
+	InstrCountFiltered1(ps, batch_state->total_batch_rows - not_filtered_rows);
+	if (ps->instrument)
+	{
+		/*
+		 * These values are normally updated by InstrStopNode(), and are
+		 * required so that the calculations in InstrEndLoop() run properly.
+		 */
+		ps->instrument->running = true;
+		ps->instrument->tuplecount += not_filtered_rows;
+	}
+}
+
 static void
 decompress_chunk_rescan(CustomScanState *node)
 {
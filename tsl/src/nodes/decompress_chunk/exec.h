@@ -8,6 +8,7 @@
 #include <postgres.h>
 
 #include "batch_queue.h"
+#include "compressed_batch.h"
 #include "decompress_context.h"
 #include <nodes/extensible.h>
 
@@ -33,6 +34,13 @@ typedef struct DecompressChunkState
 
 	List *sortinfo;
 
+	/*
+	 * Number of compressed batches the batch sorted merge has to look at to
+	 * satisfy the query LIMIT, or zero if not bounded. See
+	 * batch_sorted_merge_limit() for why this is enough.
+	 */
+	int batch_sorted_merge_limit;
+
 	/*
 	 * For some predicates, we have more efficient implementation that work on
 	 * the entire compressed batch in one go. They go to this list, and the rest
@@ -46,5 +54,11 @@ typedef struct DecompressChunkState
 
 extern Node *decompress_chunk_state_create(CustomScan *cscan);
 
-TupleTableSlot *decompress_chunk_exec_vector_agg_impl(CustomScanState *vector_agg_state,
-													  DecompressChunkState *decompress_state);
+/*
+ * Batch-mode output of DecompressChunk for the parent nodes that work on the
+ * entire decompressed batches, see decompress_chunk_load_batch().
+ */
+extern DecompressBatchState *decompress_chunk_load_batch(DecompressChunkState *chunk_state,
+														 TupleTableSlot *compressed_slot);
+extern void decompress_chunk_count_batch_rows(DecompressChunkState *chunk_state,
+											  const DecompressBatchState *batch_state);
@@ -34,6 +34,7 @@
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/exec.h"
 #include "nodes/decompress_chunk/planner.h"
+#include "nodes/decompress_chunk/vector_expression.h"
 #include "nodes/decompress_chunk/vector_quals.h"
 #include "nodes/vector_agg/exec.h"
 #include "ts_catalog/array_utils.h"
@@ -669,6 +670,90 @@ is_not_runtime_constant(Node *node)
 	return result;
 }
 
+/*
+ * Check whether the given expression can be computed in vectorized fashion
+ * from a single column of the relation, and return the Var that references
+ * this column. Besides the plain Var, we support time_bucket() and the
+ * arithmetic operators where the other argument is a runtime constant.
+ */
+static Var *
+get_vector_expression_var(Node *node)
+{
+	if (IsA(node, Var))
+	{
+		return castNode(Var, node);
+	}
+
+	if (IsA(node, FuncExpr))
+	{
+		return vector_time_bucket_get_var(castNode(FuncExpr, node));
+	}
+
+	if (IsA(node, OpExpr) && list_length(castNode(OpExpr, node)->args) == 2)
+	{
+		OpExpr *opexpr = castNode(OpExpr, node);
+		Node *larg = linitial(opexpr->args);
+		Node *rarg = lsecond(opexpr->args);
+		if (!is_not_runtime_constant(rarg) &&
+			vector_arithmetic_supported(opexpr, /* vector_on_left = */ true))
+		{
+			return get_vector_expression_var(larg);
+		}
+
+		if (!is_not_runtime_constant(larg) &&
+			vector_arithmetic_supported(opexpr, /* vector_on_left = */ false))
+		{
+			return get_vector_expression_var(rarg);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Check whether the given expression can be computed in vectorized fashion
+ * from a column of the relation that supports bulk decompression, and return
+ * the Var that references this column.
+ */
+static Var *
+get_vector_column_var(Node *node, const VectorQualInfo *vqinfo)
+{
+	Var *var = get_vector_expression_var(node);
+	if (var == NULL)
+	{
+		return NULL;
+	}
+
+	if ((Index) var->varno != vqinfo->rti)
+	{
+		/*
+		 * We have a Var from other relation (join clause), can't vectorize it
+		 * at the moment.
+		 */
+		return NULL;
+	}
+
+	if (var->varattno <= 0)
+	{
+		/*
+		 * Can't vectorize operators with special variables such as whole-row var.
+		 */
+		return NULL;
+	}
+
+	/*
+	 * ExecQual is performed before ExecProject and operates on the decompressed
+	 * scan slot, so the qual attnos are the uncompressed chunk attnos.
+	 */
+	if (!vqinfo->vector_attrs[var->varattno])
+	{
+		/* This column doesn't support bulk decompression. */
+		return NULL;
+	}
+
+	return var;
+}
+
 /*
  * Try to check if the current qual is vectorizable, and if needed make a
  * commuted copy. If not, return NULL.
@@ -804,10 +889,11 @@ vector_qual_make(Node *qual, const VectorQualInfo *vqinfo)
 		return NULL;
 	}
 
-	if (opexpr && IsA(arg2, Var))
+	if (opexpr && is_not_runtime_constant(arg2) && !is_not_runtime_constant(arg1))
 	{
 		/*
-		 * Try to commute the operator if we have Var on the right.
+		 * Try to commute the operator if we have Var or an expression
+		 * depending on it on the right, and a constant on the left.
 		 */
 		opno = get_commutator(opno);
 		if (!OidIsValid(opno))
@@ -829,55 +915,49 @@ vector_qual_make(Node *qual, const VectorQualInfo *vqinfo)
 	}
 
 	/*
-	 * We can vectorize the operation where the left side is a Var.
+	 * We can vectorize the operation where the left side is a Var, or an
+	 * expression over a Var that we can compute in vectorized fashion.
 	 */
-	if (!IsA(arg1, Var))
+	var = get_vector_column_var(arg1, vqinfo);
+	if (var == NULL)
 	{
 		return NULL;
 	}
 
-	var = castNode(Var, arg1);
-	if ((Index) var->varno != vqinfo->rti)
+	if (nulltest)
 	{
 		/*
-		 * We have a Var from other relation (join clause), can't vectorize it
-		 * at the moment.
+		 * The checks we've done to this point is all that is required for null
+		 * test.
 		 */
-		return NULL;
+		return (Node *) nulltest;
 	}
 
-	if (var->varattno <= 0)
+	Assert(arg2);
+	if (opexpr && is_not_runtime_constant(arg2))
 	{
 		/*
-		 * Can't vectorize operators with special variables such as whole-row var.
+		 * We can vectorize the comparison of two columns of arithmetic types,
+		 * or of the expressions over them, e.g. "end_ts > start_ts + '5 min'".
 		 */
-		return NULL;
-	}
+		if (get_vector_column_var(arg2, vqinfo) == NULL)
+		{
+			return NULL;
+		}
 
-	/*
-	 * ExecQual is performed before ExecProject and operates on the decompressed
-	 * scan slot, so the qual attnos are the uncompressed chunk attnos.
-	 */
-	if (!vqinfo->vector_attrs[var->varattno])
-	{
-		/* This column doesn't support bulk decompression. */
-		return NULL;
-	}
+		if (!get_vector_vector_predicate(get_opcode(opno)))
+		{
+			return NULL;
+		}
 
-	if (nulltest)
-	{
-		/*
-		 * The checks we've done to this point is all that is required for null
-		 * test.
-		 */
-		return (Node *) nulltest;
+		return (Node *) opexpr;
 	}
 
 	/*
-	 * We can vectorize the operation where the right side is a constant or can
-	 * be evaluated to a constant at run time (e.g. contains stable functions).
+	 * Otherwise, we can vectorize the operation where the right side is a
+	 * constant or can be evaluated to a constant at run time (e.g. contains
+	 * stable functions).
 	 */
-	Assert(arg2);
 	if (is_not_runtime_constant(arg2))
 	{
 		return NULL;
@@ -1031,6 +1111,47 @@ find_var_subexpression(void *expr, Index varno)
 	return NULL;
 }
 
+/*
+ * Determine how many compressed batches the batch sorted merge might have to
+ * open, when the query has a LIMIT.
+ *
+ * The compressed batches are sorted by the min/max metadata of the first
+ * orderby column, and the metadata value is attained by some row of the batch.
+ * If we have N batches that go before a given batch in this order, each of them
+ * contains at least one row that goes before any row of the given batch, so the
+ * top N rows are always found in the first N batches. This allows us to use a
+ * bounded sort for the compressed batches, and not to look at the rest of them.
+ *
+ * This only holds when all rows of the batches are returned, i.e. there are no
+ * filters that are evaluated on decompressed rows, and when the query is
+ * ordered by the same single column the batches are sorted by. Returns zero if
+ * there is no usable limit.
+ */
+static int
+batch_sorted_merge_limit(PlannerInfo *root, DecompressChunkPath *dcpath, List *quals)
+{
+	Query *parse = root->parse;
+
+	if (!dcpath->batch_sorted_merge || quals != NIL || parse->rowMarks != NIL)
+		return 0;
+
+	/*
+	 * Postgres sets limit_tuples only when there is no grouping, aggregation,
+	 * window functions or SRFs in the tlist, but it doesn't account for the
+	 * joins.
+	 */
+	if (root->limit_tuples <= 0 || root->limit_tuples > PG_INT32_MAX ||
+		list_length(parse->jointree->fromlist) != 1 ||
+		!IsA(linitial(parse->jointree->fromlist), RangeTblRef))
+		return 0;
+
+	if (list_length(dcpath->custom_path.path.pathkeys) != 1 || root->sort_pathkeys == NIL ||
+		!pathkeys_contained_in(root->sort_pathkeys, dcpath->custom_path.path.pathkeys))
+		return 0;
+
+	return (int) root->limit_tuples;
+}
+
 Plan *
 decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path,
 							 List *output_targetlist, List *clauses, List *custom_plans)
@@ -1402,6 +1523,8 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 	lfirst_int(list_nth_cell(settings, DCS_BatchSortedMerge)) = dcpath->batch_sorted_merge;
 	lfirst_int(list_nth_cell(settings, DCS_EnableBulkDecompression)) = enable_bulk_decompression;
 	lfirst_int(list_nth_cell(settings, DCS_HasRowMarks)) = root->parse->rowMarks != NIL;
+	lfirst_int(list_nth_cell(settings, DCS_BatchSortedMergeLimit)) =
+		batch_sorted_merge_limit(root, dcpath, decompress_plan->scan.plan.qual);
 
 	/*
 	 * Vectorized quals must go into custom_exprs, because Postgres has to see
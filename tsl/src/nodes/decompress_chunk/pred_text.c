@@ -41,7 +41,7 @@ vector_const_text_comparison(const ArrowArray *arrow, const Datum constdatum, bo
 	const uint32 veclen = end - start;                                                             \
 	bool isequal = veclen != textlen ?                                                             \
 					   false :                                                                     \
-					   (strncmp((char *) &values[start], (char *) cstring, textlen) == 0);         \
+					   (memcmp(&values[start], cstring, textlen) == 0);                            \
 	word |= ((uint64) (isequal == needequal)) << bit_index;
 
 			INNER_LOOP
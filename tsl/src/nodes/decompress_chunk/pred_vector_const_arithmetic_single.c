@@ -9,6 +9,9 @@
  * Specialized for particular arithmetic data types and predicate.
  * Marked as noinline for the ease of debugging. Inlining it shouldn't be
  * beneficial because it's a big self-contained loop.
+ *
+ * The vector-vector predicate for the same pair of types is defined here as
+ * well, with the second vector having the type of the constant.
  */
 
 #define PG_PREDICATE_HELPER(X) PG_PREDICATE(X)
@@ -16,9 +19,15 @@
 #define FUNCTION_NAME_HELPER(X, Y, Z) predicate_##X##_##Y##_vector_##Z##_const
 #define FUNCTION_NAME(X, Y, Z) FUNCTION_NAME_HELPER(X, Y, Z)
 
-#ifdef GENERATE_DISPATCH_TABLE
+#define VECTOR_FUNCTION_NAME_HELPER(X, Y, Z) predicate_##X##_##Y##_vector_##Z##_vector
+#define VECTOR_FUNCTION_NAME(X, Y, Z) VECTOR_FUNCTION_NAME_HELPER(X, Y, Z)
+
+#if defined(GENERATE_DISPATCH_TABLE)
 case PG_PREDICATE_HELPER(PREDICATE_NAME):
 	return FUNCTION_NAME(PREDICATE_NAME, VECTOR_CTYPE, CONST_CTYPE);
+#elif defined(GENERATE_VECTOR_DISPATCH_TABLE)
+case PG_PREDICATE_HELPER(PREDICATE_NAME):
+	return VECTOR_FUNCTION_NAME(PREDICATE_NAME, VECTOR_CTYPE, CONST_CTYPE);
 #else
 
 static pg_noinline void
@@ -54,6 +63,42 @@ FUNCTION_NAME(PREDICATE_NAME, VECTOR_CTYPE,
 	}
 }
 
+static pg_noinline void
+VECTOR_FUNCTION_NAME(PREDICATE_NAME, VECTOR_CTYPE,
+					 CONST_CTYPE)(const ArrowArray *left, const ArrowArray *right,
+								  uint64 *restrict result)
+{
+	const size_t n = left->length;
+	Assert((size_t) right->length == n);
+
+	/* Now run the predicate itself. */
+	const VECTOR_CTYPE *left_values = (const VECTOR_CTYPE *) left->buffers[1];
+	const CONST_CTYPE *right_values = (const CONST_CTYPE *) right->buffers[1];
+
+	for (size_t outer = 0; outer < n / 64; outer++)
+	{
+		uint64 word = 0;
+		for (size_t inner = 0; inner < 64; inner++)
+		{
+			const bool valid = PREDICATE_EXPRESSION(left_values[outer * 64 + inner],
+													right_values[outer * 64 + inner]);
+			word |= ((uint64) valid) << inner;
+		}
+		result[outer] &= word;
+	}
+
+	if (n % 64)
+	{
+		uint64 tail_word = 0;
+		for (size_t i = (n / 64) * 64; i < n; i++)
+		{
+			const bool valid = PREDICATE_EXPRESSION(left_values[i], right_values[i]);
+			tail_word |= ((uint64) valid) << (i % 64);
+		}
+		result[n / 64] &= tail_word;
+	}
+}
+
 #endif
 
 #undef PG_PREDICATE_HELPER
@@ -61,5 +106,8 @@ FUNCTION_NAME(PREDICATE_NAME, VECTOR_CTYPE,
 #undef FUNCTION_NAME
 #undef FUNCTION_NAME_HELPER
 
+#undef VECTOR_FUNCTION_NAME
+#undef VECTOR_FUNCTION_NAME_HELPER
+
 #undef PREDICATE_EXPRESSION
 #undef PREDICATE_NAME
@@ -5,8 +5,9 @@
  */
 
 /*
- * Vector-const predicates for one pair of arithmetic types. For NaN comparison,
- * Postgres has its own nonstandard rules different from the IEEE floats.
+ * Vector-const and vector-vector predicates for one pair of arithmetic types.
+ * For NaN comparison, Postgres has its own nonstandard rules different from
+ * the IEEE floats.
  */
 
 #define PREDICATE_NAME GE
@@ -13,6 +13,7 @@
 #include <utils/builtins.h>
 #include <utils/typcache.h>
 
+#include "compression/batch_metadata_builder_bloom1.h"
 #include "compression/create.h"
 #include "custom_type_cache.h"
 #include "decompress_chunk.h"
@@ -313,6 +314,81 @@ pushdown_op_to_segment_meta_min_max(QualPushdownContext *context, List *expr_arg
 	}
 }
 
+/*
+ * Push down the equality or "= ANY(array)" condition to the bloom filter sparse
+ * index, as a call to the function that checks the bloom filter. The result is
+ * lossy, so the original condition has to be rechecked.
+ */
+static Expr *
+pushdown_op_to_segment_meta_bloom1(QualPushdownContext *context, List *expr_args, Oid op_oid,
+								   Oid op_collation, bool is_array_op)
+{
+	if (list_length(expr_args) != 2)
+		return NULL;
+
+	Expr *leftop = linitial(expr_args);
+	Expr *rightop = lsecond(expr_args);
+
+	if (IsA(leftop, RelabelType))
+		leftop = ((RelabelType *) leftop)->arg;
+	if (IsA(rightop, RelabelType))
+		rightop = ((RelabelType *) rightop)->arg;
+
+	/*
+	 * The ScalarArrayOpExpr always has the scalar on the left side, for the
+	 * OpExpr we might have to commute the operator.
+	 */
+	if (!is_array_op && !IsA(leftop, Var))
+	{
+		op_oid = get_commutator(op_oid);
+		Expr *tmp = leftop;
+		leftop = rightop;
+		rightop = tmp;
+	}
+
+	if (!IsA(leftop, Var))
+		return NULL;
+
+	Var *var = castNode(Var, leftop);
+	if ((Index) var->varno != context->chunk_rel->relid || var->varattno <= 0)
+		return NULL;
+
+	AttrNumber bloom1_attno = compressed_column_metadata_attno(context->settings,
+															   context->chunk_rte->relid,
+															   var->varattno,
+															   context->compressed_rte->relid,
+															   BLOOM1_SPARSE_INDEX_TYPE);
+	if (bloom1_attno == InvalidAttrNumber)
+		return NULL;
+
+	if (var->varcollid != op_collation)
+		return NULL;
+
+	if (!bloom1_operator_supported(op_oid, var->vartype, op_collation))
+		return NULL;
+
+	Oid value_type = exprType((Node *) rightop);
+	if (is_array_op)
+		value_type = get_element_type(value_type);
+
+	if (value_type != var->vartype)
+		return NULL;
+
+	Expr *expr = get_pushdownsafe_expr(context, rightop);
+	if (expr == NULL)
+		return NULL;
+
+	Var *bloom1_var =
+		makeVar(context->compressed_rel->relid, bloom1_attno, BYTEAOID, -1, InvalidOid, 0);
+
+	return (Expr *) makeFuncExpr(bloom1_get_contains_function(is_array_op),
+								 BOOLOID,
+								 list_make2(bloom1_var, expr),
+								 InvalidOid,
+								 op_collation,
+								 COERCE_EXPLICIT_CALL);
+}
+
 static Node *
 modify_expression(Node *node, QualPushdownContext *context)
 {
@@ -330,6 +406,14 @@ modify_expression(Node *node, QualPushdownContext *context)
 															   opexpr->args,
 															   opexpr->opno,
 															   opexpr->inputcollid);
+				if (pd == NULL)
+				{
+					pd = pushdown_op_to_segment_meta_bloom1(context,
+															opexpr->args,
+															opexpr->opno,
+															opexpr->inputcollid,
+															/* is_array_op = */ false);
+				}
 				if (pd != NULL)
 				{
 					context->needs_recheck = true;
@@ -340,10 +424,29 @@ modify_expression(Node *node, QualPushdownContext *context)
 			/* opexpr will still be checked for segment by columns */
 			break;
 		}
+		case T_ScalarArrayOpExpr:
+		{
+			ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) node;
+			if (saop->useOr)
+			{
+				Expr *pd = pushdown_op_to_segment_meta_bloom1(context,
+															  saop->args,
+															  saop->opno,
+															  saop->inputcollid,
+															  /* is_array_op = */ true);
+				if (pd != NULL)
+				{
+					context->needs_recheck = true;
+					/* pd is on the compressed table so do not mutate further */
+					return (Node *) pd;
+				}
+			}
+			/* saop will still be checked for segment by columns */
+			break;
+		}
 		case T_BoolExpr:
 		case T_CoerceViaIO:
 		case T_RelabelType:
-		case T_ScalarArrayOpExpr:
 		case T_List:
 		case T_Const:
 		case T_NullTest:
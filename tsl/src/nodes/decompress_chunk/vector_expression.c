@@ -0,0 +1,676 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized computation of simple expressions over the decompressed columns,
+ * that are used as the left side of the vectorized predicates. This allows
+ * vectorizing filters like "time_bucket('1 hour', ts) = $1" or
+ * "value * 2 > 10" without materializing the rows.
+ *
+ * The supported expressions are the fixed-width time_bucket(), the built-in
+ * arithmetic operators +, -, * and / for the integer and float types, and the
+ * addition or subtraction of an interval to a timestamp, where the other
+ * argument is a runtime constant. The arithmetic expressions can be nested,
+ * e.g. "(value + 1) * 2".
+ */
+
+#include <postgres.h>
+
+#include <math.h>
+
+#include <access/transam.h>
+#include <catalog/pg_type.h>
+#include <common/int.h>
+#include <nodes/nodeFuncs.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include "vector_expression.h"
+
+#include "nodes/decompress_chunk/compressed_batch.h"
+#include "nodes/vector_agg/vector_time_bucket.h"
+
+typedef enum ArithmeticOp
+{
+	AO_Invalid = 0,
+	AO_Add,
+	AO_Sub,
+	AO_Mul,
+	AO_Div,
+} ArithmeticOp;
+
+static ArithmeticOp
+get_arithmetic_op(Oid opno)
+{
+	/*
+	 * We only support the built-in operators, because we have to reproduce
+	 * their exact behavior.
+	 */
+	if (opno >= FirstGenbkiObjectId)
+	{
+		return AO_Invalid;
+	}
+
+	char *opname = get_opname(opno);
+	if (opname == NULL || strlen(opname) != 1)
+	{
+		return AO_Invalid;
+	}
+
+	switch (opname[0])
+	{
+		case '+':
+			return AO_Add;
+		case '-':
+			return AO_Sub;
+		case '*':
+			return AO_Mul;
+		case '/':
+			return AO_Div;
+		default:
+			return AO_Invalid;
+	}
+}
+
+static int
+get_arithmetic_type_bytes(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return 2;
+		case INT4OID:
+		case FLOAT4OID:
+			return 4;
+		case INT8OID:
+		case FLOAT8OID:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+static bool
+is_float_type(Oid typid)
+{
+	return typid == FLOAT4OID || typid == FLOAT8OID;
+}
+
+static bool
+is_timestamp_type(Oid typid)
+{
+	return typid == TIMESTAMPOID || typid == TIMESTAMPTZOID;
+}
+
+/*
+ * Check whether the given operator is a binary arithmetic operator that we
+ * can compute in vectorized fashion, when the left or the right argument is
+ * the column expression. The caller has to check that the other argument is a
+ * runtime constant.
+ */
+bool
+vector_arithmetic_supported(const OpExpr *opexpr, bool vector_on_left)
+{
+	if (list_length(opexpr->args) != 2)
+	{
+		return false;
+	}
+
+	const ArithmeticOp op = get_arithmetic_op(opexpr->opno);
+	if (op == AO_Invalid)
+	{
+		return false;
+	}
+
+	const Oid ltype = exprType(linitial(opexpr->args));
+	const Oid rtype = exprType(lsecond(opexpr->args));
+
+	if (is_timestamp_type(ltype))
+	{
+		/* Timestamp column plus or minus interval. */
+		return vector_on_left && (op == AO_Add || op == AO_Sub) && rtype == INTERVALOID &&
+			   opexpr->opresulttype == ltype;
+	}
+
+	const int lbytes = get_arithmetic_type_bytes(ltype);
+	const int rbytes = get_arithmetic_type_bytes(rtype);
+	if (lbytes == 0 || rbytes == 0)
+	{
+		return false;
+	}
+
+	if (is_float_type(ltype) != is_float_type(rtype) ||
+		is_float_type(ltype) != is_float_type(opexpr->opresulttype))
+	{
+		return false;
+	}
+
+	/*
+	 * The built-in cross-type operators have the result type of the wider
+	 * argument.
+	 */
+	return get_arithmetic_type_bytes(opexpr->opresulttype) == Max(lbytes, rbytes);
+}
+
+#define READ_INT(ARRAY, ROW, BYTES)                                                                \
+	((BYTES) == 2 ? ((const int16 *) (ARRAY))[ROW] :                                               \
+	 (BYTES) == 4 ? ((const int32 *) (ARRAY))[ROW] :                                               \
+					((const int64 *) (ARRAY))[ROW])
+
+#define READ_FLOAT(ARRAY, ROW, BYTES)                                                              \
+	((BYTES) == 4 ? (double) ((const float4 *) (ARRAY))[ROW] : ((const float8 *) (ARRAY))[ROW])
+
+#define SET_UNSAFE(BITMAP, ROW, UNSAFE)                                                            \
+	((BITMAP)[(ROW) / 64] |= ((uint64) (UNSAFE)) << ((ROW) % 64))
+
+/*
+ * Compute the integer operator for all rows in int64. The rows for which the
+ * result overflows or the operator throws an error are marked as unsafe, and
+ * are recomputed later by the SQL function.
+ */
+static pg_attribute_always_inline void
+compute_int_arithmetic_impl(ArithmeticOp op, bool vector_on_left, int vector_bytes,
+							const void *vector_values, int64 const_value, int nrows,
+							int64 *restrict result_values, uint64 *restrict unsafe_rows)
+{
+	for (int row = 0; row < nrows; row++)
+	{
+		const int64 vector_value = READ_INT(vector_values, row, vector_bytes);
+		const int64 a = vector_on_left ? vector_value : const_value;
+		const int64 b = vector_on_left ? const_value : vector_value;
+		int64 result = 0;
+		bool unsafe = false;
+		switch (op)
+		{
+			case AO_Add:
+				unsafe = pg_add_s64_overflow(a, b, &result);
+				break;
+			case AO_Sub:
+				unsafe = pg_sub_s64_overflow(a, b, &result);
+				break;
+			case AO_Mul:
+				unsafe = pg_mul_s64_overflow(a, b, &result);
+				break;
+			case AO_Div:
+				/* Don't trap on division by zero or overflow. */
+				unsafe = (b == 0) | ((a == PG_INT64_MIN) & (b == -1));
+				result = a / (unsafe ? 1 : b);
+				break;
+			default:
+				pg_unreachable();
+		}
+		SET_UNSAFE(unsafe_rows, row, unsafe);
+		result_values[row] = result;
+	}
+}
+
+/*
+ * Add a fixed-width interval to the timestamps. The rows with non-finite
+ * timestamps and the results outside of the valid timestamp range are marked
+ * as unsafe, and are recomputed later by the SQL function. If the interval
+ * has months or days, the computation depends on the calendar and the time
+ * zone, so all rows are unsafe.
+ */
+static void
+compute_timestamp_arithmetic(ArithmeticOp op, const Interval *interval, const int64 *vector_values,
+							 int nrows, int64 *restrict result_values, uint64 *restrict unsafe_rows)
+{
+	const bool fixed_width =
+		interval->month == 0 && interval->day == 0 && interval->time != PG_INT64_MIN;
+	const int64 shift = !fixed_width ? 0 : op == AO_Sub ? -interval->time : interval->time;
+	for (int row = 0; row < nrows; row++)
+	{
+		const int64 value = vector_values[row];
+		int64 result = 0;
+		bool unsafe = pg_add_s64_overflow(value, shift, &result);
+		unsafe |= !fixed_width;
+		unsafe |= TIMESTAMP_NOT_FINITE(value);
+		unsafe |= !IS_VALID_TIMESTAMP(result);
+		SET_UNSAFE(unsafe_rows, row, unsafe);
+		result_values[row] = result;
+	}
+}
+
+/*
+ * Compute the float operator for all rows. The float4 operations are computed
+ * in double and rounded, which gives the same result for +, -, * and /. The
+ * non-finite results and the underflows are marked as unsafe and recomputed
+ * later by the SQL function, which either returns the special value or throws
+ * an error.
+ */
+static pg_attribute_always_inline void
+compute_float_arithmetic_impl(ArithmeticOp op, bool vector_on_left, int vector_bytes,
+							  int result_bytes, const void *vector_values, double const_value,
+							  int nrows, void *restrict result_values,
+							  uint64 *restrict unsafe_rows)
+{
+	for (int row = 0; row < nrows; row++)
+	{
+		const double vector_value = READ_FLOAT(vector_values, row, vector_bytes);
+		const double a = vector_on_left ? vector_value : const_value;
+		const double b = vector_on_left ? const_value : vector_value;
+		double result = 0;
+		switch (op)
+		{
+			case AO_Add:
+				result = a + b;
+				break;
+			case AO_Sub:
+				result = a - b;
+				break;
+			case AO_Mul:
+				result = a * b;
+				break;
+			case AO_Div:
+				result = a / b;
+				break;
+			default:
+				pg_unreachable();
+		}
+
+		if (result_bytes == 4)
+		{
+			const float4 narrowed = (float4) result;
+			((float4 *) result_values)[row] = narrowed;
+			result = narrowed;
+		}
+		else
+		{
+			((float8 *) result_values)[row] = result;
+		}
+
+		bool unsafe = !isfinite(result);
+		if (op == AO_Mul)
+		{
+			unsafe |= (result == 0) & (a != 0) & (b != 0);
+		}
+		else if (op == AO_Div)
+		{
+			unsafe |= (result == 0) & (a != 0);
+		}
+		SET_UNSAFE(unsafe_rows, row, unsafe);
+	}
+}
+
+static Datum
+read_datum(Oid typid, const void *values, int row)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return Int16GetDatum(((const int16 *) values)[row]);
+		case INT4OID:
+			return Int32GetDatum(((const int32 *) values)[row]);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return Int64GetDatum(((const int64 *) values)[row]);
+		case FLOAT4OID:
+			return Float4GetDatum(((const float4 *) values)[row]);
+		case FLOAT8OID:
+			return Float8GetDatum(((const float8 *) values)[row]);
+		default:
+			Ensure(false, "unexpected type %d in vectorized expression", typid);
+			pg_unreachable();
+	}
+}
+
+static void
+write_datum(Oid typid, void *values, int row, Datum datum)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			((int16 *) values)[row] = DatumGetInt16(datum);
+			break;
+		case INT4OID:
+			((int32 *) values)[row] = DatumGetInt32(datum);
+			break;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			((int64 *) values)[row] = DatumGetInt64(datum);
+			break;
+		case FLOAT4OID:
+			((float4 *) values)[row] = DatumGetFloat4(datum);
+			break;
+		case FLOAT8OID:
+			((float8 *) values)[row] = DatumGetFloat8(datum);
+			break;
+		default:
+			Ensure(false, "unexpected type %d in vectorized expression", typid);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Make an ArrowArray with the given values and the validity of the input
+ * array. The expressions we support are strict, so the nulls are the same.
+ */
+static const ArrowArray *
+make_result_arrow(VectorQualState *vqstate, const ArrowArray *input, const void *values)
+{
+	ArrowArray *result =
+		MemoryContextAllocZero(vqstate->per_vector_mcxt, sizeof(ArrowArray) + sizeof(void *) * 2);
+	result->length = input->length;
+	result->null_count = input->null_count;
+	result->n_buffers = 2;
+	result->buffers = (const void **) &result[1];
+	result->buffers[0] = input->buffers[0];
+	result->buffers[1] = values;
+	return result;
+}
+
+static const ArrowArray *
+compute_arithmetic(VectorQualState *vqstate, OpExpr *opexpr, const uint64 *filter,
+				   bool *is_default_value)
+{
+	Expr *larg = linitial(opexpr->args);
+	Expr *rarg = lsecond(opexpr->args);
+	const bool vector_on_left = !IsA(larg, Const);
+	Ensure(IsA(vector_on_left ? rarg : larg, Const),
+		   "failed to evaluate runtime constant in vectorized expression");
+
+	/*
+	 * The arithmetic operators are strict, so a null constant should have been
+	 * folded by the constification.
+	 */
+	Const *constnode = castNode(Const, vector_on_left ? rarg : larg);
+	Ensure(!constnode->constisnull, "vectorized expression called for a null value");
+
+	Expr *vector_arg = vector_on_left ? larg : rarg;
+	const ArrowArray *input =
+		vector_expression_compute(vqstate, vector_arg, filter, is_default_value);
+	Ensure(input->dictionary == NULL, "unexpected dictionary in vectorized expression");
+
+	const Oid vector_type = exprType((Node *) vector_arg);
+	const Oid result_type = opexpr->opresulttype;
+	const bool is_timestamp = is_timestamp_type(vector_type);
+	const int vector_bytes = is_timestamp ? 8 : get_arithmetic_type_bytes(vector_type);
+	const int result_bytes = is_timestamp ? 8 : get_arithmetic_type_bytes(result_type);
+	const ArithmeticOp op = get_arithmetic_op(opexpr->opno);
+	Assert(op != AO_Invalid && vector_bytes != 0 && result_bytes != 0);
+	Assert(!is_timestamp || vector_on_left);
+
+	const int nrows = input->length;
+	const void *vector_values = input->buffers[1];
+	const size_t n_words = (nrows + 63) / 64;
+	uint64 *unsafe_rows =
+		MemoryContextAllocZero(vqstate->per_vector_mcxt, sizeof(uint64) * n_words);
+
+	/* The value buffer has 64-byte padding as required by Arrow. */
+	void *result_values =
+		MemoryContextAlloc(vqstate->per_vector_mcxt, pad_to_multiple(64, result_bytes * nrows));
+
+#define DISPATCH(IMPL, ...)                                                                        \
+	switch (op)                                                                                    \
+	{                                                                                              \
+		case AO_Add:                                                                               \
+			IMPL(AO_Add, __VA_ARGS__);                                                             \
+			break;                                                                                 \
+		case AO_Sub:                                                                               \
+			IMPL(AO_Sub, __VA_ARGS__);                                                             \
+			break;                                                                                 \
+		case AO_Mul:                                                                               \
+			IMPL(AO_Mul, __VA_ARGS__);                                                             \
+			break;                                                                                 \
+		default:                                                                                   \
+			IMPL(AO_Div, __VA_ARGS__);                                                             \
+			break;                                                                                 \
+	}
+
+	if (is_timestamp)
+	{
+		compute_timestamp_arithmetic(op,
+									 DatumGetIntervalP(constnode->constvalue),
+									 vector_values,
+									 nrows,
+									 result_values,
+									 unsafe_rows);
+	}
+	else if (is_float_type(result_type))
+	{
+		const double const_value = constnode->consttype == FLOAT4OID ?
+									   (double) DatumGetFloat4(constnode->constvalue) :
+									   DatumGetFloat8(constnode->constvalue);
+
+#define FLOAT_IMPL(OP, VECTOR_BYTES, RESULT_BYTES)                                                 \
+	compute_float_arithmetic_impl(OP,                                                              \
+								  vector_on_left,                                                  \
+								  VECTOR_BYTES,                                                    \
+								  RESULT_BYTES,                                                    \
+								  vector_values,                                                   \
+								  const_value,                                                     \
+								  nrows,                                                           \
+								  result_values,                                                   \
+								  unsafe_rows)
+
+		if (vector_bytes == 4 && result_bytes == 4)
+		{
+			DISPATCH(FLOAT_IMPL, 4, 4);
+		}
+		else if (vector_bytes == 4)
+		{
+			DISPATCH(FLOAT_IMPL, 4, 8);
+		}
+		else
+		{
+			DISPATCH(FLOAT_IMPL, 8, 8);
+		}
+#undef FLOAT_IMPL
+	}
+	else
+	{
+		int64 const_value;
+		switch (constnode->consttype)
+		{
+			case INT2OID:
+				const_value = DatumGetInt16(constnode->constvalue);
+				break;
+			case INT4OID:
+				const_value = DatumGetInt32(constnode->constvalue);
+				break;
+			default:
+				const_value = DatumGetInt64(constnode->constvalue);
+				break;
+		}
+
+		/*
+		 * The narrower integer results are computed in int64 and then checked
+		 * for overflow when converting to the result type.
+		 */
+		int64 *wide_values =
+			result_bytes == 8 ?
+				result_values :
+				MemoryContextAlloc(vqstate->per_vector_mcxt, sizeof(int64) * nrows);
+
+#define INT_IMPL(OP, VECTOR_BYTES)                                                                 \
+	compute_int_arithmetic_impl(OP,                                                                \
+								vector_on_left,                                                    \
+								VECTOR_BYTES,                                                      \
+								vector_values,                                                     \
+								const_value,                                                       \
+								nrows,                                                             \
+								wide_values,                                                       \
+								unsafe_rows)
+
+		switch (vector_bytes)
+		{
+			case 2:
+				DISPATCH(INT_IMPL, 2);
+				break;
+			case 4:
+				DISPATCH(INT_IMPL, 4);
+				break;
+			default:
+				DISPATCH(INT_IMPL, 8);
+				break;
+		}
+#undef INT_IMPL
+
+		if (result_bytes == 4)
+		{
+			for (int row = 0; row < nrows; row++)
+			{
+				const int64 value = wide_values[row];
+				SET_UNSAFE(unsafe_rows, row, value < PG_INT32_MIN || value > PG_INT32_MAX);
+				((int32 *) result_values)[row] = (int32) value;
+			}
+		}
+		else if (result_bytes == 2)
+		{
+			for (int row = 0; row < nrows; row++)
+			{
+				const int64 value = wide_values[row];
+				SET_UNSAFE(unsafe_rows, row, value < PG_INT16_MIN || value > PG_INT16_MAX);
+				((int16 *) result_values)[row] = (int16) value;
+			}
+		}
+	}
+#undef DISPATCH
+
+	bool have_unsafe = false;
+	for (size_t i = 0; i < n_words; i++)
+	{
+		have_unsafe |= unsafe_rows[i] != 0;
+	}
+
+	if (unlikely(have_unsafe))
+	{
+		/*
+		 * Recompute the unsafe rows by calling the operator function, to
+		 * reproduce its exact behavior for the special values and the errors.
+		 * This is done only for the valid rows that pass the filter, because
+		 * the function can throw an error.
+		 */
+		const uint64 *validity = input->buffers[0];
+		const uint64 *row_filter = *is_default_value ? NULL : filter;
+		FmgrInfo flinfo;
+		fmgr_info(get_opcode(opexpr->opno), &flinfo);
+		for (int row = 0; row < nrows; row++)
+		{
+			if (!arrow_row_is_valid(unsafe_rows, row) ||
+				!arrow_row_both_valid(validity, row_filter, row))
+			{
+				continue;
+			}
+
+			const Datum vector_datum = read_datum(vector_type, vector_values, row);
+			const Datum result =
+				FunctionCall2Coll(&flinfo,
+								  opexpr->inputcollid,
+								  vector_on_left ? vector_datum : constnode->constvalue,
+								  vector_on_left ? constnode->constvalue : vector_datum);
+			write_datum(result_type, result_values, row, result);
+		}
+	}
+
+	return make_result_arrow(vqstate, input, result_values);
+}
+
+/*
+ * The state of a vectorized expression that doesn't change between the
+ * batches, so that we don't have to repeat the function lookups for every
+ * batch. For now, only time_bucket() needs it.
+ */
+typedef struct VectorExpressionState
+{
+	FuncExpr *func;
+	VectorTimeBucket *bucket;
+} VectorExpressionState;
+
+static bool
+init_states_walker(Node *node, List **states)
+{
+	if (node == NULL)
+	{
+		return false;
+	}
+
+	if (IsA(node, FuncExpr) && vector_time_bucket_get_var(castNode(FuncExpr, node)) != NULL)
+	{
+		VectorExpressionState *state = palloc(sizeof(VectorExpressionState));
+		state->func = castNode(FuncExpr, node);
+		state->bucket = vector_time_bucket_create(state->func);
+		*states = lappend(*states, state);
+		return false;
+	}
+
+	return expression_tree_walker(node, init_states_walker, states);
+}
+
+/*
+ * Prepare the state of the vectorized expressions used in the given
+ * vectorized quals. This is done once per scan, and the result goes to
+ * VectorQualState.expression_states. The states are allocated in the current
+ * memory context, which must outlive the scan.
+ */
+List *
+vector_expression_init_states(List *quals)
+{
+	List *states = NIL;
+	init_states_walker((Node *) quals, &states);
+	return states;
+}
+
+static const ArrowArray *
+compute_time_bucket(VectorQualState *vqstate, FuncExpr *func, const uint64 *filter,
+					bool *is_default_value)
+{
+	const ArrowArray *input =
+		vqstate->get_arrow_array(vqstate, lsecond(func->args), is_default_value);
+
+	VectorTimeBucket *bucket = NULL;
+	ListCell *lc;
+	foreach (lc, vqstate->expression_states)
+	{
+		VectorExpressionState *state = lfirst(lc);
+		if (state->func == func)
+		{
+			bucket = state->bucket;
+			break;
+		}
+	}
+	Ensure(bucket != NULL, "vectorized time_bucket() state is not initialized");
+
+	const CompressedColumnValues input_values = {
+		.decompression_type = bucket->value_bytes,
+		.buffers = { input->buffers[0], input->buffers[1] },
+		.arrow = (ArrowArray *) input,
+	};
+	CompressedColumnValues result_values;
+	vector_time_bucket_compute(bucket,
+							   &input_values,
+							   *is_default_value ? NULL : filter,
+							   input->length,
+							   &result_values);
+
+	return make_result_arrow(vqstate, input, result_values.buffers[1]);
+}
+
+/*
+ * Compute the given expression for the current batch and return the resulting
+ * ArrowArray. For a plain Var, this is just the decompressed column. The
+ * filter is the bitmap of the rows that passed the preceding quals, it is used
+ * to avoid raising errors for the rows that are filtered out anyway.
+ */
+const ArrowArray *
+vector_expression_compute(VectorQualState *vqstate, Expr *expr, const uint64 *filter,
+						  bool *is_default_value)
+{
+	switch (nodeTag(expr))
+	{
+		case T_Var:
+			return vqstate->get_arrow_array(vqstate, expr, is_default_value);
+		case T_FuncExpr:
+			return compute_time_bucket(vqstate, castNode(FuncExpr, expr), filter, is_default_value);
+		case T_OpExpr:
+			return compute_arithmetic(vqstate, castNode(OpExpr, expr), filter, is_default_value);
+		default:
+			Ensure(false, "unexpected node type %d in vectorized expression", nodeTag(expr));
+			pg_unreachable();
+	}
+}
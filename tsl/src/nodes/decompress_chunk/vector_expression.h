@@ -0,0 +1,19 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <nodes/primnodes.h>
+
+#include "compression/arrow_c_data_interface.h"
+#include "vector_quals.h"
+
+extern bool vector_arithmetic_supported(const OpExpr *opexpr, bool vector_on_left);
+
+extern List *vector_expression_init_states(List *quals);
+
+extern const ArrowArray *vector_expression_compute(VectorQualState *vqstate, Expr *expr,
+												   const uint64 *filter, bool *is_default_value);
@@ -49,6 +49,28 @@ get_vector_const_predicate(Oid pg_predicate)
 		case F_TEXTNE:
 			return vector_const_textne;
 
+		/*
+		 * The bytea equality is bytewise like for text. Like the other varlena
+		 * columns, bytea retains the dictionary encoding after decompression,
+		 * so these predicates are computed on the distinct values.
+		 */
+		case F_BYTEAEQ:
+			return vector_const_texteq;
+
+		case F_BYTEANE:
+			return vector_const_textne;
+
+		/*
+		 * The enum equality compares the Oids of the enum values, so we can use
+		 * the int32 comparison. The ordering comparisons depend on the sort
+		 * order of enum labels and are not supported.
+		 */
+		case F_ENUM_EQ:
+			return predicate_EQ_int32_vector_int32_const;
+
+		case F_ENUM_NE:
+			return predicate_NE_int32_vector_int32_const;
+
 		default:
 			/*
 			 * More checks below, this branch is to placate the static analyzers.
@@ -76,6 +98,24 @@ get_vector_const_predicate(Oid pg_predicate)
 	return NULL;
 }
 
+/*
+ * Look up the vectorized implementation of a Postgres predicate that compares
+ * two columns of arithmetic types.
+ */
+VectorVectorPredicate *
+get_vector_vector_predicate(Oid pg_predicate)
+{
+	switch (pg_predicate)
+	{
+#define GENERATE_VECTOR_DISPATCH_TABLE
+#include "pred_vector_const_arithmetic_all.c"
+#undef GENERATE_VECTOR_DISPATCH_TABLE
+
+		default:
+			return NULL;
+	}
+}
+
 void
 vector_nulltest(const ArrowArray *arrow, int test_type, uint64 *restrict result)
 {
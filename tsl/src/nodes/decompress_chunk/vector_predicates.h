@@ -13,6 +13,10 @@ typedef void(VectorPredicate)(const ArrowArray *, Datum, uint64 *restrict);
 
 VectorPredicate *get_vector_const_predicate(Oid pg_predicate);
 
+typedef void(VectorVectorPredicate)(const ArrowArray *, const ArrowArray *, uint64 *restrict);
+
+VectorVectorPredicate *get_vector_vector_predicate(Oid pg_predicate);
+
 void vector_array_predicate(VectorPredicate *vector_const_predicate, bool is_or,
 							const ArrowArray *vector, Datum array, uint64 *restrict final_result);
 
@@ -46,6 +46,13 @@ typedef struct VectorQualInfo
 typedef struct VectorQualState
 {
 	List *vectorized_quals_constified;
+
+	/*
+	 * The state of the vectorized expressions in the quals that is prepared
+	 * once per scan, see vector_expression_init_states().
+	 */
+	List *expression_states;
+
 	uint16 num_results;
 	uint64 *vector_qual_result;
 	MemoryContext per_vector_mcxt;
@@ -9,20 +9,24 @@
 #include <commands/explain.h>
 #include <executor/executor.h>
 #include <executor/tuptable.h>
+#include <miscadmin.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <nodes/pg_list.h>
 #include <optimizer/optimizer.h>
+#include <utils/tuplestore.h>
 
 #include "nodes/vector_agg/exec.h"
 
 #include "compression/arrow_c_data_interface.h"
+#include "guc.h"
 #include "hypercore/arrow_tts.h"
 #include "hypercore/vector_quals.h"
 #include "nodes/columnar_scan/columnar_scan.h"
 #include "nodes/decompress_chunk/compressed_batch.h"
 #include "nodes/decompress_chunk/exec.h"
+#include "nodes/decompress_chunk/vector_expression.h"
 #include "nodes/decompress_chunk/vector_quals.h"
 #include "nodes/vector_agg.h"
 #include "nodes/vector_agg/plan.h"
@@ -122,6 +126,7 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 
 	VectorAggState *vector_agg_state = (VectorAggState *) node;
 	vector_agg_state->input_ended = false;
+	vector_agg_state->child_ended = false;
 	CustomScanState *childstate = (CustomScanState *) linitial(vector_agg_state->custom.custom_ps);
 
 	/*
@@ -150,6 +155,13 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 		castNode(CustomScan, vector_agg_state->custom.ss.ps.plan)->custom_scan_tlist;
 	const int tlist_length = list_length(aggregated_tlist);
 
+	/*
+	 * The attribute numbers of the batch min/max metadata columns for the
+	 * aggregates that can use them, parallel to the aggregated targetlist.
+	 */
+	List *metadata_attnos = list_nth(cscan->custom_private, VASI_BatchMetadataAttnos);
+	Assert(metadata_attnos == NIL || list_length(metadata_attnos) == tlist_length);
+
 	/*
 	 * First, count how many grouping columns and aggregate functions we have.
 	 */
@@ -165,7 +177,7 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 		else
 		{
 			/* This is a grouping column. */
-			Assert(IsA(tlentry->expr, Var));
+			Assert(IsA(tlentry->expr, Var) || IsA(tlentry->expr, FuncExpr));
 			grouping_column_counter++;
 		}
 	}
@@ -199,19 +211,50 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 
 			Aggref *aggref = castNode(Aggref, tlentry->expr);
 
-			VectorAggFunctions *func = get_vector_aggregate(aggref->aggfnoid);
+			const Oid argtype =
+				aggref->aggargtypes != NIL ? linitial_oid(aggref->aggargtypes) : InvalidOid;
+			VectorAggFunctions *func = get_vector_aggregate(aggref->aggfnoid, argtype);
 			Assert(func != NULL);
 			def->func = *func;
 
+			def->input_offset2 = -1;
 			if (list_length(aggref->args) > 0)
 			{
-				Assert(list_length(aggref->args) == 1);
+				Assert(list_length(aggref->args) <= 2);
 
 				/* The aggregate should be a partial aggregate */
 				Assert(aggref->aggsplit == AGGSPLIT_INITIAL_SERIAL);
 
 				Var *var = castNode(Var, castNode(TargetEntry, linitial(aggref->args))->expr);
 				def->input_offset = get_input_offset(childstate, var);
+				def->argtypes[0] = var->vartype;
+
+				if (list_length(aggref->args) == 2)
+				{
+					Assert(def->func.agg_many_vector2 != NULL);
+					Expr *arg2 = castNode(TargetEntry, lsecond(aggref->args))->expr;
+					if (IsA(arg2, Const))
+					{
+						/*
+						 * Constant second argument, like the fraction of
+						 * approximate_percentile(). It is passed to the
+						 * function as a scalar column.
+						 */
+						Const *c = castNode(Const, arg2);
+						def->const_arg2_value = c->constvalue;
+						def->const_arg2_isnull = c->constisnull;
+						def->const_arg2.decompression_type = DT_Scalar;
+						def->const_arg2.output_value = &def->const_arg2_value;
+						def->const_arg2.output_isnull = &def->const_arg2_isnull;
+						def->argtypes[1] = c->consttype;
+					}
+					else
+					{
+						Var *var2 = castNode(Var, arg2);
+						def->input_offset2 = get_input_offset(childstate, var2);
+						def->argtypes[1] = var2->vartype;
+					}
+				}
 			}
 			else
 			{
@@ -222,17 +265,38 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 			{
 				Node *constified = estimate_expression_value(&root, (Node *) aggref->aggfilter);
 				def->filter_clauses = list_make1(constified);
+				def->filter_expression_states =
+					vector_expression_init_states(def->filter_clauses);
 			}
+
+			def->metadata_attno =
+				metadata_attnos != NIL ? list_nth_int(metadata_attnos, i) : InvalidAttrNumber;
+			def->metadata_values.decompression_type = DT_Invalid;
+			def->metadata_values.output_value = &def->metadata_value;
+			def->metadata_values.output_isnull = &def->metadata_isnull;
 		}
 		else
 		{
 			/* This is a grouping column. */
-			Assert(IsA(tlentry->expr, Var));
-
 			GroupingColumn *col = &vector_agg_state->grouping_columns[grouping_column_counter++];
 			col->output_offset = i;
 
-			Var *var = castNode(Var, tlentry->expr);
+			Var *var = NULL;
+			if (IsA(tlentry->expr, FuncExpr))
+			{
+				/*
+				 * This is a time_bucket() over a column, which is computed
+				 * for the entire batch by the grouping policy.
+				 */
+				FuncExpr *func = castNode(FuncExpr, tlentry->expr);
+				col->time_bucket = vector_time_bucket_create(func);
+				var = castNode(Var, lsecond(func->args));
+			}
+			else
+			{
+				var = castNode(Var, tlentry->expr);
+			}
+
 			col->input_offset = get_input_offset(childstate, var);
 			get_column_storage_properties(childstate, col->input_offset, col);
 		}
@@ -266,11 +330,78 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 										vector_agg_state->grouping_columns,
 										grouping_type);
 	}
+
+	/*
+	 * If we can aggregate the batches where all rows pass the vectorized quals
+	 * using their metadata, tell DecompressChunk not to decompress the
+	 * aggregated columns for these batches.
+	 */
+	if (metadata_attnos != NIL)
+	{
+		Assert(grouping_type == VAGT_Batch);
+		Assert(!TTS_IS_ARROWTUPLE(childstate->ss.ss_ScanTupleSlot));
+		DecompressChunkState *decompress_state = (DecompressChunkState *) childstate;
+		decompress_state->decompress_context.skip_decompression_all_rows_pass = true;
+		vector_agg_state->use_batch_metadata = true;
+	}
+
+	/*
+	 * Check whether the hash grouping can save its input and aggregate it by
+	 * partitions of grouping keys when it doesn't fit into work_mem. We save
+	 * the compressed tuples, so this requires DecompressChunk as the child.
+	 */
+	if (intVal(list_nth(cscan->custom_private, VASI_SpillAllowed)) &&
+		ts_guc_enable_vectorized_aggregation_spill &&
+		vector_agg_state->grouping->gp_set_partition != NULL &&
+		!TTS_IS_ARROWTUPLE(childstate->ss.ss_ScanTupleSlot))
+	{
+		DecompressChunkState *decompress_state = (DecompressChunkState *) childstate;
+		PlanState *compressed_scan = linitial(decompress_state->csstate.custom_ps);
+		vector_agg_state->spill_enabled = true;
+		vector_agg_state->spill_slot = ExecInitExtraTupleSlot(estate,
+															  ExecGetResultType(compressed_scan),
+															  &TTSOpsMinimalTuple);
+
+		/*
+		 * In a parallel plan, our partial results go through Gather into a
+		 * single-threaded Finalize aggregation, which easily becomes the
+		 * bottleneck for high-cardinality groupings. Do as much of the
+		 * aggregation as possible in the parallel processes, see
+		 * vector_agg_reset_grouping().
+		 */
+		vector_agg_state->in_parallel_plan =
+			intVal(list_nth(cscan->custom_private, VASI_InParallelPlan));
+	}
+}
+
+/*
+ * Forget the saved input of the partitioned hash aggregation.
+ */
+static void
+vector_agg_spill_end(VectorAggState *state)
+{
+	/* The slot might reference the tuplestore memory, so clear it first. */
+	if (state->spill_slot != NULL)
+	{
+		ExecClearTuple(state->spill_slot);
+	}
+
+	if (state->spill_store != NULL)
+	{
+		tuplestore_end(state->spill_store);
+		state->spill_store = NULL;
+	}
+
+	state->spill_store_ended = false;
+	state->partition_bits = 0;
+	state->current_partition = 0;
+	state->stat_spill_passes = 0;
 }
 
 static void
 vector_agg_end(CustomScanState *node)
 {
+	vector_agg_spill_end((VectorAggState *) node);
 	ExecEndNode(linitial(node->custom_ps));
 }
 
@@ -284,17 +415,57 @@ vector_agg_rescan(CustomScanState *node)
 
 	VectorAggState *state = (VectorAggState *) node;
 	state->input_ended = false;
+	state->child_ended = false;
+
+	vector_agg_spill_end(state);
 
 	state->grouping->gp_reset(state->grouping);
 }
 
+/*
+ * Read the min/max metadata values of the current compressed batch for the
+ * aggregate functions that can use them. This is only possible when all rows
+ * of the batch pass the vectorized quals. In this case, DecompressChunk
+ * doesn't decompress the aggregated columns.
+ */
+static void
+compressed_batch_set_metadata_values(VectorAggState *vector_agg_state,
+									 const DecompressBatchState *batch_state,
+									 TupleTableSlot *compressed_slot)
+{
+	const bool all_rows_pass = batch_state->vector_qual_result == NULL;
+	const int naggs = vector_agg_state->num_agg_defs;
+	for (int i = 0; i < naggs; i++)
+	{
+		VectorAggDef *agg_def = &vector_agg_state->agg_defs[i];
+		if (agg_def->metadata_attno == InvalidAttrNumber)
+		{
+			continue;
+		}
+
+		if (!all_rows_pass)
+		{
+			agg_def->metadata_values.decompression_type = DT_Invalid;
+			continue;
+		}
+
+		agg_def->metadata_value =
+			slot_getattr(compressed_slot, agg_def->metadata_attno, &agg_def->metadata_isnull);
+		agg_def->metadata_values.decompression_type = DT_Scalar;
+	}
+}
+
 /*
  * Get the next slot to aggregate for a compressed batch.
  *
  * Implements "get next slot" on top of DecompressChunk. Note that compressed
- * tuples are read directly from the DecompressChunk child node, which means
- * that the processing normally done in DecompressChunk is actually done here
- * (batch processing and filtering).
+ * tuples are read directly from the DecompressChunk child node, and are
+ * decompressed using the batch-mode output of DecompressChunk, which means
+ * that we bypass its tuple-by-tuple interface.
+ *
+ * When the input is saved for the partitioned hash aggregation, we first replay
+ * the saved compressed tuples, and then continue with the child node, saving
+ * the new tuples as well.
  *
  * Returns an TupleTableSlot that implements a compressed batch.
  */
@@ -303,57 +474,68 @@ compressed_batch_get_next_slot(VectorAggState *vector_agg_state)
 {
 	DecompressChunkState *decompress_state =
 		(DecompressChunkState *) linitial(vector_agg_state->custom.custom_ps);
-	DecompressContext *dcontext = &decompress_state->decompress_context;
-	BatchQueue *batch_queue = decompress_state->batch_queue;
-	DecompressBatchState *batch_state = batch_array_get_at(&batch_queue->batch_array, 0);
+	Tuplestorestate *spill_store = vector_agg_state->spill_store;
+	DecompressBatchState *batch_state = NULL;
+	TupleTableSlot *compressed_slot = NULL;
+	bool from_child = false;
 
 	do
 	{
-		/*
-		 * We discard the previous compressed batch here and not earlier,
-		 * because the grouping column values returned by the batch grouping
-		 * policy are owned by the compressed batch memory context. This is done
-		 * to avoid generic value copying in the grouping policy to simplify its
-		 * code.
-		 */
-		compressed_batch_discard_tuples(batch_state);
-
-		TupleTableSlot *compressed_slot =
-			ExecProcNode(linitial(decompress_state->csstate.custom_ps));
-
-		if (TupIsNull(compressed_slot))
+		compressed_slot = NULL;
+		from_child = false;
+		if (spill_store != NULL && !vector_agg_state->spill_store_ended)
 		{
-			vector_agg_state->input_ended = true;
-			return NULL;
+			compressed_slot = vector_agg_state->spill_slot;
+			if (!tuplestore_gettupleslot(spill_store, true, false, compressed_slot))
+			{
+				vector_agg_state->spill_store_ended = true;
+				compressed_slot = NULL;
+			}
 		}
 
-		compressed_batch_set_compressed_tuple(dcontext, batch_state, compressed_slot);
+		if (compressed_slot == NULL)
+		{
+			if (!vector_agg_state->child_ended)
+			{
+				compressed_slot = ExecProcNode(linitial(decompress_state->csstate.custom_ps));
+				from_child = true;
+			}
+
+			if (TupIsNull(compressed_slot))
+			{
+				vector_agg_state->child_ended = true;
+				vector_agg_state->input_ended = true;
+				return NULL;
+			}
+		}
 
 		/* If the entire batch is filtered out, then immediately read the next
 		 * one */
-	} while (batch_state->next_batch_row >= batch_state->total_batch_rows);
+		batch_state = decompress_chunk_load_batch(decompress_state, compressed_slot);
+	} while (batch_state == NULL);
+
+	if (vector_agg_state->use_batch_metadata)
+	{
+		compressed_batch_set_metadata_values(vector_agg_state, batch_state, compressed_slot);
+	}
 
 	/*
-	 * Count rows filtered out by vectorized filters for EXPLAIN. Normally
-	 * this is done in tuple-by-tuple interface of DecompressChunk, so that
-	 * it doesn't say it filtered out more rows that were returned (e.g.
-	 * with LIMIT). Here we always work in full batches. The batches that
-	 * were fully filtered out, and their rows, were already counted in
-	 * compressed_batch_set_compressed_tuple().
+	 * The replayed tuples were already saved and counted when we read them
+	 * from the child node for the first time. The fully filtered out batches
+	 * don't have to be saved.
 	 */
-	const int not_filtered_rows =
-		arrow_num_valid(batch_state->vector_qual_result, batch_state->total_batch_rows);
-	InstrCountFiltered1(dcontext->ps, batch_state->total_batch_rows - not_filtered_rows);
-	if (dcontext->ps->instrument)
+	if (!from_child)
 	{
-		/*
-		 * These values are normally updated by InstrStopNode(), and are
-		 * required so that the calculations in InstrEndLoop() run properly.
-		 */
-		dcontext->ps->instrument->running = true;
-		dcontext->ps->instrument->tuplecount += not_filtered_rows;
+		return &batch_state->decompressed_scan_slot_data.base;
+	}
+
+	if (spill_store != NULL)
+	{
+		tuplestore_puttupleslot(spill_store, compressed_slot);
 	}
 
+	decompress_chunk_count_batch_rows(decompress_state, batch_state);
+
 	return &batch_state->decompressed_scan_slot_data.base;
 }
 
@@ -417,6 +599,7 @@ compressed_batch_init_vector_quals(VectorAggState *agg_state, VectorAggDef *agg_
 	agg_state->vqual_state = (CompressedBatchVectorQualState) {
 				.vqstate = {
 					.vectorized_quals_constified = agg_def->filter_clauses,
+					.expression_states = agg_def->filter_expression_states,
 					.num_results = batch_state->total_batch_rows,
 					.per_vector_mcxt = batch_state->per_batch_context,
 					.slot = decompress_state->csstate.ss.ss_ScanTupleSlot,
@@ -438,124 +621,240 @@ static VectorQualState *
 arrow_init_vector_quals(VectorAggState *agg_state, VectorAggDef *agg_def, TupleTableSlot *slot)
 {
 	vector_qual_state_init(&agg_state->vqual_state.vqstate, agg_def->filter_clauses, slot);
+	agg_state->vqual_state.vqstate.expression_states = agg_def->filter_expression_states;
 	return &agg_state->vqual_state.vqstate;
 }
 
-static TupleTableSlot *
-vector_agg_exec(CustomScanState *node)
+/*
+ * Start saving the input for the partitioned hash aggregation.
+ */
+static void
+vector_agg_spill_begin(VectorAggState *state)
 {
-	VectorAggState *vector_agg_state = (VectorAggState *) node;
-	ExprContext *econtext = node->ss.ps.ps_ExprContext;
-	ResetExprContext(econtext);
-
-	TupleTableSlot *aggregated_slot = vector_agg_state->custom.ss.ps.ps_ResultTupleSlot;
-	ExecClearTuple(aggregated_slot);
+	Assert(state->spill_enabled);
+	Assert(state->spill_store == NULL);
 
-	/*
-	 * If we have more partial aggregation results, continue returning them.
-	 */
-	GroupingPolicy *grouping = vector_agg_state->grouping;
-	MemoryContext old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
-	bool have_partial = grouping->gp_do_emit(grouping, aggregated_slot);
+	MemoryContext old_context = MemoryContextSwitchTo(state->custom.ss.ps.state->es_query_cxt);
+	state->spill_store = tuplestore_begin_heap(false, false, vector_agg_spill_store_kbytes());
 	MemoryContextSwitchTo(old_context);
-	if (have_partial)
-	{
-		/* The grouping policy produced a partial aggregation result. */
-		return ExecStoreVirtualTuple(aggregated_slot);
-	}
 
-	/*
-	 * If the partial aggregation results have ended, and the input has ended,
-	 * we're done.
-	 */
-	if (vector_agg_state->input_ended)
-	{
-		return NULL;
-	}
+	/* There is nothing to replay yet. */
+	state->spill_store_ended = true;
+	state->partition_bits = 0;
+	state->current_partition = 0;
+	state->stat_spill_passes = 1;
+}
 
-	/*
-	 * Have no more partial aggregation results and still have input, have to
-	 * reset the grouping policy and start a new cycle of partial aggregation.
-	 */
+/*
+ * Reset the grouping policy before aggregating the next portion of the input.
+ * When we aggregate the saved input by partitions, restrict the grouping policy
+ * to the current partition of grouping keys.
+ */
+static void
+vector_agg_reset_grouping(VectorAggState *state)
+{
+	GroupingPolicy *grouping = state->grouping;
 	grouping->gp_reset(grouping);
 
-	/*
-	 * Now we loop through the input compressed tuples, until they end or until
-	 * the grouping policy asks us to emit partials.
-	 */
-	while (!grouping->gp_should_emit(grouping))
+	if (state->spill_store != NULL)
+	{
+		grouping->gp_set_partition(grouping, state->partition_bits, state->current_partition);
+	}
+	else if (state->in_parallel_plan)
 	{
 		/*
-		 * Get the next slot to aggregate. It will be either a compressed
-		 * batch or an arrow tuple table slot. Both hold arrow arrays of data
-		 * that can be vectorized.
+		 * Don't emit the partial results early in a parallel plan. Aggregate
+		 * into a single partition of all grouping keys, which lets the
+		 * grouping policy use its entire share of work_mem. When it doesn't
+		 * fit, we start saving the input as usual.
 		 */
-		TupleTableSlot *slot = vector_agg_state->get_next_slot(vector_agg_state);
+		grouping->gp_set_partition(grouping, 0, 0);
+	}
+}
 
-		/*
-		 * Exit if there is no more data. Note that it is not possible to do
-		 * the standard TupIsNull() check here because the compressed batch's
-		 * implementation of TupleTableSlot never clears the empty flag bit
-		 * (TTS_EMPTY), so it will always look empty. Therefore, look at the
-		 * "input_ended" flag instead.
-		 */
-		if (vector_agg_state->input_ended)
-			break;
+/*
+ * Start a new pass over the saved input, for the current partition of grouping
+ * keys.
+ */
+static void
+vector_agg_start_pass(VectorAggState *state)
+{
+	tuplestore_rescan(state->spill_store);
+	state->spill_store_ended = false;
+	state->input_ended = false;
+	state->stat_spill_passes++;
+}
+
+/*
+ * After this many splits of the partitions of grouping keys, we stop splitting
+ * them and fall back to emitting the partial aggregation results.
+ */
+#define MAX_SPILL_PARTITION_BITS 10
+
+/*
+ * Called when the grouping policy asks to emit the partial results before the
+ * input has ended. Returns true if we have restarted the aggregation for a
+ * smaller partition of grouping keys, and false if we have to emit the partial
+ * results.
+ */
+static bool
+vector_agg_spill(VectorAggState *state)
+{
+	if (!state->spill_enabled)
+	{
+		return false;
+	}
 
+	if (state->spill_store == NULL)
+	{
 		/*
-		 * Compute the vectorized filters for the aggregate function FILTER
-		 * clauses.
+		 * The grouping policy has reached its limit for the first time. Emit
+		 * the partial results as usual, and start saving the input, so that
+		 * the rest of it can be aggregated using all of work_mem, possibly in
+		 * several passes.
 		 */
-		const int naggs = vector_agg_state->num_agg_defs;
-		for (int i = 0; i < naggs; i++)
-		{
-			VectorAggDef *agg_def = &vector_agg_state->agg_defs[i];
-			if (agg_def->filter_clauses == NIL)
-			{
-				continue;
-			}
-
-			VectorQualState *vqstate =
-				vector_agg_state->init_vector_quals(vector_agg_state, agg_def, slot);
-			vector_qual_compute(vqstate);
-			agg_def->filter_result = vqstate->vector_qual_result;
-		}
+		vector_agg_spill_begin(state);
+		return false;
+	}
 
+	if (state->partition_bits >= MAX_SPILL_PARTITION_BITS)
+	{
 		/*
-		 * Finally, pass the compressed batch to the grouping policy.
+		 * The grouping keys don't fit into work_mem even after many splits.
+		 * Emit the partial results for this partition, the final aggregation
+		 * will combine them.
 		 */
-		grouping->gp_add_batch(grouping, slot);
+		return false;
 	}
 
 	/*
-	 * If we have partial aggregation results, start returning them.
+	 * Split the current partition in two, and restart the aggregation of the
+	 * first half from the beginning of the saved input.
 	 */
-	old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
-	have_partial = grouping->gp_do_emit(grouping, aggregated_slot);
-	MemoryContextSwitchTo(old_context);
-	if (have_partial)
+	state->partition_bits++;
+	state->current_partition *= 2;
+	vector_agg_start_pass(state);
+	vector_agg_reset_grouping(state);
+	return true;
+}
+
+/*
+ * Called when the input of the current pass has ended and the results have
+ * been emitted. Returns true if we have started the aggregation of the next
+ * partition of grouping keys.
+ */
+static bool
+vector_agg_next_partition(VectorAggState *state)
+{
+	if (state->spill_store == NULL)
 	{
-		/* Have partial aggregation results. */
-		return ExecStoreVirtualTuple(aggregated_slot);
+		return false;
 	}
 
-	if (vector_agg_state->input_ended)
+	Assert(state->child_ended);
+	if (state->current_partition + 1 >= (((uint32) 1) << state->partition_bits))
+	{
+		return false;
+	}
+
+	state->current_partition++;
+	vector_agg_start_pass(state);
+	return true;
+}
+
+static TupleTableSlot *
+vector_agg_exec(CustomScanState *node)
+{
+	VectorAggState *vector_agg_state = (VectorAggState *) node;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	ResetExprContext(econtext);
+
+	TupleTableSlot *aggregated_slot = vector_agg_state->custom.ss.ps.ps_ResultTupleSlot;
+	ExecClearTuple(aggregated_slot);
+
+	GroupingPolicy *grouping = vector_agg_state->grouping;
+	for (;;)
 	{
 		/*
-		 * Have no partial aggregation results and the input has ended, so we're
-		 * done. We can get here only if we had no input at all, otherwise the
-		 * grouping policy would have produced some partials above.
+		 * If we have more partial aggregation results, continue returning them.
 		 */
-		return NULL;
-	}
+		MemoryContext old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		bool have_partial = grouping->gp_do_emit(grouping, aggregated_slot);
+		MemoryContextSwitchTo(old_context);
+		if (have_partial)
+		{
+			/* The grouping policy produced a partial aggregation result. */
+			return ExecStoreVirtualTuple(aggregated_slot);
+		}
 
-	/*
-	 * We cannot get here. This would mean we still have input, and the
-	 * grouping policy asked us to stop but couldn't produce any partials.
-	 */
-	Assert(false);
-	pg_unreachable();
-	return NULL;
+		/*
+		 * If the partial aggregation results have ended, and the input has
+		 * ended, we're done. The exception is when we aggregate the saved
+		 * input by partitions of grouping keys, and have more partitions to
+		 * go. This also covers the partitions that turned out to be empty.
+		 */
+		if (vector_agg_state->input_ended && !vector_agg_next_partition(vector_agg_state))
+		{
+			return NULL;
+		}
+
+		/*
+		 * Have no more partial aggregation results and still have input, have
+		 * to reset the grouping policy and start a new cycle of partial
+		 * aggregation.
+		 */
+		vector_agg_reset_grouping(vector_agg_state);
+
+		/*
+		 * Now we loop through the input compressed tuples, until they end or
+		 * until the grouping policy asks us to emit partials. In the latter
+		 * case, we might be able to continue by saving the input and
+		 * aggregating it by partitions of grouping keys instead.
+		 */
+		while (!grouping->gp_should_emit(grouping) || vector_agg_spill(vector_agg_state))
+		{
+			/*
+			 * Get the next slot to aggregate. It will be either a compressed
+			 * batch or an arrow tuple table slot. Both hold arrow arrays of
+			 * data that can be vectorized.
+			 */
+			TupleTableSlot *slot = vector_agg_state->get_next_slot(vector_agg_state);
+
+			/*
+			 * Exit if there is no more data. Note that it is not possible to
+			 * do the standard TupIsNull() check here because the compressed
+			 * batch's implementation of TupleTableSlot never clears the empty
+			 * flag bit (TTS_EMPTY), so it will always look empty. Therefore,
+			 * look at the "input_ended" flag instead.
+			 */
+			if (vector_agg_state->input_ended)
+				break;
+
+			/*
+			 * Compute the vectorized filters for the aggregate function FILTER
+			 * clauses.
+			 */
+			const int naggs = vector_agg_state->num_agg_defs;
+			for (int i = 0; i < naggs; i++)
+			{
+				VectorAggDef *agg_def = &vector_agg_state->agg_defs[i];
+				if (agg_def->filter_clauses == NIL)
+				{
+					continue;
+				}
+
+				VectorQualState *vqstate =
+					vector_agg_state->init_vector_quals(vector_agg_state, agg_def, slot);
+				vector_qual_compute(vqstate);
+				agg_def->filter_result = vqstate->vector_qual_result;
+			}
+
+			/*
+			 * Finally, pass the compressed batch to the grouping policy.
+			 */
+			grouping->gp_add_batch(grouping, slot);
+		}
+	}
 }
 
 static void
@@ -565,6 +864,18 @@ vector_agg_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	if (es->verbose || es->format != EXPLAIN_FORMAT_TEXT)
 	{
 		ExplainPropertyText("Grouping Policy", state->grouping->gp_explain(state->grouping), es);
+
+		if (state->use_batch_metadata)
+		{
+			ExplainPropertyBool("Batch Metadata Aggregation", true, es);
+		}
+	}
+
+	/* Like the batches of HashAggregate, these are shown without VERBOSE. */
+	if (es->analyze && state->spill_store != NULL)
+	{
+		ExplainPropertyInteger("Spill Partitions", NULL, ((int64) 1) << state->partition_bits, es);
+		ExplainPropertyInteger("Spill Passes", NULL, state->stat_spill_passes, es);
 	}
 }
 
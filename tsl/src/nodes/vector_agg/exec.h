@@ -10,17 +10,53 @@
 
 #include "nodes/decompress_chunk/compressed_batch.h"
 #include <nodes/execnodes.h>
+#include <utils/tuplestore.h>
 
 #include "function/functions.h"
 #include "grouping_policy.h"
+#include "vector_time_bucket.h"
 
 typedef struct VectorAggDef
 {
 	VectorAggFunctions func;
 	int input_offset;
+
+	/*
+	 * The second argument of the two-argument functions like first(value, time),
+	 * -1 otherwise or when it is a constant. We also need the argument types for
+	 * these functions.
+	 */
+	int input_offset2;
+	Oid argtypes[2];
+
+	/*
+	 * The constant second argument, like the fraction in
+	 * approximate_percentile(value, 0.99), presented as a scalar column.
+	 */
+	CompressedColumnValues const_arg2;
+	Datum const_arg2_value;
+	bool const_arg2_isnull;
+
 	int output_offset;
 	List *filter_clauses;
+	List *filter_expression_states;
 	uint64 *filter_result;
+
+	/*
+	 * For min() and max() that can be computed from the batch min/max metadata,
+	 * the attribute number of the metadata column in the compressed scan tuple,
+	 * InvalidAttrNumber otherwise.
+	 */
+	AttrNumber metadata_attno;
+
+	/*
+	 * The metadata value of the current batch, as a scalar column value, if
+	 * the batch is aggregated using the metadata. The decompression type is
+	 * DT_Invalid otherwise, and the aggregated column is used as usual.
+	 */
+	CompressedColumnValues metadata_values;
+	Datum metadata_value;
+	bool metadata_isnull;
 } VectorAggDef;
 
 typedef struct GroupingColumn
@@ -30,6 +66,12 @@ typedef struct GroupingColumn
 
 	int16 value_bytes;
 	bool by_value;
+
+	/*
+	 * If the grouping column is a time_bucket() expression over the input
+	 * column, this is the state of its vectorized computation, otherwise NULL.
+	 */
+	VectorTimeBucket *time_bucket;
 } GroupingColumn;
 
 typedef struct VectorAggState
@@ -51,6 +93,34 @@ typedef struct VectorAggState
 
 	GroupingPolicy *grouping;
 
+	/*
+	 * Spilling of the input for the hash grouping with high cardinality. After
+	 * the grouping policy first asks to emit partial results, we also save the
+	 * compressed tuples read from the child node into a tuplestore. When the
+	 * hash table outgrows its share of work_mem, we replay the saved input,
+	 * aggregating the grouping keys by hash partitions, one partition per
+	 * pass. The "child_ended" flag tracks the end of the child node input, and the
+	 * "input_ended" flag is the end of the current pass in this case. In
+	 * parallel plans, the grouping policy uses its entire share of work_mem
+	 * before we start saving the input, so that the partial results are not
+	 * emitted early.
+	 */
+	bool spill_enabled;
+	bool in_parallel_plan;
+	Tuplestorestate *spill_store;
+	TupleTableSlot *spill_slot;
+	bool spill_store_ended;
+	bool child_ended;
+	int partition_bits;
+	uint32 current_partition;
+	int stat_spill_passes;
+
+	/*
+	 * Whether the compressed batches where all rows pass the vectorized quals
+	 * are aggregated using their metadata, without decompression.
+	 */
+	bool use_batch_metadata;
+
 	/*
 	 * State to compute vector quals for FILTER clauses.
 	 */
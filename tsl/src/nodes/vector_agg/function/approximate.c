@@ -0,0 +1,574 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized implementation of the approximate aggregates
+ * approximate_count_distinct(value) and approximate_percentile(value, fraction).
+ * The partial results are the serialized sketches in the same format as the
+ * row-by-row implementation, so that they can be combined with each other.
+ */
+
+#include <postgres.h>
+
+#include <catalog/pg_type.h>
+#include <common/hashfn.h>
+#include <nodes/value.h>
+#include <parser/parse_func.h>
+#include <utils/float.h>
+
+#include "ddsketch.h"
+#include "extension.h"
+#include "functions.h"
+#include "hyperloglog.h"
+
+/*
+ * The vectorized approximate_count_distinct() must compute the same hashes as
+ * the extended hash functions used by the row-by-row implementation, so we
+ * have a specialization for every group of types that use the same hash
+ * function.
+ */
+typedef enum HllHashKind
+{
+	HLL_HASH_INT2,
+	HLL_HASH_INT4,
+	HLL_HASH_INT8,
+	HLL_HASH_FLOAT4,
+	HLL_HASH_FLOAT8,
+	HLL_HASH_TEXT,
+} HllHashKind;
+
+/* Same as hashint4extended() with zero seed. */
+static pg_attribute_always_inline uint64
+hll_hash_int4(int32 value)
+{
+	return hash_bytes_uint32_extended((uint32) value, 0);
+}
+
+/* Same as hashint8extended() with zero seed. */
+static pg_attribute_always_inline uint64
+hll_hash_int8(int64 value)
+{
+	uint32 lohalf = (uint32) value;
+	const uint32 hihalf = (uint32) (value >> 32);
+	lohalf ^= (value >= 0) ? hihalf : ~hihalf;
+	return hash_bytes_uint32_extended(lohalf, 0);
+}
+
+/* Same as hashfloat8extended() with zero seed. */
+static pg_attribute_always_inline uint64
+hll_hash_float8(float8 value)
+{
+	if (value == (float8) 0)
+	{
+		return 0;
+	}
+
+	if (isnan(value))
+	{
+		value = get_float8_nan();
+	}
+
+	return hash_bytes_extended((const unsigned char *) &value, sizeof(value), 0);
+}
+
+/*
+ * Same as hashtextextended() with zero seed for a deterministic collation,
+ * which is checked at planning time.
+ */
+static pg_attribute_always_inline uint64
+hll_hash_bytes(const uint8 *data, int len)
+{
+	return hash_bytes_extended(data, len, 0);
+}
+
+static uint64
+hll_hash_datum(Datum value, HllHashKind kind)
+{
+	switch (kind)
+	{
+		case HLL_HASH_INT2:
+			return hll_hash_int4(DatumGetInt16(value));
+		case HLL_HASH_INT4:
+			return hll_hash_int4(DatumGetInt32(value));
+		case HLL_HASH_INT8:
+			return hll_hash_int8(DatumGetInt64(value));
+		case HLL_HASH_FLOAT4:
+			return hll_hash_float8(DatumGetFloat4(value));
+		case HLL_HASH_FLOAT8:
+			return hll_hash_float8(DatumGetFloat8(value));
+		case HLL_HASH_TEXT:
+		{
+			const text *t = DatumGetTextPP(value);
+			return hll_hash_bytes((const uint8 *) VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+		}
+	}
+	pg_unreachable();
+}
+
+static pg_attribute_always_inline uint64
+hll_hash_text_row(const ArrowArray *vector, int row)
+{
+	const uint32 start = ((const uint32 *) vector->buffers[1])[row];
+	const int32 value_bytes = ((const uint32 *) vector->buffers[1])[row + 1] - start;
+	return hll_hash_bytes(&((const uint8 *) vector->buffers[2])[start], value_bytes);
+}
+
+/*
+ * Hash the value in the given row of an arrow array. For dictionary-encoded
+ * text, the hashes of the dictionary entries are computed in advance.
+ */
+static pg_attribute_always_inline uint64
+hll_hash_row(const ArrowArray *vector, const uint64 *dict_hashes, int row, HllHashKind kind)
+{
+	switch (kind)
+	{
+		case HLL_HASH_INT2:
+			return hll_hash_int4(((const int16 *) vector->buffers[1])[row]);
+		case HLL_HASH_INT4:
+			return hll_hash_int4(((const int32 *) vector->buffers[1])[row]);
+		case HLL_HASH_INT8:
+			return hll_hash_int8(((const int64 *) vector->buffers[1])[row]);
+		case HLL_HASH_FLOAT4:
+			return hll_hash_float8(((const float4 *) vector->buffers[1])[row]);
+		case HLL_HASH_FLOAT8:
+			return hll_hash_float8(((const float8 *) vector->buffers[1])[row]);
+		case HLL_HASH_TEXT:
+			if (dict_hashes != NULL)
+			{
+				return dict_hashes[((const int16 *) vector->buffers[1])[row]];
+			}
+			return hll_hash_text_row(vector, row);
+	}
+	pg_unreachable();
+}
+
+static uint64 *
+hll_hash_dictionary(const ArrowArray *vector, HllHashKind kind)
+{
+	if (kind != HLL_HASH_TEXT || vector->dictionary == NULL)
+	{
+		return NULL;
+	}
+
+	const ArrowArray *dict = vector->dictionary;
+	uint64 *dict_hashes = palloc(sizeof(*dict_hashes) * dict->length);
+	for (int i = 0; i < dict->length; i++)
+	{
+		dict_hashes[i] = hll_hash_text_row(dict, i);
+	}
+	return dict_hashes;
+}
+
+typedef struct
+{
+	/* The registers are allocated when we see the first not null value. */
+	uint8 *registers;
+} HllState;
+
+static void
+hll_init(void *restrict agg_states, int n)
+{
+	HllState *states = (HllState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		states[i].registers = NULL;
+	}
+}
+
+static pg_attribute_always_inline uint8 *
+hll_get_registers(HllState *state, MemoryContext agg_extra_mctx)
+{
+	if (unlikely(state->registers == NULL))
+	{
+		state->registers = MemoryContextAllocZero(agg_extra_mctx, TS_HLL_NUM_REGISTERS);
+	}
+	return state->registers;
+}
+
+static pg_attribute_always_inline void
+hll_vector_impl(HllState *state, const ArrowArray *vector, const uint64 *filter,
+				MemoryContext agg_extra_mctx, HllHashKind kind)
+{
+	uint64 *dict_hashes = hll_hash_dictionary(vector, kind);
+	const int n = vector->length;
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		ts_hll_add_hash(hll_get_registers(state, agg_extra_mctx),
+						hll_hash_row(vector, dict_hashes, row, kind));
+	}
+
+	if (dict_hashes != NULL)
+	{
+		pfree(dict_hashes);
+	}
+}
+
+static pg_attribute_always_inline void
+hll_many_vector_impl(HllState *states, const uint32 *offsets, const uint64 *filter, int start_row,
+					 int end_row, const ArrowArray *vector, MemoryContext agg_extra_mctx,
+					 HllHashKind kind)
+{
+	uint64 *dict_hashes = hll_hash_dictionary(vector, kind);
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		Assert(offsets[row] != 0);
+		HllState *state = &states[offsets[row]];
+		ts_hll_add_hash(hll_get_registers(state, agg_extra_mctx),
+						hll_hash_row(vector, dict_hashes, row, kind));
+	}
+
+	if (dict_hashes != NULL)
+	{
+		pfree(dict_hashes);
+	}
+}
+
+static pg_attribute_always_inline void
+hll_scalar_impl(HllState *state, Datum constvalue, bool constisnull, int n,
+				MemoryContext agg_extra_mctx, HllHashKind kind)
+{
+	if (constisnull || n == 0)
+	{
+		return;
+	}
+
+	/* The same value repeated doesn't change the sketch. */
+	ts_hll_add_hash(hll_get_registers(state, agg_extra_mctx), hll_hash_datum(constvalue, kind));
+}
+
+static pg_attribute_always_inline void
+hll_many_scalar_impl(HllState *states, const uint32 *offsets, const uint64 *filter, int start_row,
+					 int end_row, Datum constvalue, bool constisnull, MemoryContext agg_extra_mctx,
+					 HllHashKind kind)
+{
+	if (constisnull)
+	{
+		return;
+	}
+
+	const uint64 hash = hll_hash_datum(constvalue, kind);
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		Assert(offsets[row] != 0);
+		HllState *state = &states[offsets[row]];
+		ts_hll_add_hash(hll_get_registers(state, agg_extra_mctx), hash);
+	}
+}
+
+static void
+hll_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	HllState *state = (HllState *) agg_state;
+
+	if (state->registers == NULL)
+	{
+		*out_result = 0;
+		*out_isnull = true;
+		return;
+	}
+
+	*out_result = PointerGetDatum(ts_hll_serialize(state->registers));
+	*out_isnull = false;
+}
+
+#define HLL_FUNCTIONS(NAME, KIND)                                                                  \
+	static void NAME##_vector(void *restrict agg_state,                                            \
+							  const ArrowArray *vector,                                            \
+							  const uint64 *filter,                                                \
+							  MemoryContext agg_extra_mctx)                                        \
+	{                                                                                              \
+		hll_vector_impl((HllState *) agg_state, vector, filter, agg_extra_mctx, KIND);             \
+	}                                                                                              \
+                                                                                                   \
+	static void NAME##_scalar(void *restrict agg_state,                                            \
+							  Datum constvalue,                                                    \
+							  bool constisnull,                                                    \
+							  int n,                                                               \
+							  MemoryContext agg_extra_mctx)                                        \
+	{                                                                                              \
+		hll_scalar_impl((HllState *) agg_state, constvalue, constisnull, n, agg_extra_mctx, KIND); \
+	}                                                                                              \
+                                                                                                   \
+	static void NAME##_many_vector(void *restrict agg_states,                                      \
+								   const uint32 *offsets,                                          \
+								   const uint64 *filter,                                           \
+								   int start_row,                                                  \
+								   int end_row,                                                    \
+								   const ArrowArray *vector,                                       \
+								   MemoryContext agg_extra_mctx)                                   \
+	{                                                                                              \
+		hll_many_vector_impl((HllState *) agg_states,                                              \
+							 offsets,                                                              \
+							 filter,                                                               \
+							 start_row,                                                            \
+							 end_row,                                                              \
+							 vector,                                                               \
+							 agg_extra_mctx,                                                       \
+							 KIND);                                                                \
+	}                                                                                              \
+                                                                                                   \
+	static void NAME##_many_scalar(void *restrict agg_states,                                      \
+								   const uint32 *offsets,                                          \
+								   const uint64 *filter,                                           \
+								   int start_row,                                                  \
+								   int end_row,                                                    \
+								   Datum constvalue,                                               \
+								   bool constisnull,                                               \
+								   MemoryContext agg_extra_mctx)                                   \
+	{                                                                                              \
+		hll_many_scalar_impl((HllState *) agg_states,                                              \
+							 offsets,                                                              \
+							 filter,                                                               \
+							 start_row,                                                            \
+							 end_row,                                                              \
+							 constvalue,                                                           \
+							 constisnull,                                                          \
+							 agg_extra_mctx,                                                       \
+							 KIND);                                                                \
+	}                                                                                              \
+                                                                                                   \
+	static VectorAggFunctions NAME##_agg = {                                                       \
+		.state_bytes = sizeof(HllState),                                                           \
+		.agg_init = hll_init,                                                                      \
+		.agg_emit = hll_emit,                                                                      \
+		.agg_vector = NAME##_vector,                                                               \
+		.agg_scalar = NAME##_scalar,                                                               \
+		.agg_many_vector = NAME##_many_vector,                                                     \
+		.agg_many_scalar = NAME##_many_scalar,                                                     \
+	};
+
+HLL_FUNCTIONS(hll_int2, HLL_HASH_INT2)
+HLL_FUNCTIONS(hll_int4, HLL_HASH_INT4)
+HLL_FUNCTIONS(hll_int8, HLL_HASH_INT8)
+HLL_FUNCTIONS(hll_float4, HLL_HASH_FLOAT4)
+HLL_FUNCTIONS(hll_float8, HLL_HASH_FLOAT8)
+HLL_FUNCTIONS(hll_text, HLL_HASH_TEXT)
+
+/*
+ * approximate_percentile(value, fraction) with a constant fraction, which is
+ * passed as the scalar second argument.
+ */
+typedef struct
+{
+	DDSketch sketch;
+} PercentileState;
+
+static void
+percentile_init(void *restrict agg_states, int n)
+{
+	PercentileState *states = (PercentileState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		ts_ddsketch_init(&states[i].sketch, 0);
+	}
+}
+
+static pg_attribute_always_inline void
+percentile_add_row(PercentileState *state, const CompressedColumnValues *value, double fraction,
+				   int row)
+{
+	/* The fraction is a constant, so it is the same for all rows. */
+	state->sketch.fraction = fraction;
+
+	if (value->decompression_type == DT_Scalar)
+	{
+		if (!*value->output_isnull)
+		{
+			ts_ddsketch_add(&state->sketch, DatumGetFloat8(*value->output_value));
+		}
+		return;
+	}
+
+	if (arrow_row_is_valid(value->buffers[0], row))
+	{
+		ts_ddsketch_add(&state->sketch, ((const float8 *) value->buffers[1])[row]);
+	}
+}
+
+static double
+percentile_get_fraction(const CompressedColumnValues *fraction)
+{
+	/* The rows with null second argument are already excluded. */
+	Assert(fraction->decompression_type == DT_Scalar);
+	Assert(!*fraction->output_isnull);
+	return DatumGetFloat8(*fraction->output_value);
+}
+
+static void
+percentile_vector(void *restrict agg_state, const CompressedColumnValues *value,
+				  const CompressedColumnValues *fraction_arg, const Oid *argtypes,
+				  const uint64 *filter, int n, MemoryContext agg_extra_mctx)
+{
+	PercentileState *state = (PercentileState *) agg_state;
+	const double fraction = percentile_get_fraction(fraction_arg);
+
+	MemoryContext old = MemoryContextSwitchTo(agg_extra_mctx);
+	for (int row = 0; row < n; row++)
+	{
+		if (arrow_row_is_valid(filter, row))
+		{
+			percentile_add_row(state, value, fraction, row);
+		}
+	}
+	MemoryContextSwitchTo(old);
+}
+
+static void
+percentile_many_vector(void *restrict agg_states, const uint32 *offsets, const uint64 *filter,
+					   int start_row, int end_row, const CompressedColumnValues *value,
+					   const CompressedColumnValues *fraction_arg, const Oid *argtypes,
+					   MemoryContext agg_extra_mctx)
+{
+	PercentileState *states = (PercentileState *) agg_states;
+	const double fraction = percentile_get_fraction(fraction_arg);
+
+	MemoryContext old = MemoryContextSwitchTo(agg_extra_mctx);
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (arrow_row_is_valid(filter, row))
+		{
+			Assert(offsets[row] != 0);
+			percentile_add_row(&states[offsets[row]], value, fraction, row);
+		}
+	}
+	MemoryContextSwitchTo(old);
+}
+
+static void
+percentile_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	PercentileState *state = (PercentileState *) agg_state;
+
+	if (state->sketch.count == 0)
+	{
+		*out_result = 0;
+		*out_isnull = true;
+		return;
+	}
+
+	*out_result = PointerGetDatum(ts_ddsketch_serialize(&state->sketch));
+	*out_isnull = false;
+}
+
+static VectorAggFunctions percentile_agg = {
+	.state_bytes = sizeof(PercentileState),
+	.agg_init = percentile_init,
+	.agg_emit = percentile_emit,
+	.agg_vector2 = percentile_vector,
+	.agg_many_vector2 = percentile_many_vector,
+};
+
+static Oid count_distinct_arg_types[] = { ANYELEMENTOID };
+static Oid percentile_arg_types[] = { FLOAT8OID, FLOAT8OID };
+
+static Oid
+lookup_approximate(const char *name, int nargs, Oid *argtypes)
+{
+	List *l = list_make2(makeString(ts_extension_schema_name()), makeString(pstrdup(name)));
+	return LookupFuncName(l, nargs, argtypes, false);
+}
+
+static Oid
+get_percentile_oid(void)
+{
+	static Oid percentile_oid = InvalidOid;
+
+	if (!OidIsValid(percentile_oid))
+	{
+		percentile_oid = lookup_approximate("approximate_percentile",
+											lengthof(percentile_arg_types),
+											percentile_arg_types);
+	}
+
+	return percentile_oid;
+}
+
+/*
+ * Return the vectorized implementation of approximate_count_distinct() for the
+ * given argument type, or of approximate_percentile(), if the given aggregate
+ * function Oid is one of them.
+ */
+VectorAggFunctions *
+get_vector_approximate_aggregate(Oid aggfnoid, Oid argtype)
+{
+	static Oid count_distinct_oid = InvalidOid;
+
+	if (!OidIsValid(count_distinct_oid))
+	{
+		count_distinct_oid = lookup_approximate("approximate_count_distinct",
+												lengthof(count_distinct_arg_types),
+												count_distinct_arg_types);
+	}
+
+	if (aggfnoid == get_percentile_oid())
+	{
+		return &percentile_agg;
+	}
+
+	if (aggfnoid != count_distinct_oid)
+	{
+		return NULL;
+	}
+
+	switch (argtype)
+	{
+		case INT2OID:
+			return &hll_int2_agg;
+		case INT4OID:
+		case DATEOID:
+			return &hll_int4_agg;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return &hll_int8_agg;
+		case FLOAT4OID:
+			return &hll_float4_agg;
+		case FLOAT8OID:
+			return &hll_float8_agg;
+		case TEXTOID:
+			return &hll_text_agg;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Whether the vectorized approximate_percentile() supports the given fraction
+ * argument. It must be a not null constant in the valid range, otherwise the
+ * row-by-row implementation reports the error.
+ */
+bool
+vector_approximate_percentile_fraction_supported(Oid aggfnoid, const Node *fraction)
+{
+	if (aggfnoid != get_percentile_oid() || !IsA(fraction, Const))
+	{
+		return false;
+	}
+
+	const Const *c = (const Const *) fraction;
+	if (c->constisnull)
+	{
+		return false;
+	}
+
+	const double value = DatumGetFloat8(c->constvalue);
+	return value >= 0 && value <= 1;
+}
@@ -0,0 +1,537 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized implementation of the bookend aggregates first(value, cmp) and
+ * last(value, cmp), for a fixed-size by-value or text value and an integer-like
+ * comparison element, e.g. a timestamp.
+ */
+
+#include <postgres.h>
+
+#include <catalog/pg_type.h>
+#include <nodes/value.h>
+#include <parser/parse_func.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+
+#include "agg_bookend.h"
+#include "extension.h"
+#include "functions.h"
+
+typedef struct
+{
+	/* The best comparison element seen so far. */
+	int64 cmp;
+
+	/*
+	 * The value from the row with the best comparison element. Text values
+	 * are copied into the aggregate function extra memory context.
+	 */
+	Datum value;
+
+	/* Types of the arguments, required to serialize the partial result. */
+	Oid value_type;
+	Oid cmp_type;
+
+	/* Whether we have seen any row with not null comparison element. */
+	bool have_cmp;
+	bool value_isnull;
+
+	/*
+	 * The batch row with the best comparison element when we have found it,
+	 * but haven't copied the value yet. See first_last_store_pending().
+	 */
+	int16 pending_row;
+} FirstLastState;
+
+static void
+first_last_init(void *restrict agg_states, int n)
+{
+	FirstLastState *states = (FirstLastState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		states[i].cmp = 0;
+		states[i].value = 0;
+		states[i].value_type = InvalidOid;
+		states[i].cmp_type = InvalidOid;
+		states[i].have_cmp = false;
+		states[i].value_isnull = true;
+		states[i].pending_row = -1;
+	}
+}
+
+/*
+ * All supported comparison element types are integers of different width, so
+ * we compare them as int64.
+ */
+static int64
+first_last_cmp_from_datum(Datum datum, Oid cmp_type)
+{
+	switch (cmp_type)
+	{
+		case INT2OID:
+			return DatumGetInt16(datum);
+		case INT4OID:
+		case DATEOID:
+			return DatumGetInt32(datum);
+		default:
+			Assert(cmp_type == INT8OID || cmp_type == TIMESTAMPOID || cmp_type == TIMESTAMPTZOID);
+			return DatumGetInt64(datum);
+	}
+}
+
+static Datum
+first_last_cmp_to_datum(int64 cmp, Oid cmp_type)
+{
+	switch (cmp_type)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) cmp);
+		case INT4OID:
+		case DATEOID:
+			return Int32GetDatum((int32) cmp);
+		default:
+			Assert(cmp_type == INT8OID || cmp_type == TIMESTAMPOID || cmp_type == TIMESTAMPTZOID);
+			return Int64GetDatum(cmp);
+	}
+}
+
+static pg_attribute_always_inline int64
+first_last_get_cmp(const CompressedColumnValues *cmp, int cmp_bytes, int64 scalar_cmp, int row)
+{
+	switch (cmp_bytes)
+	{
+		case 2:
+			return ((const int16 *) cmp->buffers[1])[row];
+		case 4:
+			return ((const int32 *) cmp->buffers[1])[row];
+		case 8:
+			return ((const int64 *) cmp->buffers[1])[row];
+		default:
+			Assert(cmp_bytes == 0);
+			return scalar_cmp;
+	}
+}
+
+static pg_attribute_always_inline bool
+first_last_is_better(bool is_last, int64 new_cmp, int64 current_cmp)
+{
+	/*
+	 * The comparison is strict, so that the earliest row wins between the
+	 * rows with equal comparison elements, same as in the row-by-row
+	 * implementation.
+	 */
+	return is_last ? new_cmp > current_cmp : new_cmp < current_cmp;
+}
+
+/*
+ * Copy the value from the given batch row into the aggregate state.
+ */
+static void
+first_last_store_value(FirstLastState *state, const CompressedColumnValues *value, int row,
+					   MemoryContext agg_extra_mctx)
+{
+	const bool is_text = state->value_type == TEXTOID;
+
+	if (is_text && !state->value_isnull)
+	{
+		pfree(DatumGetPointer(state->value));
+	}
+
+	state->value = 0;
+	state->value_isnull = true;
+
+	if (value->decompression_type == DT_Scalar)
+	{
+		if (*value->output_isnull)
+		{
+			return;
+		}
+
+		if (is_text)
+		{
+			MemoryContext old = MemoryContextSwitchTo(agg_extra_mctx);
+			state->value = datumCopy(*value->output_value, /* typByVal = */ false, -1);
+			MemoryContextSwitchTo(old);
+		}
+		else
+		{
+			state->value = *value->output_value;
+		}
+		state->value_isnull = false;
+		return;
+	}
+
+	if (!arrow_row_is_valid(value->buffers[0], row))
+	{
+		return;
+	}
+
+	switch ((int) value->decompression_type)
+	{
+		case 2:
+			state->value = Int16GetDatum(((const int16 *) value->buffers[1])[row]);
+			break;
+		case 4:
+			state->value = Int32GetDatum(((const int32 *) value->buffers[1])[row]);
+			break;
+		case 8:
+			state->value = Int64GetDatum(((const int64 *) value->buffers[1])[row]);
+			break;
+		case DT_ArrowText:
+		case DT_ArrowTextDict:
+		{
+			const int index = value->decompression_type == DT_ArrowTextDict ?
+								  ((const int16 *) value->buffers[3])[row] :
+								  row;
+			const uint32 start = ((const uint32 *) value->buffers[1])[index];
+			const int32 value_bytes = ((const uint32 *) value->buffers[1])[index + 1] - start;
+
+			text *copy = MemoryContextAlloc(agg_extra_mctx, VARHDRSZ + value_bytes);
+			SET_VARSIZE(copy, VARHDRSZ + value_bytes);
+			memcpy(VARDATA(copy), &((const char *) value->buffers[2])[start], value_bytes);
+			state->value = PointerGetDatum(copy);
+			break;
+		}
+		default:
+			elog(ERROR,
+				 "unexpected decompression type %d for first()/last() value",
+				 (int) value->decompression_type);
+			pg_unreachable();
+	}
+	state->value_isnull = false;
+}
+
+static void
+first_last_update_state(FirstLastState *state, int64 cmp, const Oid *argtypes)
+{
+	if (!state->have_cmp)
+	{
+		state->have_cmp = true;
+		state->value_type = argtypes[0];
+		state->cmp_type = argtypes[1];
+	}
+	state->cmp = cmp;
+}
+
+static pg_attribute_always_inline void
+first_last_vector_impl(FirstLastState *state, const CompressedColumnValues *value,
+					   const CompressedColumnValues *cmp, const Oid *argtypes,
+					   const uint64 *filter, int n, MemoryContext agg_extra_mctx, bool is_last,
+					   int cmp_bytes)
+{
+	const int64 scalar_cmp =
+		cmp_bytes == 0 ? first_last_cmp_from_datum(*cmp->output_value, argtypes[1]) : 0;
+
+	/*
+	 * First, find the best row in the batch, so that we have to copy only one
+	 * value.
+	 */
+	int best_row = -1;
+	int64 best_cmp = 0;
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		const int64 new_cmp = first_last_get_cmp(cmp, cmp_bytes, scalar_cmp, row);
+		if (best_row < 0 || first_last_is_better(is_last, new_cmp, best_cmp))
+		{
+			best_row = row;
+			best_cmp = new_cmp;
+		}
+	}
+
+	if (best_row < 0)
+	{
+		return;
+	}
+
+	if (state->have_cmp && !first_last_is_better(is_last, best_cmp, state->cmp))
+	{
+		return;
+	}
+
+	first_last_update_state(state, best_cmp, argtypes);
+	first_last_store_value(state, value, best_row, agg_extra_mctx);
+}
+
+/*
+ * Copy the values for the states that have found a better row in the given
+ * range of rows. We do this in a separate pass, so that the text values are
+ * copied at most once per state for the given range, even when the comparison
+ * element increases monotonically.
+ */
+static void
+first_last_store_pending(FirstLastState *states, const uint32 *offsets, const uint64 *filter,
+						 int start_row, int end_row, const CompressedColumnValues *value,
+						 MemoryContext agg_extra_mctx)
+{
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		FirstLastState *state = &states[offsets[row]];
+		if (state->pending_row != row)
+		{
+			continue;
+		}
+
+		first_last_store_value(state, value, row, agg_extra_mctx);
+		state->pending_row = -1;
+	}
+}
+
+static pg_attribute_always_inline void
+first_last_many_vector_impl(FirstLastState *states, const uint32 *offsets, const uint64 *filter,
+							int start_row, int end_row, const CompressedColumnValues *value,
+							const CompressedColumnValues *cmp, const Oid *argtypes,
+							MemoryContext agg_extra_mctx, bool is_last, int cmp_bytes)
+{
+	const int64 scalar_cmp =
+		cmp_bytes == 0 ? first_last_cmp_from_datum(*cmp->output_value, argtypes[1]) : 0;
+
+	bool have_pending = false;
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		const int64 new_cmp = first_last_get_cmp(cmp, cmp_bytes, scalar_cmp, row);
+		FirstLastState *state = &states[offsets[row]];
+		if (state->have_cmp && !first_last_is_better(is_last, new_cmp, state->cmp))
+		{
+			continue;
+		}
+
+		first_last_update_state(state, new_cmp, argtypes);
+		state->pending_row = row;
+		have_pending = true;
+	}
+
+	if (have_pending)
+	{
+		first_last_store_pending(states,
+								 offsets,
+								 filter,
+								 start_row,
+								 end_row,
+								 value,
+								 agg_extra_mctx);
+	}
+}
+
+/*
+ * Get the width of the comparison element in the arrow array, or zero if it
+ * is a scalar.
+ */
+static int
+first_last_cmp_bytes(const CompressedColumnValues *cmp)
+{
+	if (cmp->decompression_type == DT_Scalar)
+	{
+		/* The rows with null comparison element are filtered out. */
+		Assert(!*cmp->output_isnull);
+		return 0;
+	}
+
+	Ensure(cmp->decompression_type == 2 || cmp->decompression_type == 4 ||
+			   cmp->decompression_type == 8,
+		   "unexpected decompression type %d for first()/last() comparison element",
+		   (int) cmp->decompression_type);
+
+	return cmp->decompression_type;
+}
+
+/*
+ * Generate the specializations for the fixed width of the comparison element.
+ */
+#define FIRST_LAST_DISPATCH(FUNC, IS_LAST, CMP_BYTES, ...)                                         \
+	switch (CMP_BYTES)                                                                             \
+	{                                                                                              \
+		case 2:                                                                                    \
+			FUNC(__VA_ARGS__, IS_LAST, 2);                                                         \
+			break;                                                                                 \
+		case 4:                                                                                    \
+			FUNC(__VA_ARGS__, IS_LAST, 4);                                                         \
+			break;                                                                                 \
+		case 8:                                                                                    \
+			FUNC(__VA_ARGS__, IS_LAST, 8);                                                         \
+			break;                                                                                 \
+		default:                                                                                   \
+			FUNC(__VA_ARGS__, IS_LAST, 0);                                                         \
+			break;                                                                                 \
+	}
+
+#define FIRST_LAST_FUNCTIONS(NAME, IS_LAST)                                                        \
+	static void NAME##_vector(void *restrict agg_state,                                            \
+							  const CompressedColumnValues *value,                                 \
+							  const CompressedColumnValues *cmp,                                   \
+							  const Oid *argtypes,                                                 \
+							  const uint64 *filter,                                                \
+							  int n,                                                               \
+							  MemoryContext agg_extra_mctx)                                        \
+	{                                                                                              \
+		FIRST_LAST_DISPATCH(first_last_vector_impl,                                                \
+							IS_LAST,                                                               \
+							first_last_cmp_bytes(cmp),                                             \
+							(FirstLastState *) agg_state,                                          \
+							value,                                                                 \
+							cmp,                                                                   \
+							argtypes,                                                              \
+							filter,                                                                \
+							n,                                                                     \
+							agg_extra_mctx)                                                        \
+	}                                                                                              \
+                                                                                                   \
+	static void NAME##_many_vector(void *restrict agg_states,                                      \
+								   const uint32 *offsets,                                          \
+								   const uint64 *filter,                                           \
+								   int start_row,                                                  \
+								   int end_row,                                                    \
+								   const CompressedColumnValues *value,                            \
+								   const CompressedColumnValues *cmp,                              \
+								   const Oid *argtypes,                                            \
+								   MemoryContext agg_extra_mctx)                                   \
+	{                                                                                              \
+		FIRST_LAST_DISPATCH(first_last_many_vector_impl,                                           \
+							IS_LAST,                                                               \
+							first_last_cmp_bytes(cmp),                                             \
+							(FirstLastState *) agg_states,                                         \
+							offsets,                                                               \
+							filter,                                                                \
+							start_row,                                                             \
+							end_row,                                                               \
+							value,                                                                 \
+							cmp,                                                                   \
+							argtypes,                                                              \
+							agg_extra_mctx)                                                        \
+	}
+
+FIRST_LAST_FUNCTIONS(first, false)
+FIRST_LAST_FUNCTIONS(last, true)
+
+/*
+ * The partial result is the serialized state of the bookend aggregate.
+ */
+static void
+first_last_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	FirstLastState *state = (FirstLastState *) agg_state;
+
+	if (!state->have_cmp)
+	{
+		*out_result = 0;
+		*out_isnull = true;
+		return;
+	}
+
+	Assert(state->pending_row == -1);
+
+	bytea *result = ts_bookend_serialize_values(state->value_type,
+												state->value,
+												state->value_isnull,
+												state->cmp_type,
+												first_last_cmp_to_datum(state->cmp,
+																		state->cmp_type),
+												/* cmp_isnull = */ false);
+	*out_result = PointerGetDatum(result);
+	*out_isnull = false;
+}
+
+static VectorAggFunctions first_agg = {
+	.state_bytes = sizeof(FirstLastState),
+	.agg_init = first_last_init,
+	.agg_emit = first_last_emit,
+	.agg_vector2 = first_vector,
+	.agg_many_vector2 = first_many_vector,
+};
+
+static VectorAggFunctions last_agg = {
+	.state_bytes = sizeof(FirstLastState),
+	.agg_init = first_last_init,
+	.agg_emit = first_last_emit,
+	.agg_vector2 = last_vector,
+	.agg_many_vector2 = last_many_vector,
+};
+
+static Oid first_last_arg_types[] = { ANYELEMENTOID, ANYOID };
+
+static Oid
+lookup_first_last(const char *name)
+{
+	List *l = list_make2(makeString(ts_extension_schema_name()), makeString(pstrdup(name)));
+	return LookupFuncName(l, lengthof(first_last_arg_types), first_last_arg_types, false);
+}
+
+/*
+ * Return the vectorized implementation of first() or last() if the given
+ * aggregate function Oid is one of them.
+ */
+VectorAggFunctions *
+get_vector_first_last_aggregate(Oid aggfnoid)
+{
+	static Oid first_oid = InvalidOid;
+	static Oid last_oid = InvalidOid;
+
+	if (!OidIsValid(first_oid))
+	{
+		first_oid = lookup_first_last("first");
+		last_oid = lookup_first_last("last");
+	}
+
+	if (aggfnoid == first_oid)
+	{
+		return &first_agg;
+	}
+
+	if (aggfnoid == last_oid)
+	{
+		return &last_agg;
+	}
+
+	return NULL;
+}
+
+/*
+ * Whether the vectorized first()/last() supports the given argument types.
+ * The value must be text or a fixed-size by-value type that we can decompress
+ * in bulk, and the comparison element must be an integer-like type.
+ */
+bool
+vector_first_last_types_supported(Oid value_type, Oid cmp_type)
+{
+	switch (cmp_type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			break;
+		default:
+			return false;
+	}
+
+	if (value_type == TEXTOID)
+	{
+		return true;
+	}
+
+	int16 typlen;
+	bool typbyval;
+	get_typlenbyval(value_type, &typlen, &typbyval);
+	return typbyval && (typlen == 2 || typlen == 4 || typlen == 8);
+}
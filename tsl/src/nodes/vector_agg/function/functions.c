@@ -195,10 +195,11 @@ VectorAggFunctions count_any_agg = {
 
 /*
  * Return the vector aggregate definition corresponding to the given
- * PG aggregate function Oid.
+ * PG aggregate function Oid. The type of the first argument is required for
+ * the polymorphic aggregates, and is InvalidOid for count(*).
  */
 VectorAggFunctions *
-get_vector_aggregate(Oid aggfnoid)
+get_vector_aggregate(Oid aggfnoid, Oid argtype)
 {
 	switch (aggfnoid)
 	{
@@ -215,6 +216,14 @@ get_vector_aggregate(Oid aggfnoid)
 #include "sum_float_templates.c"
 #undef GENERATE_DISPATCH_TABLE
 		default:
-			return NULL;
+		{
+			/* Our own aggregate functions don't have fixed Oids. */
+			VectorAggFunctions *result = get_vector_first_last_aggregate(aggfnoid);
+			if (result == NULL)
+			{
+				result = get_vector_approximate_aggregate(aggfnoid, argtype);
+			}
+			return result;
+		}
 	}
 }
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <compression/arrow_c_data_interface.h>
+#include <nodes/decompress_chunk/compressed_batch.h>
 
 /*
  * Function table for a vectorized implementation of an aggregate function.
@@ -53,8 +54,35 @@ typedef struct
 							int start_row, int end_row, Datum constvalue, bool constisnull,
 							MemoryContext agg_extra_mctx);
 
+	/*
+	 * Aggregate functions with two arguments, like first(value, time). Either
+	 * argument can be an arrow array or a scalar value for the entire batch,
+	 * so they are passed as the compressed column values. The rows with null
+	 * second argument are already excluded by the filter. The argument types
+	 * are passed as well, because the partial aggregation result depends on
+	 * them. These functions are NULL for the one-argument aggregates.
+	 *
+	 * The second argument can also be a constant, like the fraction in
+	 * approximate_percentile(value, 0.99), and then it is passed as a scalar.
+	 */
+	void (*agg_vector2)(void *restrict agg_state, const CompressedColumnValues *arg1,
+						const CompressedColumnValues *arg2, const Oid *argtypes,
+						const uint64 *filter, int n, MemoryContext agg_extra_mctx);
+
+	void (*agg_many_vector2)(void *restrict agg_states, const uint32 *offsets,
+							 const uint64 *filter, int start_row, int end_row,
+							 const CompressedColumnValues *arg1,
+							 const CompressedColumnValues *arg2, const Oid *argtypes,
+							 MemoryContext agg_extra_mctx);
+
 	/* Emit a partial aggregation result. */
 	void (*agg_emit)(void *restrict agg_state, Datum *out_result, bool *out_isnull);
 } VectorAggFunctions;
 
-VectorAggFunctions *get_vector_aggregate(Oid aggfnoid);
+VectorAggFunctions *get_vector_aggregate(Oid aggfnoid, Oid argtype);
+
+VectorAggFunctions *get_vector_first_last_aggregate(Oid aggfnoid);
+bool vector_first_last_types_supported(Oid value_type, Oid cmp_type);
+
+VectorAggFunctions *get_vector_approximate_aggregate(Oid aggfnoid, Oid argtype);
+bool vector_approximate_percentile_fraction_supported(Oid aggfnoid, const Node *fraction);
@@ -7,6 +7,7 @@
 
 #include <postgres.h>
 #include <executor/tuptable.h>
+#include <miscadmin.h>
 
 typedef struct GroupingPolicy GroupingPolicy;
 
@@ -53,8 +54,30 @@ typedef struct GroupingPolicy
 	 * Description of this grouping policy for the EXPLAIN output.
 	 */
 	char *(*gp_explain)(GroupingPolicy *gp);
+
+	/*
+	 * Optional, NULL if not supported. After the reset, aggregate only the
+	 * rows with grouping keys that belong to the given partition, defined by
+	 * the upper partition_bits of the key hash. This is used when the input
+	 * can be replayed, or the partial results should not be emitted early, so
+	 * the policy can use its entire share of work_mem before asking to emit
+	 * the results, see vector_agg_spill_store_kbytes().
+	 */
+	void (*gp_set_partition)(GroupingPolicy *gp, int partition_bits, uint32 partition);
 } GroupingPolicy;
 
+/*
+ * When the input is saved to aggregate it by partitions of grouping keys, the
+ * saved input and the partial aggregation results share work_mem. The saved
+ * input is only read sequentially, so it gets the smaller part, and the rest
+ * of it goes to a temporary file.
+ */
+static inline int
+vector_agg_spill_store_kbytes(void)
+{
+	return work_mem / 4;
+}
+
 /*
  * The various types of grouping we might use, as determined at planning time.
  * The hashed subtypes are all implemented by hash grouping policy.
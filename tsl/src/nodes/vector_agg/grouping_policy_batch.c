@@ -113,10 +113,75 @@ gp_batch_reset(GroupingPolicy *obj)
 	policy->have_results = false;
 }
 
+/*
+ * Compute an aggregate function with two arguments, like first(value, time).
+ */
+static void
+compute_two_argument_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slot,
+							   VectorAggDef *agg_def, void *agg_state,
+							   MemoryContext agg_extra_mctx)
+{
+	uint16 total_batch_rows = 0;
+	const uint64 *vector_qual_result = vector_slot_get_qual_result(vector_slot, &total_batch_rows);
+
+	const CompressedColumnValues *arg1 =
+		vector_slot_get_compressed_column_values(vector_slot,
+												 AttrOffsetGetAttrNumber(agg_def->input_offset));
+	const CompressedColumnValues *arg2 = &agg_def->const_arg2;
+	if (agg_def->input_offset2 >= 0)
+	{
+		arg2 = vector_slot_get_compressed_column_values(vector_slot,
+														AttrOffsetGetAttrNumber(
+															agg_def->input_offset2));
+	}
+
+	Assert(arg1->decompression_type != DT_Invalid);
+	Assert(arg2->decompression_type != DT_Invalid);
+	Ensure(arg1->decompression_type != DT_Iterator && arg2->decompression_type != DT_Iterator,
+		   "expected arrow array but got iterator for two-argument aggregate");
+
+	/*
+	 * The rows with null second argument are skipped by these functions.
+	 */
+	const uint64 *arg2_validity_bitmap = NULL;
+	if (arg2->decompression_type == DT_Scalar)
+	{
+		if (*arg2->output_isnull)
+		{
+			return;
+		}
+	}
+	else
+	{
+		arg2_validity_bitmap = arg2->buffers[0];
+	}
+
+	const size_t num_words = (total_batch_rows + 63) / 64;
+	const uint64 *filter = arrow_combine_validity(num_words,
+												  policy->tmp_filter,
+												  vector_qual_result,
+												  agg_def->filter_result,
+												  arg2_validity_bitmap);
+
+	agg_def->func.agg_vector2(agg_state,
+							  arg1,
+							  arg2,
+							  agg_def->argtypes,
+							  filter,
+							  total_batch_rows,
+							  agg_extra_mctx);
+}
+
 static void
 compute_single_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slot,
 						 VectorAggDef *agg_def, void *agg_state, MemoryContext agg_extra_mctx)
 {
+	if (agg_def->func.agg_vector2 != NULL)
+	{
+		compute_two_argument_aggregate(policy, vector_slot, agg_def, agg_state, agg_extra_mctx);
+		return;
+	}
+
 	const ArrowArray *arg_arrow = NULL;
 	const uint64 *arg_validity_bitmap = NULL;
 	Datum arg_datum = 0;
@@ -131,8 +196,15 @@ compute_single_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slo
 	if (agg_def->input_offset >= 0)
 	{
 		const AttrNumber attnum = AttrOffsetGetAttrNumber(agg_def->input_offset);
+
+		/*
+		 * For min() and max(), the batch might be aggregated using its
+		 * metadata instead of the decompressed column.
+		 */
 		const CompressedColumnValues *values =
-			vector_slot_get_compressed_column_values(vector_slot, attnum);
+			agg_def->metadata_values.decompression_type == DT_Scalar ?
+				&agg_def->metadata_values :
+				vector_slot_get_compressed_column_values(vector_slot, attnum);
 
 		Assert(values->decompression_type != DT_Invalid);
 		Ensure(values->decompression_type != DT_Iterator,
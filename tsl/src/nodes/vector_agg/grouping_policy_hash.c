@@ -5,8 +5,9 @@
  */
 
 /*
- * This grouping policy groups the rows using a hash table. Currently it only
- * supports a single fixed-size by-value compressed column that fits into a Datum.
+ * This grouping policy groups the rows using a hash table. The grouping keys
+ * are handled by the hashing strategies, and can be either the compressed
+ * columns or the time_bucket() expressions over them.
  */
 
 #include <postgres.h>
@@ -14,6 +15,7 @@
 #include <access/attnum.h>
 #include <access/tupdesc.h>
 #include <executor/tuptable.h>
+#include <miscadmin.h>
 #include <nodes/pg_list.h>
 
 #include "grouping_policy.h"
@@ -118,12 +120,98 @@ gp_hash_reset(GroupingPolicy *obj)
 	policy->stat_input_total_rows = 0;
 	policy->stat_bulk_filtered_rows = 0;
 	policy->stat_consecutive_keys = 0;
+
+	policy->partitioned = false;
+	policy->partition_bits = 0;
+	policy->current_partition = 0;
+}
+
+static void
+gp_hash_set_partition(GroupingPolicy *gp, int partition_bits, uint32 partition)
+{
+	GroupingPolicyHash *policy = (GroupingPolicyHash *) gp;
+
+	Assert(!policy->returning_results);
+	Assert(policy->hashing.last_used_key_index == 0);
+	Assert(partition_bits >= 0 && partition_bits < 32);
+	Assert(partition < (((uint32) 1) << partition_bits));
+
+	policy->partitioned = true;
+	policy->partition_bits = partition_bits;
+	policy->current_partition = partition;
+}
+
+/*
+ * Compute an aggregate function with two arguments, like first(value, time).
+ */
+static void
+compute_two_argument_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot,
+							   int start_row, int end_row, const VectorAggDef *agg_def,
+							   void *agg_states)
+{
+	uint16 total_batch_rows = 0;
+	vector_slot_get_qual_result(vector_slot, &total_batch_rows);
+
+	const CompressedColumnValues *arg1 =
+		vector_slot_get_compressed_column_values(vector_slot,
+												 AttrOffsetGetAttrNumber(agg_def->input_offset));
+	const CompressedColumnValues *arg2 = &agg_def->const_arg2;
+	if (agg_def->input_offset2 >= 0)
+	{
+		arg2 = vector_slot_get_compressed_column_values(vector_slot,
+														AttrOffsetGetAttrNumber(
+															agg_def->input_offset2));
+	}
+
+	Assert(arg1->decompression_type != DT_Invalid);
+	Assert(arg2->decompression_type != DT_Invalid);
+	Ensure(arg1->decompression_type != DT_Iterator && arg2->decompression_type != DT_Iterator,
+		   "expected arrow array but got iterator for two-argument aggregate");
+
+	/*
+	 * The rows with null second argument are skipped by these functions.
+	 */
+	const uint64 *arg2_validity_bitmap = NULL;
+	if (arg2->decompression_type == DT_Scalar)
+	{
+		if (*arg2->output_isnull)
+		{
+			return;
+		}
+	}
+	else
+	{
+		arg2_validity_bitmap = arg2->buffers[0];
+	}
+
+	const size_t num_words = (total_batch_rows + 63) / 64;
+	const uint64 *filter = arrow_combine_validity(num_words,
+												  policy->tmp_filter,
+												  agg_def->filter_result,
+												  policy->batch_filter,
+												  arg2_validity_bitmap);
+
+	agg_def->func.agg_many_vector2(agg_states,
+								   policy->key_index_for_row,
+								   filter,
+								   start_row,
+								   end_row,
+								   arg1,
+								   arg2,
+								   agg_def->argtypes,
+								   policy->agg_extra_mctx);
 }
 
 static void
 compute_single_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot, int start_row,
 						 int end_row, const VectorAggDef *agg_def, void *agg_states)
 {
+	if (agg_def->func.agg_many_vector2 != NULL)
+	{
+		compute_two_argument_aggregate(policy, vector_slot, start_row, end_row, agg_def, agg_states);
+		return;
+	}
+
 	const ArrowArray *arg_arrow = NULL;
 	const uint64 *arg_validity_bitmap = NULL;
 	Datum arg_datum = 0;
@@ -131,7 +219,7 @@ compute_single_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot
 	uint16 total_batch_rows = 0;
 	const uint32 *offsets = policy->key_index_for_row;
 	MemoryContext agg_extra_mctx = policy->agg_extra_mctx;
-	const uint64 *vector_qual_result = vector_slot_get_qual_result(vector_slot, &total_batch_rows);
+	vector_slot_get_qual_result(vector_slot, &total_batch_rows);
 
 	/*
 	 * We have functions with one argument, and one function with no arguments
@@ -168,7 +256,7 @@ compute_single_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot
 	const uint64 *filter = arrow_combine_validity(num_words,
 												  policy->tmp_filter,
 												  agg_def->filter_result,
-												  vector_qual_result,
+												  policy->batch_filter,
 												  arg_validity_bitmap);
 
 	/*
@@ -298,7 +386,7 @@ gp_hash_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 {
 	GroupingPolicyHash *policy = (GroupingPolicyHash *) gp;
 	uint16 n;
-	const uint64 *restrict filter = vector_slot_get_qual_result(vector_slot, &n);
+	const uint64 *filter = vector_slot_get_qual_result(vector_slot, &n);
 
 	Assert(!policy->returning_results);
 
@@ -330,16 +418,63 @@ gp_hash_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 		policy->num_tmp_filter_words = (num_words * 2 + 1);
 	}
 
+	/*
+	 * When aggregating by partitions of grouping keys, the hashing strategy
+	 * clears the rows with keys from other partitions in a copy of the batch
+	 * filter, which is then used as the filter for this batch.
+	 */
+	if (policy->partition_bits > 0)
+	{
+		if (num_words > policy->num_partition_filter_words)
+		{
+			policy->partition_filter =
+				palloc(sizeof(*policy->partition_filter) * (num_words * 2 + 1));
+			policy->num_partition_filter_words = (num_words * 2 + 1);
+		}
+
+		if (filter != NULL)
+		{
+			memcpy(policy->partition_filter, filter, sizeof(*filter) * num_words);
+		}
+		else
+		{
+			memset(policy->partition_filter, 0xFF, sizeof(*filter) * num_words);
+			if (n % 64 != 0)
+			{
+				/* The bits for past-the-end rows must be zero. */
+				policy->partition_filter[num_words - 1] = ~0ULL >> (64 - n % 64);
+			}
+		}
+	}
+	policy->batch_filter = policy->partition_bits > 0 ? policy->partition_filter : filter;
+
 	/*
 	 * Arrange the input compressed columns in the order of grouping columns.
 	 */
 	for (int i = 0; i < policy->num_grouping_columns; i++)
 	{
 		const GroupingColumn *def = &policy->grouping_columns[i];
+		const CompressedColumnValues *values =
+			vector_slot_get_compressed_column_values(vector_slot,
+													 AttrOffsetGetAttrNumber(def->input_offset));
 
-		policy->current_batch_grouping_column_values[i] =
-			*vector_slot_get_compressed_column_values(vector_slot,
-													  AttrOffsetGetAttrNumber(def->input_offset));
+		if (def->time_bucket != NULL)
+		{
+			/*
+			 * The grouping column is a time_bucket() over the input column.
+			 * Compute it for the entire batch, and then hash the resulting
+			 * values as if they were a decompressed column.
+			 */
+			vector_time_bucket_compute(def->time_bucket,
+									   values,
+									   filter,
+									   n,
+									   &policy->current_batch_grouping_column_values[i]);
+		}
+		else
+		{
+			policy->current_batch_grouping_column_values[i] = *values;
+		}
 	}
 
 	/*
@@ -350,6 +485,7 @@ gp_hash_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 	/*
 	 * Add the batch rows to aggregate function states.
 	 */
+	filter = policy->batch_filter;
 	if (filter == NULL)
 	{
 		/*
@@ -421,6 +557,24 @@ gp_hash_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 	policy->stat_input_valid_rows += arrow_num_valid(filter, n);
 }
 
+/*
+ * Estimate the memory used by the current partial aggregation results, i.e.
+ * the hash table, the output keys and the aggregate function states.
+ */
+static uint64
+gp_hash_memory_bytes(GroupingPolicyHash *policy)
+{
+	const uint64 keys = policy->hashing.last_used_key_index;
+	uint64 bytes = policy->hashing.get_size_bytes(&policy->hashing);
+	bytes += keys * sizeof(Datum);
+	for (int i = 0; i < policy->num_agg_defs; i++)
+	{
+		bytes += keys * policy->agg_defs[i].func.state_bytes;
+	}
+	bytes += MemoryContextMemAllocated(policy->agg_extra_mctx, false);
+	return bytes;
+}
+
 static bool
 gp_hash_should_emit(GroupingPolicy *gp)
 {
@@ -435,14 +589,34 @@ gp_hash_should_emit(GroupingPolicy *gp)
 		return true;
 	}
 
+	if (policy->partitioned)
+	{
+		/*
+		 * The input is saved and can be replayed for aggregating the other
+		 * partitions of grouping keys, so we can use the rest of work_mem
+		 * after the saved input for the current partition. The caller splits
+		 * it further if it doesn't fit. In parallel plans, the caller also
+		 * does this before saving the input, so that we don't emit the partial
+		 * results early.
+		 */
+		return gp_hash_memory_bytes(policy) >
+			   (uint64) (work_mem - vector_agg_spill_store_kbytes()) * 1024;
+	}
+
 	/*
 	 * Don't grow the hash table cardinality too much, otherwise we become bound
 	 * by memory reads. In general, when this first stage of grouping doesn't
 	 * significantly reduce the cardinality, it becomes pure overhead and the
 	 * work will be done by the final Postgres aggregation, so we should bail
 	 * out early here.
+	 *
+	 * Some aggregate states are much larger than the hash table entries, e.g.
+	 * the HyperLogLog registers of approximate_count_distinct() take several
+	 * kilobytes per group in agg_extra_mctx, so we also have to check all the
+	 * memory we use against work_mem.
 	 */
-	return policy->hashing.get_size_bytes(&policy->hashing) > 512 * 1024;
+	return policy->hashing.get_size_bytes(&policy->hashing) > 512 * 1024 ||
+		   gp_hash_memory_bytes(policy) > (uint64) work_mem * 1024;
 }
 
 static bool
@@ -514,4 +688,5 @@ static const GroupingPolicy grouping_policy_hash_functions = {
 	.gp_should_emit = gp_hash_should_emit,
 	.gp_do_emit = gp_hash_do_emit,
 	.gp_explain = gp_hash_explain,
+	.gp_set_partition = gp_hash_set_partition,
 };
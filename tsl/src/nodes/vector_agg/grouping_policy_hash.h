@@ -114,6 +114,21 @@ typedef struct GroupingPolicyHash
 	 */
 	MemoryContext agg_extra_mctx;
 
+	/*
+	 * When the input is aggregated by partitions of grouping keys, we only
+	 * aggregate the rows with keys where the upper partition_bits of the hash
+	 * are equal to current_partition. The rows of other partitions are
+	 * cleared in partition_filter, which is the filter of the current batch in
+	 * this case. The batch_filter is the effective filter of the current batch
+	 * used by the aggregate functions.
+	 */
+	bool partitioned;
+	int partition_bits;
+	uint32 current_partition;
+	uint64 *partition_filter;
+	uint64 num_partition_filter_words;
+	const uint64 *batch_filter;
+
 	/*
 	 * Whether we are in the mode of returning the partial aggregation results.
 	 * If we are, track the index of the last returned grouping key.
@@ -25,19 +25,30 @@ typedef struct BatchHashingParams
 	HashingStrategy *restrict hashing;
 
 	uint32 *restrict result_key_indexes;
+
+	/*
+	 * When aggregating by partitions of grouping keys, the rows with keys from
+	 * other partitions are cleared in the partition filter, which is also the
+	 * batch filter in this case.
+	 */
+	int partition_bits;
+	uint32 current_partition;
+	uint64 *restrict partition_filter;
 } BatchHashingParams;
 
 static pg_attribute_always_inline BatchHashingParams
 build_batch_hashing_params(GroupingPolicyHash *policy, TupleTableSlot *vector_slot)
 {
-	uint16 nrows;
 	BatchHashingParams params = {
 		.policy = policy,
 		.hashing = &policy->hashing,
-		.batch_filter = vector_slot_get_qual_result(vector_slot, &nrows),
+		.batch_filter = policy->batch_filter,
 		.num_grouping_columns = policy->num_grouping_columns,
 		.grouping_column_values = policy->current_batch_grouping_column_values,
 		.result_key_indexes = policy->key_index_for_row,
+		.partition_bits = policy->partition_bits,
+		.current_partition = policy->current_partition,
+		.partition_filter = policy->partition_filter,
 	};
 
 	Assert(policy->num_grouping_columns > 0);
@@ -80,6 +80,50 @@ FUNCTION_NAME(hash_strategy_prepare_for_batch)(GroupingPolicyHash *policy,
 	FUNCTION_NAME(key_hashing_prepare_for_batch)(policy, vector_slot);
 }
 
+/*
+ * Find the unique index of the given key using the hash table, adding a new
+ * key if it is not there yet.
+ */
+static pg_attribute_always_inline uint32
+FUNCTION_NAME(lookup_or_insert)(HashingStrategy *restrict hashing, OUTPUT_KEY_TYPE output_key,
+								HASH_TABLE_KEY_TYPE hash_table_key)
+{
+	struct FUNCTION_NAME(hash) *restrict table = hashing->table;
+
+	bool found = false;
+	FUNCTION_NAME(entry) *restrict entry = FUNCTION_NAME(insert)(table, hash_table_key, &found);
+	if (!found)
+	{
+		/*
+		 * New key, have to store it persistently.
+		 */
+		const uint32 index = ++hashing->last_used_key_index;
+		entry->key_index = index;
+		FUNCTION_NAME(key_hashing_store_new)(hashing, index, output_key);
+		DEBUG_PRINT("%p: new key index %d\n", hashing, index);
+	}
+
+	return entry->key_index;
+}
+
+/*
+ * Check whether the key belongs to the partition we are currently aggregating.
+ * The partition is determined by the upper bits of the 32-bit key hash, so that
+ * it is independent of the lower bits used by the hash table.
+ */
+static pg_attribute_always_inline bool
+FUNCTION_NAME(key_in_partition)(BatchHashingParams params, HASH_TABLE_KEY_TYPE hash_table_key)
+{
+	if (likely(params.partition_bits == 0))
+	{
+		return true;
+	}
+
+	Assert(params.partition_bits < 32);
+	const uint32 hash = (uint32) KEY_HASH(hash_table_key);
+	return (hash >> (32 - params.partition_bits)) == params.current_partition;
+}
+
 /*
  * Fill the unique key indexes for all rows of the batch, using a hash table.
  */
@@ -90,8 +134,6 @@ FUNCTION_NAME(fill_offsets_impl)(BatchHashingParams params, int start_row, int e
 
 	uint32 *restrict indexes = params.result_key_indexes;
 
-	struct FUNCTION_NAME(hash) *restrict table = hashing->table;
-
 	HASH_TABLE_KEY_TYPE prev_hash_table_key = { 0 };
 	uint32 previous_key_index = 0;
 	for (int row = start_row; row < end_row; row++)
@@ -115,7 +157,13 @@ FUNCTION_NAME(fill_offsets_impl)(BatchHashingParams params, int start_row, int e
 
 		if (unlikely(!key_valid))
 		{
-			/* The key is null. */
+			/* The key is null. It always belongs to the first partition. */
+			if (unlikely(params.current_partition != 0))
+			{
+				arrow_set_row_validity(params.partition_filter, row, false);
+				continue;
+			}
+
 			if (hashing->null_key_index == 0)
 			{
 				hashing->null_key_index = ++hashing->last_used_key_index;
@@ -143,31 +191,126 @@ FUNCTION_NAME(fill_offsets_impl)(BatchHashingParams params, int start_row, int e
 			continue;
 		}
 
+		if (!FUNCTION_NAME(key_in_partition)(params, hash_table_key))
+		{
+			/*
+			 * The key belongs to another partition, so this row is going to be
+			 * aggregated in a different pass over the input.
+			 */
+			arrow_set_row_validity(params.partition_filter, row, false);
+			continue;
+		}
+
 		/*
 		 * Find the key using the hash table.
 		 */
-		bool found = false;
-		FUNCTION_NAME(entry) *restrict entry = FUNCTION_NAME(insert)(table, hash_table_key, &found);
-		if (!found)
+		const uint32 key_index =
+			FUNCTION_NAME(lookup_or_insert)(hashing, output_key, hash_table_key);
+		DEBUG_PRINT("%p: row %d key index %d\n", hashing, row, key_index);
+		indexes[row] = key_index;
+
+		previous_key_index = key_index;
+		prev_hash_table_key = hash_table_key;
+	}
+}
+
+#ifdef USE_DICT_HASHING
+/*
+ * Fill the unique key indexes for a batch where the single grouping column is
+ * dictionary-encoded. Instead of hashing the value of every row, we hash each
+ * dictionary entry once, when it is first referenced by a row that passes the
+ * filter, and remember its key index in a lookup array indexed by the
+ * dictionary index. The entries are looked up in the order of their first
+ * occurrence in the rows, so that the order of the new key indexes is the same
+ * as for the non-dictionary hashing. We rely on this when we use the hash
+ * table as a GroupAggregate. The unreferenced entries are not added, so that
+ * we don't produce empty groups.
+ */
+static pg_attribute_always_inline void
+FUNCTION_NAME(fill_offsets_dict)(BatchHashingParams params, int start_row, int end_row)
+{
+	HashingStrategy *restrict hashing = params.hashing;
+
+	uint32 *restrict indexes = params.result_key_indexes;
+
+	uint32 *restrict key_index_for_dict = hashing->key_index_for_dict;
+
+	const int16 *restrict dict_indices = (const int16 *) params.single_grouping_column.buffers[3];
+
+	const uint64 *restrict validity = (const uint64 *) params.single_grouping_column.buffers[0];
+
+	/*
+	 * The dictionary itself is hashed as a plain text column without nulls.
+	 */
+	BatchHashingParams dict_params = params;
+	dict_params.single_grouping_column.decompression_type = DT_ArrowText;
+	dict_params.single_grouping_column.buffers[0] = NULL;
+	dict_params.single_grouping_column.buffers[3] = NULL;
+
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(params.batch_filter, row))
+		{
+			/* The row doesn't pass the filter. */
+			continue;
+		}
+
+		if (unlikely(!arrow_row_is_valid(validity, row)))
+		{
+			/* The key is null. It always belongs to the first partition. */
+			if (unlikely(params.current_partition != 0))
+			{
+				arrow_set_row_validity(params.partition_filter, row, false);
+				continue;
+			}
+
+			if (hashing->null_key_index == 0)
+			{
+				hashing->null_key_index = ++hashing->last_used_key_index;
+			}
+			indexes[row] = hashing->null_key_index;
+			continue;
+		}
+
+		const int16 dict_index = dict_indices[row];
+		Assert(dict_index >= 0 && (uint64) dict_index < hashing->num_key_index_for_dict);
+		if (key_index_for_dict[dict_index] == 0)
 		{
+			bool key_valid = false;
+			OUTPUT_KEY_TYPE output_key = { 0 };
+			HASH_TABLE_KEY_TYPE hash_table_key = { 0 };
+			FUNCTION_NAME(key_hashing_get_key)(dict_params,
+											   dict_index,
+											   &output_key,
+											   &hash_table_key,
+											   &key_valid);
+			Assert(key_valid);
+
 			/*
-			 * New key, have to store it persistently.
+			 * The dictionary entries of other partitions are marked with an
+			 * invalid key index, so that we check the partition only once.
 			 */
-			const uint32 index = ++hashing->last_used_key_index;
-			entry->key_index = index;
-			FUNCTION_NAME(key_hashing_store_new)(hashing, index, output_key);
-			DEBUG_PRINT("%p: row %d new key index %d\n", hashing, row, index);
+			key_index_for_dict[dict_index] =
+				FUNCTION_NAME(key_in_partition)(params, hash_table_key) ?
+					FUNCTION_NAME(lookup_or_insert)(hashing, output_key, hash_table_key) :
+					PG_UINT32_MAX;
 		}
-		else
+
+		if (unlikely(key_index_for_dict[dict_index] == PG_UINT32_MAX))
 		{
-			DEBUG_PRINT("%p: row %d old key index %d\n", hashing, row, entry->key_index);
+			arrow_set_row_validity(params.partition_filter, row, false);
+			continue;
 		}
-		indexes[row] = entry->key_index;
 
-		previous_key_index = entry->key_index;
-		prev_hash_table_key = entry->hash_table_key;
+		indexes[row] = key_index_for_dict[dict_index];
+		DEBUG_PRINT("%p: row %d dict index %d key index %d\n",
+					hashing,
+					row,
+					dict_index,
+					indexes[row]);
 	}
 }
+#endif
 
 static void
 FUNCTION_NAME(fill_offsets)(GroupingPolicyHash *policy, TupleTableSlot *vector_slot, int start_row,
@@ -177,6 +320,14 @@ FUNCTION_NAME(fill_offsets)(GroupingPolicyHash *policy, TupleTableSlot *vector_s
 
 	BatchHashingParams params = build_batch_hashing_params(policy, vector_slot);
 
+#ifdef USE_DICT_HASHING
+	if (params.single_grouping_column.decompression_type == DT_ArrowTextDict)
+	{
+		FUNCTION_NAME(fill_offsets_dict)(params, start_row, end_row);
+		return;
+	}
+#endif
+
 	FUNCTION_NAME(fill_offsets_impl)(params, start_row, end_row);
 }
 
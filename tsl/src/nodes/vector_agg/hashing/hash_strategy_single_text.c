@@ -25,6 +25,7 @@
 #define EXPLAIN_NAME "single text"
 #define KEY_VARIANT single_text
 #define OUTPUT_KEY_TYPE BytesView
+#define USE_DICT_HASHING
 
 static void
 single_text_key_hashing_init(HashingStrategy *hashing)
@@ -130,6 +131,33 @@ single_text_emit_key(GroupingPolicyHash *policy, uint32 current_key,
 static void
 single_text_key_hashing_prepare_for_batch(GroupingPolicyHash *policy, TupleTableSlot *vector_slot)
 {
+	/*
+	 * For the dictionary-encoded batches, prepare the lookup array that maps
+	 * the dictionary entries to the unique key indexes. We don't need the
+	 * mapping from the previous batch, so we don't need to use repalloc.
+	 */
+	const CompressedColumnValues *column = &policy->current_batch_grouping_column_values[0];
+	if (column->decompression_type != DT_ArrowTextDict)
+	{
+		return;
+	}
+
+	Assert(column->arrow != NULL && column->arrow->dictionary != NULL);
+	const uint64 num_dict_entries = column->arrow->dictionary->length;
+	HashingStrategy *hashing = &policy->hashing;
+	if (num_dict_entries > hashing->num_key_index_for_dict)
+	{
+		if (hashing->key_index_for_dict != NULL)
+		{
+			pfree(hashing->key_index_for_dict);
+		}
+		hashing->num_key_index_for_dict = num_dict_entries;
+		hashing->key_index_for_dict =
+			palloc(sizeof(hashing->key_index_for_dict[0]) * hashing->num_key_index_for_dict);
+	}
+	memset(hashing->key_index_for_dict,
+		   0,
+		   num_dict_entries * sizeof(hashing->key_index_for_dict[0]));
 }
 
 #include "hash_strategy_impl.c"
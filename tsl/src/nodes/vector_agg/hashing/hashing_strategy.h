@@ -62,6 +62,15 @@ typedef struct HashingStrategy
 	 */
 	uint32 null_key_index;
 
+	/*
+	 * For a dictionary-encoded grouping column, the unique key indexes of the
+	 * dictionary entries of the current batch, indexed by dictionary index.
+	 * Zero means that the entry hasn't been looked up yet. This allows us to
+	 * hash each distinct value once per batch, not once per row.
+	 */
+	uint32 *restrict key_index_for_dict;
+	uint64 num_key_index_for_dict;
+
 #ifdef TS_USE_UMASH
 	/*
 	 * UMASH fingerprinting parameters.
@@ -13,6 +13,7 @@
 #include <nodes/plannodes.h>
 #include <parser/parsetree.h>
 #include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
 
 #include "plan.h"
 
@@ -22,6 +23,7 @@
 #include "nodes/decompress_chunk/vector_quals.h"
 #include "nodes/vector_agg.h"
 #include "utils.h"
+#include "vector_time_bucket.h"
 
 static struct CustomScanMethods scan_methods = { .CustomName = VECTOR_AGG_NODE_NAME,
 												 .CreateCustomScanState = vector_agg_state_create };
@@ -128,6 +130,38 @@ resolve_outer_special_vars(List *agg_tlist, Plan *childplan)
 	return castNode(List, resolve_outer_special_vars_mutator((Node *) agg_tlist, childplan));
 }
 
+/*
+ * Check whether the plan reads a parallel-aware scan, which means that it runs
+ * in the parallel processes below a Gather node.
+ */
+static bool
+has_parallel_aware_scan(Plan *plan)
+{
+	if (plan == NULL)
+	{
+		return false;
+	}
+
+	if (plan->parallel_aware)
+	{
+		return true;
+	}
+
+	if (IsA(plan, CustomScan))
+	{
+		ListCell *lc;
+		foreach (lc, castNode(CustomScan, plan)->custom_plans)
+		{
+			if (has_parallel_aware_scan(lfirst(lc)))
+			{
+				return true;
+			}
+		}
+	}
+
+	return has_parallel_aware_scan(plan->lefttree) || has_parallel_aware_scan(plan->righttree);
+}
+
 /*
  * Create a vectorized aggregation node to replace the given partial aggregation
  * node.
@@ -161,6 +195,14 @@ vector_agg_plan_create(Plan *childplan, Agg *agg, List *resolved_targetlist,
 	vector_agg->scan.plan.startup_cost = agg->plan.startup_cost;
 	vector_agg->scan.plan.total_cost = agg->plan.total_cost;
 
+	/*
+	 * We are not parallel-aware: each parallel process emits its own partial
+	 * results, and they are combined by the Finalize aggregation above Gather.
+	 * Combining them ourselves in shared memory would require the combine
+	 * functions and a serialized state format for the vectorized aggregate
+	 * functions, which don't exist yet. The states also hold pointers into
+	 * the process-local memory.
+	 */
 	vector_agg->scan.plan.parallel_aware = false;
 	vector_agg->scan.plan.parallel_safe = childplan->parallel_safe;
 	vector_agg->scan.plan.async_capable = false;
@@ -178,6 +220,33 @@ vector_agg_plan_create(Plan *childplan, Agg *agg, List *resolved_targetlist,
 	lfirst(list_nth_cell(vector_agg->custom_private, VASI_GroupingType)) =
 		makeInteger(grouping_type);
 
+	/*
+	 * The hash grouping can save its input and aggregate it in several passes
+	 * by partitions of the grouping keys. This changes the order of output
+	 * keys, so it is only allowed when we are replacing a HashAggregate.
+	 */
+	lfirst(list_nth_cell(vector_agg->custom_private, VASI_SpillAllowed)) =
+		makeInteger(grouping_type != VAGT_Batch && agg->aggstrategy == AGG_HASHED);
+
+	/*
+	 * In a parallel plan, our partial results go through Gather into the
+	 * single-threaded Finalize aggregation. We can't tell this at execution
+	 * time, because the parallel mode of the executor state is only set when
+	 * the execution starts, and never in the parallel workers.
+	 */
+	lfirst(list_nth_cell(vector_agg->custom_private, VASI_InParallelPlan)) =
+		makeInteger(has_parallel_aware_scan(childplan));
+
+	/*
+	 * With per-batch grouping over DecompressChunk, check whether we can
+	 * compute the aggregates from the batch metadata without decompression.
+	 */
+	if (!is_columnar_scan(childplan) && grouping_type == VAGT_Batch)
+	{
+		lfirst(list_nth_cell(vector_agg->custom_private, VASI_BatchMetadataAttnos)) =
+			vectoragg_plan_batch_metadata(childplan, resolved_targetlist);
+	}
+
 	if (is_columnar_scan(childplan))
 	{
 		CustomScan *custom = castNode(CustomScan, childplan);
@@ -226,6 +295,32 @@ is_vector_var(const VectorQualInfo *vqinfo, Expr *expr)
 	return vqinfo->vector_attrs && vqinfo->vector_attrs[var->varattno];
 }
 
+/*
+ * Whether the expression can be used as a vectorized grouping column: must be
+ * either a vector Var, or a time_bucket() over a vector Var that we can compute
+ * in vectorized fashion. Returns the grouping Var or NULL.
+ */
+static Var *
+get_vector_grouping_var(const VectorQualInfo *vqinfo, Expr *expr)
+{
+	Var *var = NULL;
+	if (IsA(expr, Var))
+	{
+		var = castNode(Var, expr);
+	}
+	else if (IsA(expr, FuncExpr))
+	{
+		var = vector_time_bucket_get_var(castNode(FuncExpr, expr));
+	}
+
+	if (var == NULL || !is_vector_var(vqinfo, (Expr *) var))
+	{
+		return NULL;
+	}
+
+	return var;
+}
+
 /*
  * Whether we can vectorize this particular aggregate.
  */
@@ -261,7 +356,18 @@ can_vectorize_aggref(const VectorQualInfo *vqi, Aggref *aggref)
 		aggref->aggfilter = (Expr *) aggfilter_vectorized;
 	}
 
-	if (get_vector_aggregate(aggref->aggfnoid) == NULL)
+	if (OidIsValid(aggref->inputcollid) && !get_collation_isdeterministic(aggref->inputcollid))
+	{
+		/*
+		 * The vectorized functions compare and hash the text values bytewise,
+		 * which is only correct for the deterministic collations.
+		 */
+		return false;
+	}
+
+	const Oid argtype =
+		aggref->aggargtypes != NIL ? linitial_oid(aggref->aggargtypes) : InvalidOid;
+	if (get_vector_aggregate(aggref->aggfnoid, argtype) == NULL)
 	{
 		/*
 		 * We don't have a vectorized implementation for this particular
@@ -276,6 +382,31 @@ can_vectorize_aggref(const VectorQualInfo *vqi, Aggref *aggref)
 		return true;
 	}
 
+	if (list_length(aggref->args) == 2)
+	{
+		/*
+		 * The functions with two arguments we support are first(value, cmp)
+		 * and last(value, cmp) for some argument types, and
+		 * approximate_percentile(value, fraction) with a constant fraction.
+		 */
+		TargetEntry *value = castNode(TargetEntry, linitial(aggref->args));
+		TargetEntry *second = castNode(TargetEntry, lsecond(aggref->args));
+		if (!is_vector_var(vqi, value->expr))
+		{
+			return false;
+		}
+
+		if (IsA(second->expr, Const))
+		{
+			return vector_approximate_percentile_fraction_supported(aggref->aggfnoid,
+																	(Node *) second->expr);
+		}
+
+		return is_vector_var(vqi, second->expr) &&
+			   vector_first_last_types_supported(exprType((Node *) value->expr),
+												 exprType((Node *) second->expr));
+	}
+
 	/* The function must have one argument, check it. */
 	Assert(list_length(aggref->args) == 1);
 	TargetEntry *argument = castNode(TargetEntry, linitial(aggref->args));
@@ -283,6 +414,25 @@ can_vectorize_aggref(const VectorQualInfo *vqi, Aggref *aggref)
 	return is_vector_var(vqi, argument->expr);
 }
 
+/*
+ * Whether the hash grouping strategies support the given type of a compressed
+ * grouping column. The bulk decompression produces other types as well, e.g.
+ * "char" or numeric.
+ */
+static bool
+is_vector_grouping_type(Oid type)
+{
+	if (type == TEXTOID)
+	{
+		return true;
+	}
+
+	int16 typlen;
+	bool typbyval;
+	get_typlenbyval(type, &typlen, &typbyval);
+	return typbyval && (typlen == 2 || typlen == 4 || typlen == 8);
+}
+
 /*
  * What vectorized grouping strategy we can use for the given grouping columns.
  */
@@ -298,6 +448,7 @@ get_vectorized_grouping_type(const VectorQualInfo *vqinfo, Agg *agg, List *resol
 	 */
 	int num_grouping_columns = 0;
 	bool all_segmentby = true;
+	bool all_types_supported = true;
 	Var *single_grouping_var = NULL;
 
 	ListCell *lc;
@@ -309,23 +460,32 @@ get_vectorized_grouping_type(const VectorQualInfo *vqinfo, Agg *agg, List *resol
 			continue;
 		}
 
-		if (!IsA(target_entry->expr, Var))
+		/*
+		 * Besides the Aggrefs, we can see Vars or the grouping expressions in
+		 * the aggregated targetlists. We support only the Vars and the
+		 * time_bucket() over them. Just say it's not vectorizable otherwise,
+		 * because here we are working with arbitrary plans that we don't
+		 * control.
+		 */
+		Var *var = get_vector_grouping_var(vqinfo, target_entry->expr);
+		if (var == NULL)
 		{
-			/*
-			 * We shouldn't see anything except Vars or Aggrefs in the
-			 * aggregated targetlists. Just say it's not vectorizable, because
-			 * here we are working with arbitrary plans that we don't control.
-			 */
 			return VAGT_Invalid;
 		}
 
 		num_grouping_columns++;
 
-		if (!is_vector_var(vqinfo, target_entry->expr))
-			return VAGT_Invalid;
+		/*
+		 * The grouping expressions are computed by the hash grouping policy,
+		 * the per-batch grouping only works with plain segmentby columns.
+		 */
+		all_segmentby &= IsA(target_entry->expr, Var) && vqinfo->segmentby_attrs[var->varattno];
 
-		Var *var = castNode(Var, target_entry->expr);
-		all_segmentby &= vqinfo->segmentby_attrs[var->varattno];
+		/*
+		 * The hash grouping compares the keys bytewise, so it works only for
+		 * the types where this matches the equality operator.
+		 */
+		all_types_supported &= is_vector_grouping_type(var->vartype);
 
 		/*
 		 * If we have a single grouping column, record it for the additional
@@ -358,6 +518,11 @@ get_vectorized_grouping_type(const VectorQualInfo *vqinfo, Agg *agg, List *resol
 		return VAGT_Batch;
 	}
 
+	if (!all_types_supported)
+	{
+		return VAGT_Invalid;
+	}
+
 	/*
 	 * We support hashed vectorized grouping by one fixed-size by-value
 	 * compressed column.
@@ -665,11 +830,11 @@ try_insert_vector_agg_node(Plan *plan, List *rtable)
 				return plan;
 			}
 		}
-		else if (IsA(target_entry->expr, Var))
+		else if (IsA(target_entry->expr, Var) || IsA(target_entry->expr, FuncExpr))
 		{
-			if (!is_vector_var(&vqi, target_entry->expr))
+			if (get_vector_grouping_var(&vqi, target_entry->expr) == NULL)
 			{
-				/* Variable not vectorizable. */
+				/* Grouping column not vectorizable. */
 				return plan;
 			}
 		}
@@ -15,11 +15,15 @@
 typedef enum
 {
 	VASI_GroupingType = 0,
+	VASI_BatchMetadataAttnos = 1,
+	VASI_SpillAllowed = 2,
+	VASI_InParallelPlan = 3,
 	VASI_Count
 } VectorAggSettingsIndex;
 
 extern void _vector_agg_init(void);
 extern void vectoragg_plan_decompress_chunk(Plan *childplan, VectorQualInfo *vqi);
+extern List *vectoragg_plan_batch_metadata(Plan *childplan, List *resolved_targetlist);
 extern void vectoragg_plan_tam(Plan *childplan, const List *rtable, VectorQualInfo *vqi);
 Plan *try_insert_vector_agg_node(Plan *plan, List *rtable);
 bool has_vector_agg_node(Plan *plan, bool *has_normal_agg);
@@ -6,9 +6,14 @@
 #include <postgres.h>
 #include <nodes/pathnodes.h>
 #include <nodes/plannodes.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
 
+#include "compression/create.h"
 #include "nodes/decompress_chunk/planner.h"
 #include "plan.h"
+#include "ts_catalog/array_utils.h"
+#include "ts_catalog/compression_settings.h"
 
 /*
  * Whether the given compressed column index corresponds to a vector variable.
@@ -136,3 +141,178 @@ vectoragg_plan_decompress_chunk(Plan *childplan, VectorQualInfo *vqi)
 	List *settings = linitial(custom->custom_private);
 	vqi->reverse = list_nth_int(settings, DCS_Reverse);
 }
+
+/*
+ * Which batch metadata column can be used to compute the given aggregate
+ * function: "min", "max", or NULL if none.
+ */
+static char *
+get_aggregate_metadata_type(Oid aggfnoid)
+{
+	switch (aggfnoid)
+	{
+		case F_MIN_INT2:
+		case F_MIN_INT4:
+		case F_MIN_INT8:
+		case F_MIN_FLOAT4:
+		case F_MIN_FLOAT8:
+		case F_MIN_DATE:
+		case F_MIN_TIMESTAMP:
+		case F_MIN_TIMESTAMPTZ:
+			return "min";
+		case F_MAX_INT2:
+		case F_MAX_INT4:
+		case F_MAX_INT8:
+		case F_MAX_FLOAT4:
+		case F_MAX_FLOAT8:
+		case F_MAX_DATE:
+		case F_MAX_TIMESTAMP:
+		case F_MAX_TIMESTAMPTZ:
+			return "max";
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Find the position of the given compressed chunk attribute in the output of
+ * the compressed scan, or InvalidAttrNumber if it is not there.
+ */
+static AttrNumber
+find_compressed_scan_attno(Plan *compressed_plan, AttrNumber compressed_chunk_attno)
+{
+	if (!IsA(compressed_plan, SeqScan) && !IsA(compressed_plan, IndexScan) &&
+		!IsA(compressed_plan, BitmapHeapScan))
+	{
+		/*
+		 * Other plans like index-only scans don't reference the compressed
+		 * chunk attributes directly in their targetlists.
+		 */
+		return InvalidAttrNumber;
+	}
+
+	const Index scanrelid = ((Scan *) compressed_plan)->scanrelid;
+	ListCell *lc;
+	foreach (lc, compressed_plan->targetlist)
+	{
+		TargetEntry *target = lfirst_node(TargetEntry, lc);
+		if (!IsA(target->expr, Var))
+		{
+			continue;
+		}
+
+		Var *var = castNode(Var, target->expr);
+		if ((Index) var->varno == scanrelid && var->varattno == compressed_chunk_attno)
+		{
+			return target->resno;
+		}
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * Check whether the aggregates can be computed from the batch metadata for the
+ * compressed batches where all rows pass the vectorized filters. This is
+ * possible for count(*), for any aggregates over segmentby columns, and for
+ * min() and max() over the compressed columns that have the min/max sparse
+ * index. In this case, we don't have to decompress the aggregated columns at
+ * all.
+ *
+ * Returns an integer list parallel to the aggregated targetlist, with the
+ * attribute numbers of the min/max metadata columns in the compressed scan
+ * tuple, or InvalidAttrNumber for the entries that don't use the metadata.
+ * Returns NIL if some aggregate requires decompression, or if none of them
+ * uses the metadata, because then there is nothing to gain.
+ */
+List *
+vectoragg_plan_batch_metadata(Plan *childplan, List *resolved_targetlist)
+{
+	const CustomScan *custom = castNode(CustomScan, childplan);
+	List *settings = linitial(custom->custom_private);
+
+	if (list_nth_int(settings, DCS_BatchSortedMerge))
+	{
+		/* The batch sorted merge always needs the decompressed batches. */
+		return NIL;
+	}
+
+	const Oid chunk_relid = list_nth_int(settings, DCS_ChunkRelid);
+	CompressionSettings *compression_settings = ts_compression_settings_get(chunk_relid);
+	if (compression_settings == NULL)
+	{
+		return NIL;
+	}
+
+	Plan *compressed_plan = linitial(custom->custom_plans);
+	List *metadata_attnos = NIL;
+	bool have_metadata_aggregates = false;
+
+	ListCell *lc;
+	foreach (lc, resolved_targetlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		if (!IsA(target_entry->expr, Aggref))
+		{
+			/* Grouping columns are segmentby here and need no decompression. */
+			metadata_attnos = lappend_int(metadata_attnos, InvalidAttrNumber);
+			continue;
+		}
+
+		Aggref *aggref = castNode(Aggref, target_entry->expr);
+		if (aggref->aggfilter != NULL)
+		{
+			return NIL;
+		}
+
+		if (aggref->args == NIL)
+		{
+			/* count(*) only uses the batch row count. */
+			metadata_attnos = lappend_int(metadata_attnos, InvalidAttrNumber);
+			continue;
+		}
+
+		if (list_length(aggref->args) != 1)
+		{
+			return NIL;
+		}
+
+		Var *var = castNode(Var, castNode(TargetEntry, linitial(aggref->args))->expr);
+		const char *attname = get_attname(chunk_relid, var->varattno, /* missing_ok = */ false);
+		if (ts_array_is_member(compression_settings->fd.segmentby, attname))
+		{
+			/* The segmentby values are not decompressed anyway. */
+			metadata_attnos = lappend_int(metadata_attnos, InvalidAttrNumber);
+			continue;
+		}
+
+		char *metadata_type = get_aggregate_metadata_type(aggref->aggfnoid);
+		if (metadata_type == NULL || !get_typbyval(var->vartype))
+		{
+			return NIL;
+		}
+
+		const AttrNumber compressed_chunk_attno =
+			compressed_column_metadata_attno(compression_settings,
+											 chunk_relid,
+											 var->varattno,
+											 compression_settings->fd.compress_relid,
+											 metadata_type);
+		if (compressed_chunk_attno == InvalidAttrNumber)
+		{
+			return NIL;
+		}
+
+		const AttrNumber compressed_scan_attno =
+			find_compressed_scan_attno(compressed_plan, compressed_chunk_attno);
+		if (compressed_scan_attno == InvalidAttrNumber)
+		{
+			return NIL;
+		}
+
+		metadata_attnos = lappend_int(metadata_attnos, compressed_scan_attno);
+		have_metadata_aggregates = true;
+	}
+
+	return have_metadata_aggregates ? metadata_attnos : NIL;
+}
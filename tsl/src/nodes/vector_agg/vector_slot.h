@@ -75,6 +75,7 @@ vector_slot_get_compressed_column_values(TupleTableSlot *slot, const AttrNumber
 		else if (arrow->dictionary)
 		{
 			values->decompression_type = DT_ArrowTextDict;
+			values->arrow = (ArrowArray *) arrow;
 			values->buffers[0] = arrow->buffers[0];
 			values->buffers[1] = arrow->dictionary->buffers[1];
 			values->buffers[2] = arrow->dictionary->buffers[2];
@@ -83,6 +84,7 @@ vector_slot_get_compressed_column_values(TupleTableSlot *slot, const AttrNumber
 		else
 		{
 			values->decompression_type = DT_ArrowText;
+			values->arrow = (ArrowArray *) arrow;
 			values->buffers[0] = arrow->buffers[0];
 			values->buffers[1] = arrow->buffers[1];
 			values->buffers[2] = arrow->buffers[2];
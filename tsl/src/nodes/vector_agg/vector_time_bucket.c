@@ -0,0 +1,444 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized time_bucket() used as a grouping expression for the hash grouping
+ * policy. It produces a fixed-width column of bucketed values from the
+ * decompressed column, which is then handed to the usual hashing strategies
+ * as if it was a decompressed column itself.
+ */
+
+#include <postgres.h>
+
+#include <catalog/pg_type.h>
+#include <common/int.h>
+#include <nodes/nodeFuncs.h>
+#include <utils/datetime.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include "vector_time_bucket.h"
+
+#include "compat/compat.h"
+#include "compression/arrow_c_data_interface.h"
+#include "func_cache.h"
+
+/*
+ * The default origin of time_bucket() for timestamps, Monday 2000-01-03. Must
+ * match the one in time_bucket.c.
+ */
+#define DEFAULT_ORIGIN (2 * USECS_PER_DAY)
+
+/*
+ * The limit on the absolute values of the period, shift and the bucketed
+ * value for the 8-byte types, so that the bucket computation cannot overflow.
+ * The values outside this range are bucketed by the SQL function.
+ */
+#define SAFE_LIMIT_64 (PG_INT64_MAX / 4)
+
+static bool
+interval_get_fixed_usecs(const Interval *interval, bool allow_days, int64 *usecs)
+{
+	if (interval->month != 0)
+	{
+		/* Month buckets are not fixed-width. */
+		return false;
+	}
+
+	if (interval->day != 0 && !allow_days)
+	{
+		/*
+		 * The day arithmetic for timestamptz depends on the time zone, so it
+		 * is not fixed-width either.
+		 */
+		return false;
+	}
+
+	int64 day_usecs;
+	if (pg_mul_s64_overflow(interval->day, USECS_PER_DAY, &day_usecs) ||
+		pg_add_s64_overflow(interval->time, day_usecs, usecs))
+	{
+		return false;
+	}
+
+	return *usecs >= -SAFE_LIMIT_64 && *usecs <= SAFE_LIMIT_64;
+}
+
+/*
+ * Determine the period and the shift of the bucket boundaries for the given
+ * time_bucket() call, if it is supported for vectorized computation.
+ */
+static bool
+get_bucket_parameters(FuncExpr *func, int64 *period, int64 *shift)
+{
+	const int nargs = list_length(func->args);
+	Const *period_const = castNode(Const, linitial(func->args));
+	Var *var = castNode(Var, lsecond(func->args));
+	Const *third_const = nargs > 2 ? castNode(Const, lthird(func->args)) : NULL;
+	int64 offset = 0;
+
+	switch (var->vartype)
+	{
+		case INT2OID:
+			*period = DatumGetInt16(period_const->constvalue);
+			offset = third_const ? DatumGetInt16(third_const->constvalue) : 0;
+			break;
+		case INT4OID:
+			*period = DatumGetInt32(period_const->constvalue);
+			offset = third_const ? DatumGetInt32(third_const->constvalue) : 0;
+			break;
+		case INT8OID:
+			*period = DatumGetInt64(period_const->constvalue);
+			offset = third_const ? DatumGetInt64(third_const->constvalue) : 0;
+			break;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		{
+			if (!interval_get_fixed_usecs(DatumGetIntervalP(period_const->constvalue),
+										  /* allow_days = */ true,
+										  period))
+			{
+				return false;
+			}
+
+			if (*period <= 0)
+			{
+				return false;
+			}
+
+			if (third_const == NULL)
+			{
+				/* Default origin. */
+				offset = DEFAULT_ORIGIN;
+			}
+			else if (third_const->consttype == INTERVALOID)
+			{
+				/*
+				 * The offset is applied as (time_bucket(ts - offset) + offset),
+				 * with the default origin, so it is the same as the origin
+				 * shifted by the offset.
+				 */
+				int64 offset_usecs;
+				if (!interval_get_fixed_usecs(DatumGetIntervalP(third_const->constvalue),
+											  /* allow_days = */ var->vartype == TIMESTAMPOID,
+											  &offset_usecs))
+				{
+					return false;
+				}
+				offset = DEFAULT_ORIGIN % *period + offset_usecs % *period;
+			}
+			else
+			{
+				/* Explicit origin. */
+				Assert(third_const->consttype == var->vartype);
+				offset = DatumGetTimestamp(third_const->constvalue);
+				if (TIMESTAMP_NOT_FINITE(offset))
+				{
+					return false;
+				}
+			}
+			break;
+		}
+		default:
+			return false;
+	}
+
+	if (*period <= 0 || *period > SAFE_LIMIT_64)
+	{
+		/* This is an error for time_bucket(), let the SQL function report it. */
+		return false;
+	}
+
+	*shift = offset % *period;
+	return true;
+}
+
+/*
+ * Check whether the given function expression is a time_bucket() call that we
+ * can compute in vectorized fashion, and return the bucketed Var if it is.
+ */
+Var *
+vector_time_bucket_get_var(FuncExpr *func)
+{
+	FuncInfo *finfo = ts_func_cache_get_bucketing_func(func->funcid);
+	if (finfo == NULL || finfo->origin != ORIGIN_TIMESCALE ||
+		strcmp(finfo->funcname, "time_bucket") != 0)
+	{
+		return NULL;
+	}
+
+	const int nargs = list_length(func->args);
+	if (nargs != 2 && nargs != 3)
+	{
+		/* The variant with time zone is not fixed-width. */
+		return NULL;
+	}
+
+	ListCell *lc;
+	foreach (lc, func->args)
+	{
+		Node *arg = lfirst(lc);
+		if (foreach_current_index(lc) == 1)
+		{
+			if (!IsA(arg, Var))
+			{
+				return NULL;
+			}
+		}
+		else if (!IsA(arg, Const) || castNode(Const, arg)->constisnull)
+		{
+			return NULL;
+		}
+	}
+
+	Var *var = castNode(Var, lsecond(func->args));
+	if (var->vartype != func->funcresulttype)
+	{
+		return NULL;
+	}
+
+	int64 period;
+	int64 shift;
+	if (!get_bucket_parameters(func, &period, &shift))
+	{
+		return NULL;
+	}
+
+	return var;
+}
+
+VectorTimeBucket *
+vector_time_bucket_create(FuncExpr *func)
+{
+	VectorTimeBucket *bucket = palloc0(sizeof(VectorTimeBucket));
+	Var *var = vector_time_bucket_get_var(func);
+	Ensure(var != NULL, "unsupported time_bucket() in vectorized grouping");
+
+	bucket->typid = var->vartype;
+	bucket->value_bytes = get_typlen(var->vartype);
+
+	const bool valid = get_bucket_parameters(func, &bucket->period, &bucket->shift);
+	Assert(valid);
+	(void) valid;
+
+	const int64 margin = 2 * bucket->period + Abs(bucket->shift);
+	switch (bucket->typid)
+	{
+		case INT2OID:
+			bucket->safe_min = PG_INT16_MIN + margin;
+			bucket->safe_max = PG_INT16_MAX - margin;
+			break;
+		case INT4OID:
+			bucket->safe_min = (int64) PG_INT32_MIN + margin;
+			bucket->safe_max = (int64) PG_INT32_MAX - margin;
+			break;
+		default:
+			/*
+			 * This also excludes the non-finite timestamps, which are returned
+			 * as is by time_bucket().
+			 */
+			bucket->safe_min = -SAFE_LIMIT_64;
+			bucket->safe_max = SAFE_LIMIT_64;
+			break;
+	}
+
+	const int nargs = list_length(func->args);
+	fmgr_info(func->funcid, &bucket->flinfo);
+	bucket->fcinfo = HEAP_FCINFO(nargs);
+	InitFunctionCallInfoData(*bucket->fcinfo,
+							 &bucket->flinfo,
+							 nargs,
+							 func->inputcollid,
+							 NULL,
+							 NULL);
+	for (int i = 0; i < nargs; i++)
+	{
+		if (i == 1)
+		{
+			/* This is the bucketed value. */
+			continue;
+		}
+
+		Const *c = castNode(Const, list_nth(func->args, i));
+		bucket->fcinfo->args[i].value = c->constvalue;
+		bucket->fcinfo->args[i].isnull = false;
+	}
+
+	return bucket;
+}
+
+static Datum
+time_bucket_call(VectorTimeBucket *bucket, Datum value)
+{
+	FunctionCallInfo fcinfo = bucket->fcinfo;
+	fcinfo->args[1].value = value;
+	fcinfo->args[1].isnull = false;
+	fcinfo->isnull = false;
+	Datum result = FunctionCallInvoke(fcinfo);
+	Ensure(!fcinfo->isnull, "time_bucket() returned null for a non-null value");
+	return result;
+}
+
+static pg_attribute_always_inline int64
+time_bucket_value(int64 value, int64 period, int64 shift)
+{
+	const int64 shifted = value - shift;
+	int64 quotient = shifted / period;
+	if (shifted % period < 0)
+	{
+		/* The C division truncates toward zero, we need floor. */
+		quotient--;
+	}
+	return quotient * period + shift;
+}
+
+static pg_attribute_always_inline void
+compute_bucket_impl(VectorTimeBucket *bucket, const CompressedColumnValues *input,
+					const uint64 *filter, int nrows, int value_bytes)
+{
+	const uint64 *validity = input->buffers[0];
+	const void *input_values = input->buffers[1];
+	const int64 period = bucket->period;
+	const int64 shift = bucket->shift;
+	const int64 safe_min = bucket->safe_min;
+	const int64 safe_max = bucket->safe_max;
+
+#define READ_VALUE(ARRAY, ROW)                                                                     \
+	(value_bytes == 2 ? ((const int16 *) (ARRAY))[ROW] :                                           \
+	 value_bytes == 4 ? ((const int32 *) (ARRAY))[ROW] :                                           \
+						((const int64 *) (ARRAY))[ROW])
+
+#define WRITE_VALUE(ARRAY, ROW, VALUE)                                                             \
+	do                                                                                             \
+	{                                                                                              \
+		if (value_bytes == 2)                                                                      \
+			((int16 *) (ARRAY))[ROW] = (VALUE);                                                    \
+		else if (value_bytes == 4)                                                                 \
+			((int32 *) (ARRAY))[ROW] = (VALUE);                                                    \
+		else                                                                                       \
+			((int64 *) (ARRAY))[ROW] = (VALUE);                                                    \
+	} while (0)
+
+	/*
+	 * First, compute the buckets for all rows without branching, clamping the
+	 * values to the range where the computation is exact. The null rows and
+	 * the rows that don't pass the filter are computed as well, but are not
+	 * used.
+	 */
+	bool have_unsafe = false;
+	for (int row = 0; row < nrows; row++)
+	{
+		const int64 value = READ_VALUE(input_values, row);
+		have_unsafe |= (value < safe_min) | (value > safe_max);
+		const int64 clamped = Min(Max(value, safe_min), safe_max);
+		WRITE_VALUE(bucket->values, row, time_bucket_value(clamped, period, shift));
+	}
+
+	if (likely(!have_unsafe))
+	{
+		return;
+	}
+
+	/*
+	 * We have some values that are close to the boundaries of the type range,
+	 * or not finite. Compute them using the SQL function. This is done only for
+	 * the valid rows that pass the filter, because the function can throw an
+	 * out of range error.
+	 */
+	for (int row = 0; row < nrows; row++)
+	{
+		const int64 value = READ_VALUE(input_values, row);
+		if (likely(value >= safe_min && value <= safe_max))
+		{
+			continue;
+		}
+
+		if (!arrow_row_both_valid(validity, filter, row))
+		{
+			continue;
+		}
+
+		int64 result;
+		switch (value_bytes)
+		{
+			case 2:
+				result = DatumGetInt16(time_bucket_call(bucket, Int16GetDatum(value)));
+				break;
+			case 4:
+				result = DatumGetInt32(time_bucket_call(bucket, Int32GetDatum(value)));
+				break;
+			default:
+				result = DatumGetInt64(time_bucket_call(bucket, Int64GetDatum(value)));
+				break;
+		}
+		WRITE_VALUE(bucket->values, row, result);
+	}
+
+#undef READ_VALUE
+#undef WRITE_VALUE
+}
+
+/*
+ * Compute the time_bucket() for the given decompressed column of the batch.
+ * The result refers to the storage owned by the VectorTimeBucket and is valid
+ * until the next call.
+ */
+void
+vector_time_bucket_compute(VectorTimeBucket *bucket, const CompressedColumnValues *input,
+						   const uint64 *filter, int nrows, CompressedColumnValues *result)
+{
+	*result = *input;
+	result->arrow = NULL;
+
+	if (input->decompression_type == DT_Scalar)
+	{
+		/*
+		 * Segmentby column or a compressed column with default value, the
+		 * bucket is the same for the entire batch.
+		 */
+		bucket->scalar_isnull = *input->output_isnull;
+		bucket->scalar_value =
+			bucket->scalar_isnull ? (Datum) 0 : time_bucket_call(bucket, *input->output_value);
+		result->output_value = &bucket->scalar_value;
+		result->output_isnull = &bucket->scalar_isnull;
+		return;
+	}
+
+	Ensure(input->decompression_type == bucket->value_bytes,
+		   "unexpected decompression type %d for time_bucket() input",
+		   input->decompression_type);
+
+	if (nrows > bucket->num_allocated_values)
+	{
+		if (bucket->values != NULL)
+		{
+			pfree(bucket->values);
+		}
+
+		/* The value buffer has 64-byte padding as required by Arrow. */
+		bucket->num_allocated_values = nrows;
+		bucket->values = MemoryContextAlloc(GetMemoryChunkContext(bucket),
+											pad_to_multiple(64, bucket->value_bytes * nrows));
+	}
+
+	switch (bucket->value_bytes)
+	{
+		case 2:
+			compute_bucket_impl(bucket, input, filter, nrows, 2);
+			break;
+		case 4:
+			compute_bucket_impl(bucket, input, filter, nrows, 4);
+			break;
+		case 8:
+			compute_bucket_impl(bucket, input, filter, nrows, 8);
+			break;
+		default:
+			Ensure(false, "unexpected value size %d for time_bucket()", bucket->value_bytes);
+			pg_unreachable();
+	}
+
+	result->buffers[1] = bucket->values;
+}
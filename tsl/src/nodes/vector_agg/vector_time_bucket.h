@@ -0,0 +1,56 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <nodes/primnodes.h>
+
+#include "nodes/decompress_chunk/compressed_batch.h"
+
+/*
+ * Vectorized computation of a fixed-width time_bucket() over a compressed
+ * column, used as a grouping expression by the hash grouping policy.
+ *
+ * All supported variants of time_bucket() can be reduced to the form
+ * floor((value - shift) / period) * period + shift, where the period and the
+ * shift are known at planning time. We use this form for the bulk computation,
+ * and fall back to calling the actual SQL function for the rows that are close
+ * to the boundaries of the type range, to reproduce its exact behavior for the
+ * non-finite values and the out of range errors.
+ */
+typedef struct VectorTimeBucket
+{
+	/* The type of the bucketed column, which is also the result type. */
+	Oid typid;
+	int16 value_bytes;
+
+	/* Bucket width and the shift of the bucket boundaries, in column units. */
+	int64 period;
+	int64 shift;
+
+	/* The range of values for which the bulk computation is exact. */
+	int64 safe_min;
+	int64 safe_max;
+
+	/* The SQL function call used for the rows outside of the safe range. */
+	FmgrInfo flinfo;
+	FunctionCallInfo fcinfo;
+
+	/*
+	 * The result storage, reused across batches.
+	 */
+	void *values;
+	int num_allocated_values;
+	Datum scalar_value;
+	bool scalar_isnull;
+} VectorTimeBucket;
+
+extern Var *vector_time_bucket_get_var(FuncExpr *func);
+extern VectorTimeBucket *vector_time_bucket_create(FuncExpr *func);
+extern void vector_time_bucket_compute(VectorTimeBucket *bucket, const CompressedColumnValues *input,
+									   const uint64 *filter, int nrows,
+									   CompressedColumnValues *result);
@@ -0,0 +1,551 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <commands/explain.h>
+#include <executor/executor.h>
+#include <executor/tuptable.h>
+#include <miscadmin.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/pg_list.h>
+#include <parser/parsetree.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/ruleutils.h>
+#include <utils/tuplesort.h>
+#include <utils/typcache.h>
+
+#include "compression/arrow_c_data_interface.h"
+#include "debug_assert.h"
+#include "nodes/decompress_chunk/compressed_batch.h"
+#include "nodes/decompress_chunk/exec.h"
+#include "nodes/vector_sort/vector_sort.h"
+
+typedef struct VectorSortState
+{
+	CustomScanState custom;
+
+	/* The sort keys of the replaced Sort node. */
+	int num_sort_keys;
+	AttrNumber *sort_col_idx;
+	Oid *sort_operators;
+	Oid *collations;
+	bool *nulls_first;
+
+	/*
+	 * For each sorted column, the index of the DecompressChunk compressed
+	 * column that holds its values.
+	 */
+	int *input_offsets;
+
+	/* The tuples built from the decompressed batches for sorting. */
+	TupleTableSlot *input_slot;
+
+	/* The sorted tuples that we return. */
+	TupleTableSlot *sorted_slot;
+
+	Tuplesortstate *tuplesort;
+	bool sort_done;
+
+	/* Whether the parent node can rewind, scan backward or mark the output. */
+	bool random_access;
+} VectorSortState;
+
+static void
+vector_sort_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	VectorSortState *state = (VectorSortState *) node;
+	CustomScan *cscan = castNode(CustomScan, node->ss.ps.plan);
+
+	/*
+	 * Like the Sort node, we can rewind, scan backward and restore the marked
+	 * positions using the sorted output, so the child doesn't have to support
+	 * this.
+	 */
+	state->random_access =
+		(eflags & (EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) != 0;
+	eflags &= ~(EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK);
+
+	node->custom_ps =
+		lappend(node->custom_ps, ExecInitNode(linitial(cscan->custom_plans), estate, eflags));
+
+	List *sort_col_idx = list_nth(cscan->custom_private, VSSI_SortColIdx);
+	List *sort_operators = list_nth(cscan->custom_private, VSSI_SortOperators);
+	List *collations = list_nth(cscan->custom_private, VSSI_Collations);
+	List *nulls_first = list_nth(cscan->custom_private, VSSI_NullsFirst);
+
+	state->num_sort_keys = list_length(sort_col_idx);
+	state->sort_col_idx = palloc(sizeof(AttrNumber) * state->num_sort_keys);
+	state->sort_operators = palloc(sizeof(Oid) * state->num_sort_keys);
+	state->collations = palloc(sizeof(Oid) * state->num_sort_keys);
+	state->nulls_first = palloc(sizeof(bool) * state->num_sort_keys);
+	for (int i = 0; i < state->num_sort_keys; i++)
+	{
+		state->sort_col_idx[i] = list_nth_int(sort_col_idx, i);
+		state->sort_operators[i] = list_nth_oid(sort_operators, i);
+		state->collations[i] = list_nth_oid(collations, i);
+		state->nulls_first[i] = list_nth_int(nulls_first, i);
+	}
+
+	/*
+	 * Find the compressed columns of DecompressChunk that hold the values of
+	 * the sorted columns.
+	 */
+	const DecompressChunkState *decompress_state = linitial(node->custom_ps);
+	const DecompressContext *dcontext = &decompress_state->decompress_context;
+	List *input_attnos = list_nth(cscan->custom_private, VSSI_InputAttnos);
+	state->input_offsets = palloc(sizeof(int) * list_length(input_attnos));
+	for (int i = 0; i < list_length(input_attnos); i++)
+	{
+		const AttrNumber attno = list_nth_int(input_attnos, i);
+		int offset = -1;
+		for (int j = 0; j < dcontext->num_data_columns; j++)
+		{
+			if (dcontext->compressed_chunk_columns[j].custom_scan_attno == attno)
+			{
+				offset = j;
+				break;
+			}
+		}
+		Ensure(offset >= 0, "decompressed column %d not found", attno);
+		state->input_offsets[i] = offset;
+	}
+
+	TupleDesc tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	Assert(tupdesc->natts == list_length(input_attnos));
+	state->input_slot = ExecInitExtraTupleSlot(estate, tupdesc, &TTSOpsVirtual);
+	state->sorted_slot = ExecInitExtraTupleSlot(estate, tupdesc, &TTSOpsMinimalTuple);
+}
+
+static void
+vector_sort_end(CustomScanState *node)
+{
+	VectorSortState *state = (VectorSortState *) node;
+
+	/* The slot might reference the tuplesort memory, so clear it first. */
+	ExecClearTuple(state->sorted_slot);
+
+	if (state->tuplesort != NULL)
+	{
+		tuplesort_end(state->tuplesort);
+		state->tuplesort = NULL;
+	}
+
+	ExecEndNode(linitial(node->custom_ps));
+}
+
+static void
+vector_sort_rescan(CustomScanState *node)
+{
+	VectorSortState *state = (VectorSortState *) node;
+
+	ExecClearTuple(state->sorted_slot);
+
+	/*
+	 * If the parameters didn't change, and we have kept the sorted output for
+	 * random access, we can just rewind it. Otherwise we have to sort again.
+	 */
+	if (state->sort_done && node->ss.ps.chgParam == NULL && state->random_access)
+	{
+		tuplesort_rescan(state->tuplesort);
+		return;
+	}
+
+	if (state->tuplesort != NULL)
+	{
+		tuplesort_end(state->tuplesort);
+		state->tuplesort = NULL;
+	}
+	state->sort_done = false;
+
+	if (node->ss.ps.chgParam != NULL)
+		UpdateChangedParamSet(linitial(node->custom_ps), node->ss.ps.chgParam);
+
+	ExecReScan(linitial(node->custom_ps));
+}
+
+static void
+vector_sort_mark_pos(CustomScanState *node)
+{
+	VectorSortState *state = (VectorSortState *) node;
+
+	if (!state->sort_done)
+		return;
+
+	tuplesort_markpos(state->tuplesort);
+}
+
+static void
+vector_sort_restr_pos(CustomScanState *node)
+{
+	VectorSortState *state = (VectorSortState *) node;
+
+	if (!state->sort_done)
+		return;
+
+	tuplesort_restorepos(state->tuplesort);
+}
+
+/*
+ * Get the value of the given row of a decompressed column. This follows
+ * make_next_tuple() in compressed_batch.c, but doesn't store the values into
+ * the decompressed scan slot of DecompressChunk.
+ */
+static pg_attribute_always_inline void
+get_decompressed_value(const CompressedColumnValues *column_values, int arrow_row,
+					   Datum *restrict value, bool *restrict isnull)
+{
+	if (column_values->decompression_type == DT_Iterator ||
+		column_values->decompression_type == DT_Scalar)
+	{
+		/*
+		 * The row-by-row decompressed columns are advanced for each row by
+		 * the caller, and the scalar values are the same for the entire batch.
+		 * In both cases, the value is in the decompressed scan slot.
+		 */
+		*value = *column_values->output_value;
+		*isnull = *column_values->output_isnull;
+		return;
+	}
+
+	*isnull = !arrow_row_is_valid(column_values->buffers[0], arrow_row);
+
+	if (column_values->decompression_type > SIZEOF_DATUM)
+	{
+		/*
+		 * Fixed-width by-reference type that doesn't fit into a Datum,
+		 * such as UUID, or the 8-byte types on 32-bit systems.
+		 */
+		const int value_bytes = column_values->decompression_type;
+		const char *src = column_values->buffers[1];
+		*value = PointerGetDatum(&src[value_bytes * arrow_row]);
+	}
+	else if (column_values->decompression_type == DT_ArrowBits)
+	{
+		*value = BoolGetDatum(arrow_row_is_valid(column_values->buffers[1], arrow_row));
+	}
+	else if (column_values->decompression_type > 0)
+	{
+		/*
+		 * Fixed-width by-value type that fits into a Datum. The arrow buffers
+		 * are padded, so we can always read 8 bytes, see make_next_tuple().
+		 */
+		const uint8 value_bytes = column_values->decompression_type;
+		const char *src = column_values->buffers[1];
+		memcpy(value, &src[value_bytes * arrow_row], SIZEOF_DATUM);
+	}
+	else
+	{
+		/*
+		 * Text or another varlena type. The decompressed scan slot has a
+		 * buffer for the datum with the varlena header, which is big enough
+		 * for any value in the batch. We can reuse it, because the tuplesort
+		 * copies the tuple.
+		 */
+		Assert(column_values->decompression_type == DT_ArrowText ||
+			   column_values->decompression_type == DT_ArrowTextDict);
+		if (*isnull)
+		{
+			*value = (Datum) 0;
+			return;
+		}
+
+		const int text_row = column_values->decompression_type == DT_ArrowTextDict ?
+								 ((int16 *) column_values->buffers[3])[arrow_row] :
+								 arrow_row;
+		const uint32 start = ((uint32 *) column_values->buffers[1])[text_row];
+		const int32 value_bytes = ((uint32 *) column_values->buffers[1])[text_row + 1] - start;
+		Assert(value_bytes >= 0);
+
+		*value = *column_values->output_value;
+		Assert(DatumGetPointer(*value) != NULL);
+		SET_VARSIZE(DatumGetPointer(*value), value_bytes + VARHDRSZ);
+		memcpy(VARDATA(DatumGetPointer(*value)),
+			   &((uint8 *) column_values->buffers[2])[start],
+			   value_bytes);
+	}
+}
+
+/*
+ * Advance the compressed columns that are decompressed row-by-row, because
+ * they don't support bulk decompression. This has to be done for every row,
+ * even when it doesn't pass the vectorized quals.
+ */
+static void
+advance_iterators(DecompressBatchState *batch_state, int num_data_columns)
+{
+	for (int i = 0; i < num_data_columns; i++)
+	{
+		CompressedColumnValues *column_values = &batch_state->compressed_columns[i];
+		if (column_values->decompression_type != DT_Iterator)
+		{
+			continue;
+		}
+
+		DecompressionIterator *iterator = (DecompressionIterator *) column_values->buffers[0];
+		DecompressResult result = iterator->try_next(iterator);
+		if (result.is_done)
+		{
+			elog(ERROR, "compressed column out of sync with batch counter");
+		}
+
+		*column_values->output_isnull = result.is_null;
+		*column_values->output_value = result.val;
+	}
+}
+
+/*
+ * Put the rows of a decompressed batch that pass the vectorized quals into
+ * the tuplesort. The tuples are built directly from the decompressed arrow
+ * arrays, bypassing the tuple-by-tuple output of DecompressChunk.
+ */
+static void
+vector_sort_add_batch(VectorSortState *state, const DecompressContext *dcontext,
+					  DecompressBatchState *batch_state)
+{
+	TupleTableSlot *slot = state->input_slot;
+	const int natts = slot->tts_tupleDescriptor->natts;
+	const int num_data_columns = dcontext->num_data_columns;
+	const int n = batch_state->total_batch_rows;
+	const uint64 *restrict filter = batch_state->vector_qual_result;
+
+	bool have_iterators = false;
+	for (int i = 0; i < num_data_columns; i++)
+	{
+		if (batch_state->compressed_columns[i].decompression_type == DT_Iterator)
+		{
+			have_iterators = true;
+			break;
+		}
+	}
+
+	for (int output_row = 0; output_row < n; output_row++)
+	{
+		/*
+		 * The row-by-row decompression follows the scan direction of
+		 * DecompressChunk, so we have to read the arrow arrays in the same
+		 * order, see compressed_batch_advance().
+		 */
+		const int arrow_row = unlikely(dcontext->reverse) ? n - 1 - output_row : output_row;
+
+		if (have_iterators)
+		{
+			advance_iterators(batch_state, num_data_columns);
+		}
+
+		if (!arrow_row_is_valid(filter, arrow_row))
+		{
+			continue;
+		}
+
+		for (int i = 0; i < natts; i++)
+		{
+			get_decompressed_value(&batch_state->compressed_columns[state->input_offsets[i]],
+								   arrow_row,
+								   &slot->tts_values[i],
+								   &slot->tts_isnull[i]);
+		}
+
+		/*
+		 * It's a virtual tuple slot, so we can just update the values in-place
+		 * for each row, see make_next_tuple().
+		 */
+		if (TTS_EMPTY(slot))
+		{
+			ExecStoreVirtualTuple(slot);
+		}
+
+		tuplesort_puttupleslot(state->tuplesort, slot);
+	}
+
+	/* The values reference the batch memory, which is reset for the next batch. */
+	ExecClearTuple(slot);
+}
+
+/*
+ * Read all the compressed batches from the child of DecompressChunk, and sort
+ * their rows.
+ */
+static void
+vector_sort_perform(VectorSortState *state)
+{
+	DecompressChunkState *decompress_state =
+		(DecompressChunkState *) linitial(state->custom.custom_ps);
+	const DecompressContext *dcontext = &decompress_state->decompress_context;
+	PlanState *compressed_scan = linitial(decompress_state->csstate.custom_ps);
+
+	Assert(state->tuplesort == NULL);
+	state->tuplesort = tuplesort_begin_heap(state->input_slot->tts_tupleDescriptor,
+											state->num_sort_keys,
+											state->sort_col_idx,
+											state->sort_operators,
+											state->collations,
+											state->nulls_first,
+											work_mem,
+											NULL,
+											state->random_access ? TUPLESORT_RANDOMACCESS :
+																   TUPLESORT_NONE);
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		TupleTableSlot *compressed_slot = ExecProcNode(compressed_scan);
+		if (TupIsNull(compressed_slot))
+		{
+			break;
+		}
+
+		DecompressBatchState *batch_state =
+			decompress_chunk_load_batch(decompress_state, compressed_slot);
+		if (batch_state == NULL)
+		{
+			/* The entire batch is filtered out by the vectorized quals. */
+			continue;
+		}
+
+		vector_sort_add_batch(state, dcontext, batch_state);
+
+		decompress_chunk_count_batch_rows(decompress_state, batch_state);
+	}
+
+	tuplesort_performsort(state->tuplesort);
+	state->sort_done = true;
+}
+
+static TupleTableSlot *
+vector_sort_exec(CustomScanState *node)
+{
+	VectorSortState *state = (VectorSortState *) node;
+
+	if (!state->sort_done)
+	{
+		vector_sort_perform(state);
+	}
+
+	/*
+	 * Like in the Sort node, the tuple is not copied, and the slot is cleared
+	 * at the end of the sorted output.
+	 */
+	(void) tuplesort_gettupleslot(state->tuplesort,
+								  ScanDirectionIsForward(node->ss.ps.state->es_direction),
+								  /* copy = */ false,
+								  state->sorted_slot,
+								  NULL);
+	return state->sorted_slot;
+}
+
+/*
+ * Append the ordering options of a sort key to its EXPLAIN output, the same
+ * way as it is done for the Sort node.
+ */
+static void
+append_sort_order_options(StringInfo buf, Node *sortexpr, Oid sort_operator, Oid collation,
+						  bool nulls_first)
+{
+	const Oid sortcoltype = exprType(sortexpr);
+	bool reverse = false;
+	TypeCacheEntry *typentry =
+		lookup_type_cache(sortcoltype, TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+
+	/* Print COLLATE if it's not default for the column's type. */
+	if (OidIsValid(collation) && collation != get_typcollation(sortcoltype))
+	{
+		char *collname = get_collation_name(collation);
+		if (collname == NULL)
+			elog(ERROR, "cache lookup failed for collation %u", collation);
+		appendStringInfo(buf, " COLLATE %s", quote_identifier(collname));
+	}
+
+	/* Print direction if not ASC, or USING if non-default sort operator. */
+	if (sort_operator == typentry->gt_opr)
+	{
+		appendStringInfoString(buf, " DESC");
+		reverse = true;
+	}
+	else if (sort_operator != typentry->lt_opr)
+	{
+		char *opname = get_opname(sort_operator);
+		if (opname == NULL)
+			elog(ERROR, "cache lookup failed for operator %u", sort_operator);
+		appendStringInfo(buf, " USING %s", opname);
+		/* Determine whether operator would be considered ASC or DESC. */
+		(void) get_equality_op_for_ordering_op(sort_operator, &reverse);
+	}
+
+	/* Add NULLS FIRST/LAST only if it wouldn't be default. */
+	if (nulls_first && !reverse)
+	{
+		appendStringInfoString(buf, " NULLS FIRST");
+	}
+	else if (!nulls_first && reverse)
+	{
+		appendStringInfoString(buf, " NULLS LAST");
+	}
+}
+
+static void
+vector_sort_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	VectorSortState *state = (VectorSortState *) node;
+	Plan *plan = node->ss.ps.plan;
+
+	List *context = set_deparse_context_plan(es->deparse_cxt, plan, ancestors);
+	const bool useprefix = list_length(es->rtable) > 1 || es->verbose;
+
+	List *sort_keys = NIL;
+	for (int i = 0; i < state->num_sort_keys; i++)
+	{
+		TargetEntry *target = get_tle_by_resno(plan->targetlist, state->sort_col_idx[i]);
+		Ensure(target != NULL, "no tlist entry for sort key %d", state->sort_col_idx[i]);
+
+		StringInfoData buf;
+		initStringInfo(&buf);
+		appendStringInfoString(&buf,
+							   deparse_expression((Node *) target->expr,
+												  context,
+												  useprefix,
+												  /* showimplicit = */ true));
+		append_sort_order_options(&buf,
+								  (Node *) target->expr,
+								  state->sort_operators[i],
+								  state->collations[i],
+								  state->nulls_first[i]);
+		sort_keys = lappend(sort_keys, buf.data);
+	}
+	ExplainPropertyList("Sort Key", sort_keys, es);
+
+	if (es->analyze && state->sort_done && state->tuplesort != NULL)
+	{
+		TuplesortInstrumentation stats;
+		tuplesort_get_stats(state->tuplesort, &stats);
+		ExplainPropertyText("Sort Method", tuplesort_method_name(stats.sortMethod), es);
+		ExplainPropertyInteger("Sort Space Used", "kB", stats.spaceUsed, es);
+		ExplainPropertyText("Sort Space Type", tuplesort_space_type_name(stats.spaceType), es);
+	}
+}
+
+static struct CustomExecMethods exec_methods = {
+	.CustomName = VECTOR_SORT_NODE_NAME,
+	.BeginCustomScan = vector_sort_begin,
+	.ExecCustomScan = vector_sort_exec,
+	.EndCustomScan = vector_sort_end,
+	.ReScanCustomScan = vector_sort_rescan,
+	.MarkPosCustomScan = vector_sort_mark_pos,
+	.RestrPosCustomScan = vector_sort_restr_pos,
+	.ExplainCustomScan = vector_sort_explain,
+};
+
+Node *
+vector_sort_state_create(CustomScan *cscan)
+{
+	VectorSortState *state =
+		(VectorSortState *) newNode(sizeof(VectorSortState), T_CustomScanState);
+	state->custom.methods = &exec_methods;
+	return (Node *) state;
+}
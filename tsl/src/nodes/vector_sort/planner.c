@@ -0,0 +1,338 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * VectorSort replaces a Sort node over DecompressChunk. Instead of going
+ * through the tuple-by-tuple output of DecompressChunk, it reads the
+ * decompressed batches using its batch-mode interface, and builds the tuples
+ * for sorting directly from the arrow arrays. This node is added in the
+ * post-planning hook, like VectorAgg.
+ */
+#include <postgres.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/plannodes.h>
+
+#include "import/list.h"
+#include "nodes/decompress_chunk/planner.h"
+#include "nodes/vector_sort/vector_sort.h"
+#include "utils.h"
+
+static CustomScanMethods scan_methods = { .CustomName = VECTOR_SORT_NODE_NAME,
+										  .CreateCustomScanState = vector_sort_state_create };
+
+void
+_vector_sort_init(void)
+{
+	TryRegisterCustomScanMethods(&scan_methods);
+}
+
+/*
+ * Build an output targetlist for a custom node that just references all the
+ * custom scan targetlist entries.
+ */
+static List *
+build_trivial_custom_output_targetlist(List *scan_targetlist)
+{
+	List *result = NIL;
+
+	ListCell *lc;
+	foreach (lc, scan_targetlist)
+	{
+		TargetEntry *scan_entry = (TargetEntry *) lfirst(lc);
+
+		Var *var = makeVar(INDEX_VAR,
+						   scan_entry->resno,
+						   exprType((Node *) scan_entry->expr),
+						   exprTypmod((Node *) scan_entry->expr),
+						   exprCollation((Node *) scan_entry->expr),
+						   /* varlevelsup = */ 0);
+
+		TargetEntry *output_entry = makeTargetEntry((Expr *) var,
+													scan_entry->resno,
+													scan_entry->resname,
+													scan_entry->resjunk);
+
+		result = lappend(result, output_entry);
+	}
+
+	return result;
+}
+
+/*
+ * We build the sorted tuples from the decompressed columns, so DecompressChunk
+ * must output just these columns without any projection. Returns the scan
+ * attribute numbers of the output columns, or NIL if it is not the case.
+ */
+static List *
+get_decompressed_output_attnos(const CustomScan *decompress_chunk)
+{
+	List *decompression_map = list_nth(decompress_chunk->custom_private, DCP_DecompressionMap);
+
+	/*
+	 * The output targetlist references the custom scan targetlist if we have
+	 * one, and the uncompressed chunk columns otherwise.
+	 */
+	const Index scan_varno =
+		decompress_chunk->custom_scan_tlist != NIL ? INDEX_VAR : decompress_chunk->scan.scanrelid;
+
+	List *result = NIL;
+	ListCell *lc;
+	foreach (lc, decompress_chunk->scan.plan.targetlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		if (!IsA(target_entry->expr, Var))
+		{
+			return NIL;
+		}
+
+		Var *var = castNode(Var, target_entry->expr);
+		if ((Index) var->varno != scan_varno || var->varattno <= 0)
+		{
+			return NIL;
+		}
+
+		if (!list_member_int(decompression_map, var->varattno))
+		{
+			return NIL;
+		}
+
+		result = lappend_int(result, var->varattno);
+	}
+
+	return result;
+}
+
+/*
+ * Build the scan targetlist of VectorSort, with the output columns of
+ * DecompressChunk resolved to the uncompressed chunk variables.
+ */
+static List *
+build_vector_sort_scan_targetlist(const Sort *sort, const CustomScan *decompress_chunk)
+{
+	List *result = NIL;
+	ListCell *lc;
+	foreach (lc, decompress_chunk->scan.plan.targetlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		Var *var = castNode(Var, target_entry->expr);
+		if (var->varno == INDEX_VAR)
+		{
+			var = castNode(Var,
+						   list_nth_node(TargetEntry,
+										 decompress_chunk->custom_scan_tlist,
+										 AttrNumberGetAttrOffset(var->varattno))
+							   ->expr);
+		}
+
+		/* Sort doesn't project, so its output columns are the same. */
+		TargetEntry *sort_entry = list_nth_node(TargetEntry,
+												sort->plan.targetlist,
+												AttrNumberGetAttrOffset(target_entry->resno));
+
+		result = lappend(result,
+						 makeTargetEntry((Expr *) copyObject(var),
+										 target_entry->resno,
+										 sort_entry->resname,
+										 sort_entry->resjunk));
+	}
+
+	return result;
+}
+
+/*
+ * Create a vectorized sort node to replace the given Sort node.
+ */
+static Plan *
+vector_sort_plan_create(Sort *sort, CustomScan *decompress_chunk, List *input_attnos)
+{
+	CustomScan *vector_sort = makeNode(CustomScan);
+	vector_sort->custom_plans = list_make1(decompress_chunk);
+	vector_sort->methods = &scan_methods;
+
+	/*
+	 * Like Sort, we support backward scan and mark/restore of the sorted
+	 * output. The planner has already relied on this for the Sort node.
+	 */
+	vector_sort->flags = CUSTOMPATH_SUPPORT_BACKWARD_SCAN | CUSTOMPATH_SUPPORT_MARK_RESTORE;
+
+	/*
+	 * Note that this is being called from the post-planning hook, and therefore
+	 * after set_plan_refs(). The output targetlist must reference the scan
+	 * targetlist with INDEX_VAR special varnos.
+	 */
+	vector_sort->custom_scan_tlist = build_vector_sort_scan_targetlist(sort, decompress_chunk);
+	vector_sort->scan.plan.targetlist =
+		build_trivial_custom_output_targetlist(vector_sort->custom_scan_tlist);
+
+	/*
+	 * Copy the costs from the Sort node, so that they show up in the EXPLAIN
+	 * output. They are not used for any other purposes, because this hook is
+	 * called after the planning is finished.
+	 */
+	vector_sort->scan.plan.plan_rows = sort->plan.plan_rows;
+	vector_sort->scan.plan.plan_width = sort->plan.plan_width;
+	vector_sort->scan.plan.startup_cost = sort->plan.startup_cost;
+	vector_sort->scan.plan.total_cost = sort->plan.total_cost;
+
+	vector_sort->scan.plan.parallel_aware = false;
+	vector_sort->scan.plan.parallel_safe = sort->plan.parallel_safe;
+	vector_sort->scan.plan.async_capable = false;
+
+	vector_sort->scan.plan.plan_node_id = sort->plan.plan_node_id;
+
+	Assert(sort->plan.qual == NIL);
+
+	vector_sort->scan.plan.initPlan = sort->plan.initPlan;
+
+	vector_sort->scan.plan.extParam = bms_copy(sort->plan.extParam);
+	vector_sort->scan.plan.allParam = bms_copy(sort->plan.allParam);
+
+	List *sort_col_idx = NIL;
+	List *sort_operators = NIL;
+	List *collations = NIL;
+	List *nulls_first = NIL;
+	for (int i = 0; i < sort->numCols; i++)
+	{
+		sort_col_idx = lappend_int(sort_col_idx, sort->sortColIdx[i]);
+		sort_operators = lappend_oid(sort_operators, sort->sortOperators[i]);
+		collations = lappend_oid(collations, sort->collations[i]);
+		nulls_first = lappend_int(nulls_first, sort->nullsFirst[i]);
+	}
+
+	vector_sort->custom_private = ts_new_list(T_List, VSSI_Count);
+	lfirst(list_nth_cell(vector_sort->custom_private, VSSI_SortColIdx)) = sort_col_idx;
+	lfirst(list_nth_cell(vector_sort->custom_private, VSSI_SortOperators)) = sort_operators;
+	lfirst(list_nth_cell(vector_sort->custom_private, VSSI_Collations)) = collations;
+	lfirst(list_nth_cell(vector_sort->custom_private, VSSI_NullsFirst)) = nulls_first;
+	lfirst(list_nth_cell(vector_sort->custom_private, VSSI_InputAttnos)) = input_attnos;
+
+	return (Plan *) vector_sort;
+}
+
+/*
+ * Whether a Limit above this node can pass its bound down to the Sort node,
+ * see ExecSetTupleBound().
+ */
+static bool
+passes_tuple_bound(Plan *plan)
+{
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+		case T_MergeAppend:
+		case T_Result:
+		case T_SubqueryScan:
+		case T_Gather:
+		case T_GatherMerge:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static Plan *
+insert_vector_sort_node(Plan *plan, bool bounded)
+{
+	/*
+	 * The bounded Sort only keeps the top N tuples. We can't do this, because
+	 * custom nodes are not told about the bound, so we leave such Sort nodes
+	 * alone.
+	 */
+	const bool child_bounded = (IsA(plan, Limit) && castNode(Limit, plan)->limitCount != NULL) ||
+							   (bounded && passes_tuple_bound(plan));
+
+	if (plan->lefttree)
+	{
+		plan->lefttree = insert_vector_sort_node(plan->lefttree, child_bounded);
+	}
+
+	if (plan->righttree)
+	{
+		plan->righttree = insert_vector_sort_node(plan->righttree, child_bounded);
+	}
+
+	List *append_plans = NIL;
+	if (IsA(plan, Append))
+	{
+		append_plans = castNode(Append, plan)->appendplans;
+	}
+	else if (IsA(plan, MergeAppend))
+	{
+		append_plans = castNode(MergeAppend, plan)->mergeplans;
+	}
+	else if (IsA(plan, CustomScan))
+	{
+		CustomScan *custom = castNode(CustomScan, plan);
+		if (strcmp("ChunkAppend", custom->methods->CustomName) == 0)
+		{
+			append_plans = custom->custom_plans;
+		}
+	}
+	else if (IsA(plan, SubqueryScan))
+	{
+		SubqueryScan *subquery = castNode(SubqueryScan, plan);
+		append_plans = list_make1(subquery->subplan);
+	}
+
+	if (append_plans)
+	{
+		ListCell *lc;
+		foreach (lc, append_plans)
+		{
+			lfirst(lc) = insert_vector_sort_node(lfirst(lc), child_bounded);
+		}
+		return plan;
+	}
+
+	if (!IsA(plan, Sort) || bounded)
+	{
+		return plan;
+	}
+
+	Sort *sort = castNode(Sort, plan);
+	Plan *childplan = sort->plan.lefttree;
+	if (childplan == NULL || !IsA(childplan, CustomScan) ||
+		strcmp(castNode(CustomScan, childplan)->methods->CustomName, "DecompressChunk") != 0)
+	{
+		return plan;
+	}
+
+	if (childplan->qual != NIL)
+	{
+		/*
+		 * The batch-mode output of DecompressChunk doesn't apply the Postgres
+		 * quals, only the vectorized ones.
+		 */
+		return plan;
+	}
+
+	if (list_length(sort->plan.targetlist) != list_length(childplan->targetlist))
+	{
+		/* Not sure what this would mean, but check just to be on the safe side. */
+		return plan;
+	}
+
+	CustomScan *decompress_chunk = castNode(CustomScan, childplan);
+	List *input_attnos = get_decompressed_output_attnos(decompress_chunk);
+	if (input_attnos == NIL)
+	{
+		return plan;
+	}
+
+	return vector_sort_plan_create(sort, decompress_chunk, input_attnos);
+}
+
+/*
+ * Where possible, replace the Sort plan nodes over DecompressChunk with our own
+ * vectorized sort node. The replacement is done in-place.
+ */
+Plan *
+try_insert_vector_sort_node(Plan *plan)
+{
+	return insert_vector_sort_node(plan, /* bounded = */ false);
+}
@@ -0,0 +1,30 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <nodes/plannodes.h>
+
+#define VECTOR_SORT_NODE_NAME "VectorSort"
+
+/*
+ * The indexes of settings that we have to pass through the custom_private list.
+ * These are the sort keys of the replaced Sort node, and the DecompressChunk
+ * scan attribute numbers of the sorted columns.
+ */
+typedef enum
+{
+	VSSI_SortColIdx = 0,
+	VSSI_SortOperators = 1,
+	VSSI_Collations = 2,
+	VSSI_NullsFirst = 3,
+	VSSI_InputAttnos = 4,
+	VSSI_Count
+} VectorSortSettingsIndex;
+
+extern void _vector_sort_init(void);
+extern Plan *try_insert_vector_sort_node(Plan *plan);
+extern Node *vector_sort_state_create(CustomScan *cscan);
@@ -26,6 +26,7 @@
 #include "nodes/gapfill/gapfill.h"
 #include "nodes/skip_scan/skip_scan.h"
 #include "nodes/vector_agg/plan.h"
+#include "nodes/vector_sort/vector_sort.h"
 #include "planner.h"
 #include "planner/partialize.h"
 
@@ -240,6 +241,11 @@ tsl_postprocess_plan(PlannedStmt *stmt)
 		stmt->planTree = try_insert_vector_agg_node(stmt->planTree, stmt->rtable);
 	}
 
+	if (ts_guc_enable_vectorized_sort)
+	{
+		stmt->planTree = try_insert_vector_sort_node(stmt->planTree);
+	}
+
 #ifdef TS_DEBUG
 	if (ts_guc_debug_require_vector_agg != DRO_Allow)
 	{
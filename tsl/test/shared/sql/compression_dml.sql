@@ -271,7 +271,7 @@ BEGIN;
 SELECT count(*) FROM direct_delete WHERE device='d1' AND reading='r2';
 ROLLBACK;
 
--- constraints involving non-segmentby columns should not directly delete
+-- constraints involving non-segmentby columns directly delete batches where all rows match
 BEGIN; :ANALYZE DELETE FROM direct_delete WHERE value = '1.0'; ROLLBACK;
 BEGIN; :ANALYZE DELETE FROM direct_delete WHERE device = 'd1' AND value = '1.0'; ROLLBACK;
 BEGIN; :ANALYZE DELETE FROM direct_delete WHERE reading = 'r1' AND value = '1.0'; ROLLBACK;
@@ -0,0 +1,90 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE fake_now(value int);
+INSERT INTO fake_now VALUES (5);
+CREATE FUNCTION fake_now() RETURNS int LANGUAGE SQL STABLE AS $$ SELECT value FROM fake_now $$;
+
+CREATE VIEW chunk_ranges AS
+SELECT hypertable_name, range_start_integer, range_end_integer
+FROM timescaledb_information.chunks
+ORDER BY hypertable_name, range_start_integer;
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 10);
+
+-- The current time is needed to know which chunks to create
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreation_policy('metrics');
+\set ON_ERROR_STOP 1
+SELECT set_integer_now_func('metrics', 'fake_now');
+
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreation_policy('metrics', 0);
+SELECT add_chunk_precreation_policy('metrics', 1001);
+\set ON_ERROR_STOP 1
+
+INSERT INTO metrics VALUES (5, 1, 1.0);
+SELECT add_chunk_precreation_policy('metrics') AS job_id \gset
+SELECT application_name, schedule_interval, proc_schema, proc_name, check_schema, check_name, config
+FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+
+-- Creates the chunks of the next two time ranges
+CALL run_job(:job_id);
+SELECT * FROM chunk_ranges;
+
+-- The existing chunks are skipped
+CALL run_job(:job_id);
+SELECT * FROM chunk_ranges;
+
+-- Moving the current time creates the chunks ahead of it
+UPDATE fake_now SET value = 27;
+CALL run_job(:job_id);
+SELECT * FROM chunk_ranges;
+
+-- The inserts use the pre-created chunks
+INSERT INTO metrics VALUES (31, 1, 1.0), (45, 1, 1.0);
+SELECT * FROM chunk_ranges;
+
+-- Adding the policy again
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreation_policy('metrics');
+\set ON_ERROR_STOP 1
+SELECT add_chunk_precreation_policy('metrics', if_not_exists => true);
+SELECT add_chunk_precreation_policy('metrics', 5, if_not_exists => true);
+
+SELECT remove_chunk_precreation_policy('metrics');
+SELECT remove_chunk_precreation_policy('metrics', if_exists => true);
+\set ON_ERROR_STOP 0
+SELECT remove_chunk_precreation_policy('metrics');
+\set ON_ERROR_STOP 1
+
+-- With space partitioning, the chunks are created in the partitions of the
+-- current time range
+UPDATE fake_now SET value = 5;
+CREATE TABLE metrics_space(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics_space', 'time', chunk_time_interval => 10);
+SELECT table_name FROM add_dimension('metrics_space', 'device', number_partitions => 2);
+SELECT set_integer_now_func('metrics_space', 'fake_now');
+INSERT INTO metrics_space SELECT 5, d, 1.0 FROM generate_series(1, 4) d;
+SELECT add_chunk_precreation_policy('metrics_space', 3, schedule_interval => '10 min') AS job_id \gset
+SELECT schedule_interval, config FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+CALL run_job(:job_id);
+
+SELECT count(*) AS time_ranges, count(DISTINCT num_chunks) AS partition_counts,
+       min(range_start_integer) AS first_start, max(range_end_integer) AS last_end
+FROM (
+    SELECT range_start_integer, range_end_integer, count(*) AS num_chunks
+    FROM chunk_ranges WHERE hypertable_name = 'metrics_space'
+    GROUP BY 1, 2
+) ranges;
+
+-- The default schedule interval is half of the chunk interval for the
+-- time types
+CREATE TABLE metrics_tz(time timestamptz NOT NULL, value float);
+SELECT table_name FROM create_hypertable('metrics_tz', 'time', chunk_time_interval => interval '1 day');
+SELECT add_chunk_precreation_policy('metrics_tz') AS job_id \gset
+SELECT schedule_interval, config FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+CALL run_job(:job_id);
+SELECT count(*) FROM show_chunks('metrics_tz');
@@ -37,11 +37,28 @@ select count(compress_chunk(decompress_chunk(x))) from show_chunks('sparse') x;
 explain (costs off) select * from sparse where value = 1;
 
 
--- Not for other index types.
+-- The bloom filter sparse index is created for the columns that have hash
+-- indexes.
 drop index ii;
 create index ii on sparse using hash(value);
 select count(compress_chunk(decompress_chunk(x))) from show_chunks('sparse') x;
 explain (costs off) select * from sparse where value = 1;
+explain (costs off) select * from sparse where value = any(array[1, 2]);
+select * from sparse where value = any(array[1, 2]) order by ts;
+
+-- Not for the other operators.
+explain (costs off) select * from sparse where value < 1;
+
+-- The batches to decompress for DML are also filtered by the bloom filter.
+delete from sparse where value = 3;
+update sparse set value = -4 where value = any(array[4, 5]);
+select * from sparse where value in (3, 4, 5, -4) order by ts;
+
+-- Should be disabled with the GUC
+set timescaledb.enable_sparse_index_bloom to off;
+select count(compress_chunk(decompress_chunk(x))) from show_chunks('sparse') x;
+explain (costs off) select * from sparse where value = 1;
+reset timescaledb.enable_sparse_index_bloom;
 
 
 -- When the chunk is recompressed without index, no sparse index is created.
@@ -0,0 +1,113 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test COPY that compresses the rows directly into the compressed chunks.
+
+create table copydirect(ts int, device text, value float);
+select create_hypertable('copydirect', 'ts', chunk_time_interval => 1000);
+alter table copydirect set (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'ts');
+
+insert into copydirect select x, 'd' || x % 3, x from generate_series(0, 99) x;
+select count(compress_chunk(x)) from show_chunks('copydirect') x;
+
+create view chunk_info as
+select ds.range_start, ch.status, ch.compressed_chunk_id is not null as compressed
+from _timescaledb_catalog.chunk ch
+join _timescaledb_catalog.hypertable ht on ht.id = ch.hypertable_id
+join _timescaledb_catalog.chunk_constraint cc on cc.chunk_id = ch.id
+join _timescaledb_catalog.dimension_slice ds on ds.id = cc.dimension_slice_id
+where ht.table_name = 'copydirect'
+order by ds.range_start;
+
+select * from chunk_info;
+
+set timescaledb.enable_direct_compress_copy to on;
+
+\copy copydirect from stdin
+100	d1	100
+101	d2	101
+102	d0	102
+50	d1	50.5
+\.
+
+-- The rows go into the compressed chunk, which is marked unordered but not
+-- partial.
+select * from chunk_info;
+select count(*) from only _timescaledb_internal._hyper_1_1_chunk;
+select count(*), sum(value) from copydirect;
+select * from copydirect where ts in (50, 100, 101, 102) order by ts, value;
+
+-- The chunk insert states can be closed and reopened while the rows are
+-- buffered, and the chunks don't become partial then either.
+insert into copydirect select x, 'd' || x % 3, x from generate_series(1000, 1099) x;
+select count(compress_chunk(x)) from show_chunks('copydirect') x;
+select * from chunk_info;
+
+set timescaledb.max_open_chunks_per_insert to 1;
+\copy copydirect from stdin
+104	d1	104
+1100	d1	1100
+105	d2	105
+1101	d2	1101
+\.
+reset timescaledb.max_open_chunks_per_insert;
+
+select * from chunk_info;
+select count(*) from only _timescaledb_internal._hyper_1_1_chunk;
+select count(*), sum(value) from copydirect;
+
+-- New chunks are not compressed, so the rows go into the uncompressed chunk.
+\copy copydirect from stdin
+2500	d1	2500
+\.
+
+select * from chunk_info;
+
+-- With a unique constraint the rows have to be checked against the existing
+-- batches, so they are inserted into the uncompressed chunk.
+alter table copydirect add unique (device, ts);
+select count(compress_chunk(x)) from show_chunks('copydirect') x;
+
+\copy copydirect from stdin
+103	d1	103
+\.
+
+select * from chunk_info;
+select count(*) from only _timescaledb_internal._hyper_1_1_chunk;
+
+-- The rows might be outside of the ranges of the chunk column stats, so the
+-- ranges are invalidated, and the chunk is not skipped based on them anymore.
+set timescaledb.enable_chunk_skipping to on;
+create table copyskip(ts int not null, device text, value int);
+select table_name from create_hypertable('copyskip', 'ts', chunk_time_interval => 1000);
+alter table copyskip set (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'ts');
+select enabled from enable_chunk_skipping('copyskip', 'value');
+insert into copyskip select x, 'd' || x % 3, x from generate_series(0, 99) x;
+select count(compress_chunk(x)) from show_chunks('copyskip') x;
+
+create view skip_stats as
+select s.range_start, s.range_end, s.valid
+from _timescaledb_catalog.chunk_column_stats s
+join _timescaledb_catalog.hypertable ht on ht.id = s.hypertable_id
+where ht.table_name = 'copyskip' and s.chunk_id != 0;
+
+select * from skip_stats;
+select * from copyskip where value > 200;
+
+\copy copyskip from stdin
+5	d1	500
+\.
+
+select * from skip_stats;
+select * from copyskip where value > 200;
+reset timescaledb.enable_chunk_skipping;
+
+reset timescaledb.enable_direct_compress_copy;
+
+drop view chunk_info;
+drop view skip_stats;
+drop table copydirect;
+drop table copyskip;
@@ -454,6 +454,15 @@ from :fn true) bulk join :fn false) rowbyrow using (path)
 group by 2, 3 order by 1 desc
 ;
 
+\set algo bitpack
+\set type int8
+select count(*)
+    , coalesce((bulk.rows >= 0)::text, bulk.sqlstate) bulk_result
+    , coalesce((rowbyrow.rows >= 0)::text, rowbyrow.sqlstate) rowbyrow_result
+from :fn true) bulk join :fn false) rowbyrow using (path)
+group by 2, 3 order by 1 desc
+;
+
 \set algo array
 \set type text
 select count(*)
@@ -472,3 +481,27 @@ from :fn true) bulk join :fn false) rowbyrow using (path)
 group by 2, 3 order by 1 desc
 ;
 
+-- Benchmark function for the compression algorithms and vectorized kernels.
+-- The timings are not stable, so we only check which kernels are run.
+create or replace function ts_bench_compression(anyarray, cstring, int4,
+    out kernel text, out rows int8, out uncompressed_bytes int8,
+    out compressed_bytes int8, out ns_per_row float8, out mb_per_sec float8)
+returns setof record
+as :TSL_MODULE_PATHNAME, 'ts_bench_compression' language c volatile;
+
+select kernel, rows, uncompressed_bytes, compressed_bytes < uncompressed_bytes compressed,
+    ns_per_row >= 0 timed
+from ts_bench_compression(
+    (select array_agg(case when x % 10 = 0 then null else (x / 10)::float8 end order by x)
+        from generate_series(1, 2500) x),
+    'gorilla', 2);
+
+select kernel, rows, compressed_bytes < uncompressed_bytes compressed, ns_per_row >= 0 timed
+from ts_bench_compression(
+    (select array_agg(format('device %s', x % 7) order by x) from generate_series(1, 2500) x),
+    null, 2);
+
+\set ON_ERROR_STOP 0
+select * from ts_bench_compression(array[1, 2, 3], 'deltadelta', 0);
+select * from ts_bench_compression(array[1, 2, 3], 'lz4', 1);
+\set ON_ERROR_STOP 1
@@ -0,0 +1,61 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the bitpack compression of integer columns. The compressor falls back
+-- to deltadelta for the batches where it is smaller, so the columns with
+-- regular increments should still use deltadelta, and the columns with random
+-- values in a small range should use bitpack.
+CREATE TABLE bitpack(ts int NOT NULL, counter int8, metric_id int4, seq int8, small int2);
+SELECT table_name FROM create_hypertable('bitpack', 'ts', chunk_time_interval => 10000);
+
+CREATE TABLE reference AS
+SELECT g AS ts,
+    1000000 + (h1 & 1023)::int8 AS counter,
+    (h2 & 63)::int4 AS metric_id,
+    (g * 10)::int8 AS seq,
+    CASE WHEN g % 7 = 0 THEN NULL ELSE h3 & 15 END::int2 AS small
+FROM generate_series(1, 3000) g,
+    LATERAL (SELECT ('x' || substr(md5(g::text), 1, 8))::bit(32)::int AS h1,
+        ('x' || substr(md5(g::text), 9, 8))::bit(32)::int AS h2,
+        ('x' || substr(md5(g::text), 17, 8))::bit(32)::int AS h3) h;
+
+INSERT INTO bitpack SELECT * FROM reference;
+
+ALTER TABLE bitpack SET (timescaledb.compress, timescaledb.compress_orderby = 'ts');
+
+SET timescaledb.enable_bitpack_compression = on;
+SELECT count(compress_chunk(x)) FROM show_chunks('bitpack') x;
+RESET timescaledb.enable_bitpack_compression;
+
+SELECT format('%I.%I', comp.schema_name, comp.table_name) AS "CCHUNK"
+FROM _timescaledb_catalog.chunk cat
+    JOIN _timescaledb_catalog.chunk comp ON cat.compressed_chunk_id = comp.id
+    JOIN _timescaledb_catalog.hypertable ht ON ht.id = cat.hypertable_id
+WHERE ht.table_name = 'bitpack'
+\gset
+
+SELECT (_timescaledb_functions.compressed_data_info(ts)).algorithm AS ts,
+    (_timescaledb_functions.compressed_data_info(counter)).algorithm AS counter,
+    (_timescaledb_functions.compressed_data_info(metric_id)).algorithm AS metric_id,
+    (_timescaledb_functions.compressed_data_info(seq)).algorithm AS seq,
+    (_timescaledb_functions.compressed_data_info(small)).algorithm AS small,
+    count(*)
+FROM :CCHUNK
+GROUP BY 1, 2, 3, 4, 5 ORDER BY 1, 2, 3, 4, 5;
+
+-- Bulk decompression
+SELECT count(*) FROM (SELECT * FROM bitpack EXCEPT SELECT * FROM reference) d;
+SELECT sum(counter), sum(metric_id), sum(small), count(small) FROM bitpack;
+SELECT count(*) FROM bitpack WHERE metric_id = 7;
+SELECT count(*) FROM bitpack WHERE small > 12;
+
+-- Row-by-row decompression in both directions
+SET timescaledb.enable_bulk_decompression = off;
+SELECT count(*) FROM (SELECT * FROM bitpack EXCEPT SELECT * FROM reference) d;
+SELECT * FROM bitpack ORDER BY ts LIMIT 7;
+SELECT * FROM bitpack ORDER BY ts DESC LIMIT 7;
+RESET timescaledb.enable_bulk_decompression;
+
+DROP TABLE bitpack;
+DROP TABLE reference;
@@ -0,0 +1,77 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the bulk decompression of array and dictionary compressed columns of
+-- various types besides text and bool. The fixed-width by-value types, the
+-- fixed-width by-reference types that don't fit into Datum, and the varlena
+-- types are supported. The rest, e.g. macaddr, use row-by-row decompression.
+CREATE TYPE bulk_enum AS ENUM ('a', 'b', 'c');
+
+CREATE TABLE bulk_types(ts int NOT NULL, u uuid, n numeric, j jsonb, b bytea, e bulk_enum,
+    c "char", i interval, nm name, m macaddr);
+SELECT table_name FROM create_hypertable('bulk_types', 'ts', chunk_time_interval => 10000);
+
+CREATE TABLE reference AS
+SELECT g AS ts,
+    CASE WHEN g % 11 = 0 THEN NULL ELSE md5((g % 50)::text)::uuid END AS u,
+    CASE WHEN g % 13 = 0 THEN NULL ELSE (g % 97)::numeric * 0.1 END AS n,
+    CASE WHEN g % 17 = 0 THEN NULL ELSE jsonb_build_object('k', g % 5) END AS j,
+    decode(md5(g::text), 'hex') AS b,
+    (array['a', 'b', 'c'])[g % 3 + 1]::bulk_enum AS e,
+    chr(65 + g % 26)::"char" AS c,
+    make_interval(secs => g % 60) AS i,
+    ('name' || g % 7)::name AS nm,
+    ('08:00:2b:01:02:' || lpad(to_hex(g % 256), 2, '0'))::macaddr AS m
+FROM generate_series(1, 2000) g;
+
+INSERT INTO bulk_types SELECT * FROM reference;
+
+ALTER TABLE bulk_types SET (timescaledb.compress, timescaledb.compress_orderby = 'ts');
+SELECT count(compress_chunk(x)) FROM show_chunks('bulk_types') x;
+
+-- Bulk decompression
+SET timescaledb.enable_bulk_decompression = on;
+SELECT count(*) FROM (SELECT * FROM bulk_types EXCEPT SELECT * FROM reference) d;
+SELECT count(*) FROM (SELECT * FROM reference EXCEPT SELECT * FROM bulk_types) d;
+SELECT ts, u, n, j, encode(b, 'hex') b, e, c, i, nm, m FROM bulk_types WHERE ts <= 3 ORDER BY ts;
+
+-- The null tests on these columns are vectorized.
+SET timescaledb.debug_require_vector_qual TO 'require';
+SELECT count(*) FROM bulk_types WHERE u IS NULL;
+SELECT count(*) FROM bulk_types WHERE n IS NOT NULL;
+SELECT count(*) FROM bulk_types WHERE j IS NULL;
+SELECT count(*) FROM bulk_types WHERE e IS NOT NULL AND i IS NOT NULL AND nm IS NOT NULL;
+RESET timescaledb.debug_require_vector_qual;
+
+-- The aggregates over these columns are vectorized.
+SET timescaledb.debug_require_vector_agg TO 'require';
+SELECT count(u), count(n), count(j), count(b), count(e), count(c), count(i), count(nm)
+FROM bulk_types;
+-- Hash grouping by enum works, it is a fixed-width by-value type.
+SELECT e, count(*) FROM bulk_types GROUP BY e ORDER BY e;
+RESET timescaledb.debug_require_vector_agg;
+-- Grouping by "char" is not vectorized, but still works.
+SET timescaledb.debug_require_vector_agg TO 'forbid';
+SELECT c, count(*) FROM bulk_types GROUP BY c ORDER BY c LIMIT 3;
+RESET timescaledb.debug_require_vector_agg;
+
+-- Default values of the columns added after compression.
+ALTER TABLE bulk_types ADD COLUMN du uuid DEFAULT '00000000-0000-0000-0000-000000000001';
+ALTER TABLE bulk_types ADD COLUMN dj jsonb DEFAULT '{"a": 1}';
+SET timescaledb.debug_require_vector_qual TO 'require';
+SELECT count(*) FROM bulk_types WHERE du IS NOT NULL AND dj IS NOT NULL;
+SELECT count(*) FROM bulk_types WHERE du IS NULL;
+RESET timescaledb.debug_require_vector_qual;
+SELECT DISTINCT du, dj FROM bulk_types;
+
+-- Row-by-row decompression in both directions
+SET timescaledb.enable_bulk_decompression = off;
+SELECT count(*) FROM (SELECT ts, u, n, j, b, e, c, i, nm, m FROM bulk_types
+    EXCEPT SELECT * FROM reference) d;
+SELECT ts, u, n, j, encode(b, 'hex') b, e, c, i, nm, m FROM bulk_types ORDER BY ts DESC LIMIT 3;
+RESET timescaledb.enable_bulk_decompression;
+
+DROP TABLE bulk_types;
+DROP TABLE reference;
+DROP TYPE bulk_enum;
@@ -0,0 +1,75 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the parallel compression of a chunk. The rows are partitioned between
+-- the parallel workers by the segmentby values, and the result should be the
+-- same as with the serial compression.
+CREATE TABLE parallel_compress(ts int NOT NULL, device int, tag text, value float);
+SELECT table_name FROM create_hypertable('parallel_compress', 'ts', chunk_time_interval => 100000);
+
+CREATE TABLE reference AS
+SELECT g AS ts,
+    CASE WHEN g % 101 = 0 THEN NULL ELSE g % 17 END AS device,
+    (array['x', 'y', 'z'])[g % 3 + 1] AS tag,
+    g * 0.5 AS value
+FROM generate_series(1, 20000) g;
+
+INSERT INTO parallel_compress SELECT * FROM reference;
+
+ALTER TABLE parallel_compress SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device, tag', timescaledb.compress_orderby = 'ts');
+
+SET timescaledb.compress_parallel_workers = 2;
+SET min_parallel_table_scan_size = 0;
+SET timescaledb.debug_compression_path_info = on;
+SELECT count(compress_chunk(x)) FROM show_chunks('parallel_compress') x;
+RESET timescaledb.debug_compression_path_info;
+
+SELECT format('%I.%I', comp.schema_name, comp.table_name) AS "CCHUNK"
+FROM _timescaledb_catalog.chunk cat
+    JOIN _timescaledb_catalog.chunk comp ON cat.compressed_chunk_id = comp.id
+    JOIN _timescaledb_catalog.hypertable ht ON ht.id = cat.hypertable_id
+WHERE ht.table_name = 'parallel_compress'
+\gset
+
+-- Every segment is compressed by one worker, so we have the same batches as
+-- with the serial compression. The result doesn't depend on how many of the
+-- workers could be launched.
+SELECT count(*) AS batches, count(DISTINCT (device, tag)) AS segments,
+    sum(_ts_meta_count) AS rows
+FROM :CCHUNK;
+SELECT numrows_pre_compression, numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+
+SELECT count(*) FROM (SELECT * FROM parallel_compress EXCEPT SELECT * FROM reference) d;
+SELECT count(*) FROM (SELECT * FROM reference EXCEPT SELECT * FROM parallel_compress) d;
+SELECT * FROM parallel_compress WHERE device IS NULL ORDER BY ts LIMIT 3;
+
+-- Without any available workers, the leader compresses the chunk itself, and
+-- the result is the same.
+SELECT count(decompress_chunk(x)) FROM show_chunks('parallel_compress') x;
+SET max_parallel_workers = 0;
+SET timescaledb.debug_compression_path_info = on;
+SELECT count(compress_chunk(x)) FROM show_chunks('parallel_compress') x;
+RESET timescaledb.debug_compression_path_info;
+RESET max_parallel_workers;
+
+SELECT numrows_pre_compression, numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+SELECT count(*) FROM (SELECT * FROM parallel_compress EXCEPT SELECT * FROM reference) d;
+
+-- The small chunks are compressed serially.
+RESET min_parallel_table_scan_size;
+SELECT count(decompress_chunk(x)) FROM show_chunks('parallel_compress') x;
+SET timescaledb.debug_compression_path_info = on;
+SELECT count(compress_chunk(x)) FROM show_chunks('parallel_compress') x;
+RESET timescaledb.debug_compression_path_info;
+
+SELECT numrows_pre_compression, numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+
+RESET timescaledb.compress_parallel_workers;
+
+DROP TABLE parallel_compress;
+DROP TABLE reference;
@@ -418,6 +418,7 @@ CALL order_test('SELECT * FROM sensor_data ORDER BY time DESC');
 CALL order_test('SELECT * FROM sensor_data ORDER BY time DESC LIMIT 100');
 CALL order_test('SELECT * FROM sensor_data ORDER BY time ASC NULLS FIRST');
 CALL order_test('SELECT * FROM sensor_data ORDER BY time ASC NULLS FIRST LIMIT 100');
+CALL order_test('SELECT * FROM sensor_data ORDER BY time DESC LIMIT 10 OFFSET 5');
 
 CALL order_test('SELECT * FROM test1 ORDER BY time DESC');
 CALL order_test('SELECT * FROM test1 ORDER BY time ASC NULLS LAST');
@@ -0,0 +1,129 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized approximate_count_distinct() and approximate_percentile().
+-- The vectorized and row-by-row implementations must produce the same sketches,
+-- so their results must be equal.
+\pset null $
+
+set max_parallel_workers_per_gather = 0;
+
+create table vapprox(t int, s int, i2 int2, i4 int4, i8 int8, f8 float8,
+    ts timestamptz, x text);
+select create_hypertable('vapprox', 't', chunk_time_interval => 50000);
+
+insert into vapprox
+select t, t % 3, (t % 1000)::int2,
+    case when t % 7 = 0 then null else t % 20000 end,
+    t::int8 * 1000,
+    case when t % 11 = 0 then null else (t % 5000) - 1000.5 end,
+    '2025-01-01 00:00:00+00'::timestamptz + interval '1 second' * (t % 30000),
+    'x' || (t % 3000)
+from generate_series(1, 100000) t;
+
+alter table vapprox set (timescaledb.compress, timescaledb.compress_segmentby = 's',
+    timescaledb.compress_orderby = 't');
+select count(compress_chunk(x)) from show_chunks('vapprox') x;
+vacuum analyze vapprox;
+
+set timescaledb.debug_require_vector_agg to 'require';
+
+-- The estimates are within a few percent of the exact distinct counts 3, 1000,
+-- 20000, 100000, 30000 and 3000.
+select approximate_count_distinct(s) between 2 and 4 s,
+    abs(approximate_count_distinct(i2) - 1000) < 100 i2,
+    abs(approximate_count_distinct(i4) - 20000) < 2000 i4,
+    abs(approximate_count_distinct(i8) - 100000) < 10000 i8,
+    abs(approximate_count_distinct(ts) - 30000) < 3000 ts,
+    abs(approximate_count_distinct(x) - 3000) < 300 x
+from vapprox;
+
+-- Compare the vectorized results to the row-by-row ones with no grouping,
+-- grouping by the segmentby column, and hash grouping.
+create temp table vector_result as
+select -1 g, approximate_count_distinct(i2) c2, approximate_count_distinct(i4) c4,
+    approximate_count_distinct(ts) cts, approximate_count_distinct(f8) cf8,
+    approximate_count_distinct(x) filter (where t > 50000) cx,
+    approximate_percentile(f8, 0.5) p50, approximate_percentile(f8, 0.99) p99
+from vapprox;
+
+insert into vector_result
+select s, approximate_count_distinct(i2), approximate_count_distinct(i4),
+    approximate_count_distinct(ts), approximate_count_distinct(f8),
+    approximate_count_distinct(x) filter (where t > 50000),
+    approximate_percentile(f8, 0.5), approximate_percentile(f8, 0.99)
+from vapprox group by s;
+
+insert into vector_result
+select i2 + 10, approximate_count_distinct(s), approximate_count_distinct(i4),
+    approximate_count_distinct(ts), approximate_count_distinct(f8),
+    approximate_count_distinct(x) filter (where t > 50000),
+    approximate_percentile(f8, 0.5), approximate_percentile(f8, 0.99)
+from vapprox group by i2;
+
+set timescaledb.debug_require_vector_agg to 'forbid';
+set timescaledb.enable_vectorized_aggregation to off;
+
+create temp table row_result as
+select -1 g, approximate_count_distinct(i2) c2, approximate_count_distinct(i4) c4,
+    approximate_count_distinct(ts) cts, approximate_count_distinct(f8) cf8,
+    approximate_count_distinct(x) filter (where t > 50000) cx,
+    approximate_percentile(f8, 0.5) p50, approximate_percentile(f8, 0.99) p99
+from vapprox;
+
+insert into row_result
+select s, approximate_count_distinct(i2), approximate_count_distinct(i4),
+    approximate_count_distinct(ts), approximate_count_distinct(f8),
+    approximate_count_distinct(x) filter (where t > 50000),
+    approximate_percentile(f8, 0.5), approximate_percentile(f8, 0.99)
+from vapprox group by s;
+
+insert into row_result
+select i2 + 10, approximate_count_distinct(s), approximate_count_distinct(i4),
+    approximate_count_distinct(ts), approximate_count_distinct(f8),
+    approximate_count_distinct(x) filter (where t > 50000),
+    approximate_percentile(f8, 0.5), approximate_percentile(f8, 0.99)
+from vapprox group by i2;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
+
+select count(*) from vector_result;
+select count(*) from (select * from vector_result except select * from row_result) x;
+select count(*) from (select * from row_result except select * from vector_result) x;
+
+-- The percentiles are within 1% of the exact ones, up to the difference of
+-- one rank.
+select fraction, abs(a - e) <= 0.02 * abs(e) + 1 accurate
+from (select fraction, approximate_percentile(f8, fraction) a,
+        percentile_disc(fraction) within group (order by f8) e
+    from vapprox, unnest('{0, 0.01, 0.25, 0.5, 0.9, 0.999, 1}'::float8[]) fraction
+    group by fraction) x
+order by fraction;
+
+\set ON_ERROR_STOP 0
+select approximate_percentile(f8, 1.5) from vapprox;
+select approximate_percentile(f8, null) from vapprox;
+\set ON_ERROR_STOP 1
+
+-- The sketches are mergeable, so the aggregates can be used in continuous
+-- aggregates.
+create function vapprox_now() returns int language sql stable as
+$$ select coalesce(max(t), 0) from vapprox $$;
+select set_integer_now_func('vapprox', 'vapprox_now');
+
+create materialized view vapprox_buckets
+    with (timescaledb.continuous, timescaledb.materialized_only = true) as
+select time_bucket(10000, t) bucket, approximate_count_distinct(x) cx,
+    approximate_percentile(f8, 0.5) p50
+from vapprox group by bucket;
+
+select count(*) from (
+    select * from vapprox_buckets
+    except
+    select time_bucket(10000, t), approximate_count_distinct(x),
+        approximate_percentile(f8, 0.5)
+    from vapprox group by 1) x;
+
+reset max_parallel_workers_per_gather;
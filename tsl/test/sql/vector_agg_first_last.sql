@@ -0,0 +1,59 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized first() and last() aggregates.
+\pset null $
+set timezone to 'UTC';
+
+create table fl(t int, ts timestamptz, s int, d int, v int, f float8, x text, lx text);
+select create_hypertable('fl', 's', chunk_time_interval => 1);
+
+insert into fl
+select t, case when g % 997 = 0 then null
+        else '2021-01-01 00:00:00+00'::timestamptz + (g * 7919) % 9000 * interval '1 minute' end,
+    s, t % 5,
+    case when t % 13 = 0 then null else t * 31 % 1000 end,
+    t * 0.5,
+    'x' || t % 50,
+    'long' || g
+from (select t, s, s * 3000 + t g
+    from generate_series(1, 3000) t, generate_series(0, 2) s(s)) source
+order by s, t;
+
+alter table fl set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('fl') x;
+vacuum freeze analyze fl;
+
+set max_parallel_workers_per_gather = 0;
+
+set timescaledb.debug_require_vector_agg = 'require';
+-- Uncomment to generate reference.
+--set timescaledb.enable_vectorized_aggregation to off; set timescaledb.debug_require_vector_agg = 'allow';
+
+-- Grouping by segmentby
+select s, first(v, ts), last(v, ts), first(lx, ts), last(lx, ts) from fl group by s order by s;
+
+-- Hash grouping, with different value and comparison types
+select d, first(v, ts), last(v, ts), first(x, ts), last(x, ts) from fl group by d order by d;
+select d, first(f, t), last(f, t), first(x, t), last(x, t) from fl group by d order by d;
+
+-- Filters
+select d, first(v, ts) filter (where v > 500), last(x, ts) filter (where s = 1)
+from fl group by d order by d;
+select s, d, first(lx, ts), last(v, ts) from fl where t > 2900 group by s, d order by s, d;
+
+-- Scalar comparison element. The earliest row wins for equal comparison
+-- elements.
+select d, first(v, s), last(v, s), first(x, s), last(x, s) from fl group by d order by d;
+
+reset timescaledb.debug_require_vector_agg;
+
+-- Not vectorized: unsupported comparison element type.
+set timescaledb.debug_require_vector_agg = 'forbid';
+select d, first(v, f) from fl group by d order by d;
+
+reset timescaledb.debug_require_vector_agg;
+reset max_parallel_workers_per_gather;
+reset timezone;
@@ -0,0 +1,52 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized count(*), min() and max() that are computed from the
+-- metadata of the compressed batches where all rows pass the filters.
+\pset null $
+
+create table mmeta(t int, s int, v int, x int);
+select create_hypertable('mmeta', 't', chunk_time_interval => 1000);
+
+-- The btree index creates the minmax sparse index for v on compression, and x
+-- has no batch metadata.
+create index on mmeta(v);
+
+insert into mmeta
+select t, t % 3, case when t % 7 = 0 then null else t * 2 end, t % 10
+from generate_series(1, 3000) t;
+
+-- A segment where v is null in all rows.
+insert into mmeta select t, 3, null, 0 from generate_series(3001, 3010) t;
+
+alter table mmeta set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('mmeta') x;
+vacuum freeze analyze mmeta;
+
+set max_parallel_workers_per_gather = 0;
+
+set timescaledb.debug_require_vector_agg = 'require';
+-- Uncomment to generate reference.
+--set timescaledb.enable_vectorized_aggregation to off; set timescaledb.debug_require_vector_agg = 'allow';
+
+-- No filters, all batches are aggregated from metadata.
+select count(*), min(t), max(t), min(v), max(v) from mmeta;
+select s, count(*), min(t), max(t), min(v), max(v) from mmeta group by s order by s;
+
+-- Some batches pass the vectorized filter entirely and are aggregated from
+-- metadata, the others are decompressed.
+select count(*), min(t), max(t), min(v), max(v) from mmeta where t > 1500;
+select s, count(*), min(v), max(v) from mmeta where t > 1500 group by s order by s;
+
+-- Most batches pass the filter only partially and are decompressed.
+select count(*), min(t), max(t), min(v), max(v) from mmeta where v > 0;
+select s, count(*), max(t) from mmeta where x < 5 group by s order by s;
+
+-- Aggregates that don't use the metadata.
+select count(*), min(s), max(t) from mmeta;
+select count(*), min(t), max(x) from mmeta;
+
+reset timescaledb.debug_require_vector_agg;
+reset max_parallel_workers_per_gather;
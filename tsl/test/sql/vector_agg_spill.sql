@@ -0,0 +1,98 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized hash aggregation with high cardinality of grouping keys,
+-- which doesn't fit into work_mem and is aggregated by hash partitions of keys,
+-- replaying the saved input.
+\pset null $
+
+set max_parallel_workers_per_gather = 0;
+set enable_sort to off;
+
+create table vspill(t int, k int, n text);
+select create_hypertable('vspill', 't', chunk_time_interval => 200000);
+
+insert into vspill
+select t, t % 100000, case when t % 5 = 0 then null else (t % 50000)::text end
+from generate_series(1, 400000) t;
+
+alter table vspill set (timescaledb.compress, timescaledb.compress_segmentby = '',
+    timescaledb.compress_orderby = 't');
+select count(compress_chunk(x)) from show_chunks('vspill') x;
+vacuum analyze vspill;
+
+set work_mem = '1MB';
+set timescaledb.debug_require_vector_agg to 'require';
+
+select count(*), sum(c), min(c), max(c), sum(st)
+from (select k, count(*) c, sum(t) st from vspill group by k) x;
+
+select count(*), sum(c), sum(cf), sum(mx)
+from (select k, count(*) c, count(*) filter (where t < 300000) cf, max(t) mx
+    from vspill where t > 1000 group by k) x;
+
+select count(*), count(n), sum(c), max(c)
+from (select n, count(*) c from vspill group by n) x;
+
+-- The spill statistics are shown by EXPLAIN ANALYZE. The numbers depend on the
+-- memory usage, so we hide them.
+create function explain_spill(query text, verbose bool default false)
+returns setof text language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute format('explain (analyze, verbose %s, costs off, timing off, summary off) %s',
+            verbose, query) loop
+        if line ~ 'Gather|Workers|VectorAgg|Spill' then
+            return next regexp_replace(regexp_replace(line, '^[\s>-]*', ''), '\d+', 'N', 'g');
+        end if;
+    end loop;
+end;
+$$;
+
+select * from explain_spill('select k, count(*), sum(t) from vspill group by k');
+
+-- In parallel plans, the grouping uses all of its share of work_mem before
+-- the input is saved, so that the parallel processes don't emit the partial
+-- results early. The results are the same.
+set max_parallel_workers_per_gather = 2;
+set parallel_setup_cost = 0;
+set parallel_tuple_cost = 0;
+set min_parallel_table_scan_size = 0;
+
+select count(*), sum(c), min(c), max(c), sum(st)
+from (select k, count(*) c, sum(t) st from vspill group by k) x;
+
+select count(*), count(n), sum(c), max(c)
+from (select n, count(*) c from vspill group by n) x;
+
+-- This is decided when planning, because the parallel processes can't tell
+-- at execution time. Without the workers, the leader runs the parallel part of
+-- the plan and shows the spill statistics.
+set max_parallel_workers = 0;
+select * from explain_spill('select k, count(*), sum(t) from vspill group by k', verbose => true);
+reset max_parallel_workers;
+
+reset min_parallel_table_scan_size;
+reset parallel_tuple_cost;
+reset parallel_setup_cost;
+set max_parallel_workers_per_gather = 0;
+
+-- The same results when emitting the partial aggregation results instead.
+set timescaledb.enable_vectorized_aggregation_spill to off;
+
+select count(*), sum(c), min(c), max(c), sum(st)
+from (select k, count(*) c, sum(t) st from vspill group by k) x;
+
+select count(*), count(n), sum(c), max(c)
+from (select n, count(*) c from vspill group by n) x;
+
+reset timescaledb.enable_vectorized_aggregation_spill;
+reset timescaledb.debug_require_vector_agg;
+reset work_mem;
+reset enable_sort;
+reset max_parallel_workers_per_gather;
+
+drop function explain_spill(text, bool);
@@ -0,0 +1,60 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized grouping by time_bucket() expressions.
+set timezone to 'UTC';
+
+create table tbagg(t int, ts timestamptz, s int, v int);
+select create_hypertable('tbagg', 's', chunk_time_interval => 1);
+
+insert into tbagg
+select t - 500, '2021-01-01 00:00:00+00'::timestamptz + (t - 500) * interval '7 minutes',
+    s, (t + s) % 10
+from generate_series(1, 2000) t, generate_series(0, 1) s(s);
+
+alter table tbagg set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('tbagg') x;
+vacuum freeze analyze tbagg;
+
+set max_parallel_workers_per_gather = 0;
+
+set timescaledb.debug_require_vector_agg = 'require';
+-- Uncomment to generate reference.
+--set timescaledb.enable_vectorized_aggregation to off; set timescaledb.debug_require_vector_agg = 'allow';
+
+-- Integer variants
+select time_bucket(500, t) b, count(*), sum(v) from tbagg group by b order by b;
+select time_bucket(500, t, 100) b, count(*), sum(v) from tbagg group by b order by b;
+
+-- Timestamp variants with default origin, explicit origin and offset
+select to_char(b, 'YYYY-MM-DD HH24:MI') b, c, sv from (
+    select time_bucket('1 day', ts) b, count(*) c, sum(v) sv from tbagg group by 1) q
+order by 1;
+
+select to_char(b, 'YYYY-MM-DD HH24:MI') b, c, sv from (
+    select time_bucket('1 day', ts, '2021-01-01 06:00:00+00'::timestamptz) b,
+        count(*) c, sum(v) sv
+    from tbagg group by 1) q
+order by 1;
+
+select to_char(b, 'YYYY-MM-DD HH24:MI') b, c, sv from (
+    select time_bucket('1 day', ts, '3 hours'::interval) b, count(*) c, sum(v) sv
+    from tbagg group by 1) q
+order by 1;
+
+-- Multiple grouping columns with a vectorized filter
+select s, time_bucket(500, t) b, count(*), sum(v) from tbagg where v > 6
+group by s, b order by s, b;
+
+reset timescaledb.debug_require_vector_agg;
+
+-- Not vectorized: the monthly buckets and the time zone variant.
+set timescaledb.debug_require_vector_agg = 'forbid';
+select count(*) from (select time_bucket('1 month', ts) b, count(*) from tbagg group by b) q;
+select count(*) from (select time_bucket('1 day', ts, 'Europe/Berlin') b, count(*) from tbagg group by b) q;
+
+reset timescaledb.debug_require_vector_agg;
+reset max_parallel_workers_per_gather;
+reset timezone;
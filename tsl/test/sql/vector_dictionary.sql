@@ -0,0 +1,52 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized grouping and filters that work on the distinct values of
+-- the dictionary-encoded columns.
+CREATE TYPE dict_status AS ENUM ('ok', 'warning', 'error');
+
+CREATE TABLE dict(ts int NOT NULL, region text, status dict_status, tag bytea, value int);
+SELECT table_name FROM create_hypertable('dict', 'ts', chunk_time_interval => 10000);
+
+-- The last batch has a different set of regions. The tags differ only in the
+-- bytes after the leading zero byte.
+INSERT INTO dict
+SELECT g,
+    CASE WHEN g % 23 = 0 THEN NULL
+        ELSE (array['eu', 'us', 'ap', 'sa'])[g % 4 + 1] || CASE WHEN g > 2000 THEN '-2' ELSE '' END
+    END,
+    (array['ok', 'warning', 'error'])[g / 7 % 3 + 1]::dict_status,
+    CASE WHEN g % 31 = 0 THEN NULL ELSE decode(lpad(to_hex(g % 5), 4, '0'), 'hex') END,
+    g % 10
+FROM generate_series(1, 3000) g;
+
+ALTER TABLE dict SET (timescaledb.compress, timescaledb.compress_orderby = 'ts');
+SELECT count(compress_chunk(x)) FROM show_chunks('dict') x;
+
+-- Grouping by a dictionary-encoded text column.
+SET timescaledb.debug_require_vector_agg TO 'require';
+SELECT region, count(*), sum(value) FROM dict GROUP BY region ORDER BY region;
+-- Only some of the dictionary entries are referenced by the rows that pass the
+-- filter, and we shouldn't produce the empty groups for the rest.
+SELECT region, count(*) FROM dict WHERE value = 1 GROUP BY region ORDER BY region;
+SELECT region, count(*) FROM dict WHERE ts > 2990 GROUP BY region ORDER BY region;
+RESET timescaledb.debug_require_vector_agg;
+
+-- Equality filters on dictionary-encoded enum and bytea columns.
+SET timescaledb.debug_require_vector_qual TO 'require';
+SELECT count(*) FROM dict WHERE status = 'error';
+SELECT count(*) FROM dict WHERE status <> 'ok';
+SELECT count(*) FROM dict WHERE status IN ('ok', 'error');
+SELECT count(*) FROM dict WHERE tag = '\x0001';
+SELECT count(*) FROM dict WHERE tag <> '\x0001';
+SELECT count(*) FROM dict WHERE tag IN ('\x0000', '\x0003');
+RESET timescaledb.debug_require_vector_qual;
+
+-- The ordering comparisons of enums are not vectorized.
+SET timescaledb.debug_require_vector_qual TO 'forbid';
+SELECT count(*) FROM dict WHERE status > 'ok';
+RESET timescaledb.debug_require_vector_qual;
+
+DROP TABLE dict;
+DROP TYPE dict_status;
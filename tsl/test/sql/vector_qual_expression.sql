@@ -0,0 +1,106 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized filters that have time_bucket() or arithmetic
+-- expressions over a column instead of a plain column.
+SET timezone TO 'UTC';
+
+CREATE TABLE vexpr(ts timestamptz NOT NULL, i int4, b int8, s int2, f float8, r float4);
+SELECT table_name FROM create_hypertable('vexpr', 'ts', chunk_time_interval => interval '1 week');
+
+INSERT INTO vexpr
+SELECT '2021-01-01 00:00:00+00'::timestamptz + g * interval '1 minute',
+    CASE WHEN g % 101 = 0 THEN NULL ELSE g % 100 - 50 END,
+    g * 1000,
+    g % 200,
+    g / 10.0,
+    g % 50
+FROM generate_series(1, 3000) g;
+
+ALTER TABLE vexpr SET (timescaledb.compress, timescaledb.compress_orderby = 'ts');
+SELECT count(compress_chunk(x)) FROM show_chunks('vexpr') x;
+
+SET timescaledb.debug_require_vector_qual TO 'require';
+SELECT count(*) FROM vexpr WHERE time_bucket('1 hour', ts) = '2021-01-01 10:00:00+00';
+SELECT count(*) FROM vexpr WHERE time_bucket('1 day', ts) > '2021-01-01 00:00:00+00';
+SELECT count(*) FROM vexpr WHERE time_bucket(10, i) = 20;
+SELECT count(*) FROM vexpr WHERE time_bucket(10, i, 5) < 0;
+SELECT count(*) FROM vexpr WHERE i * 2 > 10;
+SELECT count(*) FROM vexpr WHERE 10 < i * 2;
+SELECT count(*) FROM vexpr WHERE (i + 1) * 2 <= 20;
+SELECT count(*) FROM vexpr WHERE 100 - i = 120;
+SELECT count(*) FROM vexpr WHERE b / 1000 BETWEEN 100 AND 199;
+SELECT count(*) FROM vexpr WHERE s * 2 > 300;
+SELECT count(*) FROM vexpr WHERE f * 2 > 500;
+SELECT count(*) FROM vexpr WHERE r / 2::float4 >= 12::float4;
+SELECT count(*) FROM vexpr WHERE i * 2 IN (10, 20);
+SELECT count(*) FROM vexpr WHERE i + 1 IS NULL;
+
+PREPARE bucket_param(timestamptz) AS
+SELECT count(*) FROM vexpr WHERE time_bucket('1 hour', ts) = $1;
+EXECUTE bucket_param('2021-01-01 10:00:00+00');
+DEALLOCATE bucket_param;
+
+-- The errors are reported as for the scalar evaluation, but only for the rows
+-- that pass the preceding filters.
+SELECT count(*) FROM vexpr WHERE s * 1000::int2 > 0;
+SELECT count(*) FROM vexpr WHERE 100 / i > 5;
+SELECT count(*) FROM vexpr WHERE f * 1e308::float8 > 0;
+SELECT count(*) FROM vexpr WHERE i <> 0 AND 100 / i > 5;
+RESET timescaledb.debug_require_vector_qual;
+
+-- These expressions are not vectorized.
+SET timescaledb.debug_require_vector_qual TO 'forbid';
+SELECT count(*) FROM vexpr WHERE extract(hour FROM ts) BETWEEN 9 AND 17;
+SELECT count(*) FROM vexpr WHERE i % 3 = 0;
+SELECT count(*) FROM vexpr WHERE i * i > 100;
+SELECT count(*) FROM vexpr WHERE time_bucket('1 month', ts) = '2021-01-01 00:00:00+00';
+RESET timescaledb.debug_require_vector_qual;
+
+-- Comparisons of two columns, or expressions over them.
+CREATE TABLE vcmp(ts timestamptz NOT NULL, start_ts timestamptz, a int4, b int8, s int2,
+    x float8, y float4);
+SELECT table_name FROM create_hypertable('vcmp', 'ts', chunk_time_interval => interval '1 week');
+
+INSERT INTO vcmp
+SELECT '2021-01-01 00:00:00+00'::timestamptz + g * interval '1 minute',
+    CASE WHEN g % 97 = 0 THEN NULL
+        ELSE '2021-01-01 00:00:00+00'::timestamptz + (g - g % 10) * interval '1 minute' END,
+    CASE WHEN g % 89 = 0 THEN NULL ELSE g % 100 END,
+    g * 7 % 100,
+    g % 50,
+    g % 30 / 2.0,
+    CASE WHEN g % 500 = 0 THEN 'NaN'::float4 ELSE g % 20 END
+FROM generate_series(1, 3000) g;
+
+ALTER TABLE vcmp SET (timescaledb.compress, timescaledb.compress_orderby = 'ts');
+SELECT count(compress_chunk(x)) FROM show_chunks('vcmp') x;
+
+-- The column added after compression has the default value in all batches.
+ALTER TABLE vcmp ADD COLUMN c int4 DEFAULT 50;
+
+SET timescaledb.debug_require_vector_qual TO 'require';
+SELECT count(*) FROM vcmp WHERE a > b;
+SELECT count(*) FROM vcmp WHERE b >= a;
+SELECT count(*) FROM vcmp WHERE a = s;
+SELECT count(*) FROM vcmp WHERE s < a;
+SELECT count(*) FROM vcmp WHERE x > y;
+SELECT count(*) FROM vcmp WHERE y >= x;
+SELECT count(*) FROM vcmp WHERE ts > start_ts + interval '5 minutes';
+SELECT count(*) FROM vcmp WHERE ts - interval '5 minutes' <= start_ts;
+SELECT count(*) FROM vcmp WHERE ts > start_ts + interval '1 month';
+SELECT count(*) FROM vcmp WHERE a * 2 > b + 10;
+SELECT count(*) FROM vcmp WHERE a > c;
+SELECT count(*) FROM vcmp WHERE c >= s;
+RESET timescaledb.debug_require_vector_qual;
+
+-- Different types that need a cast are not vectorized.
+SET timescaledb.debug_require_vector_qual TO 'forbid';
+SELECT count(*) FROM vcmp WHERE a > x;
+RESET timescaledb.debug_require_vector_qual;
+
+DROP TABLE vcmp;
+
+DROP TABLE vexpr;
+RESET timezone;
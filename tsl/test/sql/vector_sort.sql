@@ -0,0 +1,105 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the vectorized sort over compressed data, that reads the decompressed
+-- batches of DecompressChunk directly.
+\pset null $
+
+set max_parallel_workers_per_gather = 0;
+
+create table vsort(ts int, segment int, x int, f float8, b bool, t text, u text, n numeric);
+select create_hypertable('vsort', 'ts', chunk_time_interval => 1000000);
+
+-- Two batches per segment. The text columns use the dictionary and the array
+-- compression, and the numeric column is decompressed row by row.
+insert into vsort
+select ts, ts % 3, x, x / 8.0, ts % 7 = 0,
+    case when ts % 11 = 0 then null else 'v' || ts % 50 end,
+    md5(ts::text),
+    ts % 13
+from generate_series(1, 6000) ts,
+    lateral (select case when ts % 97 = 0 then null else ts * 7919 % 1000 end x) v;
+
+alter table vsort set (timescaledb.compress, timescaledb.compress_segmentby = 'segment',
+    timescaledb.compress_orderby = 'ts');
+select count(compress_chunk(x)) from show_chunks('vsort') x;
+vacuum analyze vsort;
+
+set timescaledb.enable_vectorized_sort to on;
+
+explain (costs off) select * from vsort order by x, ts;
+
+explain (costs off) select ts, u from vsort where x > 500 order by t desc nulls last, ts;
+
+-- Run the query with and without the vectorized sort, and compare the results
+-- row by row. Also count the VectorSort nodes in the plan.
+create function vsort_compare(query text, out vector_sorts int, out total bigint,
+    out mismatches bigint) as
+$$
+declare
+    plan_line text;
+begin
+    vector_sorts := 0;
+    set local timescaledb.enable_vectorized_sort to on;
+    for plan_line in execute 'explain (costs off) ' || query loop
+        if plan_line like '%VectorSort%' then
+            vector_sorts := vector_sorts + 1;
+        end if;
+    end loop;
+    execute format('create temp table vsort_result as
+        select row_number() over () rn, q::text r from (%s) q', query);
+
+    set local timescaledb.enable_vectorized_sort to off;
+    execute format('create temp table vsort_reference as
+        select row_number() over () rn, q::text r from (%s) q', query);
+
+    select count(*) into total from vsort_result;
+    select count(*) into mismatches
+    from vsort_result full join vsort_reference using (rn)
+    where vsort_result.r is distinct from vsort_reference.r;
+
+    drop table vsort_result;
+    drop table vsort_reference;
+end;
+$$ language plpgsql;
+
+select * from vsort_compare('select * from vsort order by x, ts');
+
+select * from vsort_compare('select ts, u from vsort where x > 500 order by t desc nulls last, ts');
+
+select * from vsort_compare('select n, segment, ts from vsort order by n desc, ts');
+
+select * from vsort_compare('select b, f, t, ts from vsort where x < 100 order by b, f desc, t, ts');
+
+-- Merge join restores the marked positions in the inner sorted input.
+set enable_hashjoin to off;
+set enable_nestloop to off;
+select * from vsort_compare('select a.ts a_ts, b.ts b_ts from vsort a join vsort b
+    on a.x = b.x and a.ts < b.ts order by a.ts, b.ts');
+reset enable_hashjoin;
+reset enable_nestloop;
+
+-- The bounded sort under LIMIT and the Postgres filters in DecompressChunk are
+-- not supported.
+select * from vsort_compare('select * from vsort order by x, ts limit 10');
+
+select * from vsort_compare('select * from vsort where x = ts % 7 order by x, ts');
+
+-- Backward scan.
+begin;
+declare c scroll cursor for select x, ts from vsort where x < 3 order by x, ts;
+fetch 3 from c;
+fetch backward 2 from c;
+fetch last from c;
+fetch absolute 2 from c;
+close c;
+commit;
+
+-- Rescan with a different parameter.
+select s, q.* from unnest(array[0, 1]) s,
+    lateral (select x, ts from vsort where segment = s and x < 3 order by x, ts) q;
+
+reset timescaledb.enable_vectorized_sort;
+
+explain (costs off) select * from vsort order by x, ts;
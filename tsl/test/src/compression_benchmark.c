@@ -0,0 +1,531 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Microbenchmarks for the compression algorithms and the vectorized kernels
+ * that work on the decompressed data.
+ *
+ * The benchmark is a SQL-callable function, because the compression
+ * algorithms and the vector kernels depend on the backend environment (memory
+ * contexts, type cache, fmgr). The input values are passed as an array, so
+ * that both synthetic distributions generated in SQL and real-world columns
+ * aggregated from existing tables can be benchmarked. See
+ * scripts/bench_compression.sql for a driver script.
+ */
+#include <postgres.h>
+
+#include <access/htup_details.h>
+#include <funcapi.h>
+#include <nodes/value.h>
+#include <parser/parse_func.h>
+#include <portability/instr_time.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/typcache.h>
+
+#include "compression_sql_test.h"
+
+#include "compression/arrow_c_data_interface.h"
+#include "export.h"
+#include "nodes/decompress_chunk/vector_predicates.h"
+#include "nodes/vector_agg/function/functions.h"
+
+#if !defined(NDEBUG) || defined(TS_COMPRESSION_FUZZING) || defined(TS_COMPRESSION_BENCHMARK)
+
+/*
+ * The input values split into batches of the same size as the ones we produce
+ * when compressing a chunk.
+ */
+typedef struct BenchBatch
+{
+	Datum *values;
+	bool *nulls;
+	int nrows;
+
+	/* Compressed data, NULL if the batch consists only of nulls. */
+	void *compressed;
+
+	/* The result of bulk decompression, if supported for this algorithm. */
+	ArrowArray *arrow;
+} BenchBatch;
+
+typedef struct BenchState
+{
+	CompressionAlgorithm algo;
+	const CompressionAlgorithmDefinition *definition;
+	DecompressAllFunction decompress_all;
+	Oid element_type;
+
+	BenchBatch *batches;
+	int nbatches;
+
+	int64 rows;
+	int64 uncompressed_bytes;
+	int64 compressed_bytes;
+
+	/* Arguments of the kernel being benchmarked. */
+	VectorPredicate *predicate;
+	Datum predicate_constant;
+	VectorAggFunctions *agg;
+
+	/* Guards against the compiler optimizing out the benchmarked code. */
+	volatile int64 sink;
+} BenchState;
+
+typedef struct BenchResult
+{
+	const char *kernel;
+	double seconds;
+} BenchResult;
+
+typedef void (*BenchKernel)(BenchState *state, MemoryContext iteration_mctx);
+
+static void
+bench_compress(BenchState *state, MemoryContext iteration_mctx)
+{
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		Compressor *compressor = state->definition->compressor_for_type(state->element_type);
+		for (int row = 0; row < batch->nrows; row++)
+		{
+			if (batch->nulls[row])
+				compressor->append_null(compressor);
+			else
+				compressor->append_val(compressor, batch->values[row]);
+		}
+		state->sink += (compressor->finish(compressor) != NULL);
+	}
+}
+
+static void
+bench_decompress_all(BenchState *state, MemoryContext iteration_mctx)
+{
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		if (batch->compressed == NULL)
+			continue;
+
+		ArrowArray *arrow = state->decompress_all(PointerGetDatum(batch->compressed),
+												  state->element_type,
+												  iteration_mctx);
+		Ensure(arrow->length == batch->nrows,
+			   "decompressed %ld rows instead of %d",
+			   (long) arrow->length,
+			   batch->nrows);
+		state->sink += arrow->null_count;
+	}
+}
+
+static void
+bench_iterator(BenchState *state, bool forward)
+{
+	DecompressionInitializer init = forward ? state->definition->iterator_init_forward :
+											  state->definition->iterator_init_reverse;
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		if (batch->compressed == NULL)
+			continue;
+
+		DecompressionIterator *iter = init(PointerGetDatum(batch->compressed), state->element_type);
+		int rows = 0;
+		for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
+		{
+			rows++;
+		}
+		Ensure(rows == batch->nrows, "decompressed %d rows instead of %d", rows, batch->nrows);
+		state->sink += rows;
+	}
+}
+
+static void
+bench_iterator_forward(BenchState *state, MemoryContext iteration_mctx)
+{
+	bench_iterator(state, /* forward = */ true);
+}
+
+static void
+bench_iterator_reverse(BenchState *state, MemoryContext iteration_mctx)
+{
+	bench_iterator(state, /* forward = */ false);
+}
+
+static void
+bench_vector_predicate(BenchState *state, MemoryContext iteration_mctx)
+{
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		if (batch->arrow == NULL)
+			continue;
+
+		/*
+		 * For dictionary-encoded data, the predicate is computed on the
+		 * dictionary, same as in the vectorized filters.
+		 */
+		const ArrowArray *arrow =
+			batch->arrow->dictionary ? batch->arrow->dictionary : batch->arrow;
+		const size_t num_words = (arrow->length + 63) / 64;
+		uint64 *restrict result = palloc(sizeof(uint64) * num_words);
+		memset(result, 0xFF, sizeof(uint64) * num_words);
+		state->predicate(arrow, state->predicate_constant, result);
+		state->sink += result[0];
+	}
+}
+
+static void
+bench_vector_agg(BenchState *state, MemoryContext iteration_mctx)
+{
+	void *agg_state = palloc(state->agg->state_bytes);
+	state->agg->agg_init(agg_state, 1);
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		if (batch->arrow == NULL)
+			continue;
+
+		state->agg->agg_vector(agg_state, batch->arrow, /* filter = */ NULL, iteration_mctx);
+	}
+
+	Datum result;
+	bool isnull;
+	state->agg->agg_emit(agg_state, &result, &isnull);
+	state->sink += isnull;
+}
+
+/*
+ * Run the kernel for the given number of iterations and return the total time
+ * in seconds. The memory allocated by the kernel is freed between the
+ * iterations, and this is not included in the measured time.
+ */
+static double
+bench_run(BenchState *state, BenchKernel kernel, int iterations)
+{
+	MemoryContext iteration_mctx =
+		AllocSetContextCreate(CurrentMemoryContext, "benchmark iteration", ALLOCSET_DEFAULT_SIZES);
+	double seconds = 0;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		MemoryContext old = MemoryContextSwitchTo(iteration_mctx);
+		instr_time start;
+		instr_time duration;
+
+		INSTR_TIME_SET_CURRENT(start);
+		kernel(state, iteration_mctx);
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+		seconds += INSTR_TIME_GET_DOUBLE(duration);
+
+		MemoryContextSwitchTo(old);
+		MemoryContextReset(iteration_mctx);
+	}
+
+	MemoryContextDelete(iteration_mctx);
+	return seconds;
+}
+
+/*
+ * Split the input array into batches and compress them once, so that the
+ * decompression kernels have the data to work on.
+ */
+static void
+bench_prepare(BenchState *state, ArrayType *input)
+{
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	Datum *values;
+	bool *nulls;
+	int nvalues;
+
+	get_typlenbyvalalign(state->element_type, &typlen, &typbyval, &typalign);
+	deconstruct_array(input,
+					  state->element_type,
+					  typlen,
+					  typbyval,
+					  typalign,
+					  &values,
+					  &nulls,
+					  &nvalues);
+
+	state->rows = nvalues;
+	state->nbatches = (nvalues + TARGET_COMPRESSED_BATCH_SIZE - 1) / TARGET_COMPRESSED_BATCH_SIZE;
+	state->batches = palloc0(sizeof(BenchBatch) * state->nbatches);
+
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[i];
+		const int offset = i * TARGET_COMPRESSED_BATCH_SIZE;
+		batch->values = &values[offset];
+		batch->nulls = &nulls[offset];
+		batch->nrows = Min(TARGET_COMPRESSED_BATCH_SIZE, nvalues - offset);
+
+		Compressor *compressor = state->definition->compressor_for_type(state->element_type);
+		for (int row = 0; row < batch->nrows; row++)
+		{
+			if (batch->nulls[row])
+			{
+				compressor->append_null(compressor);
+				continue;
+			}
+
+			compressor->append_val(compressor, batch->values[row]);
+			state->uncompressed_bytes +=
+				typlen > 0 ? typlen : VARSIZE_ANY(DatumGetPointer(batch->values[row]));
+		}
+
+		batch->compressed = compressor->finish(compressor);
+		if (batch->compressed == NULL)
+			continue;
+
+		state->compressed_bytes += VARSIZE(batch->compressed);
+
+		if (state->decompress_all != NULL)
+		{
+			batch->arrow = state->decompress_all(PointerGetDatum(batch->compressed),
+												 state->element_type,
+												 CurrentMemoryContext);
+		}
+	}
+}
+
+/*
+ * Find the non-null value in the middle of the input, to use as a predicate
+ * constant that has moderate selectivity for the sorted inputs.
+ */
+static bool
+bench_get_middle_value(BenchState *state, Datum *value)
+{
+	const int middle_batch = state->nbatches / 2;
+	for (int i = 0; i < state->nbatches; i++)
+	{
+		BenchBatch *batch = &state->batches[(middle_batch + i) % state->nbatches];
+		for (int row = batch->nrows / 2; row < batch->nrows; row++)
+		{
+			if (!batch->nulls[row])
+			{
+				*value = batch->values[row];
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static VectorAggFunctions *
+bench_get_vector_aggregate(const char *name, Oid argtype)
+{
+	Oid aggfnoid = LookupFuncName(list_make2(makeString("pg_catalog"), makeString(pstrdup(name))),
+								  1,
+								  &argtype,
+								  /* missing_ok = */ true);
+	if (!OidIsValid(aggfnoid))
+		return NULL;
+
+	return get_vector_aggregate(aggfnoid);
+}
+
+TS_FUNCTION_INFO_V1(ts_bench_compression);
+
+/*
+ * Benchmark the given compression algorithm and the vectorized kernels on the
+ * given values. Returns one row per kernel with the throughput in terms of the
+ * uncompressed data size.
+ */
+Datum
+ts_bench_compression(PG_FUNCTION_ARGS)
+{
+	/* Output columns of this function. */
+	enum
+	{
+		out_kernel = 0,
+		out_rows,
+		out_uncompressed_bytes,
+		out_compressed_bytes,
+		out_ns_per_row,
+		out_mb_per_sec,
+		_out_columns
+	};
+
+	/* Cross-call context for this set-returning function. */
+	struct user_context
+	{
+		BenchState state;
+		BenchResult *results;
+		int nresults;
+		int next_result;
+		int iterations;
+	};
+
+	FuncCallContext *funcctx;
+	struct user_context *c;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		funcctx = SRF_FIRSTCALL_INIT();
+		MemoryContext old = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &funcctx->tuple_desc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+
+		if (PG_ARGISNULL(0) || PG_ARGISNULL(2))
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("values and iterations must not be null")));
+
+		c = palloc0(sizeof(struct user_context));
+		funcctx->user_fctx = c;
+		BenchState *state = &c->state;
+
+		ArrayType *input = PG_GETARG_ARRAYTYPE_P(0);
+		state->element_type = ARR_ELEMTYPE(input);
+		state->algo = PG_ARGISNULL(1) ? compression_get_default_algorithm(state->element_type) :
+										get_compression_algorithm(PG_GETARG_CSTRING(1));
+		state->definition = algorithm_definition(state->algo);
+		state->decompress_all = tsl_get_decompress_all_function(state->algo, state->element_type);
+
+		c->iterations = PG_GETARG_INT32(2);
+		if (c->iterations <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("number of iterations must be positive")));
+
+		bench_prepare(state, input);
+
+		/*
+		 * Enough for compression, three decompression kernels, two predicates
+		 * and four aggregate functions.
+		 */
+		c->results = palloc0(sizeof(BenchResult) * 10);
+
+		c->results[c->nresults++] =
+			(BenchResult){ "compress", bench_run(state, bench_compress, c->iterations) };
+
+		if (state->decompress_all != NULL)
+		{
+			c->results[c->nresults++] =
+				(BenchResult){ "decompress_all",
+							   bench_run(state, bench_decompress_all, c->iterations) };
+		}
+
+		c->results[c->nresults++] =
+			(BenchResult){ "iterator_forward",
+						   bench_run(state, bench_iterator_forward, c->iterations) };
+
+		if (state->definition->iterator_init_reverse != NULL)
+		{
+			c->results[c->nresults++] =
+				(BenchResult){ "iterator_reverse",
+							   bench_run(state, bench_iterator_reverse, c->iterations) };
+		}
+
+		/*
+		 * The vectorized kernels work on the results of bulk decompression.
+		 */
+		TypeCacheEntry *tce =
+			lookup_type_cache(state->element_type, TYPECACHE_EQ_OPR | TYPECACHE_LT_OPR);
+		if (state->decompress_all != NULL &&
+			bench_get_middle_value(state, &state->predicate_constant))
+		{
+			const struct
+			{
+				const char *name;
+				Oid opno;
+			} predicates[] = { { "vector_const_eq", tce->eq_opr },
+							   { "vector_const_lt", tce->lt_opr } };
+
+			for (size_t i = 0; i < lengthof(predicates); i++)
+			{
+				if (!OidIsValid(predicates[i].opno))
+					continue;
+
+				state->predicate = get_vector_const_predicate(get_opcode(predicates[i].opno));
+				if (state->predicate == NULL)
+					continue;
+
+				c->results[c->nresults++] =
+					(BenchResult){ predicates[i].name,
+								   bench_run(state, bench_vector_predicate, c->iterations) };
+			}
+		}
+
+		/*
+		 * The vectorized aggregate functions don't handle the dictionary
+		 * encoding.
+		 */
+		if (state->decompress_all != NULL && state->nbatches > 0 &&
+			state->batches[0].arrow != NULL && state->batches[0].arrow->dictionary == NULL)
+		{
+			const struct
+			{
+				const char *kernel;
+				const char *function;
+			} aggregates[] = { { "vector_agg_sum", "sum" },
+							   { "vector_agg_min", "min" },
+							   { "vector_agg_max", "max" },
+							   { "vector_agg_avg", "avg" } };
+
+			for (size_t i = 0; i < lengthof(aggregates); i++)
+			{
+				state->agg =
+					bench_get_vector_aggregate(aggregates[i].function, state->element_type);
+				if (state->agg == NULL)
+					continue;
+
+				c->results[c->nresults++] =
+					(BenchResult){ aggregates[i].kernel,
+								   bench_run(state, bench_vector_agg, c->iterations) };
+			}
+		}
+
+		MemoryContextSwitchTo(old);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	c = (struct user_context *) funcctx->user_fctx;
+
+	if (c->next_result >= c->nresults)
+	{
+		SRF_RETURN_DONE(funcctx);
+	}
+
+	const BenchResult *result = &c->results[c->next_result++];
+	const BenchState *state = &c->state;
+	const double total_rows = (double) state->rows * c->iterations;
+	const double total_bytes = (double) state->uncompressed_bytes * c->iterations;
+
+	Datum values[_out_columns] = { 0 };
+	bool nulls[_out_columns] = { 0 };
+
+	values[out_kernel] = PointerGetDatum(cstring_to_text(result->kernel));
+	values[out_rows] = Int64GetDatum(state->rows);
+	values[out_uncompressed_bytes] = Int64GetDatum(state->uncompressed_bytes);
+	values[out_compressed_bytes] = Int64GetDatum(state->compressed_bytes);
+
+	if (total_rows > 0 && result->seconds > 0)
+	{
+		values[out_ns_per_row] = Float8GetDatum(result->seconds * 1e9 / total_rows);
+		values[out_mb_per_sec] = Float8GetDatum(total_bytes / result->seconds / 1e6);
+	}
+	else
+	{
+		nulls[out_ns_per_row] = true;
+		nulls[out_mb_per_sec] = true;
+	}
+
+	SRF_RETURN_NEXT(funcctx,
+					HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+}
+
+#endif
@@ -15,9 +15,9 @@
 
 #include "compression/arrow_c_data_interface.h"
 
-#if !defined(NDEBUG) || defined(TS_COMPRESSION_FUZZING)
+#if !defined(NDEBUG) || defined(TS_COMPRESSION_FUZZING) || defined(TS_COMPRESSION_BENCHMARK)
 
-static int
+int
 get_compression_algorithm(char *name)
 {
 	if (pg_strcasecmp(name, "deltadelta") == 0)
@@ -40,6 +40,10 @@ get_compression_algorithm(char *name)
 	{
 		return COMPRESSION_ALGORITHM_BOOL;
 	}
+	else if (pg_strcasecmp(name, "bitpack") == 0)
+	{
+		return COMPRESSION_ALGORITHM_BITPACK;
+	}
 
 	ereport(ERROR, (errmsg("unknown compression algorithm %s", name)));
 	return _INVALID_COMPRESSION_ALGORITHM;
@@ -68,6 +72,16 @@ get_compression_algorithm(char *name)
 #undef PG_TYPE_PREFIX
 #undef DATUM_TO_CTYPE
 
+#define ALGO BITPACK
+#define CTYPE int64
+#define PG_TYPE_PREFIX INT8
+#define DATUM_TO_CTYPE DatumGetInt64
+#include "decompress_arithmetic_test_impl.c"
+#undef ALGO
+#undef CTYPE
+#undef PG_TYPE_PREFIX
+#undef DATUM_TO_CTYPE
+
 /*
  * The table of the supported testing configurations. We use it to generate
  * dispatch tables and specializations of test functions.
@@ -77,6 +91,8 @@ get_compression_algorithm(char *name)
 	X(GORILLA, FLOAT8, false)                                                                      \
 	X(DELTADELTA, INT8, true)                                                                      \
 	X(DELTADELTA, INT8, false)                                                                     \
+	X(BITPACK, INT8, true)                                                                         \
+	X(BITPACK, INT8, false)                                                                        \
 	X(ARRAY, TEXT, false)                                                                          \
 	X(ARRAY, TEXT, true)                                                                           \
 	X(DICTIONARY, TEXT, false)                                                                     \
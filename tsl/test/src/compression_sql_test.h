@@ -12,3 +12,5 @@ int decompress_ARRAY_TEXT(const uint8 *Data, size_t Size, bool bulk);
 int decompress_DICTIONARY_TEXT(const uint8 *Data, size_t Size, bool bulk);
 
 const CompressionAlgorithmDefinition *algorithm_definition(CompressionAlgorithm algo);
+
+int get_compression_algorithm(char *name);
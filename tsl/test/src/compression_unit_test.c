@@ -25,6 +25,7 @@
 #include <export.h>
 
 #include "compression/algorithms/array.h"
+#include "compression/algorithms/bitpack.h"
 #include "compression/algorithms/bool_compress.h"
 #include "compression/algorithms/deltadelta.h"
 #include "compression/algorithms/dictionary.h"
@@ -584,6 +585,107 @@ test_delta3(bool have_nulls, bool have_random)
 	TestAssertTrue(r.is_done);
 }
 
+static void
+test_bitpack(bool have_nulls, bool have_outliers)
+{
+	BitpackCompressor *compressor = bitpack_compressor_alloc();
+	Datum compressed;
+
+	int64 values[TEST_ELEMENTS];
+	bool nulls[TEST_ELEMENTS];
+	for (int i = 0; i < TEST_ELEMENTS; i++)
+	{
+		/* Small random offsets from a negative reference. */
+		values[i] = -1000 + (int64) (test_hash64(i) % 16);
+
+		/*
+		 * The large positive outliers don't fit into the bit width and become
+		 * exceptions.
+		 */
+		if (have_outliers && i % 97 == 0)
+		{
+			values[i] = (int64) (test_hash64(i) >> 1);
+		}
+
+		nulls[i] = have_nulls && i % 29 == 0;
+
+		if (nulls[i])
+		{
+			bitpack_compressor_append_null(compressor);
+		}
+		else
+		{
+			bitpack_compressor_append_value(compressor, values[i]);
+		}
+	}
+
+	compressed = PointerGetDatum(bitpack_compressor_finish(compressor));
+	TestAssertTrue(DatumGetPointer(compressed) != NULL);
+	TestAssertInt64Eq(((CompressedDataHeader *) DatumGetPointer(compressed))->compression_algorithm,
+					  COMPRESSION_ALGORITHM_BITPACK);
+
+	/* Forward decompression. */
+	DecompressionIterator *iter =
+		bitpack_decompression_iterator_from_datum_forward(compressed, INT8OID);
+	ArrowArray *bulk_result = bitpack_decompress_all(compressed, INT8OID, CurrentMemoryContext);
+	TestAssertInt64Eq(bulk_result->length, TEST_ELEMENTS);
+	for (int i = 0; i < TEST_ELEMENTS; i++)
+	{
+		DecompressResult r = bitpack_decompression_iterator_try_next_forward(iter);
+		TestAssertTrue(!r.is_done);
+		if (r.is_null)
+		{
+			TestAssertTrue(nulls[i]);
+			TestAssertTrue(!arrow_row_is_valid(bulk_result->buffers[0], i));
+		}
+		else
+		{
+			TestAssertTrue(!nulls[i]);
+			TestAssertTrue(bulk_result->buffers[0] == NULL ||
+						   arrow_row_is_valid(bulk_result->buffers[0], i));
+			TestAssertTrue(values[i] == DatumGetInt64(r.val));
+			TestAssertTrue(values[i] == ((int64 *) bulk_result->buffers[1])[i]);
+		}
+	}
+	DecompressResult r = bitpack_decompression_iterator_try_next_forward(iter);
+	TestAssertTrue(r.is_done);
+
+	/* Reverse decompression. */
+	iter = bitpack_decompression_iterator_from_datum_reverse(compressed, INT8OID);
+	for (int i = TEST_ELEMENTS - 1; i >= 0; i--)
+	{
+		DecompressResult r = bitpack_decompression_iterator_try_next_reverse(iter);
+		TestAssertTrue(!r.is_done);
+		if (r.is_null)
+		{
+			TestAssertTrue(nulls[i]);
+		}
+		else
+		{
+			TestAssertTrue(!nulls[i]);
+			TestAssertTrue(values[i] == DatumGetInt64(r.val));
+		}
+	}
+	r = bitpack_decompression_iterator_try_next_reverse(iter);
+	TestAssertTrue(r.is_done);
+}
+
+/*
+ * The bitpack compressor falls back to deltadelta when it is smaller.
+ */
+static void
+test_bitpack_fallback()
+{
+	Compressor *compressor = bitpack_compressor_for_type(INT4OID);
+	for (int i = 0; i < TEST_ELEMENTS; i++)
+		compressor->append_val(compressor, Int32GetDatum(i * 10));
+
+	void *compressed = compressor->finish(compressor);
+	TestAssertTrue(compressed != NULL);
+	TestAssertInt64Eq(((CompressedDataHeader *) compressed)->compression_algorithm,
+					  COMPRESSION_ALGORITHM_DELTADELTA);
+}
+
 static int32 test_delta4_case1[] = { -603979776, 1462059044 };
 
 static int32 test_delta4_case2[] = {
@@ -1035,6 +1137,11 @@ ts_test_compression(PG_FUNCTION_ARGS)
 	test_delta3(/* have_nulls = */ false, /* have_random = */ true);
 	test_delta3(/* have_nulls = */ true, /* have_random = */ false);
 	test_delta3(/* have_nulls = */ true, /* have_random = */ true);
+	test_bitpack(/* have_nulls = */ false, /* have_outliers = */ false);
+	test_bitpack(/* have_nulls = */ false, /* have_outliers = */ true);
+	test_bitpack(/* have_nulls = */ true, /* have_outliers = */ false);
+	test_bitpack(/* have_nulls = */ true, /* have_outliers = */ true);
+	test_bitpack_fallback();
 	test_bool();
 	test_null();
 
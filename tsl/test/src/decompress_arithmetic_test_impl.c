@@ -14,8 +14,8 @@
 #define PG_TYPE_OID PG_TYPE_OID_HELPER2(PG_TYPE_PREFIX)
 
 static void
-FUNCTION_NAME2(check_arrow, CTYPE)(ArrowArray *arrow, int error_type, DecompressResult *results,
-								   int n)
+FUNCTION_NAME3(check_arrow, ALGO, CTYPE)(ArrowArray *arrow, int error_type,
+										 DecompressResult *results, int n)
 {
 	if (n != arrow->length)
 	{
@@ -126,7 +126,7 @@ FUNCTION_NAME3(decompress, ALGO, PG_TYPE_PREFIX)(const uint8 *Data, size_t Size,
 	/* Check that both ways of decompression match. */
 	if (bulk)
 	{
-		FUNCTION_NAME2(check_arrow, CTYPE)(arrow, ERROR, results, n);
+		FUNCTION_NAME3(check_arrow, ALGO, CTYPE)(arrow, ERROR, results, n);
 		return n;
 	}
 
@@ -158,8 +158,14 @@ FUNCTION_NAME3(decompress, ALGO, PG_TYPE_PREFIX)(const uint8 *Data, size_t Size,
 	};
 
 	/*
-	 * 2) Decompress and check that it's the same.
+	 * 2) Decompress and check that it's the same. The compressor can choose a
+	 * different algorithm, e.g. bitpack falls back to deltadelta, so look it up
+	 * again.
 	 */
+	const CompressionAlgorithm recompressed_algo =
+		((CompressedDataHeader *) DatumGetPointer(compressed_data))->compression_algorithm;
+	def = algorithm_definition(recompressed_algo);
+	decompress_all = tsl_get_decompress_all_function(recompressed_algo, PG_TYPE_OID);
 	iter = def->iterator_init_forward(compressed_data, PG_TYPE_OID);
 	int nn = 0;
 	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
@@ -211,7 +217,7 @@ FUNCTION_NAME3(decompress, ALGO, PG_TYPE_PREFIX)(const uint8 *Data, size_t Size,
 	}
 	PG_END_TRY();
 
-	FUNCTION_NAME2(check_arrow, CTYPE)(arrow, PANIC, results, n);
+	FUNCTION_NAME3(check_arrow, ALGO, CTYPE)(arrow, PANIC, results, n);
 
 	return n;
 }